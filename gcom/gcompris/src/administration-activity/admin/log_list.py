@@ -18,6 +18,7 @@
 
 import goocanvas
 import gcompris
+import gcompris.admin
 import gcompris.utils
 import gcompris.skin
 import gcompris.bonus
@@ -39,6 +40,9 @@ import constants
   COLUMN_STATUS,
 ) = range(7)
 
+# How many logs are fetched at once
+LOG_PAGE_SIZE = 200
+
 class Log_list:
   """GCompris Log List Table"""
 
@@ -98,9 +102,9 @@ class Log_list:
       self.combo_user = gtk.combo_box_new_text()
       self.combo_user.show()
 
-      # Insert the ALL option (HACK, use the user_id -2 to indicate ALL)
+      # Insert the ALL option
       self.combo_user.append_text(_("All users"))
-      self.user_list.append(-2)
+      self.user_list.append(gcompris.admin.LOG_ALL_USERS)
 
       for auser in user_list:
 
@@ -144,6 +148,8 @@ class Log_list:
       sw.show()
       sw.set_shadow_type(gtk.SHADOW_ETCHED_IN)
       sw.set_policy(gtk.POLICY_NEVER, gtk.POLICY_AUTOMATIC)
+      # Fetch the next logs when the end of the list gets visible
+      sw.get_vadjustment().connect("value-changed", self.log_scrolled_cb)
 
       # create tree view
       treeview_log = gtk.TreeView(self.log_model)
@@ -194,17 +200,33 @@ class Log_list:
     # Remove all entries in the list
     self.log_model.clear()
 
-    # Grab the log data
-    if self.current_user_id == -2:
-      self.cur.execute('SELECT date, user_id, board_id, level, sublevel, duration, status FROM logs ORDER BY date')
-    else:
-      self.cur.execute('SELECT date, user_id, board_id, level, sublevel, duration, status FROM logs ' +
-                       'WHERE user_id=? ORDER BY date', (self.current_user_id, ) )
-    self.log_data = self.cur.fetchall()
+    # The key of the last log loaded, the next page starts after it
+    self.last_log = (None, 0)
+    self.log_complete = False
+
+    self.load_log_page()
+
+  # Append the next page of logs to the model
+  def load_log_page(self):
+
+    if self.log_complete:
+      return
+
+    logs = gcompris.admin.get_logs(self.current_user_id,
+                                   self.last_log[0], self.last_log[1],
+                                   LOG_PAGE_SIZE)
 
-    for alog in self.log_data:
+    for alog in logs:
       self.add_log_in_model(self.log_model, alog)
 
+    if logs:
+      self.last_log = (logs[-1][1], logs[-1][0])
+
+    self.log_complete = len(logs) < LOG_PAGE_SIZE
+
+  def log_scrolled_cb(self, adjustment):
+    if adjustment.value + 2 * adjustment.page_size >= adjustment.upper:
+      self.load_log_page()
 
   def __add_columns_log(self, treeview):
 
@@ -281,38 +303,26 @@ class Log_list:
     treeview.append_column(column)
 
   # Add log in the model
+  # alog is (log_id, date, login, board, level, sublevel, duration, status)
   def add_log_in_model(self, model, alog):
-    iter = model.append()
+    (log_id, date, login, board, level, sublevel, duration, status) = alog
 
-    status = "Lost"
-    if  alog[COLUMN_STATUS] == gcompris.bonus.WIN:
+    if  status == gcompris.bonus.WIN:
         status = "Win"
-    elif  alog[COLUMN_STATUS] == gcompris.bonus.DRAW:
+    elif  status == gcompris.bonus.DRAW:
         status = "Draw"
-    elif  alog[COLUMN_STATUS] == gcompris.bonus.COMPLETED:
+    elif  status == gcompris.bonus.COMPLETED:
         status = "Compl."
+    else:
+        status = "Lost"
 
-    login = _("Default")
-    self.cur.execute('SELECT login FROM users WHERE user_id=?', (alog[COLUMN_USER],))
-    result = self.cur.fetchall()
-    if(result):
-        login = result[0][0]
-
-    board = ""
-    self.cur.execute('SELECT name FROM boards WHERE board_id=?', (alog[COLUMN_BOARD],))
-    result = self.cur.fetchall()
-    if(result):
-        board = result[0][0]
-
-    model.set (iter,
-               COLUMN_DATE,     alog[COLUMN_DATE],
-               COLUMN_USER,     login,
-               COLUMN_BOARD,    board,
-               COLUMN_LEVEL,    alog[COLUMN_LEVEL],
-               COLUMN_SUBLEVEL, alog[COLUMN_SUBLEVEL],
-               COLUMN_DURATION, alog[COLUMN_DURATION],
-               COLUMN_STATUS,   status,
-               )
+    if login == None:
+        login = _("Default")
+
+    if board == None:
+        board = ""
+
+    model.append( (date, login, board, level, sublevel, duration, status) )
 
 
   #
@@ -322,7 +332,7 @@ class Log_list:
       self.cur.execute('delete from logs')
       self.con.commit()
 
-      self.log_model.clear()
+      self.reload_log()
 
   def on_refresh_log_clicked(self, button):
 
@@ -46,6 +46,14 @@ static gchar *menu_position = NULL;
 /* We don't wan't the callback on boards to be accepted until the menu is fully displayed */
 static gboolean menu_displayed = FALSE;
 
+/* Set while the section waits to be displayed again with the icons
+   downloaded from the server */
+static guint menu_refresh_id = 0;
+
+/* Interned skin ids */
+static GQuark menu_text_quark = 0;
+static GQuark menu_description_bg_quark = 0;
+
 static void		 menu_start (GcomprisBoard *agcomprisBoard);
 static void		 menu_pause (gboolean pause);
 static void		 menu_end (void);
@@ -72,6 +80,7 @@ static gint		 item_event(GooCanvasItem *item, GdkEvent *event, MenuItems *menuit
 static void		 display_board_icon(GcomprisBoard *board, MenuItems *menuitems);
 
 static void              display_section (gchar *path);
+static void              menu_file_fetched (const gchar *file, gpointer data);
 static void              display_welcome (MenuItems *menuitems);
 static void		 create_panel(GooCanvasItem *parent);
 static void		 create_top(GooCanvasItem *parent, gchar *path);
@@ -184,6 +193,10 @@ static void menu_start (GcomprisBoard *agcomprisBoard)
   current_x = 0.0;
   current_y = 0.0;
 
+  menu_text_quark = g_quark_from_static_string("menu/text");
+  menu_description_bg_quark =
+    g_quark_from_static_string("menu/description_bg_color");
+
   /* initialisations */
   /* in case we will make this parametrable */
 
@@ -274,18 +287,41 @@ static void menu_start (GcomprisBoard *agcomprisBoard)
 			   -1,
 			   GTK_ANCHOR_EAST,
 			   "font", gc_skin_font_board_tiny,
-			   "fill-color-rgba", gc_skin_get_color("menu/text"),
+			   "fill-color-rgba", gc_skin_get_color_q(menu_text_quark),
 			   "alignment", PANGO_ALIGN_RIGHT,
 			   NULL);
 	g_free(text);
       }
 
+      gc_net_fetched_notify_add(menu_file_fetched, NULL);
+
       menu_pause(FALSE);
 
     }
 
 }
 
+static gboolean
+menu_refresh (gpointer data)
+{
+  menu_refresh_id = 0;
+
+  if (boardRootItem && menu_position)
+    display_section(menu_position);
+
+  return FALSE;
+}
+
+/* An icon missing from the cache is downloaded in the background,
+   the section is displayed again once the downloads settle */
+static void
+menu_file_fetched (const gchar *file, gpointer data)
+{
+  if (menu_refresh_id)
+    g_source_remove(menu_refresh_id);
+  menu_refresh_id = g_timeout_add(300, menu_refresh, NULL);
+}
+
 
 static void
 create_panel(GooCanvasItem *parent)
@@ -385,6 +421,9 @@ display_section (gchar *path)
 
   g_list_foreach (boardlist, (GFunc) display_board_icon, menuitems);
 
+  /* Fetch the boards of the section from the server, if any */
+  gc_net_prefetch_boards(boardlist);
+
   if (strcmp(path,"home")!=0)
     g_list_free(boardlist);
 
@@ -394,6 +433,13 @@ display_section (gchar *path)
 static void
 menu_end ()
 {
+  gc_net_fetched_notify_remove(menu_file_fetched, NULL);
+  if (menu_refresh_id)
+    {
+      g_source_remove(menu_refresh_id);
+      menu_refresh_id = 0;
+    }
+
   if(boardRootItem!=NULL)
     goo_canvas_item_remove(boardRootItem);
 
@@ -699,7 +745,7 @@ create_info_area(GooCanvasItem *parent, MenuItems *menuitems)
 			 info_h,
 			 "stroke_color_rgba", 0xFFFFFFFFL,
 			 "fill_color_rgba",
-			 gc_skin_get_color("menu/description_bg_color"),
+			 gc_skin_get_color_q(menu_description_bg_quark),
 			 "line-width", (double) 2,
 			 "radius-x", (double) 10,
 			 "radius-y", (double) 10,
@@ -716,7 +762,7 @@ create_info_area(GooCanvasItem *parent, MenuItems *menuitems)
 			 -1,
 			 GTK_ANCHOR_CENTER,
 			 "font", gc_skin_font_board_big,
-			 "fill-color-rgba", gc_skin_get_color("menu/text"),
+			 "fill-color-rgba", gc_skin_get_color_q(menu_text_quark),
 			 "alignment", PANGO_ALIGN_CENTER,
 			 NULL);
 
@@ -728,7 +774,7 @@ create_info_area(GooCanvasItem *parent, MenuItems *menuitems)
 			 info_w - 10,
 			 GTK_ANCHOR_CENTER,
 			 "font", gc_skin_font_board_medium,
-			 "fill-color-rgba", gc_skin_get_color("menu/text"),
+			 "fill-color-rgba", gc_skin_get_color_q(menu_text_quark),
 			 "alignment", PANGO_ALIGN_CENTER,
 			 NULL);
 
@@ -740,7 +786,7 @@ create_info_area(GooCanvasItem *parent, MenuItems *menuitems)
 			 -1,
 			 GTK_ANCHOR_CENTER,
 			 "font", gc_skin_font_board_tiny,
-			 "fill-color-rgba", gc_skin_get_color("menu/text"),
+			 "fill-color-rgba", gc_skin_get_color_q(menu_text_quark),
 			 "alignment", PANGO_ALIGN_CENTER,
 			 NULL);
 }
@@ -74,26 +74,27 @@ pyGcomprisWordlistType_getattr(pyGcomprisWordlistObject *self, char *name)
     if(strcmp(name,"words")==0){
       PyObject *pydict;
       PyObject *pylist;
-      GSList *levelList, *list_words;
+      GSList *levelList;
+      guint i;
 
       pydict = PyDict_New();
 
-      // Fixme does not work, I get only the level 2 no idea why
       for (levelList = wl->levels_words; levelList;
 	   levelList = levelList->next){
 	LevelWordlist *lw = levelList->data;
 	gint level = lw->level;
 
-	pylist = PyList_New(0);
-	for (list_words = lw->words; list_words !=NULL;
-	     list_words = list_words->next){
-	  PyList_Append(pylist, Py_BuildValue("s", (gchar *)list_words->data));
+	pylist = PyList_New(lw->n_words);
+	for (i = 0; i < lw->n_words; i++){
+	  PyList_SET_ITEM(pylist, i,
+			  PyString_FromString(gc_wordlist_get_word(lw, i)));
 	}
 
 	PyDict_SetItem( pydict, PyInt_FromLong(	(long) level), pylist);
+	Py_DECREF(pylist);
+      }
 
       return pydict;
-      }
     }
   }
 
@@ -313,6 +313,96 @@ py_gc_db_users_from_group_get (PyObject* self, PyObject* args)
   return pylist;
 }
 
+/* GList *gc_db_get_logs(int user_id, gchar *after_date, gint64 after_rowid, int limit); */
+static PyObject*
+py_gc_db_get_logs (PyObject* self, PyObject* args)
+{
+  GList *logs_list;
+  GList *list;
+  PyObject *pylist;
+  int user_id;
+  gchar *after_date;
+  PY_LONG_LONG after_rowid;
+  int limit;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "izLi:gc_db_get_logs",
+		       &user_id, &after_date, &after_rowid, &limit))
+    return NULL;
+
+  /* Call the corresponding C function */
+  logs_list = gc_db_get_logs(user_id, after_date, after_rowid, limit);
+
+  /* Create and return the result, a list of
+     (log_id, date, login, board, level, sublevel, duration, status) */
+  pylist = PyList_New(0);
+  for (list = logs_list; list != NULL; list = list->next){
+    GcomprisLog *log = (GcomprisLog *) list->data;
+    PyObject *pylog = Py_BuildValue("(Lszziiii)",
+				    (PY_LONG_LONG) log->log_id,
+				    log->date,
+				    log->login,
+				    log->board,
+				    log->level,
+				    log->sublevel,
+				    log->duration,
+				    log->status);
+    if(pylog) {
+      PyList_Append(pylist, pylog);
+      Py_DECREF(pylog);
+    }
+  }
+
+  gc_db_log_list_free(logs_list);
+
+  return pylist;
+}
+
+/* GList *gc_db_get_log_stats(int user_id); */
+static PyObject*
+py_gc_db_get_log_stats (PyObject* self, PyObject* args)
+{
+  GList *stats_list;
+  GList *list;
+  PyObject *pylist;
+  int user_id;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "i:gc_db_get_log_stats", &user_id))
+    return NULL;
+
+  /* Call the corresponding C function */
+  stats_list = gc_db_get_log_stats(user_id);
+
+  /* Create and return the result, a list of
+     (user_id, login, board_id, board, level,
+      played, won, drawn, completed, duration, last_date) */
+  pylist = PyList_New(0);
+  for (list = stats_list; list != NULL; list = list->next){
+    GcomprisLogStats *stats = (GcomprisLogStats *) list->data;
+    PyObject *pystats = Py_BuildValue("(iziziiiiiiz)",
+				      stats->user_id,
+				      stats->login,
+				      stats->board_id,
+				      stats->board,
+				      stats->level,
+				      stats->played,
+				      stats->won,
+				      stats->drawn,
+				      stats->completed,
+				      stats->duration,
+				      stats->last_date);
+    if(pystats) {
+      PyList_Append(pylist, pystats);
+      Py_DECREF(pystats);
+    }
+  }
+
+  gc_db_log_stats_list_free(stats_list);
+
+  return pylist;
+}
+
 /* void                *gc_profile_set_current_user(GcomprisUser *user); */
 static PyObject*
 py_gc_profile_set_current_user (PyObject* self, PyObject* args)
@@ -378,13 +468,18 @@ static PyMethodDef PythonGcomprisAdminModule[] = {
   { "get_users_from_group",  py_gc_db_users_from_group_get, METH_VARARGS, "gc_db_users_from_group_get" },
   { "get_current_user",  py_gc_profile_get_current_user, METH_VARARGS, "gc_profile_get_current_user" },
   { "set_current_user",  py_gc_profile_set_current_user, METH_VARARGS, "gc_profile_set_current_user" },
+  { "get_logs",  py_gc_db_get_logs, METH_VARARGS, "gc_db_get_logs" },
+  { "get_log_stats",  py_gc_db_get_log_stats, METH_VARARGS, "gc_db_get_log_stats" },
   { NULL, NULL, 0, NULL}
 };
 
 
 void python_gcompris_admin_module_init(void)
 {
-  Py_InitModule("_gcompris_admin", PythonGcomprisAdminModule);
+  PyObject* module;
+  module = Py_InitModule("_gcompris_admin", PythonGcomprisAdminModule);
+
+  PyModule_AddIntConstant(module, "LOG_ALL_USERS", GC_DB_LOG_ALL_USERS);
 }
 
 /* Some usefull code parts ... */
@@ -0,0 +1,214 @@
+/* gcompris - py-mod-connect4.c
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <Python.h>
+#include "gcompris/gcompris.h"
+#include "py-mod-connect4.h"
+
+/* An Engine wraps a GcConnect4 and its transposition table.
+ *
+ *   engine = gcompris.connect4.Engine()
+ *   scores = engine.search(board.state, player, depth, msec)
+ *
+ * board.state is the list of the 7 columns, each one the list of the
+ * players who dropped a stone in it, from the bottom.
+ * scores is the list of the score of each column for player, None for
+ * the full columns.
+ */
+
+static PyObject*
+connect4_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+  py_GcomprisConnect4 *self;
+
+  if(!PyArg_ParseTuple(args, ":Engine"))
+    return NULL;
+
+  self = (py_GcomprisConnect4 *) type->tp_alloc(type, 0);
+  if(self)
+    self->engine = gc_connect4_new();
+
+  return (PyObject *) self;
+}
+
+static void
+connect4_dealloc(py_GcomprisConnect4 *self)
+{
+  gc_connect4_free(self->engine);
+  self->ob_type->tp_free((PyObject *) self);
+}
+
+/* Convert the python board state in bitboards */
+static gboolean
+connect4_parse_state(PyObject *state, glong player,
+		     guint64 *current, guint64 *mask)
+{
+  Py_ssize_t col, row;
+
+  *current = *mask = 0;
+
+  if(!PySequence_Check(state) || PySequence_Size(state) != GC_CONNECT4_WIDTH)
+    {
+      PyErr_SetString(PyExc_ValueError, "the state must have 7 columns");
+      return FALSE;
+    }
+
+  for(col = 0; col < GC_CONNECT4_WIDTH; col++)
+    {
+      PyObject *column = PySequence_GetItem(state, col);
+      Py_ssize_t height;
+
+      if(!column)
+	return FALSE;
+
+      height = PySequence_Check(column) ? PySequence_Size(column) : -1;
+      if(height < 0 || height > GC_CONNECT4_HEIGHT)
+	{
+	  Py_DECREF(column);
+	  PyErr_SetString(PyExc_ValueError, "a column holds up to 6 stones");
+	  return FALSE;
+	}
+
+      for(row = 0; row < height; row++)
+	{
+	  PyObject *stone = PySequence_GetItem(column, row);
+	  guint64 bit = G_GUINT64_CONSTANT(1)
+	    << (col * (GC_CONNECT4_HEIGHT + 1) + row);
+
+	  if(!stone)
+	    {
+	      Py_DECREF(column);
+	      return FALSE;
+	    }
+
+	  *mask |= bit;
+	  if(PyInt_Check(stone) && PyInt_AsLong(stone) == player)
+	    *current |= bit;
+	  Py_DECREF(stone);
+	}
+
+      Py_DECREF(column);
+    }
+
+  return TRUE;
+}
+
+/* list search(state, player, depth, msec) */
+static PyObject*
+py_gcompris_connect4_search(py_GcomprisConnect4 *self, PyObject* args)
+{
+  PyObject *state;
+  PyObject *result;
+  long player;
+  int depth, msec;
+  guint64 current, mask;
+  gint scores[GC_CONNECT4_WIDTH];
+  gint col;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "Olii:search", &state, &player, &depth, &msec))
+    return NULL;
+
+  if(!connect4_parse_state(state, player, &current, &mask))
+    return NULL;
+
+  /* Call the corresponding C function */
+  Py_BEGIN_ALLOW_THREADS
+  gc_connect4_search(self->engine, current, mask, depth, msec, scores);
+  Py_END_ALLOW_THREADS
+
+  /* Create and return the result */
+  result = PyList_New(GC_CONNECT4_WIDTH);
+  for(col = 0; result && col < GC_CONNECT4_WIDTH; col++)
+    {
+      if(scores[col] == GC_CONNECT4_ILLEGAL)
+	{
+	  Py_INCREF(Py_None);
+	  PyList_SET_ITEM(result, col, Py_None);
+	}
+      else
+	PyList_SET_ITEM(result, col, PyInt_FromLong(scores[col]));
+    }
+
+  return result;
+}
+
+static PyMethodDef connect4_methods[] = {
+  { "search", (PyCFunction) py_gcompris_connect4_search, METH_VARARGS,
+    "Score each column for the player to move" },
+  { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject py_GcomprisConnect4Type = {
+  PyObject_HEAD_INIT(NULL)
+  0,                                        /* ob_size */
+  "gcompris.connect4.Engine",               /* tp_name */
+  sizeof(py_GcomprisConnect4),              /* tp_basicsize */
+  0,                                        /* tp_itemsize */
+  (destructor) connect4_dealloc,            /* tp_dealloc */
+  0,                                        /* tp_print */
+  0,                                        /* tp_getattr */
+  0,                                        /* tp_setattr */
+  0,                                        /* tp_compare */
+  0,                                        /* tp_repr */
+  0,                                        /* tp_as_number */
+  0,                                        /* tp_as_sequence */
+  0,                                        /* tp_as_mapping */
+  0,                                        /* tp_hash */
+  0,                                        /* tp_call */
+  0,                                        /* tp_str */
+  0,                                        /* tp_getattro */
+  0,                                        /* tp_setattro */
+  0,                                        /* tp_as_buffer */
+  Py_TPFLAGS_DEFAULT,                       /* tp_flags */
+  "Connect 4 alpha beta search engine",     /* tp_doc */
+  0,                                        /* tp_traverse */
+  0,                                        /* tp_clear */
+  0,                                        /* tp_richcompare */
+  0,                                        /* tp_weaklistoffset */
+  0,                                        /* tp_iter */
+  0,                                        /* tp_iternext */
+  connect4_methods,                         /* tp_methods */
+  0,                                        /* tp_members */
+  0,                                        /* tp_getset */
+  0,                                        /* tp_base */
+  0,                                        /* tp_dict */
+  0,                                        /* tp_descr_get */
+  0,                                        /* tp_descr_set */
+  0,                                        /* tp_dictoffset */
+  0,                                        /* tp_init */
+  0,                                        /* tp_alloc */
+  connect4_new,                             /* tp_new */
+};
+
+static PyMethodDef PythonGcomprisConnect4Module[] = {
+  { NULL, NULL, 0, NULL}
+};
+
+void python_gcompris_connect4_module_init(void)
+{
+  PyObject* module;
+  module = Py_InitModule("_gcompris_connect4", PythonGcomprisConnect4Module);
+
+  if(PyType_Ready(&py_GcomprisConnect4Type) < 0)
+    return;
+
+  Py_INCREF(&py_GcomprisConnect4Type);
+  PyModule_AddObject(module, "Engine", (PyObject *) &py_GcomprisConnect4Type);
+
+  PyModule_AddIntConstant(module, "WIN", GC_CONNECT4_WIN);
+}
@@ -0,0 +1,31 @@
+/* gcompris - py-mod-connect4.h
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PY_MOD_CONNECT4_H_
+#define _PY_MOD_CONNECT4_H_
+
+#include <Python.h>
+#include "gcompris/gcompris_connect4.h"
+
+void python_gcompris_connect4_module_init(void);
+
+typedef struct {
+  PyObject_HEAD
+  GcConnect4 *engine;
+} py_GcomprisConnect4;
+
+#endif
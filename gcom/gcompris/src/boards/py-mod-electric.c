@@ -0,0 +1,168 @@
+/* gcompris - py-mod-electric.c
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <Python.h>
+#include "gcompris/gcompris.h"
+#include "py-mod-electric.h"
+
+/* A Circuit wraps a GcDcCircuit. It keeps the matrix structure of
+ * the last solved netlist so that solving the same circuit with other
+ * component values is cheap.
+ *
+ *   circuit = gcompris.electric.Circuit()
+ *   values = circuit.solve(netlist)
+ *
+ * values holds the results of the .print lines of the netlist.
+ */
+
+static PyObject*
+circuit_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+  py_GcomprisCircuit *self;
+
+  if(!PyArg_ParseTuple(args, ":Circuit"))
+    return NULL;
+
+  self = (py_GcomprisCircuit *) type->tp_alloc(type, 0);
+  if(self)
+    self->circuit = gc_dc_circuit_new();
+
+  return (PyObject *) self;
+}
+
+static void
+circuit_dealloc(py_GcomprisCircuit *self)
+{
+  gc_dc_circuit_free(self->circuit);
+  self->ob_type->tp_free((PyObject *) self);
+}
+
+/* list solve(netlist) */
+static PyObject*
+py_gcompris_circuit_solve(py_GcomprisCircuit *self, PyObject* args)
+{
+  gchar *netlist;
+  GArray *values;
+  GcDcStatus status;
+  PyObject *result;
+  guint i;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "s:solve", &netlist))
+    return NULL;
+
+  /* Call the corresponding C function */
+  values = g_array_new(FALSE, FALSE, sizeof(gdouble));
+  status = gc_dc_circuit_solve(self->circuit, netlist, values);
+
+  switch(status)
+    {
+    case GC_DC_OK:
+      break;
+    case GC_DC_PARSE_ERROR:
+      PyErr_Format(PyExc_ValueError, "Cannot parse '%s'",
+		   gc_dc_circuit_get_error(self->circuit));
+      break;
+    case GC_DC_UNKNOWN_ELEMENT:
+      PyErr_Format(PyExc_ValueError, "No element named '%s'",
+		   gc_dc_circuit_get_error(self->circuit));
+      break;
+    default:
+      PyErr_Format(PyExc_RuntimeError, "Cannot solve the circuit: %s",
+		   gc_dc_circuit_get_error(self->circuit));
+      break;
+    }
+
+  if(status != GC_DC_OK)
+    {
+      g_array_free(values, TRUE);
+      return NULL;
+    }
+
+  /* Create and return the result */
+  result = PyList_New(values->len);
+  for(i = 0; result && i < values->len; i++)
+    PyList_SET_ITEM(result, i,
+		    PyFloat_FromDouble(g_array_index(values, gdouble, i)));
+
+  g_array_free(values, TRUE);
+  return result;
+}
+
+static PyMethodDef circuit_methods[] = {
+  { "solve", (PyCFunction) py_gcompris_circuit_solve, METH_VARARGS,
+    "Solve a netlist, returns the values of its .print lines" },
+  { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject py_GcomprisCircuitType = {
+  PyObject_HEAD_INIT(NULL)
+  0,                                        /* ob_size */
+  "gcompris.electric.Circuit",              /* tp_name */
+  sizeof(py_GcomprisCircuit),               /* tp_basicsize */
+  0,                                        /* tp_itemsize */
+  (destructor) circuit_dealloc,             /* tp_dealloc */
+  0,                                        /* tp_print */
+  0,                                        /* tp_getattr */
+  0,                                        /* tp_setattr */
+  0,                                        /* tp_compare */
+  0,                                        /* tp_repr */
+  0,                                        /* tp_as_number */
+  0,                                        /* tp_as_sequence */
+  0,                                        /* tp_as_mapping */
+  0,                                        /* tp_hash */
+  0,                                        /* tp_call */
+  0,                                        /* tp_str */
+  0,                                        /* tp_getattro */
+  0,                                        /* tp_setattro */
+  0,                                        /* tp_as_buffer */
+  Py_TPFLAGS_DEFAULT,                       /* tp_flags */
+  "DC operating point solver",              /* tp_doc */
+  0,                                        /* tp_traverse */
+  0,                                        /* tp_clear */
+  0,                                        /* tp_richcompare */
+  0,                                        /* tp_weaklistoffset */
+  0,                                        /* tp_iter */
+  0,                                        /* tp_iternext */
+  circuit_methods,                          /* tp_methods */
+  0,                                        /* tp_members */
+  0,                                        /* tp_getset */
+  0,                                        /* tp_base */
+  0,                                        /* tp_dict */
+  0,                                        /* tp_descr_get */
+  0,                                        /* tp_descr_set */
+  0,                                        /* tp_dictoffset */
+  0,                                        /* tp_init */
+  0,                                        /* tp_alloc */
+  circuit_new,                              /* tp_new */
+};
+
+static PyMethodDef PythonGcomprisElectricModule[] = {
+  { NULL, NULL, 0, NULL}
+};
+
+void python_gcompris_electric_module_init(void)
+{
+  PyObject* module;
+  module = Py_InitModule("_gcompris_electric", PythonGcomprisElectricModule);
+
+  if(PyType_Ready(&py_GcomprisCircuitType) < 0)
+    return;
+
+  Py_INCREF(&py_GcomprisCircuitType);
+  PyModule_AddObject(module, "Circuit", (PyObject *) &py_GcomprisCircuitType);
+}
@@ -41,6 +41,10 @@ typedef int Py_ssize_t;
 #include "py-mod-utils.h"
 #include "py-mod-anim.h"
 #include "py-mod-admin.h"
+#include "py-mod-electric.h"
+#include "py-mod-connect4.h"
+#include "py-mod-sudoku.h"
+#include "py-mod-lightsoff.h"
 
 void initgoocanvas (void);
 
@@ -1575,9 +1579,11 @@ py_gcompris_wordlist_get_random_word (PyObject* self, PyObject* args)
   /* Call the corresponding C function */
   result = gc_wordlist_random_word_get (gcWordList, level);
 
-  if (result)
-    return PyString_FromString(result);
-  else {
+  if (result) {
+    PyObject *pyresult = PyString_FromString(result);
+    g_free(result);
+    return pyresult;
+  } else {
     Py_INCREF(Py_None);
     return Py_None;
   }
@@ -1737,6 +1743,10 @@ void python_gcompris_module_init(void)
   python_gcompris_utils_module_init();
   python_gcompris_anim_module_init();
   python_gcompris_admin_module_init();
+  python_gcompris_electric_module_init();
+  python_gcompris_connect4_module_init();
+  python_gcompris_sudoku_module_init();
+  python_gcompris_lightsoff_module_init();
 }
 
 /* Some usefull code parts ... */
@@ -0,0 +1,256 @@
+/* gcompris - py-mod-lightsoff.c
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <Python.h>
+#include "gcompris/gcompris.h"
+#include "py-mod-lightsoff.h"
+
+/* A Solver wraps a GcLightsoff for one grid size.
+ *
+ *   solver = gcompris.lightsoff.Solver(width, height)
+ *   presses = solver.solve(grid)
+ *   grid = solver.generate(presses)
+ *
+ * A grid is the list of its rows, each the list of its lights, 1 for
+ * on and 0 for off. solve() returns the lights to press in the same
+ * form, or None.
+ */
+
+static PyObject*
+lightsoff_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+  py_GcomprisLightsoff *self;
+  int width, height;
+
+  if(!PyArg_ParseTuple(args, "ii:Solver", &width, &height))
+    return NULL;
+
+  if(width <= 0 || width > GC_LIGHTSOFF_MAX_SIZE
+     || height <= 0 || height > GC_LIGHTSOFF_MAX_SIZE)
+    {
+      PyErr_SetString(PyExc_ValueError, "invalid grid size");
+      return NULL;
+    }
+
+  self = (py_GcomprisLightsoff *) type->tp_alloc(type, 0);
+  if(self)
+    {
+      self->solver = gc_lightsoff_new(width, height);
+      self->width = width;
+      self->height = height;
+    }
+
+  return (PyObject *) self;
+}
+
+static void
+lightsoff_dealloc(py_GcomprisLightsoff *self)
+{
+  gc_lightsoff_free(self->solver);
+  self->ob_type->tp_free((PyObject *) self);
+}
+
+/* Convert a python grid in bit rows */
+static gboolean
+lightsoff_parse_grid(py_GcomprisLightsoff *self, PyObject *grid, guint32 *rows)
+{
+  Py_ssize_t x, y;
+
+  if(!PySequence_Check(grid) || PySequence_Size(grid) != self->height)
+    {
+      PyErr_SetString(PyExc_ValueError, "the grid does not have the solver height");
+      return FALSE;
+    }
+
+  for(y = 0; y < self->height; y++)
+    {
+      PyObject *row = PySequence_GetItem(grid, y);
+
+      if(!row)
+	return FALSE;
+
+      if(!PySequence_Check(row) || PySequence_Size(row) != self->width)
+	{
+	  Py_DECREF(row);
+	  PyErr_SetString(PyExc_ValueError, "a row does not have the solver width");
+	  return FALSE;
+	}
+
+      rows[y] = 0;
+      for(x = 0; x < self->width; x++)
+	{
+	  PyObject *light = PySequence_GetItem(row, x);
+	  int on;
+
+	  if(!light)
+	    {
+	      Py_DECREF(row);
+	      return FALSE;
+	    }
+
+	  on = PyObject_IsTrue(light);
+	  Py_DECREF(light);
+	  if(on < 0)
+	    {
+	      Py_DECREF(row);
+	      return FALSE;
+	    }
+	  if(on)
+	    rows[y] |= 1u << x;
+	}
+
+      Py_DECREF(row);
+    }
+
+  return TRUE;
+}
+
+static PyObject*
+lightsoff_build_grid(py_GcomprisLightsoff *self, const guint32 *rows)
+{
+  PyObject *grid;
+  gint x, y;
+
+  grid = PyList_New(self->height);
+  for(y = 0; grid && y < self->height; y++)
+    {
+      PyObject *row = PyList_New(self->width);
+
+      if(!row)
+	{
+	  Py_DECREF(grid);
+	  return NULL;
+	}
+
+      for(x = 0; x < self->width; x++)
+	PyList_SET_ITEM(row, x, PyInt_FromLong((rows[y] >> x) & 1));
+
+      PyList_SET_ITEM(grid, y, row);
+    }
+
+  return grid;
+}
+
+/* list solve(grid) */
+static PyObject*
+py_gcompris_lightsoff_solve(py_GcomprisLightsoff *self, PyObject* args)
+{
+  PyObject *grid;
+  guint32 lights[GC_LIGHTSOFF_MAX_SIZE];
+  guint32 presses[GC_LIGHTSOFF_MAX_SIZE];
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "O:solve", &grid))
+    return NULL;
+
+  if(!lightsoff_parse_grid(self, grid, lights))
+    return NULL;
+
+  /* Call the corresponding C function */
+  if(gc_lightsoff_solve(self->solver, lights, presses) < 0)
+    {
+      Py_INCREF(Py_None);
+      return Py_None;
+    }
+
+  /* Create and return the result */
+  return lightsoff_build_grid(self, presses);
+}
+
+/* list generate(presses) */
+static PyObject*
+py_gcompris_lightsoff_generate(py_GcomprisLightsoff *self, PyObject* args)
+{
+  int presses;
+  guint32 lights[GC_LIGHTSOFF_MAX_SIZE];
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "i:generate", &presses))
+    return NULL;
+
+  /* Call the corresponding C function */
+  gc_lightsoff_generate(self->solver, presses, lights);
+
+  /* Create and return the result */
+  return lightsoff_build_grid(self, lights);
+}
+
+static PyMethodDef lightsoff_methods[] = {
+  { "solve", (PyCFunction) py_gcompris_lightsoff_solve, METH_VARARGS,
+    "Shortest list of presses that switch off a grid, None if there is none" },
+  { "generate", (PyCFunction) py_gcompris_lightsoff_generate, METH_VARARGS,
+    "Random grid made by pressing some lights" },
+  { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject py_GcomprisLightsoffType = {
+  PyObject_HEAD_INIT(NULL)
+  0,                                        /* ob_size */
+  "gcompris.lightsoff.Solver",              /* tp_name */
+  sizeof(py_GcomprisLightsoff),             /* tp_basicsize */
+  0,                                        /* tp_itemsize */
+  (destructor) lightsoff_dealloc,           /* tp_dealloc */
+  0,                                        /* tp_print */
+  0,                                        /* tp_getattr */
+  0,                                        /* tp_setattr */
+  0,                                        /* tp_compare */
+  0,                                        /* tp_repr */
+  0,                                        /* tp_as_number */
+  0,                                        /* tp_as_sequence */
+  0,                                        /* tp_as_mapping */
+  0,                                        /* tp_hash */
+  0,                                        /* tp_call */
+  0,                                        /* tp_str */
+  0,                                        /* tp_getattro */
+  0,                                        /* tp_setattro */
+  0,                                        /* tp_as_buffer */
+  Py_TPFLAGS_DEFAULT,                       /* tp_flags */
+  "Lights off solver",                      /* tp_doc */
+  0,                                        /* tp_traverse */
+  0,                                        /* tp_clear */
+  0,                                        /* tp_richcompare */
+  0,                                        /* tp_weaklistoffset */
+  0,                                        /* tp_iter */
+  0,                                        /* tp_iternext */
+  lightsoff_methods,                        /* tp_methods */
+  0,                                        /* tp_members */
+  0,                                        /* tp_getset */
+  0,                                        /* tp_base */
+  0,                                        /* tp_dict */
+  0,                                        /* tp_descr_get */
+  0,                                        /* tp_descr_set */
+  0,                                        /* tp_dictoffset */
+  0,                                        /* tp_init */
+  0,                                        /* tp_alloc */
+  lightsoff_new,                            /* tp_new */
+};
+
+static PyMethodDef PythonGcomprisLightsoffModule[] = {
+  { NULL, NULL, 0, NULL}
+};
+
+void python_gcompris_lightsoff_module_init(void)
+{
+  PyObject* module;
+  module = Py_InitModule("_gcompris_lightsoff", PythonGcomprisLightsoffModule);
+
+  if(PyType_Ready(&py_GcomprisLightsoffType) < 0)
+    return;
+
+  Py_INCREF(&py_GcomprisLightsoffType);
+  PyModule_AddObject(module, "Solver", (PyObject *) &py_GcomprisLightsoffType);
+}
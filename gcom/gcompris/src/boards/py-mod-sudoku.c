@@ -0,0 +1,322 @@
+/* gcompris - py-mod-sudoku.c
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <Python.h>
+#include "gcompris/gcompris.h"
+#include "py-mod-sudoku.h"
+
+/* A Sudoku wraps a GcSudoku.
+ *
+ *   sudoku = gcompris.sudoku.Sudoku(size, region)
+ *   holes = sudoku.generate(holes, gcompris.sudoku.MEDIUM)
+ *
+ * The cells are addressed by row and column, the values go from 1 to
+ * size, 0 is an empty cell.
+ */
+
+static PyObject*
+sudoku_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+  py_GcomprisSudoku *self;
+  int size, region;
+
+  if(!PyArg_ParseTuple(args, "ii:Sudoku", &size, &region))
+    return NULL;
+
+  if(size <= 0 || size > GC_SUDOKU_MAX_SIZE
+     || (region != 0 && region * region != size))
+    {
+      PyErr_SetString(PyExc_ValueError, "invalid sudoku size or region");
+      return NULL;
+    }
+
+  self = (py_GcomprisSudoku *) type->tp_alloc(type, 0);
+  if(self)
+    self->sudoku = gc_sudoku_new(size, region);
+
+  return (PyObject *) self;
+}
+
+static void
+sudoku_dealloc(py_GcomprisSudoku *self)
+{
+  gc_sudoku_free(self->sudoku);
+  self->ob_type->tp_free((PyObject *) self);
+}
+
+static gboolean
+sudoku_check_cell(py_GcomprisSudoku *self, int row, int col)
+{
+  gint size = gc_sudoku_get_size(self->sudoku);
+
+  if(row < 0 || row >= size || col < 0 || col >= size)
+    {
+      PyErr_SetString(PyExc_IndexError, "cell out of the sudoku");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+sudoku_check_value(py_GcomprisSudoku *self, int value, int min)
+{
+  if(value < min || value > gc_sudoku_get_size(self->sudoku))
+    {
+      PyErr_SetString(PyExc_ValueError, "value out of range");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* int generate(holes, max_rating) */
+static PyObject*
+py_gcompris_sudoku_generate(py_GcomprisSudoku *self, PyObject* args)
+{
+  int holes, max_rating;
+  gint made;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "ii:generate", &holes, &max_rating))
+    return NULL;
+
+  /* Call the corresponding C function */
+  Py_BEGIN_ALLOW_THREADS
+  made = gc_sudoku_generate(self->sudoku, holes, max_rating);
+  Py_END_ALLOW_THREADS
+
+  /* Create and return the result */
+  return PyInt_FromLong(made);
+}
+
+/* int rate() */
+static PyObject*
+py_gcompris_sudoku_rate(py_GcomprisSudoku *self, PyObject* args)
+{
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, ":rate"))
+    return NULL;
+
+  /* Call the corresponding C function */
+  return PyInt_FromLong(gc_sudoku_rate(self->sudoku));
+}
+
+/* void reset() */
+static PyObject*
+py_gcompris_sudoku_reset(py_GcomprisSudoku *self, PyObject* args)
+{
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, ":reset"))
+    return NULL;
+
+  /* Call the corresponding C function */
+  gc_sudoku_reset(self->sudoku);
+
+  /* Create and return the result */
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+/* int get(row, col) */
+static PyObject*
+py_gcompris_sudoku_get(py_GcomprisSudoku *self, PyObject* args)
+{
+  int row, col;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "ii:get", &row, &col))
+    return NULL;
+  if(!sudoku_check_cell(self, row, col))
+    return NULL;
+
+  /* Call the corresponding C function */
+  return PyInt_FromLong(gc_sudoku_get(self->sudoku, row, col));
+}
+
+/* bool is_fixed(row, col) */
+static PyObject*
+py_gcompris_sudoku_is_fixed(py_GcomprisSudoku *self, PyObject* args)
+{
+  int row, col;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "ii:is_fixed", &row, &col))
+    return NULL;
+  if(!sudoku_check_cell(self, row, col))
+    return NULL;
+
+  /* Call the corresponding C function */
+  return PyBool_FromLong(gc_sudoku_is_fixed(self->sudoku, row, col));
+}
+
+/* int get_solution(row, col) */
+static PyObject*
+py_gcompris_sudoku_get_solution(py_GcomprisSudoku *self, PyObject* args)
+{
+  int row, col;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "ii:get_solution", &row, &col))
+    return NULL;
+  if(!sudoku_check_cell(self, row, col))
+    return NULL;
+
+  /* Call the corresponding C function */
+  return PyInt_FromLong(gc_sudoku_get_solution(self->sudoku, row, col));
+}
+
+/* list check(row, col, value), the (row, col) of the conflicting cells */
+static PyObject*
+py_gcompris_sudoku_check(py_GcomprisSudoku *self, PyObject* args)
+{
+  int row, col, value;
+  gint conflicts[3];
+  gint size, n, i;
+  PyObject *result;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "iii:check", &row, &col, &value))
+    return NULL;
+  if(!sudoku_check_cell(self, row, col) || !sudoku_check_value(self, value, 1))
+    return NULL;
+
+  /* Call the corresponding C function */
+  n = gc_sudoku_check(self->sudoku, row, col, value, conflicts);
+
+  /* Create and return the result */
+  size = gc_sudoku_get_size(self->sudoku);
+  result = PyList_New(n);
+  for(i = 0; result && i < n; i++)
+    PyList_SET_ITEM(result, i, Py_BuildValue("(ii)",
+					     conflicts[i] / size,
+					     conflicts[i] % size));
+
+  return result;
+}
+
+/* bool set(row, col, value) */
+static PyObject*
+py_gcompris_sudoku_set(py_GcomprisSudoku *self, PyObject* args)
+{
+  int row, col, value;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "iii:set", &row, &col, &value))
+    return NULL;
+  if(!sudoku_check_cell(self, row, col) || !sudoku_check_value(self, value, 0))
+    return NULL;
+
+  /* Call the corresponding C function */
+  return PyBool_FromLong(gc_sudoku_set(self->sudoku, row, col, value));
+}
+
+/* bool is_solved() */
+static PyObject*
+py_gcompris_sudoku_is_solved(py_GcomprisSudoku *self, PyObject* args)
+{
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, ":is_solved"))
+    return NULL;
+
+  /* Call the corresponding C function */
+  return PyBool_FromLong(gc_sudoku_is_solved(self->sudoku));
+}
+
+static PyMethodDef sudoku_methods[] = {
+  { "generate", (PyCFunction) py_gcompris_sudoku_generate, METH_VARARGS,
+    "Make a new puzzle, returns its number of empty cells" },
+  { "rate", (PyCFunction) py_gcompris_sudoku_rate, METH_VARARGS,
+    "Rate the puzzle" },
+  { "reset", (PyCFunction) py_gcompris_sudoku_reset, METH_VARARGS,
+    "Clear the cells that are not fixed" },
+  { "get", (PyCFunction) py_gcompris_sudoku_get, METH_VARARGS,
+    "Value of a cell, 0 if empty" },
+  { "is_fixed", (PyCFunction) py_gcompris_sudoku_is_fixed, METH_VARARGS,
+    "Whether a cell is given by the puzzle" },
+  { "get_solution", (PyCFunction) py_gcompris_sudoku_get_solution, METH_VARARGS,
+    "Value of a cell in the solution" },
+  { "check", (PyCFunction) py_gcompris_sudoku_check, METH_VARARGS,
+    "Cells preventing a value to be set in a cell" },
+  { "set", (PyCFunction) py_gcompris_sudoku_set, METH_VARARGS,
+    "Set the value of a cell if it is legal" },
+  { "is_solved", (PyCFunction) py_gcompris_sudoku_is_solved, METH_VARARGS,
+    "Whether all the cells are set" },
+  { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject py_GcomprisSudokuType = {
+  PyObject_HEAD_INIT(NULL)
+  0,                                        /* ob_size */
+  "gcompris.sudoku.Sudoku",                 /* tp_name */
+  sizeof(py_GcomprisSudoku),                /* tp_basicsize */
+  0,                                        /* tp_itemsize */
+  (destructor) sudoku_dealloc,              /* tp_dealloc */
+  0,                                        /* tp_print */
+  0,                                        /* tp_getattr */
+  0,                                        /* tp_setattr */
+  0,                                        /* tp_compare */
+  0,                                        /* tp_repr */
+  0,                                        /* tp_as_number */
+  0,                                        /* tp_as_sequence */
+  0,                                        /* tp_as_mapping */
+  0,                                        /* tp_hash */
+  0,                                        /* tp_call */
+  0,                                        /* tp_str */
+  0,                                        /* tp_getattro */
+  0,                                        /* tp_setattro */
+  0,                                        /* tp_as_buffer */
+  Py_TPFLAGS_DEFAULT,                       /* tp_flags */
+  "Sudoku generator and grid",              /* tp_doc */
+  0,                                        /* tp_traverse */
+  0,                                        /* tp_clear */
+  0,                                        /* tp_richcompare */
+  0,                                        /* tp_weaklistoffset */
+  0,                                        /* tp_iter */
+  0,                                        /* tp_iternext */
+  sudoku_methods,                           /* tp_methods */
+  0,                                        /* tp_members */
+  0,                                        /* tp_getset */
+  0,                                        /* tp_base */
+  0,                                        /* tp_dict */
+  0,                                        /* tp_descr_get */
+  0,                                        /* tp_descr_set */
+  0,                                        /* tp_dictoffset */
+  0,                                        /* tp_init */
+  0,                                        /* tp_alloc */
+  sudoku_new,                               /* tp_new */
+};
+
+static PyMethodDef PythonGcomprisSudokuModule[] = {
+  { NULL, NULL, 0, NULL}
+};
+
+void python_gcompris_sudoku_module_init(void)
+{
+  PyObject* module;
+  module = Py_InitModule("_gcompris_sudoku", PythonGcomprisSudokuModule);
+
+  if(PyType_Ready(&py_GcomprisSudokuType) < 0)
+    return;
+
+  Py_INCREF(&py_GcomprisSudokuType);
+  PyModule_AddObject(module, "Sudoku", (PyObject *) &py_GcomprisSudokuType);
+
+  PyModule_AddIntConstant(module, "EASY", GC_SUDOKU_EASY);
+  PyModule_AddIntConstant(module, "MEDIUM", GC_SUDOKU_MEDIUM);
+  PyModule_AddIntConstant(module, "HARD", GC_SUDOKU_HARD);
+}
@@ -0,0 +1,31 @@
+/* gcompris - py-mod-sudoku.h
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PY_MOD_SUDOKU_H_
+#define _PY_MOD_SUDOKU_H_
+
+#include <Python.h>
+#include "gcompris/gcompris_sudoku.h"
+
+void python_gcompris_sudoku_module_init(void);
+
+typedef struct {
+  PyObject_HEAD
+  GcSudoku *sudoku;
+} py_GcomprisSudoku;
+
+#endif
@@ -16,12 +16,18 @@
  *   along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 #include <Python.h>
+#include <structmember.h>
 #define NO_IMPORT_PYGOBJECT 1
 #include <pygobject.h>
+#include <pycairo.h>
 #include "gcompris/gcompris.h"
+#include "gcompris/pixbuf_util.h"
 #include "py-mod-utils.h"
 #include "py-gcompris-board.h"
 
+/* Set by the goocanvas module initialisation */
+extern Pycairo_CAPI_t *Pycairo_CAPI;
+
 /* All functions provided by this python module
  * wraps a gcompris function. Each "py_*" function wraps the
  * "*" C function.
@@ -432,6 +438,290 @@ py_gcompris_canvas_get_property(PyObject* self, PyObject* args)
 }
 
 
+/*
+ * Zero copy access to image pixels
+ * --------------------------------
+ * A PixelBuffer exports the pixels of a GdkPixbuf or of a cairo
+ * image surface through the buffer protocol. It keeps a reference
+ * on its owner so that the memory stays valid as long as the buffer
+ * (or a memoryview on it) is alive.
+ */
+typedef struct {
+  PyObject_HEAD
+  GdkPixbuf       *pixbuf;
+  cairo_surface_t *surface;
+  guchar          *pixels;
+  Py_ssize_t       size;
+  int              width;
+  int              height;
+  int              rowstride;
+  int              n_channels;
+} PyGcomprisPixelBuffer;
+
+static void
+pixel_buffer_dealloc(PyGcomprisPixelBuffer *self)
+{
+  if(self->pixbuf)
+    g_object_unref(self->pixbuf);
+  if(self->surface)
+    cairo_surface_destroy(self->surface);
+  PyObject_DEL(self);
+}
+
+static Py_ssize_t
+pixel_buffer_getbuf(PyGcomprisPixelBuffer *self, Py_ssize_t segment, void **ptr)
+{
+  if(segment != 0) {
+    PyErr_SetString(PyExc_SystemError, "accessing non-existent buffer segment");
+    return -1;
+  }
+  *ptr = self->pixels;
+  return self->size;
+}
+
+static Py_ssize_t
+pixel_buffer_getsegcount(PyGcomprisPixelBuffer *self, Py_ssize_t *lenp)
+{
+  if(lenp)
+    *lenp = self->size;
+  return 1;
+}
+
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+static int
+pixel_buffer_getbuffer(PyGcomprisPixelBuffer *self, Py_buffer *view, int flags)
+{
+  return PyBuffer_FillInfo(view, (PyObject *) self, self->pixels, self->size,
+			   0, flags);
+}
+#endif
+
+/* Mark the pixels as modified, needed after writing in a cairo surface */
+static PyObject*
+pixel_buffer_mark_dirty(PyGcomprisPixelBuffer *self, PyObject* args)
+{
+  if(!PyArg_ParseTuple(args, ":mark_dirty"))
+    return NULL;
+
+  if(self->surface)
+    cairo_surface_mark_dirty(self->surface);
+
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+static PyBufferProcs pixel_buffer_as_buffer = {
+  (readbufferproc) pixel_buffer_getbuf,
+  (writebufferproc) pixel_buffer_getbuf,
+  (segcountproc) pixel_buffer_getsegcount,
+  (charbufferproc) NULL,
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+  (getbufferproc) pixel_buffer_getbuffer,
+  (releasebufferproc) NULL,
+#endif
+};
+
+static PyMemberDef pixel_buffer_members[] = {
+  { "width",      T_INT, offsetof(PyGcomprisPixelBuffer, width),      READONLY, "width" },
+  { "height",     T_INT, offsetof(PyGcomprisPixelBuffer, height),     READONLY, "height" },
+  { "rowstride",  T_INT, offsetof(PyGcomprisPixelBuffer, rowstride),  READONLY, "rowstride" },
+  { "n_channels", T_INT, offsetof(PyGcomprisPixelBuffer, n_channels), READONLY, "n_channels" },
+  { NULL }
+};
+
+static PyMethodDef pixel_buffer_methods[] = {
+  { "mark_dirty", (PyCFunction) pixel_buffer_mark_dirty, METH_VARARGS,
+    "cairo_surface_mark_dirty" },
+  { NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject PyGcomprisPixelBufferType = {
+  PyObject_HEAD_INIT(NULL)
+  0,                                        /* ob_size */
+  "gcompris.utils.PixelBuffer",             /* tp_name */
+  sizeof(PyGcomprisPixelBuffer),            /* tp_basicsize */
+  0,                                        /* tp_itemsize */
+  (destructor) pixel_buffer_dealloc,        /* tp_dealloc */
+  0,                                        /* tp_print */
+  0,                                        /* tp_getattr */
+  0,                                        /* tp_setattr */
+  0,                                        /* tp_compare */
+  0,                                        /* tp_repr */
+  0,                                        /* tp_as_number */
+  0,                                        /* tp_as_sequence */
+  0,                                        /* tp_as_mapping */
+  0,                                        /* tp_hash */
+  0,                                        /* tp_call */
+  0,                                        /* tp_str */
+  0,                                        /* tp_getattro */
+  0,                                        /* tp_setattro */
+  &pixel_buffer_as_buffer,                  /* tp_as_buffer */
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+  Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER, /* tp_flags */
+#else
+  Py_TPFLAGS_DEFAULT,                       /* tp_flags */
+#endif
+  "Pixels of a pixbuf or of a cairo image surface", /* tp_doc */
+  0,                                        /* tp_traverse */
+  0,                                        /* tp_clear */
+  0,                                        /* tp_richcompare */
+  0,                                        /* tp_weaklistoffset */
+  0,                                        /* tp_iter */
+  0,                                        /* tp_iternext */
+  pixel_buffer_methods,                     /* tp_methods */
+  pixel_buffer_members,                     /* tp_members */
+};
+
+/* Return the GdkPixbuf wrapped in pyobject or NULL with an exception set */
+static GdkPixbuf *
+py_pixbuf_get(PyObject *pyobject)
+{
+  if(pygobject_check(pyobject, &PyGObject_Type) &&
+     GDK_IS_PIXBUF(pygobject_get(pyobject)))
+    return GDK_PIXBUF(pygobject_get(pyobject));
+
+  PyErr_SetString(PyExc_TypeError, "a gtk.gdk.Pixbuf is required");
+  return NULL;
+}
+
+/* PixelBuffer pixel_buffer(GdkPixbuf or cairo.ImageSurface) */
+static PyObject*
+py_gcompris_pixel_buffer(PyObject* self, PyObject* args)
+{
+  PyObject* pyobject;
+  PyGcomprisPixelBuffer *result;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "O:gcompris_pixel_buffer", &pyobject))
+    return NULL;
+
+  result = PyObject_NEW(PyGcomprisPixelBuffer, &PyGcomprisPixelBufferType);
+  if(result == NULL)
+    return NULL;
+  result->pixbuf = NULL;
+  result->surface = NULL;
+
+  if(Pycairo_CAPI &&
+     PyObject_IsInstance(pyobject, (PyObject *) &PycairoImageSurface_Type)) {
+    cairo_surface_t *surface = ((PycairoSurface *) pyobject)->surface;
+
+    /* Make sure pending drawings are in memory */
+    cairo_surface_flush(surface);
+
+    result->surface    = cairo_surface_reference(surface);
+    result->pixels     = cairo_image_surface_get_data(surface);
+    result->width      = cairo_image_surface_get_width(surface);
+    result->height     = cairo_image_surface_get_height(surface);
+    result->rowstride  = cairo_image_surface_get_stride(surface);
+    result->n_channels = 4;
+    result->size       = result->rowstride * result->height;
+  } else if(pygobject_check(pyobject, &PyGObject_Type) &&
+	    GDK_IS_PIXBUF(pygobject_get(pyobject))) {
+    GdkPixbuf *pixbuf = GDK_PIXBUF(pygobject_get(pyobject));
+
+    result->pixbuf     = g_object_ref(pixbuf);
+    result->pixels     = gdk_pixbuf_get_pixels(pixbuf);
+    result->width      = gdk_pixbuf_get_width(pixbuf);
+    result->height     = gdk_pixbuf_get_height(pixbuf);
+    result->rowstride  = gdk_pixbuf_get_rowstride(pixbuf);
+    result->n_channels = gdk_pixbuf_get_n_channels(pixbuf);
+    /* The last row is not padded to the rowstride */
+    result->size       = (result->height ?
+			  (result->height - 1) * result->rowstride +
+			  result->width * result->n_channels : 0);
+  } else {
+    Py_DECREF(result);
+    PyErr_SetString(PyExc_TypeError,
+		    "a gtk.gdk.Pixbuf or a cairo.ImageSurface is required");
+    return NULL;
+  }
+
+  return (PyObject *) result;
+}
+
+/* void pixbuf_fill_rect(GdkPixbuf *pixbuf, gint x, gint y, gint w, gint h,
+                         guint32 rgba) */
+static PyObject*
+py_pixbuf_fill_rect(PyObject* self, PyObject* args)
+{
+  PyObject* pypixbuf;
+  GdkPixbuf *pixbuf;
+  gint x, y, w, h;
+  guint32 rgba;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "OiiiiI:pixbuf_fill_rect",
+		       &pypixbuf, &x, &y, &w, &h, &rgba))
+    return NULL;
+  pixbuf = py_pixbuf_get(pypixbuf);
+  if(pixbuf == NULL)
+    return NULL;
+
+  /* Call the corresponding C function */
+  pixbuf_fill_rect(pixbuf, x, y, w, h, rgba);
+
+  /* Create and return the result */
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+/* void pixbuf_blit(GdkPixbuf *src, gint sx, gint sy, gint w, gint h,
+                    GdkPixbuf *dest, gint dx, gint dy) */
+static PyObject*
+py_pixbuf_blit(PyObject* self, PyObject* args)
+{
+  PyObject* pysrc;
+  PyObject* pydest;
+  GdkPixbuf *src, *dest;
+  gint sx, sy, w, h, dx, dy;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "OiiiiOii:pixbuf_blit",
+		       &pysrc, &sx, &sy, &w, &h, &pydest, &dx, &dy))
+    return NULL;
+  src = py_pixbuf_get(pysrc);
+  if(src == NULL)
+    return NULL;
+  dest = py_pixbuf_get(pydest);
+  if(dest == NULL)
+    return NULL;
+
+  /* Call the corresponding C function */
+  pixbuf_blit(src, sx, sy, w, h, dest, dx, dy);
+
+  /* Create and return the result */
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+/* guint pixbuf_flood_fill(GdkPixbuf *pixbuf, gint x, gint y,
+                           guint32 rgba, guint tolerance) */
+static PyObject*
+py_pixbuf_flood_fill(PyObject* self, PyObject* args)
+{
+  PyObject* pypixbuf;
+  GdkPixbuf *pixbuf;
+  gint x, y;
+  guint32 rgba;
+  guint tolerance = 0;
+  guint result;
+
+  /* Parse arguments */
+  if(!PyArg_ParseTuple(args, "OiiI|I:pixbuf_flood_fill",
+		       &pypixbuf, &x, &y, &rgba, &tolerance))
+    return NULL;
+  pixbuf = py_pixbuf_get(pypixbuf);
+  if(pixbuf == NULL)
+    return NULL;
+
+  /* Call the corresponding C function */
+  result = pixbuf_flood_fill(pixbuf, x, y, rgba, tolerance);
+
+  /* Create and return the result */
+  return Py_BuildValue("I", result);
+}
+
+
 static PyMethodDef PythonGcomprisUtilsModule[] = {
   { "load_pixmap",  py_gc_pixmap_load, METH_VARARGS, "gc_pixmap_load" },
   { "load_svg",  py_gc_svg_load, METH_VARARGS, "gc_rsvg_load" },
@@ -450,13 +740,25 @@ static PyMethodDef PythonGcomprisUtilsModule[] = {
   { "filename_pass",  py_gcompris_filename_pass, METH_VARARGS, "gcompris_filename_pass" },
   { "canvas_set_property",  py_gcompris_canvas_set_property, METH_VARARGS, "gcompris_canvas_set_property" },
   { "canvas_get_property",  py_gcompris_canvas_get_property, METH_VARARGS, "gcompris_canvas_get_property" },
+  { "pixel_buffer",  py_gcompris_pixel_buffer, METH_VARARGS, "gcompris_pixel_buffer" },
+  { "pixbuf_fill_rect",  py_pixbuf_fill_rect, METH_VARARGS, "pixbuf_fill_rect" },
+  { "pixbuf_blit",  py_pixbuf_blit, METH_VARARGS, "pixbuf_blit" },
+  { "pixbuf_flood_fill",  py_pixbuf_flood_fill, METH_VARARGS, "pixbuf_flood_fill" },
   { NULL, NULL, 0, NULL}
 };
 
 
 void python_gcompris_utils_module_init(void)
 {
-  Py_InitModule("_gcompris_utils", PythonGcomprisUtilsModule);
+  PyObject* module;
+
+  if(PyType_Ready(&PyGcomprisPixelBufferType) < 0)
+    return;
+
+  module = Py_InitModule("_gcompris_utils", PythonGcomprisUtilsModule);
+
+  Py_INCREF(&PyGcomprisPixelBufferType);
+  PyModule_AddObject(module, "PixelBuffer", (PyObject *) &PyGcomprisPixelBufferType);
 }
 
 /* Some usefull code parts ... */
@@ -38,6 +38,7 @@ static PyObject* python_board_config_module = NULL;
 static PyObject* python_board_config_instance = NULL;
 
 static void	 pythonboard_init (GcomprisBoard *agcomprisBoard);
+static void	 pythonboard_cleanup (void);
 static void	 pythonboard_start (GcomprisBoard *agcomprisBoard);
 static void	 pythonboard_pause (gboolean pause);
 static void	 pythonboard_end (void);
@@ -53,6 +54,10 @@ static void	 pythongc_board_config_start (GcomprisBoard *agcomprisBoard,
 					   GcomprisProfile *aProfile);
 static void	 pythongc_board_config_stop (void);
 
+static gboolean	 pythonboard_preload_idle (gpointer data);
+static void	 pythonboard_preload_resume (void);
+static void	 pythonboard_preload_suspend (void);
+
 static gboolean  pythonboard_is_ready = FALSE;
 
 
@@ -65,7 +70,7 @@ static BoardPlugin menu_bp =
     N_("Special board that embeds python into GCompris."),
     "Olivier Samyn <osamyn@ulb.ac.be>",
     pythonboard_init,
-    NULL,
+    pythonboard_cleanup,
     NULL,
     NULL,
     pythonboard_start,
@@ -89,7 +94,7 @@ static BoardPlugin menu_bp_no_config =
     N_("Special board that embeds python into gcompris."),
     "Olivier Samyn <osamyn@ulb.ac.be>",
     pythonboard_init,
-    NULL,
+    pythonboard_cleanup,
     NULL,
     NULL,
     pythonboard_start,
@@ -119,6 +124,21 @@ GET_BPLUGIN_INFO(python)
 
 static GList *config_boards= NULL;
 
+/*
+ * The interpreter is initialized once and kept alive for the whole
+ * session. Board modules are imported at most once and kept in this
+ * cache (board file name -> module, the cache owns the reference).
+ */
+static gboolean    python_interpreter_ready = FALSE;
+static GHashTable *python_module_cache = NULL;
+
+/* Python boards waiting to be imported in the background. The main
+ * thread holds the interpreter lock, so they are imported from the main
+ * loop, one per PRELOAD_DELAY ms, when no event is pending. */
+#define PRELOAD_DELAY 200
+static GList *preload_boards = NULL;
+static guint  preload_source_id = 0;
+
 /*
  * Create the import string to be added to the python path
  * The plugin directory is passed in properties->package_python_plugin_dir
@@ -148,6 +168,92 @@ static gchar *get_pythonpath()
   return pythonpath;
 }
 
+/*
+ * Initialize the python interpreter, the search path and
+ * the gcompris modules. This is done only once, the interpreter
+ * is never finalized until gcompris exits.
+ */
+static gboolean
+python_interpreter_init()
+{
+  static gboolean called_once = FALSE;
+  static char *python_args[]={ "" };
+  static char* python_prog_name="gcompris";
+  PyObject* main_module;
+  PyObject* globals;
+  gchar* boarddir;
+
+  if (called_once)
+    return python_interpreter_ready;
+
+  called_once = TRUE;
+
+  Py_SetProgramName(python_prog_name);
+  Py_Initialize();
+
+  PySys_SetArgv(1, python_args);
+
+  init_pygobject();
+
+  main_module = PyImport_AddModule("__main__"); /* Borrowed reference */
+  globals = PyModule_GetDict(main_module); /* Borrowed reference */
+
+  if(globals==NULL){
+    g_warning("! Python disabled: Cannot get info from the python interpreter.\n");
+    return FALSE;
+  }
+
+  /* Add the python plugins dir to the python's search path */
+  boarddir = get_pythonpath();
+  g_message("Executing %s\n", boarddir);
+  if(PyRun_SimpleString(boarddir)!=0){
+    g_warning("! Python disabled: Cannot add plugins dir into search path\n");
+    g_free(boarddir);
+    return FALSE;
+  }
+  g_free(boarddir);
+
+  /* Load the gcompris modules */
+  python_gcompris_module_init();
+
+  python_module_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+					      g_free, NULL);
+
+  python_interpreter_ready = TRUE;
+  return TRUE;
+}
+
+/*
+ * Return the python module of the given board, importing it
+ * only if it is not already in our cache.
+ * The returned reference is borrowed, do not decref it.
+ */
+static PyObject *
+python_board_module_get(const gchar *board_file_name)
+{
+  PyObject* main_module;
+  PyObject* globals;
+  PyObject* module;
+
+  module = g_hash_table_lookup(python_module_cache, board_file_name);
+  if (module)
+    return module;
+
+  main_module = PyImport_AddModule("__main__"); /* Borrowed reference */
+  globals = PyModule_GetDict(main_module); /* Borrowed reference */
+
+  /* Insert the board module into the python's interpreter */
+  module = PyImport_ImportModuleEx((char *)board_file_name,
+				   globals,
+				   globals,
+				   NULL);
+
+  if (module)
+    g_hash_table_insert(python_module_cache, g_strdup(board_file_name), module);
+
+  return module;
+}
+
 GList *
 get_pythonboards_list()
 {
@@ -165,9 +271,88 @@ get_pythonboards_list()
   return pythonboards_list;
 }
 
+/*
+ * Look for a config_start method in the board python source without
+ * executing it. Only a 'def config_start' starting a line, after its
+ * indentation, counts: the boards define it as a method of their class.
+ * This is only a first guess, python_board_check_config() checks the
+ * class once the module is imported.
+ * Return 1 if found, 0 if not and -1 if the source file cannot be read.
+ */
+static gint
+python_board_source_has_config(const gchar *board_file_name)
+{
+  GcomprisProperties *properties = gc_prop_get();
+  gchar **plugin_dirs = g_strsplit( properties->package_python_plugin_dir , ":", -1 );
+  gchar *source_name = g_strdup_printf("%s.py", board_file_name);
+  gint result = -1;
+  int i;
+
+  for ( i = 0 ; i < g_strv_length( plugin_dirs ) && result < 0; i++ ) {
+    gchar *filename = g_build_filename(plugin_dirs[i], source_name, NULL);
+    gchar *contents;
+
+    if (g_file_get_contents(filename, &contents, NULL, NULL)) {
+      gchar *found = contents;
+
+      result = 0;
+      while ((found = strstr(found, "def config_start")) != NULL) {
+	gchar *p = found;
+
+	while (p > contents && (p[-1] == ' ' || p[-1] == '\t'))
+	  p--;
+	found += strlen("def config_start");
+	if ((p == contents || p[-1] == '\n')
+	    && (*found == '(' || *found == ' ')) {
+	  result = 1;
+	  break;
+	}
+      }
+      g_free(contents);
+    }
+    g_free(filename);
+  }
+
+  g_free(source_name);
+  g_strfreev (plugin_dirs);
+  return result;
+}
+
+/* Check that the board class of an imported module has a config_start
+ * method */
+static gboolean
+python_board_class_has_config(PyObject *module, const gchar *board_file_name)
+{
+  gchar *boardclass = g_strdup_printf("Gcompris_%s", board_file_name);
+  PyObject *py_boardclass;
+  gboolean has_config;
+
+  py_boardclass = PyDict_GetItemString(PyModule_GetDict(module), boardclass);
+  has_config = (py_boardclass &&
+		PyObject_HasAttrString( py_boardclass, "config_start"));
+
+  g_free(boardclass);
+  return has_config;
+}
+
+/* Once a board module is imported, fix the guess of its source scan */
+static void
+python_board_check_config(GcomprisBoard *board, PyObject *module)
+{
+  gboolean listed = (g_list_find(config_boards, board) != NULL);
+
+  if (python_board_class_has_config(module, strchr(board->type, ':')+1)) {
+    if (!listed)
+      config_boards = g_list_append(config_boards, board);
+  } else if (listed)
+    config_boards = g_list_remove(config_boards, board);
+}
+
 /* This loops over all the boards and for the python one
  * checks if they have a config method defined. If so
  * they are put in a list.
+ * The board sources are scanned, they are imported only if
+ * we have no source to look at.
  */
 static void
 init_config_boards()
@@ -175,222 +360,197 @@ init_config_boards()
   static gboolean called_once = FALSE;
   GList *python_boards;
   GList *list;
-  PyObject* globals;
-  static char *python_args[]={ "" };
-  static char* python_prog_name="gcompris";
-  char* boardclass;
   char* board_file_name;
-  PyObject* main_module;
-  char* boarddir;
-  GcomprisProperties *properties = gc_prop_get();
-  PyObject* module_dict;
-  PyObject* py_boardclass;
+  PyObject* module;
 
   if (called_once)
     return;
 
   called_once = TRUE;
 
-  if(!Py_IsInitialized()){
-    /* Initialize the python interpreter */
-    Py_SetProgramName(python_prog_name);
-    Py_Initialize();
+  if(!python_interpreter_init())
+    return;
 
-    PySys_SetArgv(1, python_args);
+  /* Get the list of python boards */
+  python_boards = get_pythonboards_list();
 
-    init_pygobject();
+  /* Search in the list each one with a config entry */
+  for(list = python_boards; list != NULL; list = list->next) {
+    GcomprisBoard *board = (GcomprisBoard *) list->data;
+    gint has_config;
 
-    main_module = PyImport_AddModule("__main__");
-    globals = PyModule_GetDict(main_module);
+    board_file_name = strchr(board->type, ':')+1;
 
-    if(globals==NULL){
-      g_print("Cannot get info from the python interpreter. Seems there is a problem with this one.\n");
-      return;
-    }
+    has_config = python_board_source_has_config(board_file_name);
 
-    /* Add the python plugins dir to the python's search path */
-    boarddir = get_pythonpath();
-    PyRun_SimpleString(boarddir);
-    g_free(boarddir);
+    if (has_config < 0) {
+      /* No source available (byte compiled only), import it */
+      has_config = 0;
 
-    /* Load the gcompris modules */
-    python_gcompris_module_init();
-  }
-  else {
-    main_module = PyImport_AddModule("__main__"); /* Borrowed reference */
-    globals = PyModule_GetDict(main_module); /* Borrowed reference */
+      module = python_board_module_get(board_file_name);
+      if(module!=NULL)
+	has_config = python_board_class_has_config(module, board_file_name);
+      else
+	PyErr_Clear();
+    }
+
+    if (has_config) {
+      config_boards = g_list_append(config_boards, board);
+      g_message("The board '%s' has a configuration entry",
+		board_file_name);
+    }
   }
 
+  /* The modules will be imported in the background
+   * once the menu is displayed */
+  preload_boards = python_boards;
+  pythonboard_preload_resume();
+}
 
-  /* Get the list of python boards */
-  python_boards = get_pythonboards_list();
+/*
+ * Import one pending python board per call. Runs at low priority and
+ * leaves the main loop in between, so that the drawing of the menu or
+ * an input event waits for one import at most.
+ */
+static gboolean
+pythonboard_preload_idle(gpointer data)
+{
+  GcomprisBoard *board;
+  PyObject *module;
 
-  /* Search in the list each one with a config entry */
-  for(list = python_boards; list != NULL; list = list->next) {
-    GcomprisBoard *board = (GcomprisBoard *) list->data;
+  if (preload_boards == NULL) {
+    preload_source_id = 0;
+    return FALSE;
+  }
 
-    /* Python is now initialized we create some usefull variables */
-    board_file_name = strchr(board->type, ':')+1;
-    boardclass = g_strdup_printf("Gcompris_%s", board_file_name);
+  /* Let the user go first */
+  if (gtk_events_pending())
+    return TRUE;
 
-    /* Test if board come with --python_plugin_dir option */
+  board = (GcomprisBoard *) preload_boards->data;
+  preload_boards = g_list_delete_link(preload_boards, preload_boards);
 
-    g_message("python_plugin_dir '%s' file_name '%s'",
-	      properties->package_python_plugin_dir,
-	      board_file_name);
+  module = python_board_module_get(strchr(board->type, ':')+1);
+  if (module == NULL) {
+    g_message("Python board '%s' failed to preload", board->type);
+    PyErr_Clear();
+  } else
+    python_board_check_config(board, module);
 
-    /* Insert the board module into the python's interpreter */
-    python_board_module = PyImport_ImportModuleEx(board_file_name,
-						  globals,
-						  globals,
-						  NULL);
+  if (preload_boards == NULL) {
+    preload_source_id = 0;
+    return FALSE;
+  }
 
-    if(python_board_module!=NULL){
-      /* Get the module dictionnary */
-      module_dict = PyModule_GetDict(python_board_module);
+  return TRUE;
+}
 
-      /* Get the python board class */
-      py_boardclass = PyDict_GetItemString(module_dict, boardclass);
+static void
+pythonboard_preload_resume(void)
+{
+  if (preload_boards && !preload_source_id)
+    preload_source_id = g_timeout_add_full(G_PRIORITY_LOW, PRELOAD_DELAY,
+					   pythonboard_preload_idle,
+					   NULL, NULL);
+}
 
-      if (PyObject_HasAttrString( py_boardclass, "config_start")) {
-	config_boards = g_list_append(config_boards, board);
-	g_message("The board '%s' has a configuration entry",
-		  board_file_name);
-      }
-    }
-    g_free(boardclass);
+static void
+pythonboard_preload_suspend(void)
+{
+  if (preload_source_id) {
+    g_source_remove(preload_source_id);
+    preload_source_id = 0;
   }
-  g_list_free(python_boards);
-
-  /* Finalize the python interpreter */
-  Py_Finalize();
 }
 
 static void
 pythonboard_init (GcomprisBoard *agcomprisBoard){
-  PyObject* main_module;
-  PyObject* globals;
   gchar* execstr;
 
   if (pythonboard_is_ready)
     return ;
 
   /* Initialize the python interpreter */
-  Py_Initialize();
+  pythonboard_is_ready = python_interpreter_init();
 
-  static char *python_args[]={ "" };
-  PySys_SetArgv( 1, python_args);
-
-  pythonboard_is_ready = TRUE;
-
-  main_module = PyImport_AddModule("__main__"); /* Borrowed reference */
-  globals = PyModule_GetDict(main_module); /* Borrowed reference */
-
-  if(globals==NULL){
-    g_warning("! Python disabled: Cannot get info from the python interpreter.\n");
-    pythonboard_is_ready = FALSE;
-  } else {
-    /* Add the python plugins dir to the python's search path */
-    execstr = get_pythonpath();
-
-    g_message("Executing %s\n", execstr);
+  if (pythonboard_is_ready) {
+    /* Try to import pygtk modules */
+    execstr = g_strdup("import gtk; import gtk.gdk");
     if(PyRun_SimpleString(execstr)!=0){
       pythonboard_is_ready = FALSE;
-      g_warning("! Python disabled: Cannot add plugins dir into search path\n");
+      g_warning("! Python disabled: Cannot import pygtk modules\n");
     } else {
-      /* Try to import pygtk modules */
+      /* Try to import gcompris modules */
       g_free(execstr);
-      execstr = g_strdup("import gtk; import gtk.gdk");
+      execstr = g_strdup("import gcompris; import gcompris.bonus; "
+			 "import gcompris.score; import gcompris.sound;"
+			 "import gcompris.skin; import gcompris.timer;"
+			 "import gcompris.utils; import gcompris.anim");
       if(PyRun_SimpleString(execstr)!=0){
 	pythonboard_is_ready = FALSE;
-	g_warning("! Python disabled: Cannot import pygtk modules\n");
-      } else {
-	/* Try to import gcompris modules */
-
-	/* Load the gcompris modules */
-	python_gcompris_module_init();
-
-	g_free(execstr);
-	execstr = g_strdup("import gcompris; import gcompris.bonus; "
-			   "import gcompris.score; import gcompris.sound;"
-			   "import gcompris.skin; import gcompris.timer;"
-			   "import gcompris.utils; import gcompris.anim");
-	if(PyRun_SimpleString(execstr)!=0){
-	  pythonboard_is_ready = FALSE;
-	  g_warning("! Python disabled: Cannot import gcompris modules\n");
-	}
+	g_warning("! Python disabled: Cannot import gcompris modules\n");
+      }
     }
     g_free(execstr);
-
   }
+}
 
-  /* Finalize the python interpreter */
-  Py_Finalize();
+static void
+python_module_cache_release(gpointer key, gpointer value, gpointer data)
+{
+  Py_XDECREF((PyObject *) value);
+}
 
+/*
+ * Called when gcompris exit
+ */
+static void
+pythonboard_cleanup (void){
+  pythonboard_preload_suspend();
+  g_list_free(preload_boards);
+  preload_boards = NULL;
+
+  if (python_module_cache) {
+    g_hash_table_foreach(python_module_cache, python_module_cache_release, NULL);
+    g_hash_table_destroy(python_module_cache);
+    python_module_cache = NULL;
+    /* Py_Finalize() is not called, it makes gcompris crash once boards
+     * using pygtk were started. The process exits anyway. */
   }
 }
 
 /*
  * Start the board.
  * In this case:
- * - initialize python interpreter
- * - import gcompris functions/objects
- * - import gtk/gnome functions/objects
- * - load the python written board
+ * - make sure the python interpreter is initialized
+ * - load the python written board (from our module cache if possible)
  * - call the board start function
  */
 static void
 pythonboard_start (GcomprisBoard *agcomprisBoard){
-  PyObject* main_module;
   PyObject* py_function_result;
   PyObject* module_dict;
   PyObject* py_boardclass;
   PyObject* py_boardclass_args;
-  PyObject* globals;
-  static char *python_args[]={ "" };
-  static char* python_prog_name="gcompris";
-  char* boarddir;
   char* boardclass;
   char* board_file_name;
 
   if(agcomprisBoard!=NULL){
-    /* Initialize the python interpreter */
-    Py_SetProgramName(python_prog_name);
-    Py_Initialize();
-
-    PySys_SetArgv(1, python_args);
-
-    init_pygobject();
-
-    main_module = PyImport_AddModule("__main__");
-    globals = PyModule_GetDict(main_module);
-
-    if(globals==NULL){
+    if(!python_interpreter_init()){
       g_print("Cannot get info from the python interpreter. Seems there is a problem with this one.\n");
       return;
     } else {
       gcomprisBoard = agcomprisBoard;
     }
 
-    /* Add the python plugins dir to the python's search path */
-    boarddir = get_pythonpath();
-
-    PyRun_SimpleString(boarddir);
-    g_free(boarddir);
-
-
-    /* Load the gcompris modules */
-    python_gcompris_module_init();
+    /* Do not compete with the board for the main loop */
+    pythonboard_preload_suspend();
 
     /* Python is now initialized we create some usefull variables */
     board_file_name = strchr(agcomprisBoard->type, ':')+1;
     boardclass = g_strdup_printf("Gcompris_%s", board_file_name);
 
-    /* Insert the board module into the python's interpreter */
-    python_board_module = PyImport_ImportModuleEx(board_file_name,
- 						  globals,
- 						  globals,
- 						  NULL);
+    python_board_module = python_board_module_get(board_file_name);
 
     if(python_board_module!=NULL){
       /* Get the module dictionnary */
@@ -442,7 +602,7 @@ static void pythonboard_pause (gboolean pause){
  * End the board.
  * In this case:
  * - call the board end function
- * - finalise python interpreter
+ * - the python interpreter is kept alive for the next board
  */
 static void pythonboard_end (void){
   PyObject* result = NULL;
@@ -454,13 +614,17 @@ static void pythonboard_end (void){
     } else {
       Py_DECREF(result);
     }
-    Py_XDECREF(python_board_module);
+    /* The module is owned by our cache */
+    python_board_module = NULL;
     Py_XDECREF(python_board_instance);
     Py_XDECREF(python_gcomprisBoard);
-    //FIXME: COMMENTED BECAUSE THIS MAKES GCOMPRIS CRASHES AFTER ENTERING/EXITING
-    //       ANY PHYTHON PLUGIN LESS THAN 10 TIMES
-    //Py_Finalize();
+    python_board_instance = NULL;
+    python_gcomprisBoard = NULL;
+    gcomprisBoard = NULL;
   }
+
+  /* Back to the menu, go on with the background imports */
+  pythonboard_preload_resume();
 }
 
 /*
@@ -567,20 +731,10 @@ static void pythonboard_repeat (void){
 /*
  * Start the board config_start.
  * In this case:
- * - initialize python interpreter
- * - import gcompris functions/objects
- * - import gtk/gnome functions/objects
- * - load the python written board
- * - call the board start function
- */
-
-/*
- * Normally python in already running when config_start is called.
- * If not config_stop has to stop it.
+ * - make sure the python interpreter is initialized
+ * - load the python written board (from our module cache if possible)
+ * - call the board config_start function
  */
-
-static gboolean python_run_by_config = FALSE;
-
 static void
 pythongc_board_config_start (GcomprisBoard *agcomprisBoard,
 			  GcomprisProfile *aProfile
@@ -590,60 +744,23 @@ pythongc_board_config_start (GcomprisBoard *agcomprisBoard,
   PyObject* module_dict;
   PyObject* py_boardclass;
   PyObject* py_boardclass_args;
-  PyObject* globals;
-  static char *python_args[]={ "" };
-  static char* python_prog_name="gcompris";
   char* boardclass;
   char* board_file_name;
-  PyObject* main_module;
-  char* boarddir;
 
   g_assert (agcomprisBoard != NULL);
 
-  if(!Py_IsInitialized()){
-    /* Initialize the python interpreter */
-    Py_SetProgramName(python_prog_name);
-    Py_Initialize();
-
-    PySys_SetArgv(1, python_args);
-
-    init_pygobject();
-
-    main_module = PyImport_AddModule("__main__");
-    globals = PyModule_GetDict(main_module);
-
-    if(globals==NULL){
-      g_print("Cannot get info from the python interpreter. Seems there is a problem with this one.\n");
-      return;
-    } else {
-      gcomprisBoard_config = agcomprisBoard;
-    }
-
-    boarddir = get_pythonpath();
-
-    PyRun_SimpleString(boarddir);
-    g_free(boarddir);
-
-    /* Load the gcompris modules */
-    python_gcompris_module_init();
-
-    python_run_by_config = TRUE;
-
-  }
-  else {
-    main_module = PyImport_AddModule("__main__"); /* Borrowed reference */
-    globals = PyModule_GetDict(main_module); /* Borrowed reference */
+  if(!python_interpreter_init()){
+    g_print("Cannot get info from the python interpreter. Seems there is a problem with this one.\n");
+    return;
   }
 
+  gcomprisBoard_config = agcomprisBoard;
+
   /* Python is now initialized we create some usefull variables */
   board_file_name = strchr(agcomprisBoard->type, ':')+1;
   boardclass = g_strdup_printf("Gcompris_%s", board_file_name);
 
-  /* Insert the board module into the python's interpreter */
-  python_board_config_module = PyImport_ImportModuleEx(board_file_name,
-						       globals,
-						       globals,
-						       NULL);
+  python_board_config_module = python_board_module_get(board_file_name);
 
   if(python_board_config_module!=NULL){
     /* Get the module dictionnary */
@@ -679,10 +796,10 @@ pythongc_board_config_start (GcomprisBoard *agcomprisBoard,
 }
 
 /*
- * End the board.
+ * End the board config.
  * In this case:
- * - call the board end function
- * - finalise python interpreter
+ * - call the board config_stop function
+ * - the python interpreter is kept alive for the next board
  */
 static void pythongc_board_config_stop (void){
   PyObject* result = NULL;
@@ -694,12 +811,11 @@ static void pythongc_board_config_stop (void){
     } else {
       Py_DECREF(result);
     }
-    Py_XDECREF(python_board_config_module);
+    /* The module is owned by our cache */
+    python_board_config_module = NULL;
     Py_XDECREF(python_board_config_instance);
     Py_XDECREF(python_gcomprisBoard_config);
-    if (python_run_by_config){
-      Py_Finalize();
-      python_run_by_config = FALSE;
-    }
+    python_board_config_instance = NULL;
+    python_gcomprisBoard_config = NULL;
   }
 }
@@ -0,0 +1 @@
+from _gcompris_connect4 import *
@@ -0,0 +1 @@
+from _gcompris_sudoku import *
@@ -201,10 +201,14 @@ static void start_board (GcomprisBoard *agcomprisBoard)
       gcomprisBoard->sublevel=1;
 
       carriage_svg_handle = gc_rsvg_load("click_on_letter/carriage.svgz");
+      goo_canvas_svg_lock ();
       rsvg_handle_get_dimensions (carriage_svg_handle, &carriage_svg_dimension);
+      goo_canvas_svg_unlock ();
 
       cloud_svg_handle = gc_rsvg_load("click_on_letter/cloud.svgz");
+      goo_canvas_svg_lock ();
       rsvg_handle_get_dimensions (cloud_svg_handle, &cloud_svg_dimension);
+      goo_canvas_svg_unlock ();
 
       if(ready)
 	{
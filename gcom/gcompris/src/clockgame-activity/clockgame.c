@@ -283,7 +283,7 @@ static void display_hour(guint hour)
 {
   double needle_size = clock_size*0.70;
   double ang;
-  GooCanvasPoints *canvasPoints;
+  gdouble coords[4];
 
   if(hour_item==NULL)
     return;
@@ -293,14 +293,13 @@ static void display_hour(guint hour)
   ang += currentTime.minute * M_PI / 360;
   ang += currentTime.second * M_PI / 21600;
 
-  canvasPoints = goo_canvas_points_new (2);
-  canvasPoints->coords[0]=cx;
-  canvasPoints->coords[1]=cy;
-  canvasPoints->coords[2]=cx + needle_size * sin(ang);
-  canvasPoints->coords[3]=cy - needle_size * cos(ang);
+  coords[0]=cx;
+  coords[1]=cy;
+  coords[2]=cx + needle_size * sin(ang);
+  coords[3]=cy - needle_size * cos(ang);
   double w = 4.0;
+  goo_canvas_polyline_set_coords(GOO_CANVAS_POLYLINE(hour_item), coords, 2);
   g_object_set (hour_item,
-		"points", canvasPoints,
 		"stroke-color", "darkblue",
 		"line-width", w,
 		"end-arrow", TRUE,
@@ -308,7 +307,6 @@ static void display_hour(guint hour)
 		"arrow-length", 4.0,
 		"arrow-width", 4.0,
 		NULL);
-  goo_canvas_points_unref(canvasPoints);
 
   currentTime.hour=hour;
   display_digital_time(digital_time_item, &currentTime);
@@ -318,7 +316,7 @@ static void display_minute(guint minute)
 {
   double needle_size = clock_size;
   double ang;
-  GooCanvasPoints *canvasPoints;
+  gdouble coords[4];
 
   if(minute_item==NULL)
     return;
@@ -326,14 +324,13 @@ static void display_minute(guint minute)
   ang = minute * M_PI / 30;
   ang += currentTime.second * M_PI / 1800;
 
-  canvasPoints = goo_canvas_points_new (2);
-  canvasPoints->coords[0]=cx;
-  canvasPoints->coords[1]=cy;
-  canvasPoints->coords[2]=cx + needle_size * sin(ang);
-  canvasPoints->coords[3]=cy - needle_size * cos(ang);
+  coords[0]=cx;
+  coords[1]=cy;
+  coords[2]=cx + needle_size * sin(ang);
+  coords[3]=cy - needle_size * cos(ang);
   double w = 4.0;
+  goo_canvas_polyline_set_coords(GOO_CANVAS_POLYLINE(minute_item), coords, 2);
   g_object_set (minute_item,
-		"points", canvasPoints,
 		"stroke-color", "red",
 		"line-width", w,
 		"end-arrow", TRUE,
@@ -341,7 +338,6 @@ static void display_minute(guint minute)
 		"arrow-length", (double) 4.0,
 		"arrow-width", (double) 3.0,
 		NULL);
-  goo_canvas_points_unref(canvasPoints);
 
   currentTime.minute=minute;
   display_digital_time(digital_time_item, &currentTime);
@@ -351,7 +347,7 @@ static void display_second(guint second)
 {
   double needle_size = clock_size;
   double ang;
-  GooCanvasPoints *canvasPoints;
+  gdouble coords[4];
 
   /* No seconds at first levels */
   if(second_item==NULL || gcomprisBoard->level<=2)
@@ -359,17 +355,15 @@ static void display_second(guint second)
 
   ang = second * M_PI / 30;
 
-  canvasPoints = goo_canvas_points_new (2);
-  canvasPoints->coords[0]=cx;
-  canvasPoints->coords[1]=cy;
-  canvasPoints->coords[2]=cx + needle_size * sin(ang);
-  canvasPoints->coords[3]=cy - needle_size * cos(ang);
+  coords[0]=cx;
+  coords[1]=cy;
+  coords[2]=cx + needle_size * sin(ang);
+  coords[3]=cy - needle_size * cos(ang);
+  goo_canvas_polyline_set_coords(GOO_CANVAS_POLYLINE(second_item), coords, 2);
   g_object_set (second_item,
-		"points", canvasPoints,
 		"stroke-color-rgba", 0x68c46fFF,
 		"line-width", 4.0,
 		NULL);
-  goo_canvas_points_unref(canvasPoints);
 
   currentTime.second=second;
   display_digital_time(digital_time_item, &currentTime);
@@ -39,130 +39,39 @@
 # This software is licensed under the GPL - General Public License      #
 #########################################################################
 
-import rules
+import gcompris.connect4
 from player import *
 from random import *
-import copy
-from board import *
-
-class Node:
-  def __init__(self, board, move, player):
-    self.board = board
-    #self.parent = parent
-    self.value = 0
-    self.childs = []
-    self.move = move
-    self.player = player
-
-  def __repr__(self):
-    if self.childs > 1:
-      number=0
-      for child in self.childs:
-        number=number+1
-      return "Has %s child(s)" % number
-    return "STATE"
 
 class MinMax(Player):
   type = 'AI'
 
+  # Search depth of each difficulty level. The search stops after
+  # search_time milliseconds anyway, the deepest levels are played
+  # as deep as this allows.
+  depths = (1, 3, 5, 42)
+  search_time = 40
+
   def __init__(self, difficulty, f):
-    self.search_depth = difficulty
+    self.engine = gcompris.connect4.Engine()
+    self.setDifficulty(difficulty)
     self.f = f
 
   def setDifficulty(self, difficulty):
-    self.search_depth = difficulty
-
-  def evaluate(self, node, player, opponent, depth):
-    if len(node.childs) > 0:
-      list = []
-      for child in node.childs:
-        list.append(child.value)
-      if node.player != player:
-        node.value = min(list)
-        #print 'min =', node.value,
-      else:
-        node.value = max(list)
-        #print 'max =', node.value,
-
-    else:
-      node.value = self.score(node, player, opponent)  / (depth + 1)
-
-  def score(self, node, player, opponent):
-    return int(random() * 100) - 50
-
-
-  def makeBoard(self, move, board, player):
-    temp_board = copy.deepcopy(board)
-    temp_board.move(move, player)
-    return temp_board
-
-  def listMoves(self, board, player):
-    checkmove = rules.isMoveLegal
-
-    options = []
-    for move in range(7):
-      if checkmove(board, move):
-        options.append(move)
-    return options
-
-  def statespace(self, node, depth, current_player, player, opponent):
-    self.f()
-    if rules.isWinner(node.board, opponent):
-      #print "a lose up ahead"
-      node.value = -10000 + depth
-      return node
-    elif rules.isWinner(node.board, player):
-      node.value = 10000 - depth
-      return node
-
-    elif self.listMoves(node.board, 0) < 1:
-      self.evaluate(node, player, opponent, depth)
-      return node
-    elif depth < self.search_depth:
-      if current_player==2:
-        next_player = 1
-      else:
-        next_player = 2
-      for move in self.listMoves(node.board, current_player):
-        node.board.move(move, current_player)
-
-        node.childs.append(self.statespace(Node( node.board, move, next_player), depth+1, next_player, player, opponent))
-        node.board.undomove(move)
-    self.evaluate(node, player, opponent, depth)
-    #print 'v=%d p=%d' %(node.value,node.player)
-    return node
-
+    self.search_depth = self.depths[max(0, min(difficulty, len(self.depths)) - 1)]
 
   def doMove(self, current_board, player, event):
-    board = copy.deepcopy(current_board)
-
-    if player == 1: opponent = 2
-    else: opponent = 1
-
-    node = Node(board, 0, player)
-
-    node =  self.statespace( node, 0, player, player, opponent);
+    scores = self.engine.search(current_board.state, player,
+                                self.search_depth, self.search_time)
 
-    bestscore = -100000
+    bestscore = max(scores)
     best_moves = []
-    #print "New Round"
-    for child in node.childs:
-      #print "Child value=", child.value, "move=", child.board.last_move
-      if child.value >= bestscore:
-        #if rules.isMoveLegal(board, child.board.last_move):
-        if bestscore == child.value:
-          #print "Move added"
-          best_moves.append(child.move)
-        else:
-          #print "New best move"
-          bestscore = child.value
-          best_moves = [child.move]
+    for move in range(len(scores)):
+      if scores[move] != None and scores[move] == bestscore:
+        best_moves.append(move)
+    if not best_moves:
+      return None
     return best_moves[int(random()*len(best_moves))]
 
   def gameOver(self, move):
     return None
-#try:
-#  psyco.bind(MinMax)
-#  psyco.bind(Node)
-#except:
-#  pass
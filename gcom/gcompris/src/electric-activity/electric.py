@@ -22,12 +22,11 @@ import gcompris.utils
 import gcompris.skin
 import gcompris.admin
 import gcompris.bonus
+import gcompris.electric
 import gtk
 import gtk.gdk
 import gobject
 import cairo
-import os
-import tempfile
 
 # Set to True to debug
 debug = False
@@ -58,10 +57,10 @@ class Gcompris_electric:
 
     # The list of placed components
     self.components = []
-    self.gnucap_timer = 0
-    self.gnucap_timer_interval = 500
+    self.simulation_idle = 0
 
-    self.gnucap_binary = None
+    # The circuit solver, it keeps the state of the last simulation
+    self.circuit = gcompris.electric.Circuit()
 
   def start(self):
 
@@ -80,26 +79,6 @@ class Gcompris_electric:
 
     self.display_game()
 
-    #
-    # Check gnucap is installed and save it's path in self.gnucap_binary
-    #
-    # You can provide a gnucap binary in python_plugin_dir.
-    #
-    for binary in (os.environ.get('GNUCAP', ''),
-                   "gnucap.exe",
-                   os.path.join(gcompris.PYTHON_PLUGIN_DIR, 'bin', 'gnucap'),
-                   "/usr/bin/gnucap",
-                   "/usr/local/bin/gnucap",
-		   os.path.join(gcompris.DATA_DIR, '..' , '..', '..', 'bin', 'gnucap')):
-      if(os.path.exists(binary)):
-        self.gnucap_binary = binary
-        break
-
-    if not self.gnucap_binary:
-      gcompris.utils.dialog(_("Cannot find the 'gnucap' electric simulator.\nYou can download and install it from:\n<http://geda.seul.org/tools/gnucap/>\nTo be detected, it must be installed in\n/usr/bin/gnucap or /usr/local/bin/gnucap.\nYou can still use this activity to draw schematics without computer simulation."),
-                            None)
-
-
   def end(self):
 
     gcompris.set_cursor(gcompris.CURSOR_DEFAULT);
@@ -177,9 +156,9 @@ class Gcompris_electric:
   def cleanup_game(self):
     self.gamewon = False
 
-    if self.gnucap_timer :
-      gobject.source_remove(self.gnucap_timer)
-      self.gnucap_timer = 0
+    if self.simulation_idle :
+      gobject.source_remove(self.simulation_idle)
+      self.simulation_idle = 0
 
     # remove the appended items from our tools
     for i in range(0,len(self.tools)):
@@ -301,47 +280,36 @@ class Gcompris_electric:
 # ----------------------------------------------------------------------
 # ----------------------------------------------------------------------
 
+  # Any change in the schematic calls us. The simulation runs once
+  # the current event is processed so that the component callbacks
+  # can trigger a new simulation safely.
   def run_simulation(self):
-    if debug: print "run_simulation %s" %(self.gnucap_binary,)
-    if not self.gnucap_binary:
-      return
+    if debug: print "self.simulation_idle = %d" %(self.simulation_idle,)
+    if not self.simulation_idle:
+      self.simulation_idle = gobject.idle_add(self.simulate)
 
-    if debug: print "self.gnucap_timer = %d" %(self.gnucap_timer,)
-    if not self.gnucap_timer:
-      if debug: print "run_simulation timeout_add"
-      self.gnucap_timer = gobject.timeout_add(self.gnucap_timer_interval, self.call_gnucap)
+  def simulate(self):
+    self.simulation_idle = 0
 
-  def call_gnucap(self):
     if not self.components:
-      if debug: print "call_gnucap: No component"
-      self.gnucap_timer = 0
-      return
-
-    connected = False
-    for component in self.components:
-      if component.is_connected():
-        connected = True
-
-    if debug: print "call_gnucap create the tempfile"
-
-    fd, filename = tempfile.mkstemp(".gnucap", "gcompris_electric", None, True)
-    f = os.fdopen(fd, "w+t")
+      if debug: print "simulate: No component"
+      return False
 
     gnucap = "Title GCompris\n"
 
     # Ugly hack: connect a 0 ohm (1 fempto) resistor between net 0
     # and first net found
-    gnucap += "R999999999 0 "
     found = False
     for component in self.components:
       if component.is_connected():
         for node in component.get_nodes():
           if(node.get_wires()):
+            gnucap += "R999999999 0 "
             gnucap += str(node.get_wires()[0].get_wire_id())
+            gnucap += " 1f\n"
             found = True
             break
       if found: break
-    gnucap += " 1f\n"
 
     gnucap_print = ""
     for component in self.components:
@@ -354,43 +322,12 @@ class Gcompris_electric:
     gnucap += ".dc\n"
     gnucap += ".end\n"
     if debug: print gnucap
-    f.writelines(gnucap)
-    f.close()
 
-    #
-    # Run gnucap with the temporary datafile we created.
-    #
-    if debug: print "calling gnucap: %s -b %s" % (self.gnucap_binary, filename)
-    output = os.popen("%s -b %s" % (self.gnucap_binary, filename))
-
-    #
-    # Read and analyse gnucap result
-    #
-    if debug: print "---------------- GNUCAP OUTPUT PARSING ---------------------"
-    line = ""
-    for line in output.readlines():
-      if debug: print "==="
-      if debug: print line
-      if(line.split() == " 0."):
-        break
-    if debug: print "------------------------------------------------------------"
-
-    if debug: print "===>"
-    if debug: print line
-    if debug: print "===>"
-
-    # Close it to check errors
-    results = output.close()
-    if results:
-      print('Failed to run gnugap with error ', results)
-      self.gnucap_timer = 0
-      return
-
-    values = []
-    if(line.split()[0] == "0."):
-      if debug: print "FOUND 0."
-      values = line.split()
-      del values[0]
+    try:
+      values = self.circuit.solve(gnucap)
+    except (ValueError, RuntimeError), e:
+      print('Failed to simulate the circuit: %s' %(e,))
+      return False
 
     if debug: print values
     i = 0
@@ -405,76 +342,20 @@ class Gcompris_electric:
         done = False
         while not done:
           if debug: print "Processing component %d" %(i,)
-          try:
-            if debug: print values[i]
-            if debug: print values[i+1]
-            dumy = values[i]
-            dumy = values[i+1]
-          except:
-            if debug: print "Warning: gnucap parsing mismatch"
+          if i + 1 >= len(values):
+            if debug: print "Warning: simulation result mismatch"
             done = True
             continue
 
-          try:
-            volt = self.convert_gnucap_value(values[i])
-            amp = self.convert_gnucap_value(values[i+1])
-            done = component.set_voltage_intensity(True, volt, amp)
-            if debug: print "Converted U=%sV I=%sA" %(volt, amp)
-          except:
-            if debug: print "Failed to convert V=%sV I=%sA" %(values[i], values[i+1])
-            done = component.set_voltage_intensity(False, 0.0, 0.0)
+          # Report absolute values like the components expect
+          volt = abs(values[i])
+          amp = abs(values[i+1])
+          done = component.set_voltage_intensity(True, volt, amp)
+          if debug: print "U=%sV I=%sA" %(volt, amp)
 
           i += 2
 
-
-    if not debug: os.remove(filename)
-    self.gnucap_timer = 0
-
-  # Convert a gnucap value back in a regular number
-  # Return a float value
-  # Or a ValueError exception
-  def convert_gnucap_value(self, value):
-    unit = 1
-
-    if value.endswith("T"):
-      unit = e12
-      value = value.replace("T", "")
-
-    if value.endswith("G"):
-      unit = 1e9
-      value = value.replace("G", "")
-
-    if value.endswith("Meg"):
-      unit = 1e6
-      value = value.replace("Meg", "")
-
-    if value.endswith("K"):
-      unit = 1e3
-      value = value.replace("K", "")
-
-    if value.endswith("u"):
-      unit = 1e-6
-      value = value.replace("u", "")
-
-    if value.endswith("n"):
-      unit = 1e-9
-      value = value.replace("n", "")
-
-    if value.endswith("p"):
-      unit = 1e-12
-      value = value.replace("p", "")
-
-    if value.endswith("f"):
-      unit = 1e-15
-      value = value.replace("f", "")
-
-    # return absolue value
-    sign = 1
-    if float(value) < 0:
-      sign = -1
-
-    return (float(sign)*float(value)*unit)
-
+    return False
 
 
 
@@ -368,7 +368,9 @@ static void add_one_item(int i, int j, int protect)
 	goo_canvas_svg_new (boardRootItem,
 			  CoverPixmap[current_layer],
 			  NULL);
+      goo_canvas_svg_lock();
       rsvg_handle_get_dimensions(CoverPixmap[current_layer], &dimension);
+      goo_canvas_svg_unlock();
       double scale = h/dimension.height;
       goo_canvas_item_set_simple_transform(item,
 					   i,
@@ -26,6 +26,7 @@
 static struct BoardPluginData *bp_data;
 
 static gboolean	 get_board_playing(void);
+static void	 board_prefetch_next(GcomprisBoard *gcomprisBoard);
 
 #ifdef ACTIVATION_CODE
 int gc_activation_check(char *code);
@@ -153,6 +154,35 @@ void gc_board_init(void)
 }
 #endif
 
+/*
+ * Called when gcompris exit, after the current board is stopped
+ */
+void gc_board_cleanup(void)
+{
+  BoardPlugin *bp;
+#ifdef STATIC_MODULE
+  guint i = 0;
+#endif
+
+  if (! bp_data)
+    return;
+
+#ifdef STATIC_MODULE
+  while(static_boards[i] != NULL) {
+    bp = (BoardPlugin *) static_boards[i++];
+    if(bp->cleanup != NULL)
+      bp->cleanup();
+  }
+#else
+  while(bp_data->init_plugins) {
+    bp = (BoardPlugin *) bp_data->init_plugins->data;
+    bp_data->init_plugins = g_list_delete_link(bp_data->init_plugins,
+					       bp_data->init_plugins);
+    bp->cleanup();
+  }
+#endif
+}
+
 BoardPlugin *gc_board_get_current_board_plugin(void)
 {
   if (! bp_data)
@@ -276,6 +306,10 @@ gc_board_check_file(GcomprisBoard *gcomprisBoard)
 	bp->init(gcomprisBoard);
       }
 
+      if(bp->cleanup != NULL
+	 && !g_list_find(bp_data->init_plugins, bp))
+	bp_data->init_plugins = g_list_prepend(bp_data->init_plugins, bp);
+
       if(bp->is_our_board(gcomprisBoard)) {
 	/* Great, we found our plugin */
 	g_message("We found the correct plugin for board %s (type=%s)\n", gcomprisBoard->name, gcomprisBoard->type);
@@ -304,6 +338,36 @@ gc_board_check_file(GcomprisBoard *gcomprisBoard)
 }
 #endif
 
+/* Fetch the files of the board about to start from the server first.
+ * While it is played, fetch the other boards of its menu, starting with
+ * the ones that follow it */
+static void
+board_prefetch_next(GcomprisBoard *gcomprisBoard)
+{
+  GList *list, *item, *boards;
+
+  if(!gc_prop_get()->server)
+    return;
+
+  gc_net_want_board(gcomprisBoard);
+
+  if(!gcomprisBoard->section)
+    return;
+
+  list = gc_menu_getlist(gcomprisBoard->section);
+  item = g_list_find(list, gcomprisBoard);
+  if(item)
+    {
+      /* The boards after this one, then the ones before it */
+      boards = g_list_copy(item->next);
+      for(; list != item; list = g_list_delete_link(list, list))
+	boards = g_list_append(boards, list->data);
+      gc_net_prefetch_boards(boards);
+      g_list_free(boards);
+    }
+  g_list_free(list);
+}
+
 void
 gc_board_play(GcomprisBoard *gcomprisBoard)
 {
@@ -321,6 +385,8 @@ gc_board_play(GcomprisBoard *gcomprisBoard)
       bp = gcomprisBoard->plugin;
       gc_board_set_current(gcomprisBoard);
 
+      board_prefetch_next(gcomprisBoard);
+
       gc_activity_intro_play(gcomprisBoard);
 
       bp->start_board(gcomprisBoard);
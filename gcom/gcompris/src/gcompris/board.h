@@ -53,9 +53,11 @@ struct BoardPluginData
 {
   GcomprisBoard	*current_gcompris_board;
   gboolean	 playing;
+  GList		*init_plugins;	/* The plugins to clean up on exit */
 };
 
 void		 gc_board_init(void);
+void		 gc_board_cleanup(void);
 BoardPlugin	*gc_board_get_current_board_plugin(void);
 GcomprisBoard	*gc_board_get_current(void);
 void		 gc_board_set_current(GcomprisBoard * gcomprisBoard);
@@ -31,7 +31,6 @@ typedef struct {
 static void _combo_level_changed(GtkComboBox *combo_level, gpointer user_data)
 {
 	LevelWordlist *lw;
-	GSList *list;
 	gchar **wordsArray, *text;
 	guint level;
 	int i;
@@ -48,13 +47,10 @@ static void _combo_level_changed(GtkComboBox *combo_level, gpointer user_data)
 		return;
 	}
 
-	wordsArray = g_malloc0(sizeof(gpointer)*(g_slist_length(lw->words)+1));
+	wordsArray = g_malloc0(sizeof(gpointer)*(lw->n_words+1));
 
-	for(i=0, list = lw->words; list; list=list->next)
-	{
-		wordsArray[i]=(gchar*)list->data;
-		i++;
-	}
+	for(i=0; i < lw->n_words; i++)
+		wordsArray[i]=(gchar*)gc_wordlist_get_word(lw, i);
 	text = g_strjoinv(" ", wordsArray);
 	g_free(wordsArray);
 
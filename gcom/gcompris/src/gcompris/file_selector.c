@@ -74,6 +74,9 @@ static guint32 control_area_x1;
 static guint32 control_area_y1;
 static guint32 directory_label_y;
 
+/* The skin ids looked up for each file */
+static GQuark fileselect_col_quark = 0;
+
 /* Represent the limits of the file area */
 #define	DRAWING_AREA_X1	40.0
 #define DRAWING_AREA_Y1	130.0
@@ -169,6 +172,7 @@ display_file_selector(int the_mode,
   control_area_x1   = gc_skin_get_number_default("gcompris/fileselectx", 85);
   control_area_y1   = gc_skin_get_number_default("gcompris/fileselecty", 80);
   directory_label_y = gc_skin_get_number_default("gcompris/fileselectdiry", 180);
+  fileselect_col_quark = g_quark_from_static_string("gcompris/fileselectcol");
 
   if(rootitem)
     return 0;
@@ -376,7 +380,7 @@ display_files(GooCanvasItem *root_item, gchar *rootdir)
 			      GTK_ANCHOR_NW,
 			      "font", "Sans 7",
 			      "fill-color-rgba",
-			      gc_skin_get_color("gcompris/fileselectcol"),
+			      gc_skin_get_color_q(fileselect_col_quark),
 			      NULL);
 
   /* Insert all files in a sorted list */
@@ -466,7 +470,7 @@ display_files(GooCanvasItem *root_item, gchar *rootdir)
 				 GTK_ANCHOR_CENTER,
 				 "font", "Sans 6",
 				 "fill-color-rgba",
-				 gc_skin_get_color("gcompris/fileselectcol"),
+				 gc_skin_get_color_q(fileselect_col_quark),
 				 NULL);
 	  g_signal_connect(_item, "button_press_event",
 			   (GCallback) item_event_file_selector,
@@ -483,7 +487,7 @@ display_files(GooCanvasItem *root_item, gchar *rootdir)
 			     -1,
 			     GTK_ANCHOR_CENTER,
 			     "font", "Sans 7",
-			     "fill-color-rgba", gc_skin_get_color("gcompris/fileselectcol"),
+			     "fill-color-rgba", gc_skin_get_color_q(fileselect_col_quark),
 			     NULL);
       g_free(file_wo_ext);
       g_free(filename);
@@ -83,11 +83,13 @@ GdkPixbuf *gc_pixmap_load_or_null(const gchar *format, ...)
   pixmapfile = g_strdup_vprintf (format, args);
   va_end (args);
 
-  /* Search */
+  /* Search, the loose files override the boards data archive */
   filename = gc_file_find_absolute(pixmapfile);
 
   if(filename)
      pixmap = gdk_pixbuf_new_from_file(filename,NULL);
+  else if((filename = gc_pack_find("%s", pixmapfile)))
+     pixmap = gc_pack_pixbuf_load(filename);
 
   g_free(pixmapfile);
   g_free(filename);
@@ -124,6 +126,8 @@ GdkPixbuf *gc_pixmap_load(const gchar *format, ...)
 
   if(filename)
     pixmap = gc_pixmap_load_or_null(filename);
+  else if((filename = gc_pack_find("%s", pixmapfile)))
+    pixmap = gc_pack_pixbuf_load(filename);
 
   if (!filename || !pixmap)
     {
@@ -177,11 +181,13 @@ RsvgHandle *gc_rsvg_load(const gchar *format, ...)
   rsvghandlefile = g_strdup_vprintf (format, args);
   va_end (args);
 
-  /* Search */
+  /* Search, the loose files override the boards data archive */
   filename = gc_file_find_absolute(rsvghandlefile);
 
   if(filename)
     rsvghandle = rsvg_handle_new_from_file (filename, &error);
+  else if((filename = gc_pack_find("%s", rsvghandlefile)))
+    rsvghandle = gc_pack_rsvg_load(filename);
 
   if (!filename || !rsvghandle)
     {
@@ -403,11 +409,19 @@ gchar *reactivate_newline(char *str)
 /* Any previous transformation are reseted first. */
 void gc_item_absolute_move(GooCanvasItem *item, int x, int y)
 {
+  GooCanvas *canvas = goo_canvas_item_get_canvas(item);
   GooCanvasBounds bounds;
 
+  /* Invalidate the areas to redraw at once */
+  if(canvas)
+    goo_canvas_begin_batch(canvas);
+
   goo_canvas_item_set_transform(item, NULL);
   goo_canvas_item_get_bounds(item, &bounds);
   goo_canvas_item_translate(item, ((double)x)-bounds.x1, ((double)y)-bounds.y1);
+
+  if(canvas)
+    goo_canvas_end_batch(canvas);
 }
 
 /* ======================================= */
@@ -483,11 +497,19 @@ gc_item_rotate_relative(GooCanvasItem *item, double angle)
 void
 gc_item_rotate_with_center(GooCanvasItem *item, double angle, int x, int y)
 {
+  GooCanvas *canvas = goo_canvas_item_get_canvas(item);
   GooCanvasBounds bounds;
 
+  /* Invalidate the areas to redraw at once */
+  if(canvas)
+    goo_canvas_begin_batch(canvas);
+
   goo_canvas_item_set_transform(item, NULL);
   goo_canvas_item_get_bounds( item, &bounds );
   goo_canvas_item_rotate(item, angle, bounds.x1+x, bounds.y1+y);
+
+  if(canvas)
+    goo_canvas_end_batch(canvas);
 }
 
 /** rotates an item around the center (x,y), relative to the widget's coordinates
@@ -541,6 +563,24 @@ gchar *g_utf8_strndup(gchar* utf8text, gint n)
   return result;
 }
 
+/* Return the absolute filename of file if it is in dir, the empty dir
+ * being the server whose files are in the network cache */
+static gchar *
+file_find_in_dir(const gchar *dir, const gchar *file)
+{
+  gchar *absolute_filename;
+
+  if(dir[0] == '\0')
+    return gc_net_get_url_from_file("%s", file);
+
+  absolute_filename = g_strdup_printf("%s/%s", dir, file);
+  if(g_file_test (absolute_filename, G_FILE_TEST_EXISTS))
+    return absolute_filename;
+
+  g_free(absolute_filename);
+  return NULL;
+}
+
 /** \brief search a given relative file in all gcompris dir it could be found
  *
  * \param format: If format contains $LOCALE, it will be first replaced by the current long locale
@@ -597,9 +637,8 @@ gc_file_find_absolute(const gchar *format, ...)
       if(g_strv_length(filesplit) == 1)
 	{
 	  g_strfreev(filesplit);
-	  absolute_filename = \
-	    g_strdup_printf("%s/%s", dir_to_search[i], filename);
-	  if(g_file_test (absolute_filename, G_FILE_TEST_EXISTS))
+	  absolute_filename = file_find_in_dir(dir_to_search[i], filename);
+	  if(absolute_filename)
 	    goto FOUND;
 	}
       else
@@ -607,10 +646,9 @@ gc_file_find_absolute(const gchar *format, ...)
 	  /* First try with the long locale */
 	  locale = g_strsplit_set(gc_locale_get(), ".", 2);
 	  filename2 = g_strjoinv(locale[0], filesplit);
-	  absolute_filename = g_strdup_printf("%s/%s", dir_to_search[i],
-					      filename2);
+	  absolute_filename = file_find_in_dir(dir_to_search[i], filename2);
 	  g_strfreev(locale);
-	  if(g_file_test (absolute_filename, G_FILE_TEST_EXISTS))
+	  if(absolute_filename)
 	    {
 	      g_strfreev(filesplit);
 	      g_free(filename2);
@@ -627,9 +665,8 @@ gc_file_find_absolute(const gchar *format, ...)
 	      g_strfreev(locale);
 	      g_strfreev(filesplit);
 	      g_free(absolute_filename);
-	      absolute_filename = g_strdup_printf("%s/%s", dir_to_search[i],
-						  filename2);
-	      if(g_file_test (absolute_filename, G_FILE_TEST_EXISTS))
+	      absolute_filename = file_find_in_dir(dir_to_search[i], filename2);
+	      if(absolute_filename)
 		{
 		  g_free(filename2);
 		  goto FOUND;
@@ -38,6 +38,48 @@ static GHashTable *cache_content=NULL;
 #define	SUPPORT_OR_RETURN(rv)	{ return rv; }
 #endif
 
+#ifdef USE_GNET
+/*
+ * The server files are kept in a content addressed store, each one in
+ * <cache_dir>/objects/<2 first md5 digits>/<md5><extension>, so that
+ * identical files are stored once. An object is only written once its
+ * md5 has been checked.
+ *
+ * The files are only downloaded by prefetch_thread, from the NetFetch
+ * pushed in prefetch_queue. The main thread never waits for it: a file
+ * not in the cache yet is queued before the prefetched ones, and the
+ * functions added with gc_net_fetched_notify_add() are called once it
+ * is there.
+ */
+typedef struct {
+  gchar    *file;
+  /* Asked by the main thread, not only prefetched */
+  gboolean  wanted;
+} NetFetch;
+
+typedef struct {
+  GcNetFetchedFunc func;
+  gpointer         user_data;
+} NetNotify;
+
+static GThread     *prefetch_thread = NULL;
+static GAsyncQueue *prefetch_queue = NULL;
+/* Pushed in prefetch_queue to stop the thread */
+static NetFetch     prefetch_stop;
+
+/* Protects fetching, verified and wanted */
+static GMutex      *fetch_lock = NULL;
+static GCond       *fetch_cond = NULL;
+/* The md5 of the objects being downloaded */
+static GHashTable  *fetching = NULL;
+/* The md5 of the objects checked since the start */
+static GHashTable  *verified = NULL;
+/* The files queued by the main thread */
+static GHashTable  *wanted = NULL;
+
+static GSList      *fetched_notify = NULL;
+#endif
+
 #ifdef USE_GNET
 static void load_md5file(GHashTable *ht, gchar *content)
 {
@@ -59,6 +101,332 @@ static void load_md5file(GHashTable *ht, gchar *content)
     }
   g_strfreev(lines);
 }
+
+static gchar *
+gc_net_object_path(const gchar *file, const gchar *md5)
+{
+  GcomprisProperties *properties = gc_prop_get();
+  gchar prefix[3] = { md5[0], md5[0] ? md5[1] : '\0', '\0' };
+  gchar *basename, *name, *ext, *path;
+
+  /* Keep the extension, some loaders rely on it */
+  basename = g_path_get_basename(file);
+  ext = strrchr(basename, '.');
+  name = g_strconcat(md5, ext ? ext : "", NULL);
+  path = g_build_filename(properties->cache_dir, "objects", prefix, name, NULL);
+
+  g_free(name);
+  g_free(basename);
+  return path;
+}
+
+static gboolean
+gc_net_md5_check(const gchar *content, gsize length, const gchar *md5)
+{
+  gchar *sum;
+  gboolean ok;
+
+  sum = g_compute_checksum_for_data(G_CHECKSUM_MD5, (const guchar *)content, length);
+  ok = (g_ascii_strcasecmp(sum, md5) == 0);
+  g_free(sum);
+
+  return ok;
+}
+
+static void
+gc_net_http_cb(GConnHttp *conn, GConnHttpEvent *event, gpointer data)
+{
+}
+
+/* The files wanted by the main thread come first, in the order asked */
+static gint
+gc_net_fetch_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+  const NetFetch *fa = a, *fb = b;
+
+  return (fb->wanted != 0) - (fa->wanted != 0);
+}
+
+/* Download file in object, fails if it does not match md5 */
+static gboolean
+gc_net_fetch(const gchar *file, const gchar *md5, const gchar *object)
+{
+  GcomprisProperties *properties = gc_prop_get();
+  GMainContext *context;
+  GConnHttp *conn;
+  gchar *url, *dirname;
+  gchar *buf = NULL;
+  gsize  buflen = 0;
+  gboolean ok = FALSE;
+
+  url = g_strconcat(properties->server, "/", file, NULL);
+
+  /* Run the request in its own context, it must not dispatch the
+     main loop sources when called from the prefetch thread */
+  context = g_main_context_new();
+  conn = gnet_conn_http_new();
+  gnet_conn_http_set_main_context(conn, context);
+  if(gnet_conn_http_set_uri(conn, url)
+     && gnet_conn_http_run(conn, gc_net_http_cb, NULL))
+    gnet_conn_http_steal_buffer(conn, &buf, &buflen);
+  gnet_conn_http_delete(conn);
+  g_main_context_unref(context);
+
+  if(buf)
+    {
+      /* Also rejects the server error pages */
+      if(gc_net_md5_check(buf, buflen, md5))
+	{
+	  dirname = g_path_get_dirname(object);
+	  g_mkdir_with_parents(dirname, 0755);
+	  g_free(dirname);
+
+	  /* Written in a temporary file first, object is always complete */
+	  ok = g_file_set_contents(object, buf, buflen, NULL);
+	}
+      else
+	g_warning("gc_net: '%s' does not match its md5, dropped", url);
+      g_free(buf);
+    }
+
+  g_free(url);
+  return ok;
+}
+
+/* Return the object of file, downloading it if needed.
+ * With check, an object already there is checked once per run.
+ */
+static gchar *
+gc_net_object_get(const gchar *file, const gchar *md5, gboolean check)
+{
+  gchar *object;
+  gboolean ok = TRUE;
+
+  object = gc_net_object_path(file, md5);
+
+  g_mutex_lock(fetch_lock);
+
+  /* It is being downloaded by another thread, wait for it. The main
+     thread only downloads when there is no prefetch thread, so it never
+     waits here */
+  while(g_hash_table_lookup(fetching, md5))
+    g_cond_wait(fetch_cond, fetch_lock);
+
+  if(g_file_test(object, G_FILE_TEST_IS_REGULAR)
+     && (!check || g_hash_table_lookup(verified, md5)))
+    {
+      g_mutex_unlock(fetch_lock);
+      return object;
+    }
+
+  g_hash_table_insert(fetching, (gpointer) md5, (gpointer) md5);
+  g_mutex_unlock(fetch_lock);
+
+  if(g_file_test(object, G_FILE_TEST_IS_REGULAR))
+    {
+      gchar *content = NULL;
+      gsize length;
+
+      if(!g_file_get_contents(object, &content, &length, NULL)
+	 || !gc_net_md5_check(content, length, md5))
+	{
+	  g_warning("gc_net: removing the corrupted cache file '%s'", object);
+	  g_remove(object);
+	}
+      g_free(content);
+    }
+
+  if(!g_file_test(object, G_FILE_TEST_IS_REGULAR))
+    ok = gc_net_fetch(file, md5, object);
+
+  g_mutex_lock(fetch_lock);
+  g_hash_table_remove(fetching, md5);
+  if(ok)
+    g_hash_table_insert(verified, (gpointer) md5, (gpointer) md5);
+  g_cond_broadcast(fetch_cond);
+  g_mutex_unlock(fetch_lock);
+
+  if(!ok)
+    {
+      g_free(object);
+      return NULL;
+    }
+
+  return object;
+}
+
+/* Return the object of file if it is in the cache, or queue it to be
+ * downloaded and return NULL. Called by the main thread, never waits
+ * for the network.
+ */
+static gchar *
+gc_net_object_lookup(const gchar *file, const gchar *md5)
+{
+  gchar *object;
+  gboolean ready;
+
+  /* Without the thread, nothing else would download it */
+  if(!prefetch_thread)
+    return gc_net_object_get(file, md5, FALSE);
+
+  object = gc_net_object_path(file, md5);
+
+  g_mutex_lock(fetch_lock);
+  ready = (!g_hash_table_lookup(fetching, md5)
+	   && g_file_test(object, G_FILE_TEST_IS_REGULAR));
+  if(!ready && !g_hash_table_lookup(wanted, file))
+    {
+      NetFetch *fetch = g_new(NetFetch, 1);
+
+      fetch->file = g_strdup(file);
+      fetch->wanted = TRUE;
+      g_hash_table_insert(wanted, fetch->file, fetch);
+      g_async_queue_push_sorted(prefetch_queue, fetch,
+				gc_net_fetch_compare, NULL);
+    }
+  g_mutex_unlock(fetch_lock);
+
+  if(!ready)
+    {
+      g_free(object);
+      return NULL;
+    }
+
+  return object;
+}
+
+/* Called in the main thread once a wanted file is in the cache */
+static gboolean
+gc_net_fetched_idle(gpointer data)
+{
+  gchar *file = data;
+  GSList *copy, *list;
+
+  /* The functions may remove any of them */
+  copy = g_slist_copy(fetched_notify);
+  for(list = copy; list; list = list->next)
+    {
+      NetNotify *notify = list->data;
+
+      if(g_slist_find(fetched_notify, notify))
+	notify->func(file, notify->user_data);
+    }
+  g_slist_free(copy);
+
+  g_free(file);
+  return FALSE;
+}
+
+static gpointer
+gc_net_prefetch_thread(gpointer data)
+{
+  NetFetch *fetch;
+
+  while((fetch = g_async_queue_pop(prefetch_queue)) != &prefetch_stop)
+    {
+      /* server_content is not changed once the thread runs */
+      const gchar *md5 = g_hash_table_lookup(server_content, fetch->file);
+      gchar *object = NULL;
+
+      if(md5)
+	object = gc_net_object_get(fetch->file, md5, TRUE);
+
+      if(fetch->wanted)
+	{
+	  g_mutex_lock(fetch_lock);
+	  g_hash_table_remove(wanted, fetch->file);
+	  g_mutex_unlock(fetch_lock);
+
+	  if(object)
+	    g_idle_add(gc_net_fetched_idle, g_strdup(fetch->file));
+	}
+
+      g_free(object);
+      g_free(fetch->file);
+      g_free(fetch);
+    }
+
+  return NULL;
+}
+
+/* Drop the prefetched files not downloaded yet, the wanted ones are kept */
+static void
+gc_net_prefetch_drop(void)
+{
+  GSList *keep = NULL, *list;
+  NetFetch *fetch;
+
+  g_async_queue_lock(prefetch_queue);
+  while((fetch = g_async_queue_try_pop_unlocked(prefetch_queue)))
+    {
+      if(fetch == &prefetch_stop)
+	continue;
+      if(fetch->wanted && prefetch_thread)
+	keep = g_slist_prepend(keep, fetch);
+      else
+	{
+	  if(fetch->wanted)
+	    {
+	      g_mutex_lock(fetch_lock);
+	      g_hash_table_remove(wanted, fetch->file);
+	      g_mutex_unlock(fetch_lock);
+	    }
+	  g_free(fetch->file);
+	  g_free(fetch);
+	}
+    }
+  keep = g_slist_reverse(keep);
+  for(list = keep; list; list = list->next)
+    g_async_queue_push_sorted_unlocked(prefetch_queue, list->data,
+				       gc_net_fetch_compare, NULL);
+  g_async_queue_unlock(prefetch_queue);
+
+  g_slist_free(keep);
+}
+
+static void
+gc_net_prefetch_push(gchar *file)
+{
+  NetFetch *fetch = g_new(NetFetch, 1);
+
+  fetch->file = file;
+  fetch->wanted = FALSE;
+  g_async_queue_push_sorted(prefetch_queue, fetch, gc_net_fetch_compare, NULL);
+}
+
+struct _prefetch_data
+  {
+    gchar *dir;
+  };
+
+static void
+_prefetch_foreach(gpointer key, gpointer value, gpointer user_data)
+{
+  struct _prefetch_data *data = (struct _prefetch_data*)user_data;
+
+  if(data->dir && g_str_has_prefix(key, data->dir))
+    gc_net_prefetch_push(g_strdup(key));
+}
+
+static void
+_want_foreach(gpointer key, gpointer value, gpointer user_data)
+{
+  struct _prefetch_data *data = (struct _prefetch_data*)user_data;
+
+  if(data->dir && g_str_has_prefix(key, data->dir))
+    g_free(gc_net_object_lookup(key, value));
+}
+
+/* The directory of the board files on the server, or NULL */
+static gchar *
+gc_net_board_dir(GcomprisBoard *board)
+{
+  if(board->boarddir && board->boarddir[0] != '\0')
+    return g_strconcat(board->boarddir, "/", NULL);
+  else if(board->name && board->name[0] != '\0')
+    return g_strconcat(board->name, "/", NULL);
+  return NULL;
+}
 #endif
 
 /** Init the network library, must be called once before using it
@@ -89,6 +457,19 @@ void gc_net_init()
     {
       server_content = g_hash_table_new(g_str_hash, g_str_equal);
       load_md5file(server_content, buf);
+
+      if (!g_thread_supported ()) g_thread_init (NULL);
+
+      fetch_lock = g_mutex_new ();
+      fetch_cond = g_cond_new ();
+      fetching = g_hash_table_new(g_str_hash, g_str_equal);
+      verified = g_hash_table_new(g_str_hash, g_str_equal);
+      wanted = g_hash_table_new(g_str_hash, g_str_equal);
+
+      prefetch_queue = g_async_queue_new();
+      prefetch_thread = g_thread_create(gc_net_prefetch_thread, NULL, TRUE, NULL);
+      if (prefetch_thread == NULL)
+	g_warning("create failed for the network prefetch thread");
     }
   else
     {
@@ -108,16 +489,51 @@ void gc_net_destroy(void)
   SUPPORT_OR_RETURN();
 
 #ifdef USE_GNET
+  if(prefetch_thread)
+    {
+      GThread *thread = prefetch_thread;
+
+      /* Without the thread, the wanted files are dropped too */
+      prefetch_thread = NULL;
+      gc_net_prefetch_drop();
+      g_async_queue_push(prefetch_queue, &prefetch_stop);
+      g_thread_join(thread);
+    }
+  if(prefetch_queue)
+    {
+      gc_net_prefetch_drop();
+      g_async_queue_unref(prefetch_queue);
+      prefetch_queue = NULL;
+    }
+
   if(server_content)
     g_hash_table_destroy(server_content);
   server_content = NULL;
+
+  if(fetching)
+    {
+      g_hash_table_destroy(fetching);
+      g_hash_table_destroy(verified);
+      g_hash_table_destroy(wanted);
+      g_mutex_free(fetch_lock);
+      g_cond_free(fetch_cond);
+      fetching = verified = wanted = NULL;
+      fetch_lock = NULL;
+      fetch_cond = NULL;
+    }
 #endif
 }
 
-/** return an absolute URL if the given file is part of the file available on our server
+/** return the local copy of a file available on our server
+ *
+ * The network is never waited for. If the file is not in the cache yet,
+ * which does not happen for the files prefetched with
+ * gc_net_prefetch_boards(), it is downloaded in the background and NULL
+ * is returned. The functions added with gc_net_fetched_notify_add() are
+ * called once it is there.
  *
  * \param file: the file to check
- * \return: a newly allocated URL or NULL
+ * \return: a newly allocated path in the cache or NULL
  */
 gchar *
 gc_net_get_url_from_file(const gchar *format, ...)
@@ -125,70 +541,128 @@ gc_net_get_url_from_file(const gchar *format, ...)
   SUPPORT_OR_RETURN(NULL);
 
 #ifdef USE_GNET
-  GcomprisProperties *properties = gc_prop_get();
   gchar *file, *cache=NULL, *value;
   va_list args;
-  gboolean cache_ok=FALSE;
+
+  if(!server_content)
+    return NULL;
 
   va_start (args, format);
   file = g_strdup_vprintf (format, args);
   va_end (args);
 
-  g_warning("gc_net_get_url_from_file '%s'", file);
-
   value = g_hash_table_lookup(server_content, (gpointer) file);
   if(value)
-    {
-      cache = g_strconcat(properties->cache_dir, "/", file, NULL);
-      if(g_file_test(cache, G_FILE_TEST_IS_REGULAR))
-	{
-	  gchar * content;
-	  gsize length;
-	  GMD5 *md5cache, *md5serv;
+    cache = gc_net_object_lookup(file, value);
 
-	  /* calc md5 of cache file */
-	  g_file_get_contents(cache, &content, &length, NULL);
-	  md5cache = gnet_md5_new(content, length);
-	  g_free(content);
+  g_free(file);
+
+  return cache;
+#endif
+}
 
-	  md5serv = gnet_md5_new_string(value);
+/** fetch in the background the files of boards not in the cache yet
+ *
+ * The icons of all the boards are fetched first, then the files of
+ * each board directory, in the order of the list. The files queued for
+ * previous boards and not fetched yet are dropped.
+ *
+ * \param boards: the list of GcomprisBoard to prefetch
+ */
+void
+gc_net_prefetch_boards(GList *boards)
+{
+  SUPPORT_OR_RETURN();
 
-	  cache_ok = gnet_md5_equal(md5serv, md5cache);
+#ifdef USE_GNET
+  struct _prefetch_data data;
+  GList *list;
 
-	  gnet_md5_delete(md5serv);
-	  gnet_md5_delete(md5cache);
-	}
-      if(cache_ok==0)
-	{
-	  gchar *url;
-	  gchar *buf = NULL;
-	  gsize  buflen;
-	  guint  response;
+  if(!prefetch_thread)
+    return;
 
-	  url = g_strconcat(properties->server, "/", file, NULL);
-	  if(gnet_http_get(url, &buf, &buflen, &response) && response == 200)
-	    {
-	      gchar *dirname;
+  gc_net_prefetch_drop();
 
-	      dirname = g_path_get_dirname(cache);
-	      g_mkdir_with_parents(dirname, 0755);
-	      g_free(dirname);
-	      g_file_set_contents(cache, buf, buflen, NULL);
-	      g_free(buf);
-	    }
-	  else
-	    { /* file is in content.txt but not in server */
-	      g_free(cache);
-	      cache = NULL;
-	    }
-	}
+  for(list = boards; list; list = list->next)
+    {
+      GcomprisBoard *board = list->data;
+
+      if(board->icon_name
+	 && g_hash_table_lookup(server_content, board->icon_name))
+	gc_net_prefetch_push(g_strdup(board->icon_name));
     }
-  g_free(file);
 
-  return cache;
+  for(list = boards; list; list = list->next)
+    {
+      GcomprisBoard *board = list->data;
+
+      data.dir = gc_net_board_dir(board);
+      g_hash_table_foreach(server_content, _prefetch_foreach, &data);
+      g_free(data.dir);
+    }
+#endif
+}
+
+/** queue the files of the board about to start that are not in the
+ *  cache yet, before any prefetched file. They are kept by
+ *  gc_net_prefetch_boards().
+ *
+ * \param board: the board to start
+ */
+void
+gc_net_want_board(GcomprisBoard *board)
+{
+  SUPPORT_OR_RETURN();
+
+#ifdef USE_GNET
+  struct _prefetch_data data;
+
+  if(!prefetch_thread)
+    return;
+
+  data.dir = gc_net_board_dir(board);
+  g_hash_table_foreach(server_content, _want_foreach, &data);
+  g_free(data.dir);
 #endif
 }
 
+/** call func in the main thread each time a file asked to
+ *  gc_net_get_url_from_file() is downloaded
+ *
+ * \param func: called with the file name, relative to the server
+ * \param user_data: passed to func
+ */
+void
+gc_net_fetched_notify_add(GcNetFetchedFunc func, gpointer user_data)
+{
+#ifdef USE_GNET
+  NetNotify *notify = g_new(NetNotify, 1);
+
+  notify->func = func;
+  notify->user_data = user_data;
+  fetched_notify = g_slist_append(fetched_notify, notify);
+#endif
+}
+
+void
+gc_net_fetched_notify_remove(GcNetFetchedFunc func, gpointer user_data)
+{
+#ifdef USE_GNET
+  GSList *list;
+
+  for(list = fetched_notify; list; list = list->next)
+    {
+      NetNotify *notify = list->data;
+
+      if(notify->func == func && notify->user_data == user_data)
+	{
+	  fetched_notify = g_slist_delete_link(fetched_notify, list);
+	  g_free(notify);
+	  return;
+	}
+    }
+#endif
+}
 
 #if 0
 /** return a glist with the content of the files in the given directory
@@ -34,6 +34,12 @@
 void gc_net_init();
 gchar     *gc_net_get_url_from_file(const gchar *format, ...);
 GSList    *gc_net_dir_read_name(const gchar* dir, const gchar *ext);
+void       gc_net_prefetch_boards(GList *boards);
+void       gc_net_want_board(GcomprisBoard *board);
+
+typedef void (*GcNetFetchedFunc) (const gchar *file, gpointer user_data);
+void       gc_net_fetched_notify_add(GcNetFetchedFunc func, gpointer user_data);
+void       gc_net_fetched_notify_remove(GcNetFetchedFunc func, gpointer user_data);
 void gc_net_destroy();
 
 void gc_cache_init(void);
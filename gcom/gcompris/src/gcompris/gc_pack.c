@@ -0,0 +1,452 @@
+/* gcompris - gc_pack.c
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "gc_pack.h"
+
+/*
+ * An archive is mapped once and never read again. It is laid out as,
+ * all the integers being little endian:
+ *
+ *   PackHeader
+ *   PackEntry entries[n_entries]	sorted by name
+ *   gchar names[names_size]		nul terminated strings
+ *   the data of the entries
+ *
+ * An entry is either stored as is, or compressed in a LZ4 block.
+ */
+#define PACK_MAGIC	"GCPK"
+#define PACK_VERSION	1
+
+#define PACK_LZ4	1
+
+typedef struct {
+  gchar   magic[4];
+  guint32 version;
+  guint32 n_entries;
+  guint32 names_size;
+} PackHeader;
+
+typedef struct {
+  guint32 name;		/* offset in names */
+  guint32 flags;
+  guint64 offset;	/* from the start of the archive */
+  guint64 size;		/* once uncompressed */
+  guint64 stored_size;
+} PackEntry;
+
+typedef struct {
+  GMappedFile     *mapped;
+  const guchar    *contents;
+  gsize            length;
+  const PackEntry *entries;
+  guint            n_entries;
+  const gchar     *names;
+  guint32          names_size;
+} Pack;
+
+/* The archives opened, the first ones win */
+static GSList *packs = NULL;
+
+static void
+gc_pack_free(Pack *pack)
+{
+  g_mapped_file_unref(pack->mapped);
+  g_free(pack);
+}
+
+/** Open an archive, its entries are then found by gc_pack_find()
+ *
+ * \param filename: the archive
+ * \return TRUE if the archive is valid
+ */
+gboolean
+gc_pack_open(const gchar *filename)
+{
+  const PackHeader *header;
+  GMappedFile *mapped;
+  Pack *pack;
+  guint i;
+
+  mapped = g_mapped_file_new(filename, FALSE, NULL);
+  if(!mapped)
+    return FALSE;
+
+  pack = g_new0(Pack, 1);
+  pack->mapped = mapped;
+  pack->contents = (const guchar *) g_mapped_file_get_contents(mapped);
+  pack->length = g_mapped_file_get_length(mapped);
+
+  header = (const PackHeader *) pack->contents;
+  if(pack->length < sizeof(PackHeader)
+     || memcmp(header->magic, PACK_MAGIC, 4) != 0
+     || GUINT32_FROM_LE(header->version) != PACK_VERSION)
+    goto invalid;
+
+  pack->n_entries = GUINT32_FROM_LE(header->n_entries);
+  pack->names_size = GUINT32_FROM_LE(header->names_size);
+  if(pack->n_entries > (pack->length - sizeof(PackHeader)) / sizeof(PackEntry)
+     || pack->names_size > pack->length - sizeof(PackHeader)
+			   - pack->n_entries * sizeof(PackEntry)
+     || pack->names_size == 0)
+    goto invalid;
+
+  pack->entries = (const PackEntry *) (header + 1);
+  pack->names = (const gchar *) (pack->entries + pack->n_entries);
+  if(pack->names[pack->names_size - 1] != '\0')
+    goto invalid;
+
+  /* Check once the entries fit in the archive */
+  for(i = 0; i < pack->n_entries; i++)
+    {
+      const PackEntry *entry = &pack->entries[i];
+      guint64 offset = GUINT64_FROM_LE(entry->offset);
+      guint64 stored_size = GUINT64_FROM_LE(entry->stored_size);
+
+      if(GUINT32_FROM_LE(entry->name) >= pack->names_size
+	 || offset > pack->length
+	 || stored_size > pack->length - offset
+	 || (!(GUINT32_FROM_LE(entry->flags) & PACK_LZ4)
+	     && stored_size != GUINT64_FROM_LE(entry->size)))
+	goto invalid;
+    }
+
+  packs = g_slist_append(packs, pack);
+  g_message("Boards data archive %s opened, %d files", filename, pack->n_entries);
+
+  return TRUE;
+
+ invalid:
+  g_warning("Invalid boards data archive %s", filename);
+  gc_pack_free(pack);
+  return FALSE;
+}
+
+/** Open the archive of the boards data, if it is installed
+ *
+ */
+void
+gc_pack_init(void)
+{
+  GcomprisProperties *properties = gc_prop_get();
+  gchar *filename;
+
+  if(!properties->package_data_dir || !properties->package_data_dir[0])
+    return;
+
+  filename = g_strconcat(properties->package_data_dir, GC_PACK_SUFFIX, NULL);
+  if(g_file_test(filename, G_FILE_TEST_IS_REGULAR))
+    gc_pack_open(filename);
+  g_free(filename);
+}
+
+void
+gc_pack_destroy(void)
+{
+  g_slist_foreach(packs, (GFunc) gc_pack_free, NULL);
+  g_slist_free(packs);
+  packs = NULL;
+}
+
+static const PackEntry *
+gc_pack_lookup(const gchar *name, Pack **found)
+{
+  GSList *list;
+
+  /* './' is not in the entry names */
+  while(name[0] == '.' && name[1] == '/')
+    name += 2;
+
+  for(list = packs; list; list = list->next)
+    {
+      Pack *pack = list->data;
+      guint low = 0, high = pack->n_entries;
+
+      while(low < high)
+	{
+	  guint middle = low + (high - low) / 2;
+	  const PackEntry *entry = &pack->entries[middle];
+	  gint cmp = strcmp(name, pack->names + GUINT32_FROM_LE(entry->name));
+
+	  if(cmp == 0)
+	    {
+	      *found = pack;
+	      return entry;
+	    }
+	  if(cmp < 0)
+	    high = middle;
+	  else
+	    low = middle + 1;
+	}
+    }
+
+  return NULL;
+}
+
+/** Find a file in the archives
+ *
+ * \param format: the relative file name, with $LOCALE replaced by the long
+ *                locale and if not found the short locale name. It support
+ *                printf formating.
+ * \param ...:    additional params for the format (printf like)
+ *
+ * \return the entry name, to be freed, or NULL
+ */
+gchar *
+gc_pack_find(const gchar *format, ...)
+{
+  va_list args;
+  gchar *filename, *name = NULL;
+  gchar **filesplit;
+  Pack *pack;
+
+  if(!packs || !format)
+    return NULL;
+
+  va_start (args, format);
+  filename = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  filesplit = g_strsplit(filename, "$LOCALE", -1);
+  if(g_strv_length(filesplit) == 1)
+    {
+      if(gc_pack_lookup(filename, &pack))
+	name = g_strdup(filename);
+    }
+  else
+    {
+      gchar *separators[] = { ".", "_" };
+      guint i;
+
+      /* First try with the long locale then the short one */
+      for(i = 0; i < G_N_ELEMENTS(separators) && !name; i++)
+	{
+	  gchar **locale = g_strsplit_set(gc_locale_get(), separators[i], 2);
+
+	  if(locale[0])
+	    {
+	      name = g_strjoinv(locale[0], filesplit);
+	      if(!gc_pack_lookup(name, &pack))
+		{
+		  g_free(name);
+		  name = NULL;
+		}
+	    }
+	  g_strfreev(locale);
+	}
+    }
+
+  g_strfreev(filesplit);
+  g_free(filename);
+
+  return name;
+}
+
+/* Uncompress a LZ4 block, fails unless it fills dst exactly */
+static gboolean
+lz4_uncompress(const guchar *src, gsize src_size, guchar *dst, gsize dst_size)
+{
+  const guchar *ip = src, *iend = src + src_size;
+  guchar *op = dst, *oend = dst + dst_size;
+
+  while(ip < iend)
+    {
+      guint token = *ip++;
+      const guchar *match;
+      gsize length, offset;
+      guint byte;
+
+      /* The literals */
+      length = token >> 4;
+      if(length == 15)
+	do
+	  {
+	    if(ip >= iend)
+	      return FALSE;
+	    byte = *ip++;
+	    length += byte;
+	  }
+	while(byte == 255);
+
+      if(length > (gsize) (iend - ip) || length > (gsize) (oend - op))
+	return FALSE;
+      memcpy(op, ip, length);
+      op += length;
+      ip += length;
+
+      /* The last sequence has no match */
+      if(ip >= iend)
+	break;
+
+      /* The match */
+      if(iend - ip < 2)
+	return FALSE;
+      offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if(offset == 0 || offset > (gsize) (op - dst))
+	return FALSE;
+
+      length = token & 15;
+      if(length == 15)
+	do
+	  {
+	    if(ip >= iend)
+	      return FALSE;
+	    byte = *ip++;
+	    length += byte;
+	  }
+	while(byte == 255);
+      length += 4;
+
+      if(length > (gsize) (oend - op))
+	return FALSE;
+
+      /* The match may overlap what it writes */
+      match = op - offset;
+      while(length--)
+	*op++ = *match++;
+    }
+
+  return op == oend;
+}
+
+/** Get the content of an entry
+ *
+ * \param name: the entry, as returned by gc_pack_find()
+ * \param length: set to the length of the content
+ * \param to_free: set to what must be freed once the content is used
+ *
+ * \return the content or NULL
+ */
+gconstpointer
+gc_pack_get(const gchar *name, gsize *length, gpointer *to_free)
+{
+  const PackEntry *entry;
+  Pack *pack;
+  gsize size, stored_size;
+  const guchar *data;
+  guchar *content;
+
+  *to_free = NULL;
+
+  entry = gc_pack_lookup(name, &pack);
+  if(!entry)
+    return NULL;
+
+  data = pack->contents + GUINT64_FROM_LE(entry->offset);
+  size = GUINT64_FROM_LE(entry->size);
+  stored_size = GUINT64_FROM_LE(entry->stored_size);
+
+  if(!(GUINT32_FROM_LE(entry->flags) & PACK_LZ4))
+    {
+      *length = size;
+      return data;
+    }
+
+  content = g_malloc(size + 1);
+  if(!lz4_uncompress(data, stored_size, content, size))
+    {
+      g_warning("Corrupted entry %s in the boards data archive", name);
+      g_free(content);
+      return NULL;
+    }
+  /* Like g_file_get_contents() */
+  content[size] = '\0';
+
+  *length = size;
+  *to_free = content;
+  return content;
+}
+
+/** load a pixbuf from the archives
+ *
+ * \param name: the entry, as returned by gc_pack_find()
+ * \return a new pixbuf or NULL
+ */
+GdkPixbuf *
+gc_pack_pixbuf_load(const gchar *name)
+{
+  GdkPixbufLoader *loader;
+  GdkPixbuf *pixmap = NULL;
+  gconstpointer data;
+  gpointer to_free;
+  gsize length;
+  gboolean ok;
+
+  data = gc_pack_get(name, &length, &to_free);
+  if(!data)
+    return NULL;
+
+  loader = gdk_pixbuf_loader_new();
+  ok = gdk_pixbuf_loader_write(loader, data, length, NULL);
+  /* The loader must be closed even after an error */
+  ok = gdk_pixbuf_loader_close(loader, NULL) && ok;
+  if(ok)
+    {
+      pixmap = gdk_pixbuf_loader_get_pixbuf(loader);
+      if(pixmap)
+	g_object_ref(pixmap);
+    }
+  g_object_unref(loader);
+
+  g_free(to_free);
+
+  return pixmap;
+}
+
+/** load an svg from the archives
+ *
+ * \param name: the entry, as returned by gc_pack_find()
+ * \return a new RsvgHandle or NULL
+ */
+RsvgHandle *
+gc_pack_rsvg_load(const gchar *name)
+{
+  RsvgHandle *rsvghandle;
+  gconstpointer data;
+  gpointer to_free;
+  gsize length;
+  gchar *base_uri;
+  gboolean ok;
+
+  data = gc_pack_get(name, &length, &to_free);
+  if(!data)
+    return NULL;
+
+  rsvghandle = rsvg_handle_new();
+
+  /* The entry path as if it was unpacked, so that the images it
+   * references with a relative href still resolve */
+  base_uri = g_build_filename(gc_prop_get()->package_data_dir, name, NULL);
+  rsvg_handle_set_base_uri(rsvghandle, base_uri);
+  g_free(base_uri);
+
+  ok = rsvg_handle_write(rsvghandle, data, length, NULL);
+  /* The handle must be closed even after an error */
+  ok = rsvg_handle_close(rsvghandle, NULL) && ok;
+  if(!ok)
+    {
+      g_object_unref(rsvghandle);
+      rsvghandle = NULL;
+    }
+
+  g_free(to_free);
+
+  return rsvghandle;
+}
@@ -0,0 +1,57 @@
+/* gcompris - gc_pack.h
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*! \file gc_pack.h
+  \brief Read the boards data from a packed archive
+*/
+
+#ifndef GC_PACK_H
+#define GC_PACK_H
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <librsvg/rsvg.h>
+
+#include "gcompris.h"
+
+/* The archive made by tools/gcompris_pack.py from the boards directory,
+ * looked for next to it as <package_data_dir>.pack
+ */
+#define GC_PACK_SUFFIX ".pack"
+
+void		 gc_pack_init(void);
+void		 gc_pack_destroy(void);
+
+gboolean	 gc_pack_open(const gchar *filename);
+
+/* Find a file in the archives, format is handled like in
+ * gc_file_find_absolute(), $LOCALE included.
+ *
+ * Return the name of the entry found, to be freed, or NULL
+ */
+gchar		*gc_pack_find(const gchar *format, ...);
+
+/* Return the content of an entry and its length. The stored entries
+ * are returned from the mapped archive, *to_free is then NULL. Else
+ * the content is uncompressed in *to_free, to be g_free()d.
+ */
+gconstpointer	 gc_pack_get(const gchar *name, gsize *length, gpointer *to_free);
+
+GdkPixbuf	*gc_pack_pixbuf_load(const gchar *name);
+RsvgHandle	*gc_pack_rsvg_load(const gchar *name);
+
+#endif
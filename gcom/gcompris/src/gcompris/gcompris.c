@@ -147,6 +147,7 @@ static gchar *popt_drag_mode       = NULL;
 static gint popt_sugar_look        = FALSE;
 static gint popt_no_zoom           = FALSE;
 static gint popt_test              = FALSE;
+static gint popt_render_threads    = 0;
 static gdouble popt_timing_base    = 1.0;
 static gdouble popt_timing_mult    = 1.0;
 
@@ -268,6 +269,9 @@ static GOptionEntry options[] = {
   {"test",'\0', 0, G_OPTION_ARG_NONE, &popt_test,
    N_("For test purpose, run in a loop all the activities"), NULL},
 
+  {"render-threads",'\0', 0, G_OPTION_ARG_INT, &popt_render_threads,
+   N_("Draw the screen with this number of threads; 0 to draw it in the main thread"), NULL},
+
   { NULL }
 };
 
@@ -630,6 +634,7 @@ _set_svg_background(GooCanvasItem *parent, gchar *file, gchar *id)
 					 rsvg_handle,
 					 NULL);
   goo_canvas_item_lower(backgroundsvgimg, NULL);
+  goo_canvas_set_retained_item(GOO_CANVAS(canvas), backgroundsvgimg);
 
   g_object_unref(rsvg_handle);
 }
@@ -654,6 +659,7 @@ _set_pixmap_background(GooCanvasItem *parent, gchar *file)
 					  "height", (gdouble) BOARDHEIGHT,
 					  NULL);
   goo_canvas_item_lower(backgroundimg, NULL);
+  goo_canvas_set_retained_item(GOO_CANVAS(canvas), backgroundimg);
 
 #if GDK_PIXBUF_MAJOR <= 2 && GDK_PIXBUF_MINOR <= 24
   gdk_pixbuf_unref(background_pixmap);
@@ -722,6 +728,7 @@ gc_set_background_by_id(GooCanvasItem *parent, RsvgHandle *rsvg_handle,
 					   NULL);
 
   goo_canvas_item_lower(backgroundsvgimg, NULL);
+  goo_canvas_set_retained_item(GOO_CANVAS(canvas), backgroundsvgimg);
 }
 
 void
@@ -877,6 +884,14 @@ static void setup_window ()
 		"has-tooltip", TRUE,
 		NULL);
 
+  if (popt_render_threads > 0)
+    {
+      if (!g_thread_supported ()) g_thread_init (NULL);
+      g_object_set (canvas,
+		    "render-threads", popt_render_threads,
+		    NULL);
+    }
+
   g_object_set (G_OBJECT(goo_canvas_get_root_item(GOO_CANVAS(canvas))),
 		"can-focus", TRUE,
 		NULL);
@@ -1194,11 +1209,13 @@ static void cleanup()
 
   single_instance_release(); /* Must be done before property destroy */
   gc_board_stop();
+  gc_board_cleanup();
   gc_db_exit();
   gc_fullscreen_set(FALSE);
   gc_menu_destroy();
   gc_net_destroy();
   gc_cache_destroy();
+  gc_pack_destroy();
   gc_prop_destroy(gc_prop_get());
 }
 
@@ -2040,6 +2057,9 @@ main (int argc, char *argv[])
   gc_net_init();
   gc_cache_init();
 
+  /* boards data archive, if installed */
+  gc_pack_init();
+
   gc_sound_build_music_list();
 
   if(properties->music || properties->fx)
@@ -40,6 +40,7 @@
 #include "properties.h"
 #include "gameutil.h"
 #include "gc_net.h"
+#include "gc_pack.h"
 #include "bonus.h"
 #include "timer.h"
 #include "score.h"
@@ -51,6 +52,10 @@
 #include "wordlist.h"
 #include "gcompris_im.h"
 #include "gcompris_alphabeta.h"
+#include "gcompris_dcsolver.h"
+#include "gcompris_connect4.h"
+#include "gcompris_sudoku.h"
+#include "gcompris_lightsoff.h"
 
 #include "drag.h"
 
@@ -0,0 +1,396 @@
+/* gcompris - gcompris_connect4.c
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "gcompris_connect4.h"
+
+#define WIDTH		GC_CONNECT4_WIDTH
+#define HEIGHT		GC_CONNECT4_HEIGHT
+#define H1		(HEIGHT + 1)
+#define N_CELLS		(WIDTH * HEIGHT)
+
+#define WIN		GC_CONNECT4_WIN
+#define INFINITY_SCORE	(WIN + 1)
+/* Scores beyond this are wins or losses at a known distance */
+#define MATE_SCORE	(WIN - N_CELLS - 1)
+
+/* 2^18 entries of 16 bytes */
+#define TABLE_BITS	18
+#define TABLE_SIZE	(1 << TABLE_BITS)
+
+/* Check the clock every so many nodes */
+#define CLOCK_NODES	1024
+
+enum { TT_EXACT, TT_LOWER, TT_UPPER };
+
+typedef struct
+{
+  guint64	key;
+  gint16	value;
+  guint8	depth;
+  guint8	flag;
+  gint8		move;
+} Connect4Entry;
+
+struct _GcConnect4
+{
+  Connect4Entry	*table;
+  GTimer	*timer;
+  gdouble	 budget;	/* in seconds, 0 for none */
+  gulong	 nodes;
+  gboolean	 can_abort;
+  gboolean	 aborted;
+};
+
+/* Explore the center columns first, they make the most alignments */
+static const gint column_order[WIDTH] = { 3, 2, 4, 1, 5, 0, 6 };
+
+#define BOTTOM(col)	(G_GUINT64_CONSTANT (1) << ((col) * H1))
+#define TOP(col)	(G_GUINT64_CONSTANT (1) << (HEIGHT - 1 + (col) * H1))
+#define COLUMN(col)	(((G_GUINT64_CONSTANT (1) << HEIGHT) - 1) << ((col) * H1))
+
+static guint64 bottom_all;
+static guint64 board_all;
+
+static gint
+popcount (guint64 b)
+{
+  gint n = 0;
+
+  for (; b; n++)
+    b &= b - 1;
+
+  return n;
+}
+
+/* The empty cells that would make four in a row for position */
+static guint64
+winning_cells (guint64 position, guint64 mask)
+{
+  guint64 r, p;
+
+  /* vertical */
+  r = (position << 1) & (position << 2) & (position << 3);
+
+  /* horizontal */
+  p = (position << H1) & (position << 2 * H1);
+  r |= p & (position << 3 * H1);
+  r |= p & (position >> H1);
+  p = (position >> H1) & (position >> 2 * H1);
+  r |= p & (position << H1);
+  r |= p & (position >> 3 * H1);
+
+  /* diagonal / */
+  p = (position << HEIGHT) & (position << 2 * HEIGHT);
+  r |= p & (position << 3 * HEIGHT);
+  r |= p & (position >> HEIGHT);
+  p = (position >> HEIGHT) & (position >> 2 * HEIGHT);
+  r |= p & (position << HEIGHT);
+  r |= p & (position >> 3 * HEIGHT);
+
+  /* diagonal \ */
+  p = (position << (HEIGHT + 2)) & (position << 2 * (HEIGHT + 2));
+  r |= p & (position << 3 * (HEIGHT + 2));
+  r |= p & (position >> (HEIGHT + 2));
+  p = (position >> (HEIGHT + 2)) & (position >> 2 * (HEIGHT + 2));
+  r |= p & (position << (HEIGHT + 2));
+  r |= p & (position >> 3 * (HEIGHT + 2));
+
+  return r & (board_all ^ mask);
+}
+
+/* The cells where a stone can be dropped */
+static inline guint64
+playable_cells (guint64 mask)
+{
+  return (mask + bottom_all) & board_all;
+}
+
+static inline gboolean
+can_play (guint64 mask, gint col)
+{
+  return (mask & TOP (col)) == 0;
+}
+
+static inline gboolean
+is_winning_move (guint64 current, guint64 mask, gint col)
+{
+  return (winning_cells (current, mask) & playable_cells (mask) & COLUMN (col)) != 0;
+}
+
+/* Static evaluation for the player to move: open threes and the
+   center column */
+static gint
+evaluate (guint64 current, guint64 mask)
+{
+  guint64 opponent = current ^ mask;
+
+  return 8 * (popcount (winning_cells (current, mask))
+	      - popcount (winning_cells (opponent, mask)))
+    + 2 * (popcount (current & COLUMN (3)) - popcount (opponent & COLUMN (3)));
+}
+
+/* Win and loss scores depend on the ply, store them relative to the
+   position */
+static inline gint
+score_to_table (gint score, gint ply)
+{
+  if (score >= MATE_SCORE)
+    return score + ply;
+  if (score <= -MATE_SCORE)
+    return score - ply;
+  return score;
+}
+
+static inline gint
+score_from_table (gint score, gint ply)
+{
+  if (score >= MATE_SCORE)
+    return score - ply;
+  if (score <= -MATE_SCORE)
+    return score + ply;
+  return score;
+}
+
+static inline Connect4Entry *
+table_entry (GcConnect4 *engine, guint64 key)
+{
+  return &engine->table[(key * G_GUINT64_CONSTANT (0x9E3779B97F4A7C15))
+			>> (64 - TABLE_BITS)];
+}
+
+static gint
+negamax (GcConnect4 *engine, guint64 current, guint64 mask,
+	 gint depth, gint alpha, gint beta, gint ply)
+{
+  guint64 key = current + mask + bottom_all;
+  Connect4Entry *entry;
+  gint alpha_orig = alpha;
+  gint best = -INFINITY_SCORE, best_move = -1;
+  gint moves[WIDTH + 1];
+  gint n_moves = 0;
+  gint i, col;
+
+  if (engine->can_abort
+      && ++engine->nodes % CLOCK_NODES == 0
+      && engine->budget > 0
+      && g_timer_elapsed (engine->timer, NULL) > engine->budget)
+    engine->aborted = TRUE;
+
+  if (engine->aborted)
+    return 0;
+
+  /* Draw game */
+  if (popcount (mask) == N_CELLS)
+    return 0;
+
+  /* Win now */
+  if (winning_cells (current, mask) & playable_cells (mask))
+    return WIN - ply - 1;
+
+  if (depth == 0)
+    return evaluate (current, mask);
+
+  entry = table_entry (engine, key);
+  if (entry->key == key)
+    {
+      if (entry->depth >= depth)
+	{
+	  gint value = score_from_table (entry->value, ply);
+
+	  if (entry->flag == TT_EXACT)
+	    return value;
+	  if (entry->flag == TT_LOWER)
+	    alpha = MAX (alpha, value);
+	  else
+	    beta = MIN (beta, value);
+	  if (alpha >= beta)
+	    return value;
+	}
+
+      if (entry->move >= 0)
+	moves[n_moves++] = entry->move;
+    }
+
+  for (i = 0; i < WIDTH; i++)
+    if (n_moves == 0 || column_order[i] != moves[0])
+      moves[n_moves++] = column_order[i];
+
+  for (i = 0; i < n_moves; i++)
+    {
+      gint value;
+
+      col = moves[i];
+      if (!can_play (mask, col))
+	continue;
+
+      value = -negamax (engine,
+			current ^ mask, mask | (mask + BOTTOM (col)),
+			depth - 1, -beta, -alpha, ply + 1);
+      if (engine->aborted)
+	return 0;
+
+      if (value > best)
+	{
+	  best = value;
+	  best_move = col;
+	}
+      if (best > alpha)
+	alpha = best;
+      if (alpha >= beta)
+	break;
+    }
+
+  entry->key = key;
+  entry->value = score_to_table (best, ply);
+  entry->depth = depth;
+  entry->move = best_move;
+  if (best <= alpha_orig)
+    entry->flag = TT_UPPER;
+  else if (best >= beta)
+    entry->flag = TT_LOWER;
+  else
+    entry->flag = TT_EXACT;
+
+  return best;
+}
+
+GcConnect4 *
+gc_connect4_new (void)
+{
+  GcConnect4 *engine = g_new0 (GcConnect4, 1);
+  gint col;
+
+  if (!bottom_all)
+    {
+      for (col = 0; col < WIDTH; col++)
+	bottom_all |= BOTTOM (col);
+      board_all = bottom_all * ((G_GUINT64_CONSTANT (1) << HEIGHT) - 1);
+    }
+
+  engine->table = g_new0 (Connect4Entry, TABLE_SIZE);
+  engine->timer = g_timer_new ();
+
+  return engine;
+}
+
+void
+gc_connect4_free (GcConnect4 *engine)
+{
+  if (!engine)
+    return;
+
+  g_timer_destroy (engine->timer);
+  g_free (engine->table);
+  g_free (engine);
+}
+
+gint
+gc_connect4_search (GcConnect4 *engine,
+		    guint64 current,
+		    guint64 mask,
+		    gint depth,
+		    gint msec,
+		    gint scores[GC_CONNECT4_WIDTH])
+{
+  gint order[WIDTH];
+  gint iteration_scores[WIDTH];
+  gint n_legal = 0;
+  gint iteration, i, col;
+
+  g_return_val_if_fail (engine != NULL, 0);
+
+  memcpy (order, column_order, sizeof (order));
+
+  for (col = 0; col < WIDTH; col++)
+    {
+      scores[col] = GC_CONNECT4_ILLEGAL;
+      if (can_play (mask, col))
+	n_legal++;
+    }
+
+  if (n_legal == 0)
+    return 0;
+
+  depth = CLAMP (depth, 1, N_CELLS - popcount (mask));
+
+  engine->budget = msec / 1000.0;
+  engine->nodes = 0;
+  engine->aborted = FALSE;
+  g_timer_start (engine->timer);
+
+  /* Iterative deepening, the best move of an iteration is searched
+     first by the next one */
+  for (iteration = 1; iteration <= depth; iteration++)
+    {
+      gint best = -INFINITY_SCORE;
+
+      /* The first iteration always completes */
+      engine->can_abort = iteration > 1;
+
+      for (i = 0; i < WIDTH; i++)
+	{
+	  gint alpha;
+
+	  col = order[i];
+	  iteration_scores[col] = GC_CONNECT4_ILLEGAL;
+	  if (!can_play (mask, col))
+	    continue;
+
+	  if (is_winning_move (current, mask, col))
+	    iteration_scores[col] = WIN - 1;
+	  else
+	    {
+	      /* Moves as good as the best one get their exact score */
+	      alpha = best > -INFINITY_SCORE ? best - 1 : -INFINITY_SCORE;
+	      iteration_scores[col] =
+		-negamax (engine,
+			  current ^ mask, mask | (mask + BOTTOM (col)),
+			  iteration - 1, -INFINITY_SCORE, -alpha, 1);
+	      if (engine->aborted)
+		break;
+	    }
+
+	  best = MAX (best, iteration_scores[col]);
+	}
+
+      if (engine->aborted)
+	break;
+
+      memcpy (scores, iteration_scores, sizeof (iteration_scores));
+
+      /* Search the best move first on the next iteration */
+      for (i = 1; i < WIDTH; i++)
+	if (scores[order[i]] == best)
+	  {
+	    col = order[i];
+	    memmove (order + 1, order, i * sizeof (gint));
+	    order[0] = col;
+	    break;
+	  }
+
+      /* The game outcome is known */
+      if (best >= MATE_SCORE || best <= -MATE_SCORE)
+	break;
+    }
+
+  g_timer_stop (engine->timer);
+
+  return n_legal;
+}
@@ -0,0 +1,62 @@
+/* gcompris - gcompris_connect4.h
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GCOMPRIS_CONNECT4_H_
+#define _GCOMPRIS_CONNECT4_H_
+
+#include <glib.h>
+
+#define GC_CONNECT4_WIDTH	7
+#define GC_CONNECT4_HEIGHT	6
+
+/* Score of a column that cannot be played */
+#define GC_CONNECT4_ILLEGAL	G_MININT
+/* Scores at or above this value are a forced win, the sooner the higher */
+#define GC_CONNECT4_WIN		10000
+
+/* A connect 4 engine on 64 bits bitboards. Each column uses 7 bits,
+ * bit col * 7 + row, row 0 being the bottom. The 7th bit of each
+ * column stays empty.
+ *
+ * The engine keeps its transposition table between two searches.
+ */
+typedef struct _GcConnect4 GcConnect4;
+
+GcConnect4	*gc_connect4_new    (void);
+void		 gc_connect4_free   (GcConnect4 *engine);
+
+/* Search the position for the player to move.
+ * current: the stones of the player to move
+ * mask: all the stones
+ * depth: the maximum depth in plies
+ * msec: the time budget of the search, 0 for none
+ *
+ * scores[col] gets the score of each column for the player to move,
+ * or GC_CONNECT4_ILLEGAL. The scores lower than the best one are upper
+ * bounds, the best moves have the exact best score.
+ *
+ * Returns the number of legal moves.
+ */
+gint		 gc_connect4_search (GcConnect4 *engine,
+				     guint64 current,
+				     guint64 mask,
+				     gint depth,
+				     gint msec,
+				     gint scores[GC_CONNECT4_WIDTH]);
+
+#endif
@@ -36,7 +36,7 @@ static sqlite3 *gcompris_db=NULL;
 
 // Increase this when the database schema changes
 // but does not change the PRAGMA SCHEMA VERSION
-#define SCHEMA_USER_VERSION 1
+#define SCHEMA_USER_VERSION 3
 
 #define CREATE_TABLE_USERS						\
   "CREATE TABLE users (user_id INT UNIQUE, login TEXT, lastname TEXT, firstname TEXT, birthdate TEXT, class_id INT ); "
@@ -58,6 +58,15 @@ static sqlite3 *gcompris_db=NULL;
   "CREATE TABLE boards (board_id INT UNIQUE, name TEXT, section_id INT, section TEXT, author TEXT, type TEXT, mode TEXT, difficulty INT, icon TEXT, boarddir TEXT, mandatory_sound_file TEXT, mandatory_sound_dataset TEXT, filename TEXT, title TEXT, description TEXT, prerequisite TEXT, goal TEXT, manual TEXT, credit TEXT, demo INT);"
 #define CREATE_TABLE_LOGS						\
   "CREATE TABLE logs (date TEXT, duration INT, user_id INT, board_id INT, level INT, sublevel INT, status INT, comment TEXT);"
+#define CREATE_INDEX_LOGS						\
+  "CREATE INDEX IF NOT EXISTS logs_date ON logs (date); "		\
+  "CREATE INDEX IF NOT EXISTS logs_user ON logs (user_id, date);"
+/* One row per (user, board, level), kept up to date from logs by the
+ * insert_logs and delete_logs triggers */
+#define CREATE_TABLE_LOGS_STATS						\
+  "CREATE TABLE logs_stats (user_id INT, board_id INT, level INT, played INT, won INT, drawn INT, completed INT, duration INT, last_date TEXT, UNIQUE (user_id, board_id, level));"
+#define FILL_TABLE_LOGS_STATS						\
+  "INSERT INTO logs_stats SELECT user_id, board_id, level, COUNT(*), SUM(status=1), SUM(status=2), SUM(status=3), SUM(duration), MAX(date) FROM logs GROUP BY user_id, board_id, level;"
 
 #define CREATE_TABLE_INFO						\
   "CREATE TABLE informations (gcompris_version TEXT UNIQUE, init_date TEXTUNIQUE, profile_id INT UNIQUE ); "
@@ -133,6 +142,23 @@ static sqlite3 *gcompris_db=NULL;
        UPDATE list_users_in_groups SET group_id=(SELECT wholegroup_id FROM class WHERE class_id=new.class_id) WHERE user_id=new.user_id; \
      END;"
 
+/* The status values are the ones of GCBonusStatusList:
+ * 1 is GC_BOARD_WIN, 2 is GC_BOARD_DRAW and 3 is GC_BOARD_COMPLETED */
+#define TRIGGER_INSERT_LOGS						\
+  "CREATE TRIGGER insert_logs INSERT ON logs\
+     BEGIN								\
+       INSERT OR IGNORE INTO logs_stats VALUES (new.user_id, new.board_id, new.level, 0, 0, 0, 0, 0, new.date); \
+       UPDATE logs_stats SET played=played+1, won=won+(new.status=1), drawn=drawn+(new.status=2), completed=completed+(new.status=3), duration=duration+new.duration, last_date=MAX(last_date, new.date) WHERE user_id=new.user_id AND board_id=new.board_id AND level=new.level; \
+     END;"
+
+/* last_date is left as is, it is the date of the last log recorded */
+#define TRIGGER_DELETE_LOGS						\
+  "CREATE TRIGGER delete_logs DELETE ON logs\
+     BEGIN								\
+       UPDATE logs_stats SET played=played-1, won=won-(old.status=1), drawn=drawn-(old.status=2), completed=completed-(old.status=3), duration=duration-old.duration WHERE user_id=old.user_id AND board_id=old.board_id AND level=old.level; \
+       DELETE FROM logs_stats WHERE user_id=old.user_id AND board_id=old.board_id AND level=old.level AND played<=0; \
+     END;"
+
 #ifdef USE_SQLITE
 /* Return the user version of the database
  * or -1 if failed. The user version is an sqlite
@@ -252,6 +278,14 @@ static void _create_db()
   if( rc!=SQLITE_OK ){
     g_error("SQL error: %s\n", zErrMsg);
   }
+  rc = sqlite3_exec(gcompris_db,CREATE_INDEX_LOGS, NULL,  0, &zErrMsg);
+  if( rc!=SQLITE_OK ){
+    g_error("SQL error: %s\n", zErrMsg);
+  }
+  rc = sqlite3_exec(gcompris_db,CREATE_TABLE_LOGS_STATS, NULL,  0, &zErrMsg);
+  if( rc!=SQLITE_OK ){
+    g_error("SQL error: %s\n", zErrMsg);
+  }
 
   /* CREATE TRIGGERS */
   rc = sqlite3_exec(gcompris_db,TRIGGER_DELETE_CLASS, NULL,  0, &zErrMsg);
@@ -278,6 +312,14 @@ static void _create_db()
   if( rc!=SQLITE_OK ){
     g_error("SQL error: %s\n", zErrMsg);
   }
+  rc = sqlite3_exec(gcompris_db,TRIGGER_INSERT_LOGS, NULL,  0, &zErrMsg);
+  if( rc!=SQLITE_OK ){
+    g_error("SQL error: %s\n", zErrMsg);
+  }
+  rc = sqlite3_exec(gcompris_db,TRIGGER_DELETE_LOGS, NULL,  0, &zErrMsg);
+  if( rc!=SQLITE_OK ){
+    g_error("SQL error: %s\n", zErrMsg);
+  }
 
   g_message("Database tables created");
 
@@ -505,6 +547,31 @@ gboolean gc_db_init(gboolean disable_database_)
 	properties->reread_menu = TRUE;
 	_set_user_version(1);
       }
+    if ( _get_user_version() == 1)
+      {
+	g_message("Upgrading schema based on user version = 1\n");
+	rc = sqlite3_exec(gcompris_db,CREATE_INDEX_LOGS, NULL,  0, &zErrMsg);
+	if( rc!=SQLITE_OK ) {
+	  g_error("SQL error: %s\n", zErrMsg);
+	}
+	_set_user_version(2);
+      }
+    if ( _get_user_version() == 2)
+      {
+	g_message("Upgrading schema based on user version = 2\n");
+	rc = sqlite3_exec(gcompris_db,
+			  "BEGIN TRANSACTION; "
+			  CREATE_TABLE_LOGS_STATS
+			  FILL_TABLE_LOGS_STATS
+			  TRIGGER_INSERT_LOGS
+			  TRIGGER_DELETE_LOGS
+			  "COMMIT;",
+			  NULL,  0, &zErrMsg);
+	if( rc!=SQLITE_OK ) {
+	  g_error("SQL error: %s\n", zErrMsg);
+	}
+	_set_user_version(3);
+      }
   }
 
   return TRUE;
@@ -2120,6 +2187,216 @@ gboolean gc_db_log(gchar *date, int duration,
 #endif
 }
 
+/* WARNING: template for g_strdup_printf
+ * The keyset (date, rowid) of the last row of the previous page lets
+ * sqlite seek in the date index instead of skipping an OFFSET.
+ */
+#define GET_LOGS(user_filter, date, rowid, limit)			\
+  "SELECT logs.rowid, logs.date, users.login, boards.name, "		\
+  "logs.level, logs.sublevel, logs.duration, logs.status "		\
+  "FROM logs "								\
+  "LEFT JOIN users ON users.user_id=logs.user_id "			\
+  "LEFT JOIN boards ON boards.board_id=logs.board_id "			\
+  "WHERE %s logs.date>=\'%s\' "					\
+  "AND (logs.date>\'%s\' OR logs.rowid>%" G_GINT64_FORMAT ") "		\
+  "ORDER BY logs.date, logs.rowid LIMIT %d;",				\
+    user_filter, date, date, rowid, limit
+
+/** \brief get a page of logs with the user login and board name
+ *
+ * \param user_id : the user to get the logs of, or GC_DB_LOG_ALL_USERS
+ * \param after_date, after_rowid : the last log of the previous page,
+ *        NULL and 0 for the first page
+ * \param limit : the maximum number of logs to return
+ *
+ * \return a list of GcomprisLog, free it with gc_db_log_list_free()
+ */
+GList *gc_db_get_logs(int user_id,
+		      gchar *after_date, gint64 after_rowid,
+		      int limit)
+{
+  SUPPORT_OR_RETURN(NULL);
+
+#ifdef USE_SQLITE
+  GList *logs_list = NULL;
+
+  char *zErrMsg;
+  char **result;
+  int rc;
+  int nrow;
+  int ncolumn;
+  int i;
+  gchar *request;
+  gchar *user_filter;
+  gchar *date_quoted = escape_quote(after_date ? after_date : "");
+  GcomprisLog *log;
+
+  if(user_id == GC_DB_LOG_ALL_USERS)
+    user_filter = g_strdup("");
+  else
+    user_filter = g_strdup_printf("logs.user_id=%d AND", user_id);
+
+  request = g_strdup_printf(GET_LOGS(user_filter,
+				     date_quoted,
+				     after_date ? after_rowid : G_GINT64_CONSTANT(-1),
+				     limit));
+
+  rc = sqlite3_get_table(gcompris_db,
+			 request,
+			 &result,
+			 &nrow,
+			 &ncolumn,
+			 &zErrMsg
+			 );
+
+  g_free(request);
+  g_free(user_filter);
+  g_free(date_quoted);
+
+  if( rc!=SQLITE_OK ){
+    g_error("SQL error: %s\n", zErrMsg);
+  }
+
+  i = ncolumn;
+  while ( i < (nrow +1)*ncolumn) {
+    log = g_malloc0(sizeof(GcomprisLog));
+
+    log->log_id = g_ascii_strtoll(result[i++], NULL, 10);
+    log->date = g_strdup(result[i++]);
+    log->login = g_strdup(result[i++]);
+    log->board = g_strdup(result[i++]);
+    log->level = atoi(result[i++]);
+    log->sublevel = atoi(result[i++]);
+    log->duration = atoi(result[i++]);
+    log->status = atoi(result[i++]);
+
+    logs_list = g_list_prepend(logs_list, log);
+  }
+
+  sqlite3_free_table(result);
+
+  return g_list_reverse(logs_list);
+#endif
+}
+
+void gc_db_log_list_free(GList *logs_list)
+{
+  GList *list;
+
+  for (list = logs_list; list != NULL; list = list->next)
+    {
+      GcomprisLog *log = (GcomprisLog *) list->data;
+
+      g_free(log->date);
+      g_free(log->login);
+      g_free(log->board);
+      g_free(log);
+    }
+
+  g_list_free(logs_list);
+}
+
+/* WARNING: template for g_strdup_printf */
+#define GET_LOG_STATS(user_filter)					\
+  "SELECT logs_stats.user_id, users.login, logs_stats.board_id, boards.name, " \
+  "logs_stats.level, logs_stats.played, logs_stats.won, logs_stats.drawn, " \
+  "logs_stats.completed, logs_stats.duration, logs_stats.last_date "	\
+  "FROM logs_stats "							\
+  "LEFT JOIN users ON users.user_id=logs_stats.user_id "		\
+  "LEFT JOIN boards ON boards.board_id=logs_stats.board_id "		\
+  "%s ORDER BY logs_stats.user_id, boards.name, logs_stats.level;",	\
+    user_filter
+
+/** \brief get the progress of a user on each board and level
+ *
+ * The statistics are maintained by triggers on the logs table, this
+ * does not read the logs.
+ *
+ * \param user_id : the user to get the statistics of, or GC_DB_LOG_ALL_USERS
+ *
+ * \return a list of GcomprisLogStats, free it with gc_db_log_stats_list_free()
+ */
+GList *gc_db_get_log_stats(int user_id)
+{
+  SUPPORT_OR_RETURN(NULL);
+
+#ifdef USE_SQLITE
+  GList *stats_list = NULL;
+
+  char *zErrMsg;
+  char **result;
+  int rc;
+  int nrow;
+  int ncolumn;
+  int i;
+  gchar *request;
+  gchar *user_filter;
+  GcomprisLogStats *stats;
+
+  if(user_id == GC_DB_LOG_ALL_USERS)
+    user_filter = g_strdup("");
+  else
+    user_filter = g_strdup_printf("WHERE logs_stats.user_id=%d", user_id);
+
+  request = g_strdup_printf(GET_LOG_STATS(user_filter));
+
+  rc = sqlite3_get_table(gcompris_db,
+			 request,
+			 &result,
+			 &nrow,
+			 &ncolumn,
+			 &zErrMsg
+			 );
+
+  g_free(request);
+  g_free(user_filter);
+
+  if( rc!=SQLITE_OK ){
+    g_error("SQL error: %s\n", zErrMsg);
+  }
+
+  i = ncolumn;
+  while ( i < (nrow +1)*ncolumn) {
+    stats = g_malloc0(sizeof(GcomprisLogStats));
+
+    stats->user_id = atoi(result[i++]);
+    stats->login = g_strdup(result[i++]);
+    stats->board_id = atoi(result[i++]);
+    stats->board = g_strdup(result[i++]);
+    stats->level = atoi(result[i++]);
+    stats->played = atoi(result[i++]);
+    stats->won = atoi(result[i++]);
+    stats->drawn = atoi(result[i++]);
+    stats->completed = atoi(result[i++]);
+    stats->duration = atoi(result[i++]);
+    stats->last_date = g_strdup(result[i++]);
+
+    stats_list = g_list_prepend(stats_list, stats);
+  }
+
+  sqlite3_free_table(result);
+
+  return g_list_reverse(stats_list);
+#endif
+}
+
+void gc_db_log_stats_list_free(GList *stats_list)
+{
+  GList *list;
+
+  for (list = stats_list; list != NULL; list = list->next)
+    {
+      GcomprisLogStats *stats = (GcomprisLogStats *) list->data;
+
+      g_free(stats->login);
+      g_free(stats->board);
+      g_free(stats->last_date);
+      g_free(stats);
+    }
+
+  g_list_free(stats_list);
+}
+
 /* \brief SQL Requires single ' to be replaced by ''
  *
  */
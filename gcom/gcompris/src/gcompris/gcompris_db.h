@@ -123,4 +123,54 @@ gboolean gc_db_log(gchar *date, int duration,
 	       int level, int sublevel,
 	       int status, gchar *comment);
 
+/* Log viewer */
+
+/* user_id of gc_db_get_logs() to get the logs of every user */
+#define GC_DB_LOG_ALL_USERS -2
+
+typedef struct {
+  /* The rowid of the log, with date it orders the logs */
+  gint64             log_id;
+  gchar             *date;
+
+  /* NULL for the default user */
+  gchar             *login;
+
+  /* The board name, NULL if the board is not known anymore */
+  gchar             *board;
+
+  gint               level;
+  gint               sublevel;
+  gint               duration;
+  gint               status;
+} GcomprisLog;
+
+GList *gc_db_get_logs(int user_id,
+		      gchar *after_date, gint64 after_rowid,
+		      int limit);
+void gc_db_log_list_free(GList *logs_list);
+
+/* Progress of a user on a board level, summed over its logs */
+typedef struct {
+  gint               user_id;
+  gchar             *login;
+  gint               board_id;
+  gchar             *board;
+  gint               level;
+
+  /* Number of logs, and how many of them are won, drawn or completed.
+     The others are lost. */
+  gint               played;
+  gint               won;
+  gint               drawn;
+  gint               completed;
+
+  /* Total time spent, in seconds */
+  gint               duration;
+  gchar             *last_date;
+} GcomprisLogStats;
+
+GList *gc_db_get_log_stats(int user_id);
+void gc_db_log_stats_list_free(GList *stats_list);
+
 #endif
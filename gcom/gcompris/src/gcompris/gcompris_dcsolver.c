@@ -0,0 +1,1139 @@
+/* gcompris - gcompris_dcsolver.c
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "gcompris_dcsolver.h"
+
+/* Conductance added from each node to the ground so that floating
+   parts of the circuit do not make the matrix singular */
+#define DC_GMIN			1e-12
+/* Resistances are clamped to this value, a closed switch is 0 ohm */
+#define DC_RMIN			1e-6
+/* Thermal voltage at 27 degrees, like gnucap */
+#define DC_VT			0.025864
+/* A reused pivot smaller than this fraction of its row forces a new
+   pivot order */
+#define DC_PIVOT_THRESHOLD	1e-3
+#define DC_MAX_ITERATIONS	200
+#define DC_RELTOL		1e-3
+#define DC_VNTOL		1e-6
+
+typedef struct
+{
+  gchar		*name;
+  gdouble	 is;
+  gdouble	 n;
+} DcModel;
+
+typedef struct
+{
+  gchar		 type;		/* 'r', 'v' or 'd' */
+  gchar		*name;
+  gint		 n1, n2;	/* unknown index of the nodes, -1 is the ground */
+  gdouble	 value;		/* resistance, voltage or diode area */
+  gchar		*model;		/* diode model name */
+  gint		 branch;	/* unknown index of a voltage source current */
+  gint		 entry[4];	/* stamped matrix entries, -1 for the ground */
+  gdouble	 is, nvt;	/* diode parameters from its model */
+  gdouble	 vd;		/* diode voltage of the last newton iteration */
+  gdouble	 gd, ieq;	/* diode linear companion model */
+} DcElement;
+
+typedef struct
+{
+  gchar		 kind;		/* 'v' or 'i' */
+  gchar		*element;
+} DcProbe;
+
+struct _GcDcCircuit
+{
+  gchar		*netlist;	/* the last solved netlist */
+  GArray	*results;	/* and its results */
+  gchar		*error;
+
+  GArray	*elements;	/* DcElement */
+  GArray	*models;	/* DcModel */
+  GArray	*probes;	/* DcProbe */
+  GHashTable	*nodes;		/* node name -> unknown index + 1 */
+  gint		 n_nodes;	/* nodes without the ground */
+  gint		 size;		/* number of unknowns */
+
+  /* The matrix entries stamped by the elements */
+  gint		 n_entries;
+  gint		*entry_row, *entry_col;
+  gdouble	*entry_value;
+  gint		*entry_lu;	/* slot of each entry in lu */
+
+  /* The L and U factors stored by rows in pivot order. Pivot k is
+     at row_perm[k], col_perm[k] of the original matrix. */
+  gboolean	 ordered;
+  gint		*row_perm, *col_perm;
+  gint		*row_ptr, *col_idx, *diag;
+  gdouble	*lu;
+  gdouble	*rhs, *x, *work;
+};
+
+static void
+dc_elements_free (GArray *elements)
+{
+  guint i;
+
+  for (i = 0; i < elements->len; i++)
+    {
+      DcElement *element = &g_array_index (elements, DcElement, i);
+      g_free (element->name);
+      g_free (element->model);
+    }
+  g_array_free (elements, TRUE);
+}
+
+static void
+dc_models_free (GArray *models)
+{
+  guint i;
+
+  for (i = 0; i < models->len; i++)
+    g_free (g_array_index (models, DcModel, i).name);
+  g_array_free (models, TRUE);
+}
+
+static void
+dc_probes_free (GArray *probes)
+{
+  guint i;
+
+  for (i = 0; i < probes->len; i++)
+    g_free (g_array_index (probes, DcProbe, i).element);
+  g_array_free (probes, TRUE);
+}
+
+/* Release the matrix structure, it is rebuilt on the next solve */
+static void
+dc_circuit_clear_matrix (GcDcCircuit *circuit)
+{
+  g_free (circuit->entry_row);
+  g_free (circuit->entry_col);
+  g_free (circuit->entry_value);
+  g_free (circuit->entry_lu);
+  g_free (circuit->row_perm);
+  g_free (circuit->col_perm);
+  g_free (circuit->row_ptr);
+  g_free (circuit->col_idx);
+  g_free (circuit->diag);
+  g_free (circuit->lu);
+  g_free (circuit->rhs);
+  g_free (circuit->x);
+  g_free (circuit->work);
+
+  circuit->entry_row = circuit->entry_col = NULL;
+  circuit->entry_value = NULL;
+  circuit->entry_lu = NULL;
+  circuit->row_perm = circuit->col_perm = NULL;
+  circuit->row_ptr = circuit->col_idx = circuit->diag = NULL;
+  circuit->lu = circuit->rhs = circuit->x = circuit->work = NULL;
+  circuit->n_entries = 0;
+  circuit->size = 0;
+  circuit->ordered = FALSE;
+}
+
+GcDcCircuit *
+gc_dc_circuit_new (void)
+{
+  GcDcCircuit *circuit = g_new0 (GcDcCircuit, 1);
+
+  circuit->results = g_array_new (FALSE, FALSE, sizeof (gdouble));
+
+  return circuit;
+}
+
+void
+gc_dc_circuit_free (GcDcCircuit *circuit)
+{
+  if (!circuit)
+    return;
+
+  dc_circuit_clear_matrix (circuit);
+
+  if (circuit->elements)
+    dc_elements_free (circuit->elements);
+  if (circuit->models)
+    dc_models_free (circuit->models);
+  if (circuit->probes)
+    dc_probes_free (circuit->probes);
+  if (circuit->nodes)
+    g_hash_table_destroy (circuit->nodes);
+
+  g_array_free (circuit->results, TRUE);
+  g_free (circuit->netlist);
+  g_free (circuit->error);
+  g_free (circuit);
+}
+
+const gchar *
+gc_dc_circuit_get_error (GcDcCircuit *circuit)
+{
+  return circuit->error;
+}
+
+static GcDcStatus
+dc_circuit_set_error (GcDcCircuit *circuit, GcDcStatus status,
+		      const gchar *what)
+{
+  g_free (circuit->error);
+  circuit->error = g_strdup (what);
+
+  /* Do not trust the cached results anymore */
+  g_free (circuit->netlist);
+  circuit->netlist = NULL;
+
+  return status;
+}
+
+/*
+ * Netlist parsing
+ * ---------------
+ */
+
+/* Parse a spice value like 10, 1f, 50.u or 10000k */
+static gboolean
+dc_parse_value (const gchar *token, gdouble *value)
+{
+  gchar *end;
+  gdouble v;
+
+  v = g_ascii_strtod (token, &end);
+  if (end == token)
+    return FALSE;
+
+  if (g_ascii_strncasecmp (end, "meg", 3) == 0)
+    v *= 1e6;
+  else
+    switch (g_ascii_tolower (*end))
+      {
+      case 't': v *= 1e12;  break;
+      case 'g': v *= 1e9;   break;
+      case 'k': v *= 1e3;   break;
+      case 'm': v *= 1e-3;  break;
+      case 'u': v *= 1e-6;  break;
+      case 'n': v *= 1e-9;  break;
+      case 'p': v *= 1e-12; break;
+      case 'f': v *= 1e-15; break;
+      default:
+	/* No scale, anything else is a unit name */
+	break;
+      }
+
+  *value = v;
+  return TRUE;
+}
+
+/* Split a line in its tokens, dropping the separators */
+static gchar **
+dc_split (const gchar *line, gint *n_tokens)
+{
+  gchar **tokens = g_strsplit_set (line, " \t\r(),=", -1);
+  gint i, n = 0;
+
+  for (i = 0; tokens[i]; i++)
+    {
+      if (tokens[i][0] == '\0')
+	g_free (tokens[i]);
+      else
+	tokens[n++] = tokens[i];
+    }
+  tokens[n] = NULL;
+
+  *n_tokens = n;
+  return tokens;
+}
+
+/* Returns the unknown index of the node, or -1 for the ground */
+static gint
+dc_node_index (GcDcCircuit *circuit, const gchar *name)
+{
+  gpointer index;
+
+  if (strcmp (name, "0") == 0 || g_ascii_strcasecmp (name, "gnd") == 0)
+    return -1;
+
+  index = g_hash_table_lookup (circuit->nodes, name);
+  if (!index)
+    {
+      index = GINT_TO_POINTER (++circuit->n_nodes);
+      g_hash_table_insert (circuit->nodes, g_strdup (name), index);
+    }
+
+  return GPOINTER_TO_INT (index) - 1;
+}
+
+static gboolean
+dc_parse_model (GcDcCircuit *circuit, gchar **tokens, gint n)
+{
+  DcModel model;
+  gint i;
+
+  if (n < 3)
+    return FALSE;
+
+  /* Only diode models are needed */
+  if (g_ascii_strcasecmp (tokens[2], "d") != 0)
+    return TRUE;
+
+  model.name = g_strdup (tokens[1]);
+  model.is = 1e-14;
+  model.n = 1.0;
+
+  for (i = 3; i + 1 < n; i += 2)
+    {
+      gdouble value;
+
+      if (!dc_parse_value (tokens[i + 1], &value))
+	{
+	  g_free (model.name);
+	  return FALSE;
+	}
+
+      if (g_ascii_strcasecmp (tokens[i], "is") == 0)
+	model.is = value;
+      else if (g_ascii_strcasecmp (tokens[i], "n") == 0)
+	model.n = value;
+    }
+
+  g_array_append_val (circuit->models, model);
+  return TRUE;
+}
+
+static void
+dc_parse_print (GcDcCircuit *circuit, gchar **tokens, gint n)
+{
+  gint i;
+
+  /* .print dc + v(R1) i(R1) */
+  for (i = 1; i + 1 < n; i++)
+    {
+      gchar kind = g_ascii_tolower (tokens[i][0]);
+
+      if (tokens[i][1] == '\0' && (kind == 'v' || kind == 'i'))
+	{
+	  DcProbe probe;
+
+	  probe.kind = kind;
+	  probe.element = g_strdup (tokens[++i]);
+	  g_array_append_val (circuit->probes, probe);
+	}
+    }
+}
+
+static gboolean
+dc_parse_element (GcDcCircuit *circuit, gchar **tokens, gint n)
+{
+  DcElement element;
+
+  memset (&element, 0, sizeof (element));
+  element.type = g_ascii_tolower (tokens[0][0]);
+  element.branch = -1;
+  element.value = 1.0;
+
+  if (n < 4)
+    return FALSE;
+
+  switch (element.type)
+    {
+    case 'r':
+      if (!dc_parse_value (tokens[3], &element.value))
+	return FALSE;
+      break;
+    case 'v':
+      /* Accept both 'V1 1 0 10' and 'V1 1 0 dc 10' */
+      if (g_ascii_strcasecmp (tokens[3], "dc") == 0)
+	{
+	  if (n < 5 || !dc_parse_value (tokens[4], &element.value))
+	    return FALSE;
+	}
+      else if (!dc_parse_value (tokens[3], &element.value))
+	return FALSE;
+      break;
+    case 'd':
+      if (n >= 5 && !dc_parse_value (tokens[4], &element.value))
+	return FALSE;
+      element.model = g_strdup (tokens[3]);
+      break;
+    default:
+      return FALSE;
+    }
+
+  element.name = g_strdup (tokens[0]);
+  element.n1 = dc_node_index (circuit, tokens[1]);
+  element.n2 = dc_node_index (circuit, tokens[2]);
+
+  g_array_append_val (circuit->elements, element);
+  return TRUE;
+}
+
+/* Parse the netlist in the circuit. Returns FALSE and sets the error
+   to the faulty line on failure. */
+static gboolean
+dc_circuit_parse (GcDcCircuit *circuit, const gchar *netlist)
+{
+  gchar **lines = g_strsplit (netlist, "\n", -1);
+  GString *line = g_string_new (NULL);
+  gboolean ok = TRUE;
+  gint i;
+
+  circuit->elements = g_array_new (FALSE, FALSE, sizeof (DcElement));
+  circuit->models = g_array_new (FALSE, FALSE, sizeof (DcModel));
+  circuit->probes = g_array_new (FALSE, FALSE, sizeof (DcProbe));
+  circuit->nodes = g_hash_table_new_full (g_str_hash, g_str_equal,
+					  g_free, NULL);
+  circuit->n_nodes = 0;
+
+  /* The first line is the title */
+  for (i = 1; ok && lines[i - 1]; i++)
+    {
+      gchar **tokens;
+      gint n;
+
+      if (lines[i] && lines[i][0] == '+')
+	{
+	  /* Continuation of the previous line */
+	  g_string_append (line, lines[i] + 1);
+	  continue;
+	}
+
+      tokens = dc_split (line->str, &n);
+
+      if (n == 0 || tokens[0][0] == '*')
+	;
+      else if (g_ascii_strcasecmp (tokens[0], ".model") == 0)
+	ok = dc_parse_model (circuit, tokens, n);
+      else if (g_ascii_strcasecmp (tokens[0], ".print") == 0)
+	dc_parse_print (circuit, tokens, n);
+      else if (tokens[0][0] == '.')
+	/* .dc, .op, .end */
+	;
+      else
+	ok = dc_parse_element (circuit, tokens, n);
+
+      if (!ok)
+	dc_circuit_set_error (circuit, GC_DC_PARSE_ERROR, line->str);
+
+      g_strfreev (tokens);
+      g_string_assign (line, lines[i] ? lines[i] : "");
+    }
+
+  g_string_free (line, TRUE);
+  g_strfreev (lines);
+
+  return ok;
+}
+
+static DcModel *
+dc_circuit_find_model (GcDcCircuit *circuit, const gchar *name)
+{
+  guint i;
+
+  for (i = 0; i < circuit->models->len; i++)
+    if (g_ascii_strcasecmp (g_array_index (circuit->models, DcModel, i).name,
+			    name) == 0)
+      return &g_array_index (circuit->models, DcModel, i);
+
+  return NULL;
+}
+
+static DcElement *
+dc_circuit_find_element (GcDcCircuit *circuit, const gchar *name)
+{
+  guint i;
+
+  for (i = 0; i < circuit->elements->len; i++)
+    if (g_ascii_strcasecmp (g_array_index (circuit->elements, DcElement, i).name,
+			    name) == 0)
+      return &g_array_index (circuit->elements, DcElement, i);
+
+  return NULL;
+}
+
+/* Returns TRUE if both element lists build the same matrix structure */
+static gboolean
+dc_same_topology (GArray *a, gint a_nodes, GArray *b, gint b_nodes)
+{
+  guint i;
+
+  if (a_nodes != b_nodes || a->len != b->len)
+    return FALSE;
+
+  for (i = 0; i < a->len; i++)
+    {
+      DcElement *ea = &g_array_index (a, DcElement, i);
+      DcElement *eb = &g_array_index (b, DcElement, i);
+
+      if (ea->type != eb->type || ea->n1 != eb->n1 || ea->n2 != eb->n2
+	  || g_ascii_strcasecmp (ea->name, eb->name) != 0)
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*
+ * Matrix structure
+ * ----------------
+ */
+
+/* Returns the entry for row, col, creating it if needed */
+static gint
+dc_circuit_entry (GcDcCircuit *circuit, GHashTable *entries,
+		  GArray *rows, GArray *cols, gint row, gint col)
+{
+  gpointer key, index;
+
+  if (row < 0 || col < 0)
+    return -1;
+
+  key = GINT_TO_POINTER (row * circuit->size + col + 1);
+  index = g_hash_table_lookup (entries, key);
+  if (!index)
+    {
+      g_array_append_val (rows, row);
+      g_array_append_val (cols, col);
+      index = GINT_TO_POINTER (rows->len);
+      g_hash_table_insert (entries, key, index);
+    }
+
+  return GPOINTER_TO_INT (index) - 1;
+}
+
+/* List the matrix entries each element stamps. The first n_nodes
+   entries are the node diagonals holding DC_GMIN. */
+static void
+dc_circuit_build (GcDcCircuit *circuit)
+{
+  GHashTable *entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+  GArray *rows = g_array_new (FALSE, FALSE, sizeof (gint));
+  GArray *cols = g_array_new (FALSE, FALSE, sizeof (gint));
+  gint size, i;
+  guint j;
+
+  size = circuit->n_nodes;
+  for (j = 0; j < circuit->elements->len; j++)
+    {
+      DcElement *element = &g_array_index (circuit->elements, DcElement, j);
+      if (element->type == 'v')
+	element->branch = size++;
+    }
+  circuit->size = size;
+
+  for (i = 0; i < circuit->n_nodes; i++)
+    dc_circuit_entry (circuit, entries, rows, cols, i, i);
+
+  for (j = 0; j < circuit->elements->len; j++)
+    {
+      DcElement *element = &g_array_index (circuit->elements, DcElement, j);
+      gint n1 = element->n1, n2 = element->n2;
+
+      if (element->type == 'v')
+	{
+	  gint b = element->branch;
+	  element->entry[0] = dc_circuit_entry (circuit, entries, rows, cols, n1, b);
+	  element->entry[1] = dc_circuit_entry (circuit, entries, rows, cols, n2, b);
+	  element->entry[2] = dc_circuit_entry (circuit, entries, rows, cols, b, n1);
+	  element->entry[3] = dc_circuit_entry (circuit, entries, rows, cols, b, n2);
+	}
+      else
+	{
+	  element->entry[0] = dc_circuit_entry (circuit, entries, rows, cols, n1, n1);
+	  element->entry[1] = dc_circuit_entry (circuit, entries, rows, cols, n1, n2);
+	  element->entry[2] = dc_circuit_entry (circuit, entries, rows, cols, n2, n1);
+	  element->entry[3] = dc_circuit_entry (circuit, entries, rows, cols, n2, n2);
+	}
+    }
+
+  circuit->n_entries = rows->len;
+  circuit->entry_row = (gint *) g_array_free (rows, FALSE);
+  circuit->entry_col = (gint *) g_array_free (cols, FALSE);
+  circuit->entry_value = g_new0 (gdouble, circuit->n_entries);
+  circuit->entry_lu = g_new0 (gint, circuit->n_entries);
+
+  circuit->row_perm = g_new (gint, size);
+  circuit->col_perm = g_new (gint, size);
+  circuit->row_ptr = g_new0 (gint, size + 1);
+  circuit->diag = g_new (gint, size);
+  circuit->rhs = g_new0 (gdouble, size);
+  circuit->x = g_new0 (gdouble, size);
+  circuit->work = g_new0 (gdouble, size);
+  circuit->ordered = FALSE;
+
+  g_hash_table_destroy (entries);
+}
+
+/* Compute the diode companion model at its current voltage */
+static void
+dc_diode_linearize (DcElement *element)
+{
+  gdouble e = exp (MIN (element->vd / element->nvt, 700.0));
+  gdouble id = element->is * (e - 1.0) + DC_GMIN * element->vd;
+
+  element->gd = element->is * e / element->nvt + DC_GMIN;
+  element->ieq = id - element->gd * element->vd;
+}
+
+static void
+dc_stamp_conductance (GcDcCircuit *circuit, DcElement *element, gdouble g)
+{
+  if (element->entry[0] >= 0)
+    circuit->entry_value[element->entry[0]] += g;
+  if (element->entry[1] >= 0)
+    circuit->entry_value[element->entry[1]] -= g;
+  if (element->entry[2] >= 0)
+    circuit->entry_value[element->entry[2]] -= g;
+  if (element->entry[3] >= 0)
+    circuit->entry_value[element->entry[3]] += g;
+}
+
+static void
+dc_circuit_stamp (GcDcCircuit *circuit)
+{
+  gint i;
+  guint j;
+
+  memset (circuit->entry_value, 0, circuit->n_entries * sizeof (gdouble));
+  memset (circuit->rhs, 0, circuit->size * sizeof (gdouble));
+
+  for (i = 0; i < circuit->n_nodes; i++)
+    circuit->entry_value[i] += DC_GMIN;
+
+  for (j = 0; j < circuit->elements->len; j++)
+    {
+      DcElement *element = &g_array_index (circuit->elements, DcElement, j);
+
+      switch (element->type)
+	{
+	case 'r':
+	  dc_stamp_conductance (circuit, element,
+				1.0 / MAX (element->value, DC_RMIN));
+	  break;
+	case 'd':
+	  dc_stamp_conductance (circuit, element, element->gd);
+	  if (element->n1 >= 0)
+	    circuit->rhs[element->n1] -= element->ieq;
+	  if (element->n2 >= 0)
+	    circuit->rhs[element->n2] += element->ieq;
+	  break;
+	case 'v':
+	  if (element->entry[0] >= 0)
+	    {
+	      circuit->entry_value[element->entry[0]] += 1.0;
+	      circuit->entry_value[element->entry[2]] += 1.0;
+	    }
+	  if (element->entry[1] >= 0)
+	    {
+	      circuit->entry_value[element->entry[1]] -= 1.0;
+	      circuit->entry_value[element->entry[3]] -= 1.0;
+	    }
+	  circuit->rhs[element->branch] = element->value;
+	  break;
+	}
+    }
+}
+
+/* Choose the pivot order with the Markowitz criterion on the stamped
+   matrix and compute the structure of the LU factors, fill-ins
+   included. The circuits are small, this works on a dense copy. */
+static gboolean
+dc_circuit_order (GcDcCircuit *circuit)
+{
+  gint n = circuit->size;
+  gdouble *a = g_new0 (gdouble, n * n);
+  guchar *nz = g_new0 (guchar, n * n);
+  guchar *row_done = g_new0 (guchar, n);
+  guchar *col_done = g_new0 (guchar, n);
+  gint *row_count = g_new (gint, n);
+  gint *col_count = g_new (gint, n);
+  gdouble *col_max = g_new (gdouble, n);
+  gint *inv_row = g_new (gint, n);
+  gint *inv_col = g_new (gint, n);
+  gboolean ok = TRUE;
+  gint i, j, k, e, nnz;
+
+  for (e = 0; e < circuit->n_entries; e++)
+    {
+      a[circuit->entry_row[e] * n + circuit->entry_col[e]] += circuit->entry_value[e];
+      nz[circuit->entry_row[e] * n + circuit->entry_col[e]] = 1;
+    }
+
+  for (k = 0; k < n && ok; k++)
+    {
+      gint best_i = -1, best_j = -1;
+      glong best_cost = G_MAXLONG;
+      gdouble best_value = 0.0;
+
+      memset (row_count, 0, n * sizeof (gint));
+      memset (col_count, 0, n * sizeof (gint));
+      memset (col_max, 0, n * sizeof (gdouble));
+
+      for (i = 0; i < n; i++)
+	for (j = 0; j < n; j++)
+	  if (!row_done[i] && !col_done[j] && nz[i * n + j])
+	    {
+	      row_count[i]++;
+	      col_count[j]++;
+	      col_max[j] = MAX (col_max[j], fabs (a[i * n + j]));
+	    }
+
+      for (i = 0; i < n; i++)
+	for (j = 0; j < n; j++)
+	  {
+	    gdouble value = fabs (a[i * n + j]);
+	    glong cost;
+
+	    if (row_done[i] || col_done[j] || !nz[i * n + j]
+		|| value == 0.0 || value < DC_PIVOT_THRESHOLD * col_max[j])
+	      continue;
+
+	    cost = (glong) (row_count[i] - 1) * (col_count[j] - 1);
+	    if (cost < best_cost || (cost == best_cost && value > best_value))
+	      {
+		best_i = i;
+		best_j = j;
+		best_cost = cost;
+		best_value = value;
+	      }
+	  }
+
+      if (best_i < 0)
+	{
+	  ok = FALSE;
+	  break;
+	}
+
+      circuit->row_perm[k] = best_i;
+      circuit->col_perm[k] = best_j;
+      row_done[best_i] = col_done[best_j] = 1;
+
+      /* Eliminate the pivot column, recording the fill-ins */
+      for (i = 0; i < n; i++)
+	{
+	  gdouble l;
+
+	  if (row_done[i] || !nz[i * n + best_j])
+	    continue;
+
+	  l = a[i * n + best_j] / a[best_i * n + best_j];
+	  for (j = 0; j < n; j++)
+	    if (!col_done[j] && nz[best_i * n + j])
+	      {
+		a[i * n + j] -= l * a[best_i * n + j];
+		nz[i * n + j] = 1;
+	      }
+	}
+    }
+
+  if (ok)
+    {
+      for (k = 0; k < n; k++)
+	{
+	  inv_row[circuit->row_perm[k]] = k;
+	  inv_col[circuit->col_perm[k]] = k;
+	}
+
+      /* The structure of the factors in pivot order */
+      nnz = 0;
+      for (i = 0; i < n; i++)
+	for (j = 0; j < n; j++)
+	  nnz += nz[i * n + j];
+
+      g_free (circuit->col_idx);
+      g_free (circuit->lu);
+      circuit->col_idx = g_new (gint, nnz);
+      circuit->lu = g_new0 (gdouble, nnz);
+
+      nnz = 0;
+      for (i = 0; i < n; i++)
+	{
+	  circuit->row_ptr[i] = nnz;
+	  for (j = 0; j < n; j++)
+	    if (nz[circuit->row_perm[i] * n + circuit->col_perm[j]])
+	      {
+		if (i == j)
+		  circuit->diag[i] = nnz;
+		circuit->col_idx[nnz++] = j;
+	      }
+	}
+      circuit->row_ptr[n] = nnz;
+
+      /* Where each stamped entry lands in the factors */
+      for (e = 0; e < circuit->n_entries; e++)
+	{
+	  gint row = inv_row[circuit->entry_row[e]];
+	  gint col = inv_col[circuit->entry_col[e]];
+	  gint lo = circuit->row_ptr[row], hi = circuit->row_ptr[row + 1] - 1;
+
+	  while (lo < hi)
+	    {
+	      gint mid = (lo + hi) / 2;
+	      if (circuit->col_idx[mid] < col)
+		lo = mid + 1;
+	      else
+		hi = mid;
+	    }
+	  circuit->entry_lu[e] = lo;
+	}
+    }
+
+  circuit->ordered = ok;
+
+  g_free (a);
+  g_free (nz);
+  g_free (row_done);
+  g_free (col_done);
+  g_free (row_count);
+  g_free (col_count);
+  g_free (col_max);
+  g_free (inv_row);
+  g_free (inv_col);
+
+  return ok;
+}
+
+/* Numerical LU factorization in the existing pivot order and
+   structure. Returns FALSE if a pivot is smaller than threshold times
+   the largest value of its U row. */
+static gboolean
+dc_circuit_factor (GcDcCircuit *circuit, gdouble threshold)
+{
+  gdouble *lu = circuit->lu;
+  gdouble *work = circuit->work;
+  gint *col_idx = circuit->col_idx;
+  gint *row_ptr = circuit->row_ptr;
+  gint *diag = circuit->diag;
+  gint e, i, p, q;
+
+  memset (lu, 0, row_ptr[circuit->size] * sizeof (gdouble));
+  for (e = 0; e < circuit->n_entries; e++)
+    lu[circuit->entry_lu[e]] += circuit->entry_value[e];
+
+  for (i = 0; i < circuit->size; i++)
+    {
+      gdouble pivot, row_max = 0.0;
+
+      for (p = row_ptr[i]; p < row_ptr[i + 1]; p++)
+	work[col_idx[p]] = lu[p];
+
+      for (p = row_ptr[i]; p < diag[i]; p++)
+	{
+	  gint k = col_idx[p];
+	  gdouble l = work[k] / lu[diag[k]];
+
+	  work[k] = l;
+	  for (q = diag[k] + 1; q < row_ptr[k + 1]; q++)
+	    work[col_idx[q]] -= l * lu[q];
+	}
+
+      for (p = row_ptr[i]; p < row_ptr[i + 1]; p++)
+	{
+	  lu[p] = work[col_idx[p]];
+	  work[col_idx[p]] = 0.0;
+	  if (p >= diag[i])
+	    row_max = MAX (row_max, fabs (lu[p]));
+	}
+
+      pivot = fabs (lu[diag[i]]);
+      if (pivot == 0.0 || pivot < threshold * row_max)
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+dc_circuit_lu_solve (GcDcCircuit *circuit)
+{
+  gdouble *lu = circuit->lu;
+  gdouble *y = circuit->work;
+  gint *col_idx = circuit->col_idx;
+  gint *row_ptr = circuit->row_ptr;
+  gint *diag = circuit->diag;
+  gint i, p;
+
+  for (i = 0; i < circuit->size; i++)
+    {
+      gdouble sum = circuit->rhs[circuit->row_perm[i]];
+      for (p = row_ptr[i]; p < diag[i]; p++)
+	sum -= lu[p] * y[col_idx[p]];
+      y[i] = sum;
+    }
+
+  for (i = circuit->size - 1; i >= 0; i--)
+    {
+      gdouble sum = y[i];
+      for (p = diag[i] + 1; p < row_ptr[i + 1]; p++)
+	sum -= lu[p] * y[col_idx[p]];
+      y[i] = sum / lu[diag[i]];
+    }
+
+  for (i = 0; i < circuit->size; i++)
+    {
+      circuit->x[circuit->col_perm[i]] = y[i];
+      y[i] = 0.0;
+    }
+}
+
+/* Factor the stamped matrix, reusing the previous pivot order when it
+   is still numerically acceptable */
+static gboolean
+dc_circuit_decompose (GcDcCircuit *circuit)
+{
+  if (circuit->ordered
+      && dc_circuit_factor (circuit, DC_PIVOT_THRESHOLD))
+    return TRUE;
+
+  if (!dc_circuit_order (circuit))
+    return FALSE;
+
+  return dc_circuit_factor (circuit, 0.0);
+}
+
+/* Limit the diode voltage step like spice does to keep the newton
+   iterations in the range of the exponential */
+static gdouble
+dc_pnjlim (gdouble vnew, gdouble vold, gdouble vt, gdouble vcrit)
+{
+  if (vnew > vcrit && fabs (vnew - vold) > 2.0 * vt)
+    {
+      if (vold > 0.0)
+	{
+	  gdouble arg = 1.0 + (vnew - vold) / vt;
+	  vnew = arg > 0.0 ? vold + vt * log (arg) : vcrit;
+	}
+      else
+	vnew = vt * log (vnew / vt);
+    }
+
+  return vnew;
+}
+
+static gdouble
+dc_circuit_voltage (GcDcCircuit *circuit, DcElement *element)
+{
+  gdouble v1 = element->n1 >= 0 ? circuit->x[element->n1] : 0.0;
+  gdouble v2 = element->n2 >= 0 ? circuit->x[element->n2] : 0.0;
+
+  return v1 - v2;
+}
+
+/* Newton iterations, a single linear solve without diodes */
+static GcDcStatus
+dc_circuit_run (GcDcCircuit *circuit)
+{
+  gint iteration, i;
+  guint j;
+
+  for (iteration = 0; iteration < DC_MAX_ITERATIONS; iteration++)
+    {
+      gboolean converged = TRUE;
+
+      for (j = 0; j < circuit->elements->len; j++)
+	{
+	  DcElement *element = &g_array_index (circuit->elements, DcElement, j);
+	  if (element->type == 'd')
+	    dc_diode_linearize (element);
+	}
+
+      dc_circuit_stamp (circuit);
+      if (!dc_circuit_decompose (circuit))
+	return GC_DC_SINGULAR;
+      dc_circuit_lu_solve (circuit);
+
+      for (i = 0; i < circuit->size; i++)
+	if (!isfinite (circuit->x[i]))
+	  return GC_DC_SINGULAR;
+
+      for (j = 0; j < circuit->elements->len; j++)
+	{
+	  DcElement *element = &g_array_index (circuit->elements, DcElement, j);
+	  gdouble vcrit, vd;
+
+	  if (element->type != 'd')
+	    continue;
+
+	  vcrit = element->nvt * log (element->nvt / (G_SQRT2 * element->is));
+	  vd = dc_pnjlim (dc_circuit_voltage (circuit, element),
+			  element->vd, element->nvt, vcrit);
+
+	  if (fabs (vd - element->vd)
+	      > DC_RELTOL * MAX (fabs (vd), fabs (element->vd)) + DC_VNTOL)
+	    converged = FALSE;
+
+	  element->vd = vd;
+	}
+
+      if (converged)
+	return GC_DC_OK;
+    }
+
+  return GC_DC_NO_CONVERGENCE;
+}
+
+GcDcStatus
+gc_dc_circuit_solve (GcDcCircuit *circuit,
+		     const gchar *netlist,
+		     GArray *values)
+{
+  GArray *old_elements = circuit->elements;
+  GArray *old_models = circuit->models;
+  GArray *old_probes = circuit->probes;
+  GHashTable *old_nodes = circuit->nodes;
+  gint old_n_nodes = circuit->n_nodes;
+  GcDcStatus status;
+  guint i;
+
+  g_return_val_if_fail (circuit != NULL, GC_DC_PARSE_ERROR);
+  g_return_val_if_fail (netlist != NULL, GC_DC_PARSE_ERROR);
+  g_return_val_if_fail (values != NULL, GC_DC_PARSE_ERROR);
+
+  g_array_set_size (values, 0);
+
+  /* Nothing changed since the last call */
+  if (circuit->netlist && strcmp (circuit->netlist, netlist) == 0)
+    {
+      g_array_append_vals (values, circuit->results->data,
+			   circuit->results->len);
+      return GC_DC_OK;
+    }
+
+  if (!dc_circuit_parse (circuit, netlist))
+    status = GC_DC_PARSE_ERROR;
+  else
+    status = GC_DC_OK;
+
+  /* Resolve the diode models */
+  for (i = 0; status == GC_DC_OK && i < circuit->elements->len; i++)
+    {
+      DcElement *element = &g_array_index (circuit->elements, DcElement, i);
+      DcModel *model;
+
+      if (element->type != 'd')
+	continue;
+
+      model = dc_circuit_find_model (circuit, element->model);
+      if (!model)
+	status = dc_circuit_set_error (circuit, GC_DC_PARSE_ERROR,
+				       element->model);
+      else
+	{
+	  element->is = model->is * element->value;
+	  element->nvt = model->n * DC_VT;
+	}
+    }
+
+  if (status != GC_DC_OK)
+    {
+      /* Keep the previous circuit */
+      dc_elements_free (circuit->elements);
+      dc_models_free (circuit->models);
+      dc_probes_free (circuit->probes);
+      g_hash_table_destroy (circuit->nodes);
+      circuit->elements = old_elements;
+      circuit->models = old_models;
+      circuit->probes = old_probes;
+      circuit->nodes = old_nodes;
+      circuit->n_nodes = old_n_nodes;
+      return status;
+    }
+
+  if (old_elements
+      && dc_same_topology (old_elements, old_n_nodes,
+			   circuit->elements, circuit->n_nodes))
+    {
+      /* Only values changed, keep the matrix structure and start the
+	 newton iterations from the previous operating point */
+      for (i = 0; i < circuit->elements->len; i++)
+	{
+	  DcElement *element = &g_array_index (circuit->elements, DcElement, i);
+	  DcElement *old = &g_array_index (old_elements, DcElement, i);
+
+	  element->branch = old->branch;
+	  element->vd = old->vd;
+	  memcpy (element->entry, old->entry, sizeof (element->entry));
+	}
+    }
+  else
+    {
+      dc_circuit_clear_matrix (circuit);
+      dc_circuit_build (circuit);
+    }
+
+  if (old_elements)
+    {
+      dc_elements_free (old_elements);
+      dc_models_free (old_models);
+      dc_probes_free (old_probes);
+      g_hash_table_destroy (old_nodes);
+    }
+
+  status = dc_circuit_run (circuit);
+  if (status != GC_DC_OK)
+    {
+      /* Restart from scratch next time */
+      for (i = 0; i < circuit->elements->len; i++)
+	g_array_index (circuit->elements, DcElement, i).vd = 0.0;
+      circuit->ordered = FALSE;
+      return dc_circuit_set_error (circuit, status,
+				   status == GC_DC_SINGULAR
+				   ? "singular matrix" : "no convergence");
+    }
+
+  for (i = 0; i < circuit->probes->len; i++)
+    {
+      DcProbe *probe = &g_array_index (circuit->probes, DcProbe, i);
+      DcElement *element = dc_circuit_find_element (circuit, probe->element);
+      gdouble v, value;
+
+      if (!element)
+	return dc_circuit_set_error (circuit, GC_DC_UNKNOWN_ELEMENT,
+				     probe->element);
+
+      v = dc_circuit_voltage (circuit, element);
+      if (probe->kind == 'v')
+	value = v;
+      else
+	switch (element->type)
+	  {
+	  case 'r':
+	    value = v / MAX (element->value, DC_RMIN);
+	    break;
+	  case 'd':
+	    value = element->gd * v + element->ieq;
+	    break;
+	  default:
+	    value = circuit->x[element->branch];
+	    break;
+	  }
+
+      g_array_append_val (values, value);
+    }
+
+  g_free (circuit->netlist);
+  circuit->netlist = g_strdup (netlist);
+  g_array_set_size (circuit->results, 0);
+  g_array_append_vals (circuit->results, values->data, values->len);
+
+  return GC_DC_OK;
+}
@@ -0,0 +1,61 @@
+/* gcompris - gcompris_dcsolver.h
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GCOMPRIS_DCSOLVER_H_
+#define _GCOMPRIS_DCSOLVER_H_
+
+#include <glib.h>
+
+/* A DC operating point solver for small spice like netlists.
+ *
+ * The netlist is the one a gnucap batch file would contain: a title
+ * line, resistors (R), voltage sources (V) and diodes (D) with their
+ * .model lines, and .print lines listing the v() and i() of the
+ * elements to report. Node 0 is the ground.
+ *
+ * The circuit is solved by modified nodal analysis with a sparse LU
+ * factorization. The pivot order is kept between two calls while the
+ * topology does not change, so that changing the value of a component
+ * only costs a numerical refactorization.
+ */
+
+typedef enum
+{
+  GC_DC_OK = 0,
+  GC_DC_PARSE_ERROR,
+  GC_DC_UNKNOWN_ELEMENT,
+  GC_DC_SINGULAR,
+  GC_DC_NO_CONVERGENCE
+} GcDcStatus;
+
+typedef struct _GcDcCircuit GcDcCircuit;
+
+GcDcCircuit	*gc_dc_circuit_new   (void);
+void		 gc_dc_circuit_free  (GcDcCircuit *circuit);
+
+/* Solve the given netlist. On success, values is filled with the
+ * gdouble results of the .print lines, in order.
+ * On error, the line or element causing it is returned in
+ * gc_dc_circuit_get_error(). */
+GcDcStatus	 gc_dc_circuit_solve (GcDcCircuit *circuit,
+				      const gchar *netlist,
+				      GArray *values);
+
+const gchar	*gc_dc_circuit_get_error (GcDcCircuit *circuit);
+
+#endif
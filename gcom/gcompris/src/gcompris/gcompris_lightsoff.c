@@ -0,0 +1,288 @@
+/* gcompris - gcompris_lightsoff.c
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "gcompris_lightsoff.h"
+
+#define MAX_SIZE	GC_LIGHTSOFF_MAX_SIZE
+
+/* Above this many free first row presses, only the first 2^n
+   combinations are tried for the shortest solution */
+#define MAX_KERNEL_SEARCH	16
+
+struct _GcLightsoff
+{
+  gint		width;
+  gint		height;
+  guint32	row_mask;
+
+  /* The last row left by chasing the lights from each first row
+     press is linear in those presses: last = chase (0) ^ T * first.
+     Its reduced row echelon form R = E * T is kept in rows, E in
+     transforms. */
+  guint32	rows[MAX_SIZE];
+  guint32	transforms[MAX_SIZE];
+  gint		pivots[MAX_SIZE];
+  gint		rank;
+
+  /* The first row presses that switch nothing, their combinations
+     give all the solutions of a grid */
+  guint32	kernel[MAX_SIZE];
+  gint		kernel_size;
+};
+
+static gint
+popcount (guint32 b)
+{
+  gint n = 0;
+
+  for (; b; n++)
+    b &= b - 1;
+
+  return n;
+}
+
+static inline void
+press_row (const GcLightsoff *lightsoff, guint32 *lights, gint row, guint32 presses)
+{
+  lights[row] ^= (presses ^ (presses << 1) ^ (presses >> 1)) & lightsoff->row_mask;
+  if (row > 0)
+    lights[row - 1] ^= presses;
+  if (row < lightsoff->height - 1)
+    lights[row + 1] ^= presses;
+}
+
+/* Press first on the first row, then each light left on a row is
+   switched off by pressing the light below it. Returns the lights
+   left on the last row. */
+static guint32
+chase (const GcLightsoff *lightsoff, const guint32 *lights,
+       guint32 first, guint32 *presses)
+{
+  guint32 grid[MAX_SIZE];
+  guint32 p = first;
+  gint row;
+
+  memcpy (grid, lights, lightsoff->height * sizeof (guint32));
+
+  for (row = 0; row < lightsoff->height; row++)
+    {
+      if (presses)
+	presses[row] = p;
+      press_row (lightsoff, grid, row, p);
+      p = grid[row];
+    }
+
+  return grid[lightsoff->height - 1];
+}
+
+GcLightsoff *
+gc_lightsoff_new (gint width, gint height)
+{
+  GcLightsoff *lightsoff;
+  guint32 zero[MAX_SIZE] = { 0 };
+  guint32 last[MAX_SIZE];
+  gint i, j, col;
+
+  g_return_val_if_fail (width > 0 && width <= MAX_SIZE, NULL);
+  g_return_val_if_fail (height > 0 && height <= MAX_SIZE, NULL);
+
+  lightsoff = g_new0 (GcLightsoff, 1);
+  lightsoff->width = width;
+  lightsoff->height = height;
+  lightsoff->row_mask = width == 32 ? 0xffffffff : (1u << width) - 1;
+
+  /* Build T, row j is the equation of the light j of the last row */
+  for (i = 0; i < width; i++)
+    last[i] = chase (lightsoff, zero, 1u << i, NULL);
+
+  for (j = 0; j < width; j++)
+    {
+      lightsoff->rows[j] = 0;
+      for (i = 0; i < width; i++)
+	if (last[i] & (1u << j))
+	  lightsoff->rows[j] |= 1u << i;
+      lightsoff->transforms[j] = 1u << j;
+    }
+
+  /* Gauss Jordan elimination over GF(2) */
+  for (col = 0; col < width; col++)
+    {
+      gint r = lightsoff->rank;
+      guint32 tmp;
+
+      while (r < width && !(lightsoff->rows[r] & (1u << col)))
+	r++;
+
+      if (r == width)
+	{
+	  /* A free column, it gives a kernel vector once eliminated */
+	  continue;
+	}
+
+      tmp = lightsoff->rows[r];
+      lightsoff->rows[r] = lightsoff->rows[lightsoff->rank];
+      lightsoff->rows[lightsoff->rank] = tmp;
+      tmp = lightsoff->transforms[r];
+      lightsoff->transforms[r] = lightsoff->transforms[lightsoff->rank];
+      lightsoff->transforms[lightsoff->rank] = tmp;
+
+      for (r = 0; r < width; r++)
+	if (r != lightsoff->rank && (lightsoff->rows[r] & (1u << col)))
+	  {
+	    lightsoff->rows[r] ^= lightsoff->rows[lightsoff->rank];
+	    lightsoff->transforms[r] ^= lightsoff->transforms[lightsoff->rank];
+	  }
+
+      lightsoff->pivots[lightsoff->rank++] = col;
+    }
+
+  /* The kernel, one vector per free column */
+  for (col = 0, j = 0; col < width; col++)
+    {
+      guint32 v;
+
+      if (j < lightsoff->rank && lightsoff->pivots[j] == col)
+	{
+	  j++;
+	  continue;
+	}
+
+      v = 1u << col;
+      for (i = 0; i < lightsoff->rank; i++)
+	if (lightsoff->rows[i] & (1u << col))
+	  v |= 1u << lightsoff->pivots[i];
+
+      lightsoff->kernel[lightsoff->kernel_size++] = v;
+    }
+
+  return lightsoff;
+}
+
+void
+gc_lightsoff_free (GcLightsoff *lightsoff)
+{
+  g_free (lightsoff);
+}
+
+gint
+gc_lightsoff_solve (GcLightsoff *lightsoff,
+		    const guint32 *lights,
+		    guint32 *presses)
+{
+  guint32 candidate[MAX_SIZE];
+  guint32 last, first = 0;
+  guint combination, n_combinations;
+  gint best = -1;
+  gint i;
+
+  g_return_val_if_fail (lightsoff != NULL, -1);
+
+  last = chase (lightsoff, lights, 0, NULL);
+
+  /* The rows eliminated to 0 must have a null right hand side */
+  for (i = lightsoff->rank; i < lightsoff->width; i++)
+    if (popcount (lightsoff->transforms[i] & last) & 1)
+      return -1;
+
+  for (i = 0; i < lightsoff->rank; i++)
+    if (popcount (lightsoff->transforms[i] & last) & 1)
+      first |= 1u << lightsoff->pivots[i];
+
+  /* Walk the kernel in gray code order, each step adds one vector */
+  n_combinations = 1u << MIN (lightsoff->kernel_size, MAX_KERNEL_SEARCH);
+  for (combination = 0; combination < n_combinations; combination++)
+    {
+      gint count = 0;
+
+      if (combination)
+	{
+	  /* The gray code changes the lowest bit set of combination */
+	  guint c = combination;
+	  gint bit = 0;
+
+	  while (!(c & 1))
+	    {
+	      c >>= 1;
+	      bit++;
+	    }
+	  first ^= lightsoff->kernel[bit];
+	}
+
+      chase (lightsoff, lights, first, candidate);
+      for (i = 0; i < lightsoff->height; i++)
+	count += popcount (candidate[i]);
+
+      if (best < 0 || count < best)
+	{
+	  best = count;
+	  memcpy (presses, candidate, lightsoff->height * sizeof (guint32));
+	}
+    }
+
+  return best;
+}
+
+void
+gc_lightsoff_generate (GcLightsoff *lightsoff,
+		       gint presses,
+		       guint32 *lights)
+{
+  gint n_cells;
+  gint cells[MAX_SIZE * MAX_SIZE];
+  gint attempts = 0;
+  gint i, row;
+
+  g_return_if_fail (lightsoff != NULL);
+
+  n_cells = lightsoff->width * lightsoff->height;
+  presses = CLAMP (presses, 0, n_cells);
+
+  for (i = 0; i < n_cells; i++)
+    cells[i] = i;
+
+  /* Some sets of presses switch nothing, do not give a dark grid */
+  do
+    {
+      gboolean dark = TRUE;
+
+      memset (lights, 0, lightsoff->height * sizeof (guint32));
+
+      /* Pick presses distinct cells */
+      for (i = 0; i < presses; i++)
+	{
+	  gint j = g_random_int_range (i, n_cells);
+	  gint cell = cells[j];
+
+	  cells[j] = cells[i];
+	  cells[i] = cell;
+
+	  press_row (lightsoff, lights, cell / lightsoff->width,
+		     1u << (cell % lightsoff->width));
+	}
+
+      for (row = 0; row < lightsoff->height; row++)
+	if (lights[row])
+	  dark = FALSE;
+
+      if (!dark)
+	break;
+    }
+  while (presses > 0 && ++attempts < 100);
+}
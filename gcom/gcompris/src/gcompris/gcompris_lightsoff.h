@@ -0,0 +1,58 @@
+/* gcompris - gcompris_lightsoff.h
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GCOMPRIS_LIGHTSOFF_H_
+#define _GCOMPRIS_LIGHTSOFF_H_
+
+#include <glib.h>
+
+#define GC_LIGHTSOFF_MAX_SIZE	32
+
+/* A lights out solver for a width x height grid. Pressing a light
+ * switches it and its 4 neighbours.
+ *
+ * A grid is an array of height rows, bit x of a row being the light
+ * of column x.
+ *
+ * Chasing the lights down reduces the puzzle to width equations over
+ * GF(2), whose unknowns are the presses on the first row. They are
+ * eliminated once when the solver is created, so solving a grid only
+ * costs a few row operations.
+ */
+typedef struct _GcLightsoff GcLightsoff;
+
+GcLightsoff	*gc_lightsoff_new      (gint width, gint height);
+void		 gc_lightsoff_free     (GcLightsoff *lightsoff);
+
+/* Find the presses that switch off all the lights, with as few
+ * presses as possible.
+ *
+ * Returns the number of presses, or -1 if the grid cannot be solved.
+ */
+gint		 gc_lightsoff_solve    (GcLightsoff *lightsoff,
+					const guint32 *lights,
+					guint32 *presses);
+
+/* Make a random grid that can be solved, by pressing presses distinct
+ * lights of a dark grid.
+ */
+void		 gc_lightsoff_generate (GcLightsoff *lightsoff,
+					gint presses,
+					guint32 *lights);
+
+#endif
@@ -0,0 +1,517 @@
+/* gcompris - gcompris_sudoku.c
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "gcompris_sudoku.h"
+
+#define MAX_SIZE	GC_SUDOKU_MAX_SIZE
+#define MAX_CELLS	(MAX_SIZE * MAX_SIZE)
+/* The rows, then the columns, then the regions */
+#define MAX_UNITS	(3 * MAX_SIZE)
+
+#define BIT(value)	(1u << ((value) - 1))
+
+typedef struct
+{
+  guint8	cells[MAX_CELLS];
+  /* The values used in each unit */
+  guint32	used[MAX_UNITS];
+} SudokuGrid;
+
+struct _GcSudoku
+{
+  gint		size;
+  gint		region;
+  gint		n_cells;
+  gint		n_units;
+  guint32	all_values;
+
+  /* The units of each cell, the region is -1 without regions */
+  gint8		cell_units[MAX_CELLS][3];
+  /* The cells of each unit */
+  guint8	unit_cells[MAX_UNITS][MAX_SIZE];
+
+  SudokuGrid	grid;
+  gint		filled;
+  /* The cell holding each value in each unit, -1 if none */
+  gint16	unit_pos[MAX_UNITS][MAX_SIZE];
+
+  gboolean	fixed[MAX_CELLS];
+  guint8	solution[MAX_CELLS];
+};
+
+static gint
+popcount (guint32 b)
+{
+  gint n = 0;
+
+  for (; b; n++)
+    b &= b - 1;
+
+  return n;
+}
+
+/* Index of the lowest bit set, plus one: the value it stands for */
+static gint
+lowest_value (guint32 b)
+{
+  gint value = 1;
+
+  while (!(b & 1))
+    {
+      b >>= 1;
+      value++;
+    }
+
+  return value;
+}
+
+static inline guint32
+candidates (const GcSudoku *sudoku, const SudokuGrid *grid, gint cell)
+{
+  const gint8 *units = sudoku->cell_units[cell];
+  guint32 used = grid->used[units[0]] | grid->used[units[1]];
+
+  if (units[2] >= 0)
+    used |= grid->used[units[2]];
+
+  return sudoku->all_values & ~used;
+}
+
+static inline void
+grid_place (const GcSudoku *sudoku, SudokuGrid *grid, gint cell, gint value)
+{
+  const gint8 *units = sudoku->cell_units[cell];
+  gint i;
+
+  grid->cells[cell] = value;
+  for (i = 0; i < 3 && units[i] >= 0; i++)
+    grid->used[units[i]] |= BIT (value);
+}
+
+static inline void
+grid_clear (const GcSudoku *sudoku, SudokuGrid *grid, gint cell)
+{
+  const gint8 *units = sudoku->cell_units[cell];
+  gint value = grid->cells[cell];
+  gint i;
+
+  grid->cells[cell] = 0;
+  for (i = 0; i < 3 && units[i] >= 0; i++)
+    grid->used[units[i]] &= ~BIT (value);
+}
+
+/* Backtracking on the cell with the fewest candidates. Counts the
+   solutions up to limit and keeps the first one in solution. With
+   shuffle, the candidates are tried in random order. */
+static void
+solve (const GcSudoku *sudoku, SudokuGrid *grid,
+       gint limit, gint *count, guint8 *solution, gboolean shuffle)
+{
+  gint cell, best = -1, best_n = MAX_SIZE + 1;
+  guint32 cand, best_cand = 0;
+  gint values[MAX_SIZE];
+  gint n_values = 0;
+  gint i;
+
+  for (cell = 0; cell < sudoku->n_cells; cell++)
+    {
+      gint n;
+
+      if (grid->cells[cell])
+	continue;
+
+      cand = candidates (sudoku, grid, cell);
+      n = popcount (cand);
+      if (n == 0)
+	return;
+
+      if (n < best_n)
+	{
+	  best = cell;
+	  best_n = n;
+	  best_cand = cand;
+	  if (n == 1)
+	    break;
+	}
+    }
+
+  if (best < 0)
+    {
+      if (*count == 0 && solution)
+	memcpy (solution, grid->cells, sudoku->n_cells);
+      (*count)++;
+      return;
+    }
+
+  for (cand = best_cand; cand; cand &= cand - 1)
+    values[n_values++] = lowest_value (cand);
+
+  if (shuffle)
+    for (i = n_values - 1; i > 0; i--)
+      {
+	gint j = g_random_int_range (0, i + 1);
+	gint value = values[i];
+
+	values[i] = values[j];
+	values[j] = value;
+      }
+
+  for (i = 0; i < n_values && *count < limit; i++)
+    {
+      grid_place (sudoku, grid, best, values[i]);
+      solve (sudoku, grid, limit, count, solution, shuffle);
+      grid_clear (sudoku, grid, best);
+    }
+}
+
+/* Solve the grid like a player would, without guessing */
+static GcSudokuRating
+rate_grid (const GcSudoku *sudoku, SudokuGrid grid)
+{
+  GcSudokuRating rating = GC_SUDOKU_EASY;
+  gboolean progress = TRUE;
+  gint cell, unit, i;
+
+  while (progress)
+    {
+      gboolean full = TRUE;
+
+      progress = FALSE;
+
+      /* A cell with a single candidate */
+      for (cell = 0; cell < sudoku->n_cells; cell++)
+	{
+	  guint32 cand;
+
+	  if (grid.cells[cell])
+	    continue;
+
+	  full = FALSE;
+	  cand = candidates (sudoku, &grid, cell);
+	  if (cand && !(cand & (cand - 1)))
+	    {
+	      grid_place (sudoku, &grid, cell, lowest_value (cand));
+	      progress = TRUE;
+	    }
+	}
+
+      if (full)
+	return rating;
+      if (progress)
+	continue;
+
+      /* A value with a single place in a unit */
+      for (unit = 0; unit < sudoku->n_units; unit++)
+	{
+	  guint32 missing = sudoku->all_values & ~grid.used[unit];
+
+	  for (; missing; missing &= missing - 1)
+	    {
+	      guint32 bit = missing & -missing;
+	      gint place = -1, n = 0;
+
+	      for (i = 0; i < sudoku->size && n < 2; i++)
+		{
+		  cell = sudoku->unit_cells[unit][i];
+		  if (!grid.cells[cell] && (candidates (sudoku, &grid, cell) & bit))
+		    {
+		      place = cell;
+		      n++;
+		    }
+		}
+
+	      if (n == 1)
+		{
+		  grid_place (sudoku, &grid, place, lowest_value (bit));
+		  rating = GC_SUDOKU_MEDIUM;
+		  progress = TRUE;
+		}
+	    }
+	}
+    }
+
+  return GC_SUDOKU_HARD;
+}
+
+GcSudoku *
+gc_sudoku_new (gint size, gint region)
+{
+  GcSudoku *sudoku;
+  gint row, col, cell;
+
+  g_return_val_if_fail (size > 0 && size <= MAX_SIZE, NULL);
+  g_return_val_if_fail (region == 0 || region * region == size, NULL);
+
+  sudoku = g_new0 (GcSudoku, 1);
+  sudoku->size = size;
+  sudoku->region = region;
+  sudoku->n_cells = size * size;
+  sudoku->n_units = region ? 3 * size : 2 * size;
+  sudoku->all_values = (1u << size) - 1;
+
+  for (row = 0; row < size; row++)
+    for (col = 0; col < size; col++)
+      {
+	cell = row * size + col;
+
+	sudoku->cell_units[cell][0] = row;
+	sudoku->unit_cells[row][col] = cell;
+
+	sudoku->cell_units[cell][1] = size + col;
+	sudoku->unit_cells[size + col][row] = cell;
+
+	if (region)
+	  {
+	    gint box = (row / region) * region + col / region;
+	    gint pos = (row % region) * region + col % region;
+
+	    sudoku->cell_units[cell][2] = 2 * size + box;
+	    sudoku->unit_cells[2 * size + box][pos] = cell;
+	  }
+	else
+	  sudoku->cell_units[cell][2] = -1;
+      }
+
+  gc_sudoku_reset (sudoku);
+
+  return sudoku;
+}
+
+void
+gc_sudoku_free (GcSudoku *sudoku)
+{
+  g_free (sudoku);
+}
+
+gint
+gc_sudoku_get_size (GcSudoku *sudoku)
+{
+  g_return_val_if_fail (sudoku != NULL, 0);
+
+  return sudoku->size;
+}
+
+gint
+gc_sudoku_generate (GcSudoku *sudoku, gint holes, GcSudokuRating max_rating)
+{
+  SudokuGrid grid;
+  gint order[MAX_CELLS];
+  gint count = 0;
+  gint made = 0;
+  gint i;
+
+  g_return_val_if_fail (sudoku != NULL, 0);
+
+  /* A random full grid */
+  memset (&grid, 0, sizeof (grid));
+  solve (sudoku, &grid, 1, &count, sudoku->solution, TRUE);
+  g_assert (count == 1);
+
+  for (i = 0; i < sudoku->n_cells; i++)
+    grid_place (sudoku, &grid, i, sudoku->solution[i]);
+
+  /* Empty the cells in a random order as long as the solution stays
+     unique and the puzzle not too hard */
+  for (i = 0; i < sudoku->n_cells; i++)
+    order[i] = i;
+  for (i = sudoku->n_cells - 1; i > 0; i--)
+    {
+      gint j = g_random_int_range (0, i + 1);
+      gint cell = order[i];
+
+      order[i] = order[j];
+      order[j] = cell;
+    }
+
+  for (i = 0; i < sudoku->n_cells && made < holes; i++)
+    {
+      gint cell = order[i];
+      gint value = grid.cells[cell];
+
+      grid_clear (sudoku, &grid, cell);
+
+      count = 0;
+      solve (sudoku, &grid, 2, &count, NULL, FALSE);
+      if (count == 1 && rate_grid (sudoku, grid) <= max_rating)
+	made++;
+      else
+	grid_place (sudoku, &grid, cell, value);
+    }
+
+  for (i = 0; i < sudoku->n_cells; i++)
+    sudoku->fixed[i] = grid.cells[i] != 0;
+
+  gc_sudoku_reset (sudoku);
+
+  return made;
+}
+
+GcSudokuRating
+gc_sudoku_rate (GcSudoku *sudoku)
+{
+  SudokuGrid grid;
+  gint i;
+
+  g_return_val_if_fail (sudoku != NULL, GC_SUDOKU_HARD);
+
+  memset (&grid, 0, sizeof (grid));
+  for (i = 0; i < sudoku->n_cells; i++)
+    if (sudoku->fixed[i])
+      grid_place (sudoku, &grid, i, sudoku->solution[i]);
+
+  return rate_grid (sudoku, grid);
+}
+
+void
+gc_sudoku_reset (GcSudoku *sudoku)
+{
+  gint i;
+
+  g_return_if_fail (sudoku != NULL);
+
+  memset (&sudoku->grid, 0, sizeof (sudoku->grid));
+  memset (sudoku->unit_pos, 0xff, sizeof (sudoku->unit_pos));
+  sudoku->filled = 0;
+
+  for (i = 0; i < sudoku->n_cells; i++)
+    if (sudoku->fixed[i])
+      {
+	gint row = i / sudoku->size;
+
+	sudoku->fixed[i] = FALSE;
+	gc_sudoku_set (sudoku, row, i - row * sudoku->size,
+		       sudoku->solution[i]);
+	sudoku->fixed[i] = TRUE;
+      }
+}
+
+gint
+gc_sudoku_get (GcSudoku *sudoku, gint row, gint col)
+{
+  g_return_val_if_fail (sudoku != NULL, 0);
+  g_return_val_if_fail (row >= 0 && row < sudoku->size, 0);
+  g_return_val_if_fail (col >= 0 && col < sudoku->size, 0);
+
+  return sudoku->grid.cells[row * sudoku->size + col];
+}
+
+gboolean
+gc_sudoku_is_fixed (GcSudoku *sudoku, gint row, gint col)
+{
+  g_return_val_if_fail (sudoku != NULL, FALSE);
+  g_return_val_if_fail (row >= 0 && row < sudoku->size, FALSE);
+  g_return_val_if_fail (col >= 0 && col < sudoku->size, FALSE);
+
+  return sudoku->fixed[row * sudoku->size + col];
+}
+
+gint
+gc_sudoku_get_solution (GcSudoku *sudoku, gint row, gint col)
+{
+  g_return_val_if_fail (sudoku != NULL, 0);
+  g_return_val_if_fail (row >= 0 && row < sudoku->size, 0);
+  g_return_val_if_fail (col >= 0 && col < sudoku->size, 0);
+
+  return sudoku->solution[row * sudoku->size + col];
+}
+
+gint
+gc_sudoku_check (GcSudoku *sudoku,
+		 gint row, gint col, gint value,
+		 gint conflicts[3])
+{
+  gint cell;
+  gint n = 0;
+  gint i;
+
+  g_return_val_if_fail (sudoku != NULL, 0);
+  g_return_val_if_fail (row >= 0 && row < sudoku->size, 0);
+  g_return_val_if_fail (col >= 0 && col < sudoku->size, 0);
+  g_return_val_if_fail (value > 0 && value <= sudoku->size, 0);
+
+  cell = row * sudoku->size + col;
+
+  for (i = 0; i < 3; i++)
+    {
+      gint unit = sudoku->cell_units[cell][i];
+      gint other;
+
+      if (unit < 0)
+	continue;
+
+      /* A cell in the row or column and the region is reported once */
+      other = sudoku->unit_pos[unit][value - 1];
+      if (other >= 0 && other != cell
+	  && (n == 0 || conflicts[n - 1] != other)
+	  && (n < 2 || conflicts[0] != other))
+	conflicts[n++] = other;
+    }
+
+  return n;
+}
+
+gboolean
+gc_sudoku_set (GcSudoku *sudoku, gint row, gint col, gint value)
+{
+  gint conflicts[3];
+  gint cell, old, i;
+
+  g_return_val_if_fail (sudoku != NULL, FALSE);
+  g_return_val_if_fail (row >= 0 && row < sudoku->size, FALSE);
+  g_return_val_if_fail (col >= 0 && col < sudoku->size, FALSE);
+  g_return_val_if_fail (value >= 0 && value <= sudoku->size, FALSE);
+
+  cell = row * sudoku->size + col;
+
+  if (sudoku->fixed[cell])
+    return FALSE;
+
+  if (value && gc_sudoku_check (sudoku, row, col, value, conflicts))
+    return FALSE;
+
+  old = sudoku->grid.cells[cell];
+  if (old)
+    {
+      for (i = 0; i < 3; i++)
+	if (sudoku->cell_units[cell][i] >= 0)
+	  sudoku->unit_pos[sudoku->cell_units[cell][i]][old - 1] = -1;
+      grid_clear (sudoku, &sudoku->grid, cell);
+      sudoku->filled--;
+    }
+
+  if (value)
+    {
+      for (i = 0; i < 3; i++)
+	if (sudoku->cell_units[cell][i] >= 0)
+	  sudoku->unit_pos[sudoku->cell_units[cell][i]][value - 1] = cell;
+      grid_place (sudoku, &sudoku->grid, cell, value);
+      sudoku->filled++;
+    }
+
+  return TRUE;
+}
+
+gboolean
+gc_sudoku_is_solved (GcSudoku *sudoku)
+{
+  g_return_val_if_fail (sudoku != NULL, FALSE);
+
+  return sudoku->filled == sudoku->n_cells;
+}
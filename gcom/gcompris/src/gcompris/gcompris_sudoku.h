@@ -0,0 +1,89 @@
+/* gcompris - gcompris_sudoku.h
+ *
+ * Copyright (C) 2008 Bruno Coudoin
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GCOMPRIS_SUDOKU_H_
+#define _GCOMPRIS_SUDOKU_H_
+
+#include <glib.h>
+
+#define GC_SUDOKU_MAX_SIZE	16
+
+/* How hard a puzzle is to solve without guessing */
+typedef enum
+{
+  GC_SUDOKU_EASY,		/* cells with a single candidate are enough */
+  GC_SUDOKU_MEDIUM,		/* needs values with a single place in a row,
+				   column or region */
+  GC_SUDOKU_HARD,		/* needs more than that */
+} GcSudokuRating;
+
+/* A sudoku grid of size x size cells holding the values 1 to size,
+ * 0 being an empty cell. With a region, the grid is also split in
+ * region x region squares, without it is a latin square.
+ *
+ * The values used by each row, column and region are kept as bit
+ * masks, so that checking a move does not scan the grid.
+ */
+typedef struct _GcSudoku GcSudoku;
+
+/* region is 0 or its square root of size */
+GcSudoku	*gc_sudoku_new          (gint size, gint region);
+void		 gc_sudoku_free         (GcSudoku *sudoku);
+
+gint		 gc_sudoku_get_size     (GcSudoku *sudoku);
+
+/* Make a new puzzle with a unique solution.
+ * holes: the number of empty cells wanted
+ * max_rating: the hardest puzzle accepted
+ *
+ * Returns the number of empty cells, which is lower than holes when
+ * no more cells can be removed keeping a unique solution or the
+ * rating.
+ */
+gint		 gc_sudoku_generate     (GcSudoku *sudoku,
+					 gint holes,
+					 GcSudokuRating max_rating);
+
+/* Rate the puzzle made by the fixed cells */
+GcSudokuRating	 gc_sudoku_rate         (GcSudoku *sudoku);
+
+/* Clear all the cells that are not fixed */
+void		 gc_sudoku_reset        (GcSudoku *sudoku);
+
+gint		 gc_sudoku_get          (GcSudoku *sudoku, gint row, gint col);
+gboolean	 gc_sudoku_is_fixed     (GcSudoku *sudoku, gint row, gint col);
+gint		 gc_sudoku_get_solution (GcSudoku *sudoku, gint row, gint col);
+
+/* Find the cells that prevent value to be set at row, col. Their
+ * indexes, row * size + col, are stored in conflicts.
+ *
+ * Returns the number of conflicting cells, 0 if the move is legal.
+ */
+gint		 gc_sudoku_check        (GcSudoku *sudoku,
+					 gint row, gint col, gint value,
+					 gint conflicts[3]);
+
+/* Set value at row, col, 0 to clear it. Fails if the cell is fixed
+ * or the move is not legal.
+ */
+gboolean	 gc_sudoku_set          (GcSudoku *sudoku,
+					 gint row, gint col, gint value);
+
+gboolean	 gc_sudoku_is_solved    (GcSudoku *sudoku);
+
+#endif
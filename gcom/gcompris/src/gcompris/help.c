@@ -60,6 +60,11 @@ static GooCanvasItem *item_selected		= NULL;
 static GooCanvasItem *item_selected_text	= NULL;
 
 static GtkTextBuffer *buffer_content;
+
+/* The skin ids of the help, interned once */
+static GQuark help_select_quark = 0;
+static GQuark help_unselect_quark = 0;
+static GQuark help_content_quark = 0;
 static guint	      caller_cursor;
 
 /*
@@ -110,6 +115,10 @@ void gc_help_start (GcomprisBoard *gcomprisBoard)
   item_selected = NULL;
   item_selected_text = NULL;
 
+  help_select_quark = g_quark_from_static_string("gcompris/helpselect");
+  help_unselect_quark = g_quark_from_static_string("gcompris/helpunselect");
+  help_content_quark = g_quark_from_static_string("gcompris/content");
+
   name = gcomprisBoard->title;
   gc_help_has_board(gcomprisBoard);
 
@@ -183,7 +192,7 @@ void gc_help_start (GcomprisBoard *gcomprisBoard)
 			     -1,
 			     GTK_ANCHOR_CENTER,
 			     "font", gc_skin_font_content,
-			     "fill-color-rgba", gc_skin_get_color("gcompris/helpunselect"),
+			     "fill-color-rgba", gc_skin_get_color_q(help_unselect_quark),
 			     NULL);
       g_signal_connect(item_prerequisite_text, "button_press_event",
 			 (GCallback) item_event_help,
@@ -213,7 +222,7 @@ void gc_help_start (GcomprisBoard *gcomprisBoard)
 					    -1,
 					    GTK_ANCHOR_CENTER,
 					    "font", gc_skin_font_content,
-					    "fill-color-rgba", gc_skin_get_color("gcompris/helpunselect"),
+					    "fill-color-rgba", gc_skin_get_color_q(help_unselect_quark),
 					    NULL);
       g_signal_connect(item_goal_text, "button_press_event",
 			 (GCallback) item_event_help,
@@ -243,7 +252,7 @@ void gc_help_start (GcomprisBoard *gcomprisBoard)
 					      -1,
 					      GTK_ANCHOR_CENTER,
 					      "font", gc_skin_font_content,
-					      "fill-color-rgba", gc_skin_get_color("gcompris/helpunselect"),
+					      "fill-color-rgba", gc_skin_get_color_q(help_unselect_quark),
 					      NULL);
       g_signal_connect(item_manual_text, "button_press_event",
 			 (GCallback) item_event_help,
@@ -273,7 +282,7 @@ void gc_help_start (GcomprisBoard *gcomprisBoard)
 					      -1,
 					      GTK_ANCHOR_CENTER,
 					      "font", gc_skin_font_content,
-					      "fill-color-rgba", gc_skin_get_color("gcompris/helpunselect"),
+					      "fill-color-rgba", gc_skin_get_color_q(help_unselect_quark),
 					      NULL);
       g_signal_connect(item_credit_text, "button_press_event",
 			 (GCallback) item_event_help,
@@ -319,9 +328,8 @@ void gc_help_start (GcomprisBoard *gcomprisBoard)
 		   (GCallback) event_disable_right_click_popup, NULL);
 
   PangoFontDescription *font_desc;
-  font_desc = pango_font_description_from_string (gc_skin_font_content);
+  font_desc = gc_skin_get_font_desc_quark (help_content_quark, FONT_CONTENT);
   gtk_widget_modify_font (view, font_desc);
-  pango_font_description_free (font_desc);
 
   GdkColor fg_color;
   GdkColor bg_color;
@@ -401,7 +409,7 @@ static void select_item(GooCanvasItem *item, GooCanvasItem *item_text)
 		   "svg-id", item_id,
 		   NULL);
       g_object_set(item_selected_text,
-		   "fill-color-rgba", gc_skin_get_color("gcompris/helpunselect"),
+		   "fill-color-rgba", gc_skin_get_color_q(help_unselect_quark),
 		   NULL);
 
     }
@@ -411,7 +419,7 @@ static void select_item(GooCanvasItem *item, GooCanvasItem *item_text)
 	       "svg-id", item_id,
 	       NULL);
   g_object_set(item_text,
-	       "fill-color-rgba", gc_skin_get_color("gcompris/helpselect"),
+	       "fill-color-rgba", gc_skin_get_color_q(help_select_quark),
 	       NULL);
   item_selected = item;
   item_selected_text = item_text;
@@ -22,6 +22,10 @@
  */
 
 #include "string.h"
+#include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
 
 /* libxml includes */
 #include <libxml/tree.h>
@@ -43,7 +47,14 @@ static void		 item_event_scroll(GtkAdjustment *adj,
 					   GooCanvas *canvas);
 static gboolean          read_xml_file(gchar *fname);
 static gboolean		 read_dataset_directory(gchar *dataset_dir);
-static void		 display_image(gchar *imagename, GooCanvasItem *rootitem);
+static void		 display_image_set(gchar *imagename, GSList *imagelist,
+					   GdkPixbuf *pixmap);
+static void		 display_imageset_until(GooCanvasItem *rootitem_set,
+						gdouble bottom);
+static gpointer		 loader_run(gchar *dataseturl);
+static void		 loader_parse(gchar *dataseturl);
+static gboolean		 loader_poll(gpointer data);
+static void		 loader_stop(void);
 static void		 free_stuff (GSList *data);
 
 static gboolean		 images_selector_displayed = FALSE;
@@ -85,13 +96,53 @@ static gboolean		 display_in_progress;
 #define LIST_IMAGE_WIDTH  LIST_AREA_X2-LIST_AREA_X1-IMAGE_GAP
 #define LIST_IMAGE_HEIGHT (LIST_AREA_Y2-LIST_AREA_Y1)/VERTICAL_NUMBER_OF_LIST_IMAGE-IMAGE_GAP
 
-static double		 ix;
-static double		 iy;
 static double		 isy;
 
 static GtkAdjustment    *list_adj;
 static GtkAdjustment    *image_adj;
 
+/* An image set parsed by the loader thread, waiting to be displayed */
+typedef struct {
+  gchar     *name;
+  GSList    *images;
+  GdkPixbuf *pixmap;	/* The thumbnail of the set */
+} ImageSet;
+
+/* An image displayed with a placeholder, waiting for its thumbnail */
+typedef struct {
+  gchar         *imagename;
+  gint           width;
+  gint           height;
+  gdouble        x;
+  gdouble        y;
+  GooCanvasItem *item;		/* The placeholder, referenced */
+  GdkPixbuf     *pixmap;	/* Set by the loader thread */
+  guint          generation;
+} Thumbnail;
+
+/* The images of a set are only loaded when they are scrolled in view */
+typedef struct {
+  GSList *next;		/* The first image not displayed yet */
+  gint    count;	/* The number of images displayed */
+} ImageSetView;
+
+/* The datasets are parsed in a thread, the main loop displays the
+ * image sets it finds as they come in loader_queue. */
+static GThread		*loader_thread = NULL;
+static GAsyncQueue	*loader_queue = NULL;
+static volatile gint	 loader_cancelled;
+static guint		 loader_source_id = 0;
+/* Pushed by the loader thread once it is done */
+static ImageSet		 loader_done;
+
+/* Once the datasets are parsed, the loader thread makes the thumbnails
+ * of the images pushed in thumbnail_queue. They are swapped in from an
+ * idle callback, which drops the ones of a previous selector. */
+static GAsyncQueue	*thumbnail_queue = NULL;
+static guint		 thumbnail_generation = 0;
+/* Pushed to stop the loader thread */
+static Thumbnail	 thumbnail_stop;
+
 /*
  * Main entry point
  * ----------------
@@ -250,6 +301,8 @@ gc_selector_images_start (GcomprisBoard *gcomprisBoard, gchar *dataset,
   /* Initial image position */
   isy = 0.0;
 
+  g_atomic_int_set(&loader_cancelled, FALSE);
+
   /* I need  the following :
      -> if dataset is a file read it.
      -> if dataset is a directory, read all xml file in it.
@@ -258,17 +311,25 @@ gc_selector_images_start (GcomprisBoard *gcomprisBoard, gchar *dataset,
     gc_file_find_absolute(dataset,
 			  NULL);
 
-  /* if the file doesn't exist */
-  if(g_file_test ((dataseturl), G_FILE_TEST_IS_DIR) )
+  if(dataseturl)
     {
-      g_warning("dataset %s is a directory. Trying to read xml", dataseturl);
+      /* Parse the datasets in the background, the image sets are
+	 displayed as soon as they are found */
+      if (!g_thread_supported ()) g_thread_init (NULL);
+      xmlInitParser();
 
-      read_dataset_directory(dataseturl);
-    }
-  else if(dataseturl)
-    {
-      /* Read the given data set file, local or net */
-      read_xml_file(dataseturl);
+      loader_queue = g_async_queue_new();
+      thumbnail_queue = g_async_queue_new();
+
+      loader_thread = g_thread_create((GThreadFunc) loader_run,
+				      g_strdup(dataseturl), TRUE, NULL);
+      if (loader_thread == NULL)
+	{
+	  g_warning("create failed for the images selector loader");
+	  loader_parse(g_strdup(dataseturl));
+	}
+
+      loader_source_id = g_timeout_add(50, loader_poll, NULL);
     }
   else
     {
@@ -321,6 +382,8 @@ void gc_selector_images_stop ()
       gc_board_pause(FALSE);
     }
 
+  loader_stop();
+
   // Destroy the image_selector box
   if(rootitem!=NULL)
     goo_canvas_item_remove(rootitem);
@@ -339,81 +402,411 @@ void gc_selector_images_stop ()
 /*-------------------------------------------------------------------------------*/
 /*-------------------------------------------------------------------------------*/
 
+/*
+ * The loader thread
+ * -----------------
+ */
+
+static GdkPixbuf	*thumbnail_load(gchar *imagename, gint width, gint height);
+static void		 thumbnail_make(Thumbnail *thumb);
+static void		 thumbnail_free(Thumbnail *thumb);
+
+static void
+loader_parse(gchar *dataseturl)
+{
+  if(g_file_test ((dataseturl), G_FILE_TEST_IS_DIR) )
+    {
+      g_warning("dataset %s is a directory. Trying to read xml", dataseturl);
+
+      read_dataset_directory(dataseturl);
+    }
+  else
+    {
+      /* Read the given data set file, local or net */
+      read_xml_file(dataseturl);
+    }
+
+  g_free(dataseturl);
+  g_async_queue_push(loader_queue, &loader_done);
+}
+
+/* Make the thumbnails requested while the loader was busy parsing */
+static void
+loader_make_pending(void)
+{
+  Thumbnail *thumb;
+
+  while ((thumb = g_async_queue_try_pop(thumbnail_queue)))
+    {
+      if (thumb == &thumbnail_stop)
+	{
+	  /* Keep it for loader_run() */
+	  g_async_queue_push(thumbnail_queue, thumb);
+	  return;
+	}
+      thumbnail_make(thumb);
+    }
+}
+
+static gpointer
+loader_run(gchar *dataseturl)
+{
+  Thumbnail *thumb;
+
+  loader_parse(dataseturl);
+
+  /* Then make the thumbnails of the images as they are displayed */
+  while ((thumb = g_async_queue_pop(thumbnail_queue)) != &thumbnail_stop)
+    thumbnail_make(thumb);
+
+  return NULL;
+}
+
+static void
+loader_push(gchar *imagename, GSList *imagelist)
+{
+  ImageSet *set;
+  GdkPixbuf *pixmap;
+
+  if (g_atomic_int_get(&loader_cancelled))
+    {
+      free_stuff(imagelist);
+      return;
+    }
+
+  /* Do not let the displayed images wait for the whole parsing */
+  if (loader_thread)
+    loader_make_pending();
+
+  pixmap = thumbnail_load(imagename,
+			  LIST_IMAGE_WIDTH * gc_zoom_factor_get(),
+			  LIST_IMAGE_HEIGHT * gc_zoom_factor_get());
+  if (!pixmap)
+    {
+      free_stuff(imagelist);
+      return;
+    }
+
+  set = g_new(ImageSet, 1);
+  set->name = g_strdup(imagename);
+  set->images = imagelist;
+  set->pixmap = pixmap;
+  g_async_queue_push(loader_queue, set);
+}
+
+/* Display the image sets found by the loader so far */
+static gboolean
+loader_poll(gpointer data)
+{
+  ImageSet *set;
+
+  while ((set = g_async_queue_try_pop(loader_queue)))
+    {
+      if (set == &loader_done)
+	{
+	  /* The loader thread keeps making the thumbnails */
+	  loader_source_id = 0;
+	  return FALSE;
+	}
+
+      display_image_set(set->name, set->images, set->pixmap);
+      g_free(set);
+    }
+
+  return TRUE;
+}
+
+/* Cancel the loader if it is still running and drop what it found */
 static void
-display_image(gchar *imagename, GooCanvasItem *root_item)
+loader_stop(void)
 {
+  ImageSet *set;
+  Thumbnail *thumb;
+
+  if (loader_source_id)
+    {
+      g_source_remove(loader_source_id);
+      loader_source_id = 0;
+    }
+
+  if (loader_thread)
+    {
+      g_atomic_int_set(&loader_cancelled, TRUE);
+      g_async_queue_push(thumbnail_queue, &thumbnail_stop);
+      g_thread_join(loader_thread);
+      loader_thread = NULL;
+    }
+
+  /* The thumbnails still on their way are dropped */
+  thumbnail_generation++;
+
+  if (loader_queue)
+    {
+      while ((set = g_async_queue_try_pop(loader_queue)))
+	if (set != &loader_done)
+	  {
+	    g_free(set->name);
+	    free_stuff(set->images);
+#if GDK_PIXBUF_MAJOR <= 2 && GDK_PIXBUF_MINOR <= 24
+	    gdk_pixbuf_unref(set->pixmap);
+#else
+	    g_object_unref(set->pixmap);
+#endif
+	    g_free(set);
+	  }
+      g_async_queue_unref(loader_queue);
+      loader_queue = NULL;
+    }
+
+  if (thumbnail_queue)
+    {
+      while ((thumb = g_async_queue_try_pop(thumbnail_queue)))
+	if (thumb != &thumbnail_stop)
+	  thumbnail_free(thumb);
+      g_async_queue_unref(thumbnail_queue);
+      thumbnail_queue = NULL;
+    }
+}
+
+/*
+ * Load imagename scaled to fit in width x height.
+ * The scaled image is kept in the .thumbnails directory of the user dir
+ * so that the full size image is decoded again only when it changes.
+ */
+static GdkPixbuf *
+thumbnail_load(gchar *imagename, gint width, gint height)
+{
+  GcomprisProperties *properties = gc_prop_get();
   GdkPixbuf *pixmap = NULL;
-  GooCanvasItem *item;
+  gchar *filename, *key, *md5, *thumbname, *mtime;
+  struct stat st;
+
+  filename = gc_file_find_absolute(imagename, NULL);
+  if (!filename)
+    return NULL;
+
+  if (g_stat(filename, &st) != 0)
+    {
+      g_free(filename);
+      return NULL;
+    }
+
+  key = g_strdup_printf("%s %dx%d", filename, width, height);
+  md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, key, -1);
+  thumbname = g_strconcat(properties->user_dir, "/.thumbnails/", md5, ".png", NULL);
+  mtime = g_strdup_printf("%ld", (long) st.st_mtime);
+
+  if (g_file_test(thumbname, G_FILE_TEST_IS_REGULAR))
+    {
+      pixmap = gdk_pixbuf_new_from_file(thumbname, NULL);
+
+      /* Same option as the freedesktop thumbnails */
+      if (pixmap
+	  && g_strcmp0(gdk_pixbuf_get_option(pixmap, "tEXt::Thumb::MTime"),
+		       mtime) != 0)
+	{
+	  g_object_unref(pixmap);
+	  pixmap = NULL;
+	}
+    }
+
+  if (!pixmap)
+    {
+      /* Let the loader scale while decoding */
+      pixmap = gdk_pixbuf_new_from_file_at_size(filename, width, height, NULL);
+
+      if (pixmap)
+	{
+	  gchar *dirname = g_path_get_dirname(thumbname);
+	  g_mkdir_with_parents(dirname, 0755);
+	  g_free(dirname);
+
+	  if (!gdk_pixbuf_save(pixmap, thumbname, "png", NULL,
+			       "tEXt::Thumb::MTime", mtime, NULL))
+	    g_warning("Fail to write the thumbnail %s", thumbname);
+	}
+    }
+
+  g_free(mtime);
+  g_free(thumbname);
+  g_free(md5);
+  g_free(key);
+  g_free(filename);
+
+  return pixmap;
+}
+
+static void
+thumbnail_free(Thumbnail *thumb)
+{
+  g_free(thumb->imagename);
+  g_object_unref(thumb->item);
+  if (thumb->pixmap)
+#if GDK_PIXBUF_MAJOR <= 2 && GDK_PIXBUF_MINOR <= 24
+    gdk_pixbuf_unref(thumb->pixmap);
+#else
+    g_object_unref(thumb->pixmap);
+#endif
+  g_free(thumb);
+}
+
+/* Swap the thumbnail in place of the placeholder, in the main loop */
+static gboolean
+thumbnail_ready(gpointer data)
+{
+  Thumbnail *thumb = (Thumbnail *)data;
   double xratio, yratio;
-  double iw, ih;
 
-  if (imagename==NULL || !images_selector_displayed)
-    return;
+  if (thumb->generation == thumbnail_generation)
+    {
+      if (thumb->pixmap)
+	{
+	  /* Calc the max to resize width or height */
+	  xratio = (double) thumb->width / gdk_pixbuf_get_width(thumb->pixmap);
+	  yratio = (double) thumb->height / gdk_pixbuf_get_height(thumb->pixmap);
+	  xratio = MIN(yratio, xratio);
+
+	  g_object_set(thumb->item,
+		       "pixbuf", thumb->pixmap,
+		       NULL);
+	  goo_canvas_item_set_simple_transform(thumb->item,
+					       thumb->x, thumb->y,
+					       xratio, 0);
+	  gc_item_focus_init(thumb->item, NULL);
+	}
+      else
+	{
+	  /* Sad, the image is not found */
+	  goo_canvas_item_remove(thumb->item);
+	}
+    }
 
-  pixmap = gc_pixmap_load_or_null(imagename);
+  thumbnail_free(thumb);
+  return FALSE;
+}
 
-  /* Sad, the image is not found */
-  if(!pixmap)
-    return;
+/* Called by the loader thread, or in the main loop without it */
+static void
+thumbnail_make(Thumbnail *thumb)
+{
+  if (!g_atomic_int_get(&loader_cancelled))
+    thumb->pixmap = thumbnail_load(thumb->imagename,
+				   thumb->width, thumb->height);
+
+  g_idle_add(thumbnail_ready, thumb);
+}
+
+/* The number of images in a row of the image area */
+static gint
+images_per_row(void)
+{
+  gdouble iw = IMAGE_WIDTH * gc_zoom_factor_get();
+
+  return MAX(1, (gint) ceil(((DRAWING_AREA_X2 - DRAWING_AREA_X1)
+			     * gc_zoom_factor_get() - IMAGE_GAP)
+			    / (iw + IMAGE_GAP)));
+}
+
+/*
+ * Display a placeholder for imagename, its thumbnail replaces it once
+ * the loader thread has made it.
+ */
+static gboolean
+display_image(gchar *imagename, GooCanvasItem *root_item, gint index)
+{
+  GdkPixbuf *pixmap = NULL;
+  Thumbnail *thumb;
+  double iw, ih;
+  gint columns = images_per_row();
+
+  if (imagename==NULL || !images_selector_displayed)
+    return FALSE;
 
   iw = IMAGE_WIDTH * gc_zoom_factor_get();
   ih = IMAGE_HEIGHT * gc_zoom_factor_get();
 
-  /* Calc the max to resize width or height */
-  xratio = (double) ((iw/(double)gdk_pixbuf_get_width(pixmap)));
-  yratio = (double) ((ih/(double)gdk_pixbuf_get_height(pixmap)));
-  xratio = MIN(yratio, xratio);
+  thumb = g_new0(Thumbnail, 1);
+  thumb->imagename = g_strdup(imagename);
+  thumb->width = iw;
+  thumb->height = ih;
+  thumb->x = (index % columns) * (iw + IMAGE_GAP);
+  thumb->y = (index / columns) * (ih + IMAGE_GAP);
+  thumb->generation = thumbnail_generation;
 
-  item = goo_canvas_image_new (root_item,
-			       pixmap,
-			       0,
-			       0,
-			       NULL);
-  goo_canvas_item_translate(item, ix, iy);
-  goo_canvas_item_scale(item, xratio, xratio);
+  pixmap = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8,
+			  thumb->width, thumb->height);
+  gdk_pixbuf_fill(pixmap, 0xFFFFFF40);
+
+  thumb->item = goo_canvas_image_new (root_item,
+				      pixmap,
+				      0,
+				      0,
+				      NULL);
+  goo_canvas_item_set_simple_transform(thumb->item,
+				       thumb->x, thumb->y, 1.0, 0);
 #if GDK_PIXBUF_MAJOR <= 2 && GDK_PIXBUF_MINOR <= 24
   gdk_pixbuf_unref(pixmap);
 #else
   g_object_unref(pixmap);
 #endif
 
-  g_signal_connect(item, "button_press_event",
+  g_signal_connect(thumb->item, "button_press_event",
 		   (GCallback) item_event_images_selector,
 		   imagename);
-  gc_item_focus_init(item, NULL);
+  g_object_ref(thumb->item);
 
-  ix += iw + IMAGE_GAP;
-  if(ix >= (DRAWING_AREA_X2 - DRAWING_AREA_X1)
-     * gc_zoom_factor_get() - IMAGE_GAP)
-    {
-      ix = 0;
-      iy += ih + IMAGE_GAP;
-    }
+  if (loader_thread)
+    g_async_queue_push(thumbnail_queue, thumb);
+  else
+    thumbnail_make(thumb);
+
+  return TRUE;
+}
+
+/* Display the images of a set down to bottom, plus one row to not
+ * show a hole while scrolling */
+static void
+display_imageset_until(GooCanvasItem *rootitem_set, gdouble bottom)
+{
+  ImageSetView *view;
+  gdouble ih = IMAGE_HEIGHT * gc_zoom_factor_get();
+  gint needed;
 
-  /* Cannot use GINT_TO_POINTER with a constant calculation */
-  guint iy_calc = iy + (ih + IMAGE_GAP)*2;
-  g_object_set_data (G_OBJECT (root_item), "iy", GINT_TO_POINTER (iy_calc));
+  view = (ImageSetView *)g_object_get_data (G_OBJECT (rootitem_set), "view");
+  g_return_if_fail (view != NULL);
+
+  needed = ((gint) (bottom / (ih + IMAGE_GAP)) + 2) * images_per_row();
+
+  for (; view->next && view->count < needed; view->next = view->next->next)
+    if (display_image(view->next->data, rootitem_set, view->count))
+      view->count++;
 }
 
 /*
- * Same as display_image but for the dataset
+ * Same as display_image but for the dataset, its thumbnail is already
+ * made by the loader thread.
  * The imagelist contains the list of images to be displayed when this dataset is selected
  */
 static void
-display_image_set(gchar *imagename, GSList *imagelist)
+display_image_set(gchar *imagename, GSList *imagelist, GdkPixbuf *pixmap)
 {
-  GdkPixbuf *pixmap = NULL;
   GooCanvasItem *item;
   GooCanvasItem *rootitem_set;
+  ImageSetView *view;
   double xratio, yratio;
   double iw, ih;
 
   if (imagename == NULL || !images_selector_displayed)
-    return;
-
-  pixmap = gc_pixmap_load_or_null(imagename);
-  if (!pixmap)
-    return;
+    {
+      g_free(imagename);
+      free_stuff(imagelist);
+#if GDK_PIXBUF_MAJOR <= 2 && GDK_PIXBUF_MINOR <= 24
+      gdk_pixbuf_unref(pixmap);
+#else
+      g_object_unref(pixmap);
+#endif
+      return;
+    }
 
   iw = LIST_IMAGE_WIDTH * gc_zoom_factor_get();
   ih = LIST_IMAGE_HEIGHT * gc_zoom_factor_get();
@@ -435,8 +828,6 @@ display_image_set(gchar *imagename, GSList *imagelist)
 #else
   g_object_unref(pixmap);
 #endif
-  g_object_set_data (G_OBJECT (item), "imagelist", imagelist);
-
   g_signal_connect(item, "button_press_event",
 		     (GCallback) item_event_imageset_selector,
 		     imagename);
@@ -467,10 +858,16 @@ display_image_set(gchar *imagename, GSList *imagelist)
     goo_canvas_group_new (goo_canvas_get_root_item(GOO_CANVAS(canvas_image_selector)),
 			  NULL);
 
+  view = g_new0(ImageSetView, 1);
+  view->next = imagelist;
+  g_object_set_data_full (G_OBJECT (rootitem_set), "view",
+			  view, g_free);
+
   g_object_set_data (G_OBJECT (item), "rootitem", rootitem_set);
-  g_object_set_data (G_OBJECT (item), "imageset_done", GINT_TO_POINTER (0));
   g_object_set_data_full (G_OBJECT (item), "imagelist",
 			  imagelist, (GDestroyNotify)free_stuff );
+  g_object_set_data_full (G_OBJECT (item), "imagename",
+			  imagename, g_free);
 }
 
 static void
@@ -491,8 +888,8 @@ item_event_imageset_selector(GooCanvasItem *item, GdkEvent *event,
 {
   GSList *image_list;
   GooCanvasItem *rootitem_set;
-  guint imageset_done;
-  gdouble last_iy;
+  gint rows;
+  gdouble upper;
 
   if(display_in_progress)
     return TRUE;
@@ -508,31 +905,23 @@ item_event_imageset_selector(GooCanvasItem *item, GdkEvent *event,
 						     "rootitem");
   g_return_val_if_fail (rootitem_set != NULL, FALSE);
 
-  imageset_done = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (item),
-						      "imageset_done"));
-
   /* Hide the previous image set if any */
   if (current_root_set != NULL) {
     g_object_set (current_root_set,
 		  "visibility", GOO_CANVAS_ITEM_INVISIBLE,
 		  NULL);
   }
-  /* Not yet displayed set */
-  if(!imageset_done)
-    {
-      /* Initial image position */
-      ix = 0;
-      iy = 0;
-
-      g_slist_foreach (image_list, (GFunc) display_image, rootitem_set);
-      g_object_set_data (G_OBJECT (item), "imageset_done", GINT_TO_POINTER (1));
-    }
+  /* Only the first page of images is displayed, the others come
+     when they are scrolled in view */
+  display_imageset_until(rootitem_set,
+			 (DRAWING_AREA_Y2 - DRAWING_AREA_Y1)
+			 * gc_zoom_factor_get());
 
   /* Set the image scrollbar back to its max position */
-  last_iy = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (rootitem_set), "iy"));
-  gdouble upper = MAX(last_iy,
-		      (DRAWING_AREA_Y2 - DRAWING_AREA_Y1)
-		      * gc_zoom_factor_get());
+  rows = (g_slist_length(image_list) + images_per_row() - 1) / images_per_row();
+  upper = MAX((rows + 1) * (IMAGE_HEIGHT * gc_zoom_factor_get() + IMAGE_GAP),
+	      (DRAWING_AREA_Y2 - DRAWING_AREA_Y1)
+	      * gc_zoom_factor_get());
 
   goo_canvas_set_bounds  (GOO_CANVAS(canvas_image_selector),
 			  0, 0,
@@ -545,7 +934,7 @@ item_event_imageset_selector(GooCanvasItem *item, GdkEvent *event,
 	       NULL);
 
   g_object_set(image_adj,
-  	       "upper", last_iy,
+  	       "upper", upper,
   	       NULL);
   gtk_adjustment_set_value(image_adj, 0);
 
@@ -595,6 +984,9 @@ item_event_scroll(GtkAdjustment *adj, GooCanvas *canvas)
     return;
 
   goo_canvas_scroll_to (canvas, 0, adj->value);
+
+  if (canvas == GOO_CANVAS(canvas_image_selector) && current_root_set)
+    display_imageset_until(current_root_set, adj->value + adj->page_size);
 }
 
 /*
@@ -725,7 +1117,8 @@ parseImage (xmlDocPtr doc, xmlNodePtr cur) {
 
   /* do not display if there is nothing to display */
   if (imageList != NULL) /* g_slist is not empty */
-    display_image_set(imageSetName, imageList);
+    loader_push(imageSetName, imageList);
+  xmlFree(imageSetName);
 
   g_free(absolutepath);
   if(pathname)
@@ -748,7 +1141,7 @@ parse_doc(xmlDocPtr doc) {
   }
   cur = cur->xmlChildrenNode;
 
-  while (cur != NULL) {
+  while (cur != NULL && !g_atomic_int_get(&loader_cancelled)) {
     if ((!xmlStrcmp(cur->name, (const xmlChar *)"ImageSet"))){
       parseImage (doc, cur);
     }
@@ -815,7 +1208,8 @@ read_dataset_directory(gchar *dataset_dir)
   if(!dataset_directory)
     return FALSE;
 
-  while ((fname = g_dir_read_name(dataset_directory))) {
+  while ((fname = g_dir_read_name(dataset_directory))
+	 && !g_atomic_int_get(&loader_cancelled)) {
     /* skip files without ".xml" */
     if (!g_str_has_suffix (fname,".xml")){
       g_warning("skipping file not in .xml : %s", fname);
@@ -19,8 +19,56 @@
  */
 
 
+#include <string.h>
 #include "pixbuf_util.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PIXBUF_UTIL_SSE2 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PIXBUF_UTIL_NEON 1
+#endif
+
+
+/*
+ * Copies a row of w 4 bytes pixels in reverse order.
+ */
+static void pixbuf_mirror_row_32(guchar *dp, const guchar *sp, gint w)
+{
+	gint j = 0;
+
+	dp += w * 4;
+
+#if defined(PIXBUF_UTIL_SSE2)
+	for (; j + 4 <= w; j += 4)
+		{
+		__m128i v = _mm_loadu_si128((const __m128i *) sp);
+
+		dp -= 16;
+		_mm_storeu_si128((__m128i *) dp,
+				 _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+		sp += 16;
+		}
+#elif defined(PIXBUF_UTIL_NEON)
+	for (; j + 4 <= w; j += 4)
+		{
+		uint32x4_t v = vrev64q_u32(vld1q_u32((const uint32_t *) sp));
+
+		dp -= 16;
+		vst1q_u32((uint32_t *) dp, vcombine_u32(vget_high_u32(v), vget_low_u32(v)));
+		sp += 16;
+		}
+#endif
+
+	for (; j < w; j++)
+		{
+		dp -= 4;
+		memcpy(dp, sp, 4);
+		sp += 4;
+		}
+}
+
 
 /*
  * Returns a copy of pixbuf mirrored and or flipped.
@@ -65,7 +113,11 @@ GdkPixbuf *pixbuf_copy_mirror(GdkPixbuf *src, gint mirror, gint flip)
 			{
 			dp = d_pix + (i * drs);
 			}
-		if (mirror)
+		if (mirror && has_alpha)
+			{
+			pixbuf_mirror_row_32(dp, sp, w);
+			}
+		else if (mirror)
 			{
 			dp += (w - 1) * a;
 			for (j = 0; j < w; j++)
@@ -73,19 +125,12 @@ GdkPixbuf *pixbuf_copy_mirror(GdkPixbuf *src, gint mirror, gint flip)
 				*(dp++) = *(sp++);	/* r */
 				*(dp++) = *(sp++);	/* g */
 				*(dp++) = *(sp++);	/* b */
-				if (has_alpha) *(dp) = *(sp++);	/* a */
 				dp -= (a + 3);
 				}
 			}
 		else
 			{
-			for (j = 0; j < w; j++)
-				{
-				*(dp++) = *(sp++);	/* r */
-				*(dp++) = *(sp++);	/* g */
-				*(dp++) = *(sp++);	/* b */
-				if (has_alpha) *(dp++) = *(sp++);	/* a */
-				}
+			memcpy(dp, sp, w * a);
 			}
 		}
 
@@ -113,10 +158,34 @@ void pixbuf_add_transparent (GdkPixbuf *pixbuf,guint alpha)
 
   h = gdk_pixbuf_get_height(pixbuf);
 
+  /* The alpha bytes are lowered with a saturated subtraction */
+  alpha = MIN(alpha, 255);
+
   while (h--) {
     w = gdk_pixbuf_get_width(pixbuf);
     p = pixels;
 
+#if defined(PIXBUF_UTIL_SSE2)
+    {
+      const __m128i sub = _mm_set1_epi32(alpha << 24);
+
+      for (; w >= 4; w -= 4) {
+	__m128i v = _mm_loadu_si128((const __m128i *) p);
+	_mm_storeu_si128((__m128i *) p, _mm_subs_epu8(v, sub));
+	p += 16;
+      }
+    }
+#elif defined(PIXBUF_UTIL_NEON)
+    {
+      const uint8x16_t sub = vreinterpretq_u8_u32(vdupq_n_u32(GUINT32_TO_LE(alpha << 24)));
+
+      for (; w >= 4; w -= 4) {
+	vst1q_u8(p, vqsubq_u8(vld1q_u8(p), sub));
+	p += 16;
+      }
+    }
+#endif
+
     while (w--) {
       if(p[3] > alpha)
 	p[3] = p[3] - alpha;
@@ -129,3 +198,203 @@ void pixbuf_add_transparent (GdkPixbuf *pixbuf,guint alpha)
   }
 }
 
+
+/*
+ * Clip the rectangle x,y,w,h to the pixbuf area.
+ * Returns FALSE if nothing is left.
+ */
+static gboolean pixbuf_clip_rect (GdkPixbuf *pixbuf,
+				  gint *x, gint *y, gint *w, gint *h)
+{
+  gint pw = gdk_pixbuf_get_width(pixbuf);
+  gint ph = gdk_pixbuf_get_height(pixbuf);
+
+  if (*x < 0) { *w += *x; *x = 0; }
+  if (*y < 0) { *h += *y; *y = 0; }
+  if (*x + *w > pw) *w = pw - *x;
+  if (*y + *h > ph) *h = ph - *y;
+
+  return (*w > 0 && *h > 0);
+}
+
+/*
+ * Fill the rectangle x,y,w,h of pixbuf with the color rgba (0xRRGGBBAA).
+ * The rectangle is clipped to the pixbuf.
+ */
+void pixbuf_fill_rect (GdkPixbuf *pixbuf, gint x, gint y, gint w, gint h,
+		       guint32 rgba)
+{
+  guchar *pixels;
+  guchar *p;
+  guchar r, g, b, a;
+  gint n_channels, rowstride;
+  gint i;
+
+  g_return_if_fail(GDK_IS_PIXBUF (pixbuf));
+
+  if (!pixbuf_clip_rect(pixbuf, &x, &y, &w, &h))
+    return;
+
+  r = (rgba >> 24) & 0xff;
+  g = (rgba >> 16) & 0xff;
+  b = (rgba >>  8) & 0xff;
+  a = rgba & 0xff;
+
+  n_channels = gdk_pixbuf_get_n_channels(pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+  pixels = gdk_pixbuf_get_pixels(pixbuf) + y * rowstride + x * n_channels;
+
+  /* Fill the first row then copy it over the next ones */
+  p = pixels;
+  for (i = 0; i < w; i++) {
+    p[0] = r;
+    p[1] = g;
+    p[2] = b;
+    if (n_channels == 4)
+      p[3] = a;
+    p += n_channels;
+  }
+
+  for (i = 1; i < h; i++)
+    memcpy(pixels + i * rowstride, pixels, w * n_channels);
+}
+
+/*
+ * Copy the area sx,sy,w,h of src at dx,dy in dest.
+ * Unlike gdk_pixbuf_copy_area(), the area is clipped to both pixbufs.
+ */
+void pixbuf_blit (GdkPixbuf *src, gint sx, gint sy, gint w, gint h,
+		  GdkPixbuf *dest, gint dx, gint dy)
+{
+  g_return_if_fail(GDK_IS_PIXBUF (src));
+  g_return_if_fail(GDK_IS_PIXBUF (dest));
+
+  /* Clip against the source */
+  if (sx < 0) { w += sx; dx -= sx; sx = 0; }
+  if (sy < 0) { h += sy; dy -= sy; sy = 0; }
+  /* Clip against the destination */
+  if (dx < 0) { w += dx; sx -= dx; dx = 0; }
+  if (dy < 0) { h += dy; sy -= dy; dy = 0; }
+
+  w = MIN(w, gdk_pixbuf_get_width(src) - sx);
+  h = MIN(h, gdk_pixbuf_get_height(src) - sy);
+  w = MIN(w, gdk_pixbuf_get_width(dest) - dx);
+  h = MIN(h, gdk_pixbuf_get_height(dest) - dy);
+
+  if (w <= 0 || h <= 0)
+    return;
+
+  gdk_pixbuf_copy_area(src, sx, sy, w, h, dest, dx, dy);
+}
+
+static inline gboolean pixel_matches (const guchar *p, const guchar *seed,
+				      gint n_channels, guint tolerance)
+{
+  gint i;
+
+  for (i = 0; i < n_channels; i++)
+    if ((guint) ABS(p[i] - seed[i]) > tolerance)
+      return FALSE;
+
+  return TRUE;
+}
+
+/*
+ * Flood fill the area connected to x,y with the color rgba (0xRRGGBBAA).
+ * A pixel belongs to the area if none of its channels differs by more
+ * than tolerance from the one at x,y.
+ * Returns the number of pixels filled.
+ */
+guint pixbuf_flood_fill (GdkPixbuf *pixbuf, gint x, gint y,
+			 guint32 rgba, guint tolerance)
+{
+  guchar *pixels;
+  guchar *visited;
+  guchar seed[4];
+  guchar color[4];
+  GArray *stack;
+  gint n_channels, rowstride;
+  gint width, height;
+  guint count = 0;
+
+  g_return_val_if_fail(GDK_IS_PIXBUF (pixbuf), 0);
+
+  width = gdk_pixbuf_get_width(pixbuf);
+  height = gdk_pixbuf_get_height(pixbuf);
+
+  if (x < 0 || y < 0 || x >= width || y >= height)
+    return 0;
+
+  n_channels = gdk_pixbuf_get_n_channels(pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+  pixels = gdk_pixbuf_get_pixels(pixbuf);
+
+  color[0] = (rgba >> 24) & 0xff;
+  color[1] = (rgba >> 16) & 0xff;
+  color[2] = (rgba >>  8) & 0xff;
+  color[3] = rgba & 0xff;
+  memcpy(seed, pixels + y * rowstride + x * n_channels, n_channels);
+
+#define PIXEL_AT(px, py) (pixels + (py) * rowstride + (px) * n_channels)
+#define MATCHES(px, py)						\
+  (!visited[(py) * width + (px)] &&				\
+   pixel_matches(PIXEL_AT(px, py), seed, n_channels, tolerance))
+
+  visited = g_malloc0(width * height);
+  stack = g_array_new(FALSE, FALSE, sizeof(gint));
+  g_array_append_val(stack, x);
+  g_array_append_val(stack, y);
+
+  /* Scanline fill: fill a whole run then push the runs above and below */
+  while (stack->len) {
+    gint cx, cy, left, right, i, dir;
+
+    cy = g_array_index(stack, gint, stack->len - 1);
+    cx = g_array_index(stack, gint, stack->len - 2);
+    g_array_set_size(stack, stack->len - 2);
+
+    if (!MATCHES(cx, cy))
+      continue;
+
+    left = cx;
+    while (left > 0 && MATCHES(left - 1, cy))
+      left--;
+    right = cx;
+    while (right < width - 1 && MATCHES(right + 1, cy))
+      right++;
+
+    for (i = left; i <= right; i++) {
+      memcpy(PIXEL_AT(i, cy), color, n_channels);
+      visited[cy * width + i] = 1;
+    }
+    count += right - left + 1;
+
+    for (dir = -1; dir <= 1; dir += 2) {
+      gint ny = cy + dir;
+      gboolean in_run = FALSE;
+
+      if (ny < 0 || ny >= height)
+	continue;
+
+      for (i = left; i <= right; i++) {
+	if (MATCHES(i, ny)) {
+	  if (!in_run) {
+	    g_array_append_val(stack, i);
+	    g_array_append_val(stack, ny);
+	    in_run = TRUE;
+	  }
+	} else {
+	  in_run = FALSE;
+	}
+      }
+    }
+  }
+
+#undef MATCHES
+#undef PIXEL_AT
+
+  g_array_free(stack, TRUE);
+  g_free(visited);
+
+  return count;
+}
@@ -28,4 +28,13 @@ GdkPixbuf *pixbuf_copy_mirror(GdkPixbuf *src, gint mirror, gint flip);
 
 void pixbuf_add_transparent (GdkPixbuf *pixbuf,guint alpha);
 
+void pixbuf_fill_rect (GdkPixbuf *pixbuf, gint x, gint y, gint w, gint h,
+		       guint32 rgba);
+
+void pixbuf_blit (GdkPixbuf *src, gint sx, gint sy, gint w, gint h,
+		  GdkPixbuf *dest, gint dx, gint dy);
+
+guint pixbuf_flood_fill (GdkPixbuf *pixbuf, gint x, gint y,
+			 guint32 rgba, guint tolerance);
+
 #endif
@@ -139,14 +139,14 @@ int sdlplayer_music(char *filename, int volume)
   return(0);
 }
 
-int sdlplayer_fx(char *filename, int volume)
+static int sdlplayer_fx_rw(SDL_RWops *rw, const char *name, int volume)
 {
   Mix_Chunk *sample;
   static int channel;
 
-  g_warning("sdlplayer %s\n", filename);
+  g_warning("sdlplayer %s\n", name);
 
-  sample=Mix_LoadWAV_RW(SDL_RWFromFile(filename, "rb"), 1);
+  sample=Mix_LoadWAV_RW(rw, 1);
   if(!sample) {
     return(cleanExit("Mix_LoadWAV_RW"));
     // handle error
@@ -167,11 +167,22 @@ int sdlplayer_fx(char *filename, int volume)
   // Mix_Chunk *sample;
   Mix_FreeChunk(sample);
 
-  g_warning("sdlplayer complete playing of %s\n", filename);
+  g_warning("sdlplayer complete playing of %s\n", name);
 
   return(0);
 }
 
+int sdlplayer_fx(char *filename, int volume)
+{
+  return sdlplayer_fx_rw(SDL_RWFromFile(filename, "rb"), filename, volume);
+}
+
+/* Play a sound already in memory, like in the boards data archive */
+int sdlplayer_fx_data(const void *data, int size, const char *name, int volume)
+{
+  return sdlplayer_fx_rw(SDL_RWFromConstMem(data, size), name, volume);
+}
+
 void sdlplayer_pause_music()
 {
   if(!sound_closed && Mix_PlayingMusic())
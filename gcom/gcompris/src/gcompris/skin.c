@@ -22,9 +22,28 @@
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 
-GHashTable* gc_skin_fonts   = NULL;
-GHashTable* gc_skin_colors  = NULL;
-GHashTable* gc_skin_numbers = NULL;
+/*
+ * The skin properties are interned at load time, the values are stored
+ * already parsed. The table only holds the ids of the skin, the index
+ * of a property plus one is found by its GQuark in gc_skin_slots, or by
+ * its name in gc_skin_names.
+ */
+typedef struct {
+  guint                 has_color  : 1;
+  guint                 has_font   : 1;
+  guint                 has_number : 1;
+  guint32               color;
+  guint32               number;
+  gchar                *font;
+  PangoFontDescription *font_desc;
+} SkinProperty;
+
+static GArray     *gc_skin_properties = NULL;
+static GHashTable *gc_skin_slots = NULL;
+static GHashTable *gc_skin_names = NULL;
+
+/* Parsed fallback fonts, keyed by font name */
+static GHashTable *gc_skin_default_font_descs = NULL;
 
 guint32 gc_skin_color_title;
 guint32 gc_skin_color_text_button;
@@ -164,13 +183,64 @@ gc_skin_rsvg_load(char *pixmapfile)
 }
 
 /*
- * Utility function used when freeing the memory used by
- * a hashtable containing strings.
+ * Return the property slot of the id, creating it if needed.
+ */
+static SkinProperty *
+skin_property_slot(gchar *id)
+{
+  guint slot;
+
+  slot = GPOINTER_TO_UINT(g_hash_table_lookup(gc_skin_names, id));
+  if(slot == 0)
+    {
+      g_array_set_size(gc_skin_properties, gc_skin_properties->len + 1);
+      slot = gc_skin_properties->len;
+      g_hash_table_insert(gc_skin_names, g_strdup(id),
+			  GUINT_TO_POINTER(slot));
+      g_hash_table_insert(gc_skin_slots,
+			  GUINT_TO_POINTER(g_quark_from_string(id)),
+			  GUINT_TO_POINTER(slot));
+    }
+
+  return &g_array_index(gc_skin_properties, SkinProperty, slot - 1);
+}
+
+/*
+ * Return the property of the quark id or NULL if the skin
+ * does not define it.
+ */
+static inline SkinProperty *
+skin_property_get(GQuark id)
+{
+  guint slot;
+
+  if(gc_skin_slots == NULL || id == 0)
+    return NULL;
+
+  slot = GPOINTER_TO_UINT(g_hash_table_lookup(gc_skin_slots,
+					      GUINT_TO_POINTER(id)));
+  if(slot == 0)
+    return NULL;
+
+  return &g_array_index(gc_skin_properties, SkinProperty, slot - 1);
+}
+
+/*
+ * Same as skin_property_get() for the id given by its name.
  */
-static void
-gc_skin_free_string(gpointer data)
+static inline SkinProperty *
+skin_property_lookup(gchar *id)
 {
-  g_free(data);
+  guint slot;
+
+  if(gc_skin_names == NULL || id == NULL)
+    return NULL;
+
+  slot = GPOINTER_TO_UINT(g_hash_table_lookup(gc_skin_names, id));
+  if(slot == 0)
+    return NULL;
+
+  return &g_array_index(gc_skin_properties, SkinProperty, slot - 1);
 }
 
 /*
@@ -314,6 +384,7 @@ skin_xml_load (gchar* skin)
   gchar* key;
   gchar* data;
   guint32 color;
+  SkinProperty *property;
 
   g_return_val_if_fail(skin!=NULL, FALSE);
 
@@ -370,34 +441,40 @@ skin_xml_load (gchar* skin)
 	data =(gchar *) xmlGetProp(node,  BAD_CAST "rgba");
 	if((key!=NULL)&&(data!=NULL)){
 	  if(gc_skin_str_to_color(data, &color)){
-	    g_hash_table_insert(gc_skin_colors, key, GUINT_TO_POINTER(color));
-	  } else {
-	    if(key!=NULL) g_free(key);
+	    property = skin_property_slot(key);
+	    property->color = color;
+	    property->has_color = TRUE;
 	  }
 	}
+	if(key!=NULL) g_free(key);
 	if(data!=NULL) g_free(data);
       }
       else if(g_ascii_strcasecmp((gchar *)node->name, "font")==0){
 	key = (gchar *)xmlGetProp(node,  BAD_CAST "id");
 	data = (gchar *)xmlGetProp(node,  BAD_CAST "name");
 	if((key!=NULL)&&(data!=NULL)){
-	  g_hash_table_insert(gc_skin_fonts, key, data);
+	  property = skin_property_slot(key);
+	  g_free(property->font);
+	  if(property->font_desc)
+	    pango_font_description_free(property->font_desc);
+	  property->font = data;
+	  property->font_desc = pango_font_description_from_string(data);
+	  property->has_font = TRUE;
 	} else {
-	  if(key!=NULL) g_free(key);
 	  if(data!=NULL) g_free(data);
 	}
+	if(key!=NULL) g_free(key);
       }
       else if(g_ascii_strcasecmp((gchar *)node->name, "number")==0){
 	key = (gchar *)xmlGetProp(node, BAD_CAST "id");
 	data = (gchar *)xmlGetProp(node, BAD_CAST "value");
 	if((key!=NULL)&&(data!=NULL)){
-	  int number = atoi(data);
-	  g_hash_table_insert(gc_skin_numbers, key, GUINT_TO_POINTER(number));
-	  g_free(data);
-	} else {
-	  if(key!=NULL) g_free(key);
-	  if(data!=NULL) g_free(data);
+	  property = skin_property_slot(key);
+	  property->number = atoi(data);
+	  property->has_number = TRUE;
 	}
+	if(key!=NULL) g_free(key);
+	if(data!=NULL) g_free(data);
       }
       node = node->next;
     }
@@ -420,15 +497,14 @@ gc_skin_load (gchar* skin)
 
   gc_skin_free();
 
-  gc_skin_fonts = g_hash_table_new_full(g_str_hash, g_str_equal,
-					      gc_skin_free_string,
-					      gc_skin_free_string);
-  gc_skin_colors = g_hash_table_new_full(g_str_hash, g_str_equal,
-					      gc_skin_free_string,
-					      NULL);
-  gc_skin_numbers = g_hash_table_new_full(g_str_hash, g_str_equal,
-					      gc_skin_free_string,
-					      NULL);
+  gc_skin_properties = g_array_new(FALSE, TRUE, sizeof(SkinProperty));
+  gc_skin_slots = g_hash_table_new(g_direct_hash, g_direct_equal);
+  gc_skin_names = g_hash_table_new_full(g_str_hash, g_str_equal,
+					g_free, NULL);
+  gc_skin_default_font_descs =
+    g_hash_table_new_full(g_str_hash, g_str_equal,
+			  g_free,
+			  (GDestroyNotify) pango_font_description_free);
   if (! skin_xml_load(DEFAULT_SKIN) )
     return FALSE;
   if(strcmp(skin,DEFAULT_SKIN)!=0)
@@ -445,14 +521,98 @@ gc_skin_load (gchar* skin)
 void
 gc_skin_free (void)
 {
-  if(gc_skin_fonts!=NULL)
-    g_hash_table_destroy(gc_skin_fonts);
+  guint i;
+
+  if(gc_skin_properties!=NULL) {
+    for(i=0; i<gc_skin_properties->len; i++) {
+      SkinProperty *property = &g_array_index(gc_skin_properties,
+					      SkinProperty, i);
+      g_free(property->font);
+      if(property->font_desc)
+	pango_font_description_free(property->font_desc);
+    }
+    g_array_free(gc_skin_properties, TRUE);
+    gc_skin_properties = NULL;
+  }
+
+  if(gc_skin_slots!=NULL) {
+    g_hash_table_destroy(gc_skin_slots);
+    gc_skin_slots = NULL;
+  }
 
-  if(gc_skin_colors!=NULL)
-    g_hash_table_destroy(gc_skin_colors);
+  if(gc_skin_names!=NULL) {
+    g_hash_table_destroy(gc_skin_names);
+    gc_skin_names = NULL;
+  }
 
-  if(gc_skin_numbers!= NULL)
-      g_hash_table_destroy(gc_skin_numbers);
+  if(gc_skin_default_font_descs!=NULL) {
+    g_hash_table_destroy(gc_skin_default_font_descs);
+    gc_skin_default_font_descs = NULL;
+  }
+}
+
+/*
+ * Get the skin color associated to the quark id
+ */
+guint32
+gc_skin_get_color_quark(GQuark id, guint32 def)
+{
+  SkinProperty *property = skin_property_get(id);
+
+  if(property && property->has_color)
+    return property->color;
+  return def;
+}
+
+/*
+ * Get the skin font name associated to the quark id
+ */
+gchar*
+gc_skin_get_font_quark(GQuark id, gchar* def)
+{
+  SkinProperty *property = skin_property_get(id);
+
+  if(property && property->has_font)
+    return property->font;
+  return def;
+}
+
+/*
+ * Get the parsed skin font associated to the quark id.
+ * If the skin does not define it, def is parsed once and cached.
+ * @WARNING: Do not free the returned description, it belongs
+ *           to the skin.
+ */
+PangoFontDescription*
+gc_skin_get_font_desc_quark(GQuark id, gchar* def)
+{
+  SkinProperty *property = skin_property_get(id);
+  PangoFontDescription *font_desc;
+
+  if(property && property->has_font)
+    return property->font_desc;
+
+  g_return_val_if_fail(gc_skin_default_font_descs != NULL, NULL);
+
+  font_desc = g_hash_table_lookup(gc_skin_default_font_descs, def);
+  if(font_desc == NULL) {
+    font_desc = pango_font_description_from_string(def);
+    g_hash_table_insert(gc_skin_default_font_descs, g_strdup(def), font_desc);
+  }
+  return font_desc;
+}
+
+/*
+ * Get the skin 'number' associated to the quark id
+ */
+guint32
+gc_skin_get_number_quark(GQuark id, guint32 def)
+{
+  SkinProperty *property = skin_property_get(id);
+
+  if(property && property->has_number)
+    return property->number;
+  return def;
 }
 
 /*
@@ -461,10 +621,10 @@ gc_skin_free (void)
 guint32
 gc_skin_get_color_default(gchar* id, guint32 def)
 {
-  gpointer result;
-  result = g_hash_table_lookup(gc_skin_colors, (gpointer)id);
-  if(result!=NULL)
-    return GPOINTER_TO_UINT(result);
+  SkinProperty *property = skin_property_lookup(id);
+
+  if(property && property->has_color)
+    return property->color;
   return def;
 }
 
@@ -489,10 +649,10 @@ gc_skin_get_gdkcolor_default(gchar* id, guint32 def, GdkColor *gdkcolor)
 gchar*
 gc_skin_get_font_default(gchar* id, gchar* def)
 {
-  gpointer result;
-  result = g_hash_table_lookup(gc_skin_fonts, (gpointer)id);
-  if(result!=NULL)
-    return (gchar*)result;
+  SkinProperty *property = skin_property_lookup(id);
+
+  if(property && property->has_font)
+    return property->font;
   return def;
 }
 
@@ -502,9 +662,9 @@ gc_skin_get_font_default(gchar* id, gchar* def)
 guint32
 gc_skin_get_number_default(gchar* id, guint32 def)
 {
-  gpointer result;
-  result = g_hash_table_lookup(gc_skin_numbers, (gpointer)id);
-  if(result!=NULL)
-    return GPOINTER_TO_UINT(result);
+  SkinProperty *property = skin_property_lookup(id);
+
+  if(property && property->has_number)
+    return property->number;
   return def;
 }
@@ -58,9 +58,21 @@ void		gc_skin_get_gdkcolor_default(gchar* id, guint32 def, GdkColor *gdkcolor);
 gchar*          gc_skin_get_font_default(gchar* id, gchar* def);
 guint32		gc_skin_get_number_default(gchar* id, guint32 def);
 
+/* Same as above without string hashing, the ids are interned with
+ * g_quark_from_static_string() once by the caller. */
+guint32		gc_skin_get_color_quark(GQuark id, guint32 def);
+gchar*		gc_skin_get_font_quark(GQuark id, gchar* def);
+PangoFontDescription *gc_skin_get_font_desc_quark(GQuark id, gchar* def);
+guint32		gc_skin_get_number_quark(GQuark id, guint32 def);
+
 #define gc_skin_get_gdkcolor(id, gdkcolor) gc_skin_get_gdkcolor_default(id, 0x0D0DFA00, gdkcolor)
 #define gc_skin_get_color(id)     gc_skin_get_color_default(id, 0x0D0DFA00)
 #define gc_skin_get_font(id)      gc_skin_get_font_default(id, "Sans 12")
 #define gc_skin_get_number(id)    gc_skin_get_number_default(id, 0)
 
+#define gc_skin_get_color_q(q)     gc_skin_get_color_quark(q, 0x0D0DFA00)
+#define gc_skin_get_font_q(q)      gc_skin_get_font_quark(q, "Sans 12")
+#define gc_skin_get_font_desc_q(q) gc_skin_get_font_desc_quark(q, "Sans 12")
+#define gc_skin_get_number_q(q)    gc_skin_get_number_quark(q, 0)
+
 #endif
@@ -286,15 +286,37 @@ thread_play_ogg (gchar *file)
 
   g_warning("  Thread_play_ogg %s", file);
 
+  /* The loose files override the boards data archive */
   absolute_file = gc_file_find_absolute(file);
 
-  if (!absolute_file)
+  if (absolute_file)
+    {
+      g_warning("   Calling gcompris internal sdlplayer_file (%s)", absolute_file);
+      g_mutex_lock(lock_fx);
+      sdlplayer_fx(absolute_file, 128);
+      g_mutex_unlock(lock_fx);
+    }
+  else if ((absolute_file = gc_pack_find("%s", file)))
+    {
+      gconstpointer data;
+      gpointer to_free;
+      gsize length;
+
+      data = gc_pack_get(absolute_file, &length, &to_free);
+      if (!data)
+	{
+	  g_free(absolute_file);
+	  return NULL;
+	}
+
+      g_mutex_lock(lock_fx);
+      sdlplayer_fx_data(data, length, absolute_file, 128);
+      g_mutex_unlock(lock_fx);
+      g_free(to_free);
+    }
+  else
     return NULL;
 
-  g_warning("   Calling gcompris internal sdlplayer_file (%s)", absolute_file);
-  g_mutex_lock(lock_fx);
-  sdlplayer_fx(absolute_file, 128);
-  g_mutex_unlock(lock_fx);
   g_signal_emit (gc_sound_controller,
 		 GCOMPRIS_SOUND_GET_CLASS (gc_sound_controller)->sound_played_signal_id,
 		 0 /* details */,
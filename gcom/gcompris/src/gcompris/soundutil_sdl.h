@@ -47,6 +47,7 @@ void	 sdlplayer_resume_music();
 void	 sdlplayer_halt_fx();
 void	 sdlplayer_resume_fx();
 int	 sdlplayer_fx(char *filename, int volume);
+int	 sdlplayer_fx_data(const void *data, int size, const char *name, int volume);
 
 gchar *gc_sound_alphabet(gchar *chars);
 
@@ -19,11 +19,266 @@
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
 
 #include "gcompris.h"
 
 void gc_wordlist_dump(GcomprisWordlist *wl);
 
+/* A parsed wordlist is compiled in the cache directory so that the
+ * next loads only map it. The file is laid out as:
+ *
+ *   WordlistCacheHeader
+ *   WordlistCacheLevel levels[n_levels]
+ *   guint32 offsets[n_words]	the words of all the levels, in pool
+ *   gchar pool[pool_size]	nul terminated strings
+ *
+ * It is in the host byte order and is rebuilt whenever the xml file
+ * changes.
+ */
+#define WORDLIST_CACHE_MAGIC	"GCWL"
+#define WORDLIST_CACHE_VERSION	1
+#define WORDLIST_CACHE_NONE	G_MAXUINT32
+
+typedef struct {
+  gchar   magic[4];
+  guint32 version;
+  /* The xml file it was compiled from */
+  gint64  mtime;
+  gint64  size;
+  guint32 n_levels;
+  guint32 n_words;
+  guint32 pool_size;
+  /* Offsets in pool, WORDLIST_CACHE_NONE if not set */
+  guint32 name;
+  guint32 description;
+  guint32 locale;
+} WordlistCacheHeader;
+
+typedef struct {
+  gint32  level;
+  guint32 first;
+  guint32 n_words;
+} WordlistCacheLevel;
+
+static gchar *
+_wordlist_cache_filename(const gchar *xmlfilename)
+{
+  GcomprisProperties *properties = gc_prop_get();
+  gchar *md5, *basename, *filename, *cache_dir;
+
+  /* The cache dir is only set with a server, the compiled wordlists are
+     also worth keeping without one */
+  if(properties && properties->cache_dir)
+    cache_dir = g_strdup(properties->cache_dir);
+  else
+    cache_dir = g_build_filename(g_get_user_cache_dir(), "gcompris", NULL);
+
+  md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, xmlfilename, -1);
+  basename = g_strconcat(md5, ".wordlist", NULL);
+  filename = g_build_filename(cache_dir, "wordlist", basename, NULL);
+  g_free(cache_dir);
+  g_free(basename);
+  g_free(md5);
+
+  return filename;
+}
+
+static gchar *
+_wordlist_cache_string(const WordlistCacheHeader *header, const gchar *pool,
+		       guint32 offset)
+{
+  if(offset == WORDLIST_CACHE_NONE || offset >= header->pool_size)
+    return NULL;
+
+  return g_strdup(pool + offset);
+}
+
+/* Map the compiled cache of xmlfilename.
+ *
+ * \return a new GcomprisWordlist whose words point in the mapped file,
+ *         or NULL if there is no cache or it is out of date.
+ */
+static GcomprisWordlist *
+_wordlist_cache_load(const gchar *filename, const gchar *xmlfilename)
+{
+  GcomprisWordlist *wordlist;
+  GMappedFile *mapped;
+  const WordlistCacheHeader *header;
+  const WordlistCacheLevel *levels;
+  const guint32 *offsets;
+  const gchar *contents, *pool;
+  gchar *cachefilename;
+  struct stat st;
+  gsize length;
+  guint i;
+
+  if(g_stat(xmlfilename, &st) != 0)
+    return NULL;
+
+  cachefilename = _wordlist_cache_filename(xmlfilename);
+  if(!cachefilename)
+    return NULL;
+
+  mapped = g_mapped_file_new(cachefilename, FALSE, NULL);
+  g_free(cachefilename);
+  if(!mapped)
+    return NULL;
+
+  contents = g_mapped_file_get_contents(mapped);
+  length = g_mapped_file_get_length(mapped);
+  header = (const WordlistCacheHeader *) contents;
+
+  if(length < sizeof(WordlistCacheHeader)
+     || memcmp(header->magic, WORDLIST_CACHE_MAGIC, 4) != 0
+     || header->version != WORDLIST_CACHE_VERSION
+     || header->mtime != (gint64) st.st_mtime
+     || header->size != (gint64) st.st_size
+     || header->n_levels > length / sizeof(WordlistCacheLevel)
+     || header->n_words > length / sizeof(guint32)
+     || length != sizeof(WordlistCacheHeader)
+		  + header->n_levels * sizeof(WordlistCacheLevel)
+		  + header->n_words * sizeof(guint32)
+		  + header->pool_size
+     || header->pool_size == 0)
+    goto invalid;
+
+  levels = (const WordlistCacheLevel *) (header + 1);
+  offsets = (const guint32 *) (levels + header->n_levels);
+  pool = (const gchar *) (offsets + header->n_words);
+
+  /* Do not trust a truncated or corrupted file */
+  if(pool[header->pool_size - 1] != '\0')
+    goto invalid;
+  for(i = 0; i < header->n_words; i++)
+    if(offsets[i] >= header->pool_size)
+      goto invalid;
+  for(i = 0; i < header->n_levels; i++)
+    if(levels[i].first > header->n_words
+       || levels[i].n_words > header->n_words - levels[i].first)
+      goto invalid;
+
+  wordlist = g_malloc0(sizeof(GcomprisWordlist));
+  wordlist->filename = g_strdup(filename);
+  wordlist->name = _wordlist_cache_string(header, pool, header->name);
+  wordlist->description = _wordlist_cache_string(header, pool, header->description);
+  wordlist->locale = _wordlist_cache_string(header, pool, header->locale);
+  wordlist->mapped = mapped;
+
+  for(i = 0; i < header->n_levels; i++)
+    {
+      LevelWordlist *lw = g_malloc0(sizeof(LevelWordlist));
+
+      lw->level = levels[i].level;
+      lw->n_words = levels[i].n_words;
+      lw->offsets = offsets + levels[i].first;
+      lw->pool = pool;
+
+      wordlist->number_of_level++;
+      wordlist->levels_words = g_slist_append(wordlist->levels_words, lw);
+    }
+
+  return wordlist;
+
+ invalid:
+  g_mapped_file_unref(mapped);
+  return NULL;
+}
+
+static guint32
+_wordlist_cache_pool_add(GString *pool, const gchar *string)
+{
+  guint32 offset = pool->len;
+
+  if(!string)
+    return WORDLIST_CACHE_NONE;
+
+  g_string_append_len(pool, string, strlen(string) + 1);
+  return offset;
+}
+
+/* Compile wordlist in the cache, for the next loads of xmlfilename */
+static void
+_wordlist_cache_save(GcomprisWordlist *wordlist, const gchar *xmlfilename)
+{
+  WordlistCacheHeader header;
+  GArray *levels, *offsets;
+  GString *pool, *contents;
+  GSList *list;
+  gchar *cachefilename, *dirname;
+  struct stat st;
+  guint i;
+
+  if(g_stat(xmlfilename, &st) != 0)
+    return;
+
+  cachefilename = _wordlist_cache_filename(xmlfilename);
+  if(!cachefilename)
+    return;
+
+  levels = g_array_new(FALSE, FALSE, sizeof(WordlistCacheLevel));
+  offsets = g_array_new(FALSE, FALSE, sizeof(guint32));
+  /* Start with an empty string so that the pool is never empty */
+  pool = g_string_new_len("", 1);
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, WORDLIST_CACHE_MAGIC, 4);
+  header.version = WORDLIST_CACHE_VERSION;
+  header.mtime = st.st_mtime;
+  header.size = st.st_size;
+  header.name = _wordlist_cache_pool_add(pool, wordlist->name);
+  header.description = _wordlist_cache_pool_add(pool, wordlist->description);
+  header.locale = _wordlist_cache_pool_add(pool, wordlist->locale);
+
+  for(list = wordlist->levels_words; list; list = list->next)
+    {
+      LevelWordlist *lw = list->data;
+      WordlistCacheLevel level;
+
+      level.level = lw->level;
+      level.first = offsets->len;
+      level.n_words = lw->n_words;
+      g_array_append_val(levels, level);
+
+      for(i = 0; i < lw->n_words; i++)
+	{
+	  guint32 offset = _wordlist_cache_pool_add(pool,
+						    gc_wordlist_get_word(lw, i));
+	  g_array_append_val(offsets, offset);
+	}
+    }
+
+  header.n_levels = levels->len;
+  header.n_words = offsets->len;
+  header.pool_size = pool->len;
+
+  contents = g_string_sized_new(sizeof(header)
+				+ levels->len * sizeof(WordlistCacheLevel)
+				+ offsets->len * sizeof(guint32)
+				+ pool->len);
+  g_string_append_len(contents, (gchar *) &header, sizeof(header));
+  g_string_append_len(contents, levels->data,
+		      levels->len * sizeof(WordlistCacheLevel));
+  g_string_append_len(contents, offsets->data,
+		      offsets->len * sizeof(guint32));
+  g_string_append_len(contents, pool->str, pool->len);
+
+  dirname = g_path_get_dirname(cachefilename);
+  g_mkdir_with_parents(dirname, 0755);
+  g_free(dirname);
+
+  if(!g_file_set_contents(cachefilename, contents->str, contents->len, NULL))
+    g_warning("Fail to write the wordlist cache %s", cachefilename);
+
+  g_string_free(contents, TRUE);
+  g_string_free(pool, TRUE);
+  g_array_free(offsets, TRUE);
+  g_array_free(levels, TRUE);
+  g_free(cachefilename);
+}
+
 /** Load a wordlist formatted xml file. It contains a list of words.
  *
  * The xml file format must be like this:
@@ -47,6 +302,9 @@ void gc_wordlist_dump(GcomprisWordlist *wl);
  * </GCompris>
  *
  *
+ * It is compiled in the cache directory the first time, later loads only
+ * map the compiled file until the xml file is changed.
+ *
  * \param format: the xml file to load (ex: wordsgame/default-fr.xml)
  *                If format contains $LOCALE, it will be first replaced by the current long locale
  *                and if not found the short locale name. It support printf formating.
@@ -59,6 +317,7 @@ GcomprisWordlist
 {
   va_list args;
   gchar* xmlfilename;
+  gchar* packname = NULL;
   gchar* filename;
   xmlDocPtr xmldoc;
   xmlNodePtr wlNode;
@@ -76,27 +335,54 @@ GcomprisWordlist
   filename = g_strdup_vprintf (format, args);
   va_end (args);
 
+  /* The loose files override the boards data archive */
   xmlfilename = gc_file_find_absolute(filename);
+  if(!xmlfilename)
+    packname = gc_pack_find("%s", filename);
 
   /* if the file doesn't exist */
-  if(!xmlfilename)
+  if(!xmlfilename && !packname)
     {
       g_warning("Couldn't find file %s !", filename);
       g_free(filename);
       return NULL;
     }
 
-  g_warning("Wordlist found %s\n", xmlfilename);
+  if(xmlfilename)
+    {
+      g_warning("Wordlist found %s\n", xmlfilename);
+
+      wordlist = _wordlist_cache_load(filename, xmlfilename);
+      if(wordlist)
+	{
+	  g_free(filename);
+	  g_free(xmlfilename);
+	  return wordlist;
+	}
+
+      xmldoc = xmlParseFile(xmlfilename);
+    }
+  else
+    {
+      gconstpointer data;
+      gpointer to_free;
+      gsize length;
+
+      /* Already mapped, not worth a compiled copy in the cache */
+      g_warning("Wordlist found %s in the boards data archive\n", packname);
 
-  xmldoc = xmlParseFile(xmlfilename);
+      data = gc_pack_get(packname, &length, &to_free);
+      xmldoc = data ? xmlParseMemory(data, length) : NULL;
+      g_free(to_free);
+      g_free(packname);
+    }
 
   if(!xmldoc){
-    g_warning("Couldn't parse file %s !", xmlfilename);
+    g_warning("Couldn't parse file %s !", filename);
     g_free(filename);
     g_free(xmlfilename);
     return NULL;
   }
-  g_free(xmlfilename);
 
   if(/* if there is no root element */
      !xmldoc->children ||
@@ -107,6 +393,7 @@ GcomprisWordlist
     g_warning("No Gcompris node");
     xmlFreeDoc(xmldoc);
     g_free(filename);
+    g_free(xmlfilename);
     return NULL;
   }
 
@@ -120,6 +407,7 @@ GcomprisWordlist
     g_warning("No wordlist node %s", (wlNode == NULL) ? (gchar *)wlNode->name : "NULL node");
     xmlFreeDoc(xmldoc);
     g_free(filename);
+    g_free(xmlfilename);
     return NULL;
   }
 
@@ -189,12 +477,18 @@ GcomprisWordlist
     node = node->next;
   }
   xmlFreeDoc(xmldoc);
+
+  if(xmlfilename)
+    _wordlist_cache_save(wordlist, xmlfilename);
+  g_free(xmlfilename);
+
   return wordlist;
 }
 
 void gc_wordlist_dump(GcomprisWordlist *wl)
 {
-	GSList *level, *words;
+	GSList *level;
+	guint i;
 
 	printf("Wordlist dump\n");
 	printf("filename:%s\n",wl->filename);
@@ -204,9 +498,9 @@ void gc_wordlist_dump(GcomprisWordlist *wl)
 	{
 		printf("Level %d\n", ((LevelWordlist*)level->data)->level);
 		printf("Words :");
-		for(words=((LevelWordlist*)level->data)->words; words; words=words->next)
+		for(i = 0; i < ((LevelWordlist*)level->data)->n_words; i++)
 		{
-			printf(" %s", (char*)words->data);
+			printf(" %s", gc_wordlist_get_word(level->data, i));
 		}
 		puts("");
 	}
@@ -231,7 +525,25 @@ LevelWordlist*gc_wordlist_get_levelwordlist(GcomprisWordlist *wordlist, guint le
 	return NULL;
 }
 
+/** get a word of a level
+ *
+ * \param lw: the level
+ * \param index: the word index, lower than lw->n_words
+ *
+ * \return the word, owned by the wordlist
+ */
+const gchar *
+gc_wordlist_get_word(LevelWordlist *lw, guint index)
+{
+	g_return_val_if_fail(lw != NULL && index < lw->n_words, NULL);
+
+	return lw->pool + lw->offsets[index];
+}
+
 /** get a random word from the wordlist in the given level
+ *
+ * The words are drawn from a shuffle bag, none is given twice
+ * before all the words of the level have been given.
  *
  * \param wordlist: the wordlist
  * \param level: the level
@@ -242,35 +554,45 @@ gchar *
 gc_wordlist_random_word_get(GcomprisWordlist *wordlist, guint level)
 {
 	LevelWordlist *lw;
-	gchar *word;
+	const gchar *word;
+	guint i, index;
 
 	if(level>wordlist->number_of_level)
 		level = wordlist->number_of_level;
 
 	lw = gc_wordlist_get_levelwordlist(wordlist, level);
-	if(!lw)
+	if(!lw || lw->n_words == 0)
 		return NULL;
 
 	g_warning("Level : %d", lw->level);
 
-	/* We got the proper level, find a random word */
-	word = (gchar *)g_slist_nth_data(lw->words,
-			RAND(0, g_slist_length(lw->words))
-			);
+	/* We got the proper level, refill the bag once it is empty */
+	if(!lw->bag)
+		lw->bag = g_new(guint, lw->n_words);
+	if(lw->bag_left == 0)
+	{
+		for(i = 0; i < lw->n_words; i++)
+			lw->bag[i] = i;
+		lw->bag_left = lw->n_words;
+	}
+
+	/* and take a random word out of it */
+	i = RAND(0, lw->bag_left);
+	index = lw->bag[i];
+	lw->bag[i] = lw->bag[--lw->bag_left];
+
+	word = gc_wordlist_get_word(lw, index);
 	g_warning("returning random word '%s'", word);
 	return(g_strdup(word));
 }
 
 static void gc_wordlist_free_level(LevelWordlist *lw)
 {
-	GSList *words;
-
 	if(!lw)
 		return;
 
-	for (words = lw->words; words !=NULL; words = words->next)
-		g_free(words->data);
-	g_slist_free(lw->words);
+	g_free(lw->bag);
+	g_free(lw->data);
 	g_free(lw);
 }
 
@@ -297,16 +619,21 @@ gc_wordlist_free(GcomprisWordlist *wordlist)
     gc_wordlist_free_level(lw);
   }
   g_slist_free ( wordlist->levels_words);
+  if (wordlist->mapped)
+    g_mapped_file_unref (wordlist->mapped);
   g_free (wordlist);
 }
 
 void gc_wordlist_set_wordlist(GcomprisWordlist *wordlist, guint level, const gchar*text)
 {
 	LevelWordlist *lw;
-	GSList *words=NULL;
+	GHashTable *seen;
 	gchar **wordsArray;
+	guint32 *offsets;
+	gchar *pool;
+	guint n_words, pool_size;
 	int i;
-	
+
 	g_warning("wordlist : add level=%d text=%s\n", level, text);
 	/* remove level */
 	if((lw = gc_wordlist_get_levelwordlist(wordlist, level)))
@@ -320,22 +647,49 @@ void gc_wordlist_set_wordlist(GcomprisWordlist *wordlist, guint level, const gch
 	/* add new level */
 	wordsArray = g_strsplit_set (text, " \n\t", 0);
 
-	i=0;
+	/* keep the first of the duplicated words */
+	seen = g_hash_table_new(g_str_hash, g_str_equal);
+	n_words = 0;
+	pool_size = 0;
 	for(i=0;wordsArray[i] != NULL; i++)
 		if (wordsArray[i][0]!='\0' &&
-			!g_slist_find_custom(words, wordsArray[i], (GCompareFunc)strcmp))
-				words = g_slist_append( words, g_strdup(wordsArray[i]));
-
-	g_strfreev ( wordsArray);
+			!g_hash_table_lookup(seen, wordsArray[i]))
+		{
+			g_hash_table_insert(seen, wordsArray[i], wordsArray[i]);
+			wordsArray[n_words++] = wordsArray[i];
+			pool_size += strlen(wordsArray[i]) + 1;
+		}
+		else
+			g_free(wordsArray[i]);
+	wordsArray[n_words] = NULL;
+	g_hash_table_destroy(seen);
 
-	if(words==NULL)
+	if(n_words==0)
+	{
+		g_strfreev ( wordsArray);
 		return;
+	}
 
-	/* initialise LevelWordlist struct */
+	/* initialise LevelWordlist struct, the offsets and the pool of
+	   words share one block */
 	LevelWordlist *level_words = g_malloc0(sizeof(LevelWordlist));
 
-	level_words->words = words;
+	level_words->data = g_malloc(n_words * sizeof(guint32) + pool_size);
+	offsets = level_words->data;
+	pool = (gchar *)(offsets + n_words);
+	pool_size = 0;
+	for(i=0; i < n_words; i++)
+	{
+		offsets[i] = pool_size;
+		strcpy(pool + pool_size, wordsArray[i]);
+		pool_size += strlen(wordsArray[i]) + 1;
+	}
+	g_strfreev ( wordsArray);
+
 	level_words->level = level;
+	level_words->n_words = n_words;
+	level_words->offsets = offsets;
+	level_words->pool = pool;
 
 	wordlist->number_of_level++;
 	wordlist->levels_words = g_slist_append( wordlist->levels_words, level_words);
@@ -343,8 +697,9 @@ void gc_wordlist_set_wordlist(GcomprisWordlist *wordlist, guint level, const gch
 
 void gc_wordlist_save(GcomprisWordlist *wordlist)
 {
-	GSList *listlevel,*listword;
+	GSList *listlevel;
 	LevelWordlist *level;
+	guint i;
 	gchar *filename, *tmp;
 	xmlNodePtr wlnode, levelnode, node;
 	xmlDocPtr doc;
@@ -374,9 +729,9 @@ void gc_wordlist_save(GcomprisWordlist *wordlist)
 			xmlSetProp(levelnode, BAD_CAST "value", BAD_CAST tmp);
 			g_free(tmp);
 		}
-		for(listword = level->words; listword; listword=listword->next)
+		for(i = 0; i < level->n_words; i++)
 		{
-			xmlNodeAddContent(levelnode, BAD_CAST listword->data);
+			xmlNodeAddContent(levelnode, BAD_CAST gc_wordlist_get_word(level, i));
 			xmlNodeAddContent(levelnode, BAD_CAST " ");
 		}
 	}
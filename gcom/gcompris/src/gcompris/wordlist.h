@@ -21,7 +21,15 @@
 
 typedef struct {
   gint level;
-  GSList *words;
+  guint n_words;
+  /* The word i is pool + offsets[i] */
+  const guint32 *offsets;
+  const gchar *pool;
+  /* The indexes of the words not given yet by gc_wordlist_random_word_get */
+  guint *bag;
+  guint bag_left;
+  /* offsets and pool when they are not mapped from the cache */
+  gpointer data;
 } LevelWordlist;
 
 typedef struct {
@@ -32,10 +40,13 @@ typedef struct {
   guint		 number_of_level;
   /* LevelWordlist list */
   GSList         *levels_words;
+  /* The compiled cache the levels are read from, if any */
+  GMappedFile    *mapped;
 } GcomprisWordlist;
 
 GcomprisWordlist *gc_wordlist_get_from_file(const gchar *fileformat, ...);
 LevelWordlist	 *gc_wordlist_get_levelwordlist(GcomprisWordlist *wordlist, guint level);
+const gchar	 *gc_wordlist_get_word(LevelWordlist *lw, guint index);
 void              gc_wordlist_free(GcomprisWordlist *wordlist);
 gchar		 *gc_wordlist_random_word_get(GcomprisWordlist *wordlist, guint level);
 void		  gc_wordlist_set_wordlist(GcomprisWordlist *wordlist, guint level, const gchar*words);
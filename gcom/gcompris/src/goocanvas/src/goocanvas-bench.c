@@ -0,0 +1,648 @@
+/*
+ * GooCanvas. Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvas-bench.c - times the canvas on recorded scenes.
+ *
+ * The canvas is a GTK widget, so a display is needed, as the X server of
+ * xvfb-run on a machine without one:
+ *
+ *   xvfb-run ./goocanvas-bench --scene=groups
+ *
+ * Each scene is built on an unrealized canvas, then for each iteration:
+ *
+ *   update	the line width of every item is changed and the canvas updated.
+ *   paint	the whole canvas is rendered in an image surface.
+ *   pick	goo_canvas_get_items_at() is called at random points.
+ *
+ * The convert scene times instead the conversion of a canvas sized pixbuf,
+ * with or without alpha, to the cairo surface painted by the image items.
+ * Its items column is the number of pixels. It is the only scene that runs
+ * without a display.
+ *
+ * The deferred check sends an expose to a realized canvas and checks that a
+ * hidden group keeps the update of its children deferred, until its bounds
+ * are read. It only prints something, and fails the run, if it is not.
+ *
+ * The results are printed as tab separated values, one line per scene and
+ * phase, so that they can be compared from one build to the next:
+ *
+ *   scene  phase  items  iterations  mean_us  min_us
+ */
+#include <config.h>
+#include <stdio.h>
+#include <string.h>
+#include <gtk/gtk.h>
+#include "goocanvas.h"
+#include "goocanvasprivate.h"
+
+/* librsvg only has this since 2.24. */
+#ifndef LIBRSVG_CHECK_VERSION
+#define LIBRSVG_CHECK_VERSION(major,minor,micro) 0
+#endif
+
+#define BENCH_N_PICKS	100
+
+/* All the SVG items share this handle. */
+static const gchar svg_data[] =
+  "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"48\" height=\"48\">"
+  "<circle cx=\"24\" cy=\"24\" r=\"20\" fill=\"#f0c000\" stroke=\"#806000\""
+  " stroke-width=\"3\"/>"
+  "<path d=\"M 14 28 Q 24 38 34 28\" fill=\"none\" stroke=\"#000\""
+  " stroke-width=\"3\"/>"
+  "<circle cx=\"17\" cy=\"18\" r=\"3\"/><circle cx=\"31\" cy=\"18\" r=\"3\"/>"
+  "</svg>";
+
+static const gchar *path_data[] = {
+  "M 0 0 L 40 0 L 40 40 L 0 40 Z",
+  "M 0 20 C 0 0 40 0 40 20 S 0 40 0 20",
+  "M 20 0 A 20 20 0 1 1 19.9 0 Z",
+  "M 0 0 Q 20 40 40 0 T 80 0 H 60 V 30 h -40 v -30 z",
+};
+
+static gint     bench_width      = 1024;
+static gint     bench_height     = 768;
+static gint     bench_iterations = 50;
+static gint     bench_items      = 2000;
+static gchar   *bench_scene      = NULL;
+static RsvgHandle *svg_handle    = NULL;
+
+static GOptionEntry options[] = {
+  {"iterations", 'i', 0, G_OPTION_ARG_INT, &bench_iterations,
+   "Number of timed iterations of each phase", "N"},
+  {"items", 'n', 0, G_OPTION_ARG_INT, &bench_items,
+   "Number of items in the rect scene, the others are scaled from it", "N"},
+  {"width", 'W', 0, G_OPTION_ARG_INT, &bench_width,
+   "Width of the canvas", "PIXELS"},
+  {"height", 'H', 0, G_OPTION_ARG_INT, &bench_height,
+   "Height of the canvas", "PIXELS"},
+  {"scene", 's', 0, G_OPTION_ARG_STRING, &bench_scene,
+   "Only run this scene", "NAME"},
+  { NULL }
+};
+
+
+static guint
+random_color (GRand *rand)
+{
+  return (g_rand_int (rand) & 0xffffff00) | 0xff;
+}
+
+
+static void
+random_position (GRand   *rand,
+		 gdouble *x,
+		 gdouble *y)
+{
+  *x = g_rand_double_range (rand, 0.0, bench_width - 48.0);
+  *y = g_rand_double_range (rand, 0.0, bench_height - 48.0);
+}
+
+
+static void
+build_rects (GooCanvasItem *parent,
+	     GRand         *rand,
+	     GPtrArray     *items)
+{
+  gdouble x, y;
+  gint i;
+
+  for (i = 0; i < bench_items; i++)
+    {
+      random_position (rand, &x, &y);
+      g_ptr_array_add (items,
+		       goo_canvas_rect_new (parent, x, y,
+					    g_rand_double_range (rand, 4.0, 48.0),
+					    g_rand_double_range (rand, 4.0, 48.0),
+					    "fill-color-rgba", random_color (rand),
+					    "stroke-color", "black",
+					    NULL));
+    }
+}
+
+
+static void
+build_paths (GooCanvasItem *parent,
+	     GRand         *rand,
+	     GPtrArray     *items)
+{
+  GooCanvasItem *item;
+  gdouble x, y;
+  gint i;
+
+  for (i = 0; i < bench_items / 2; i++)
+    {
+      random_position (rand, &x, &y);
+      item = goo_canvas_path_new (parent,
+				  path_data[i % G_N_ELEMENTS (path_data)],
+				  "fill-color-rgba", random_color (rand),
+				  "stroke-color", "black",
+				  NULL);
+      goo_canvas_item_translate (item, x, y);
+      g_ptr_array_add (items, item);
+    }
+}
+
+
+static void
+build_texts (GooCanvasItem *parent,
+	     GRand         *rand,
+	     GPtrArray     *items)
+{
+  gchar *text;
+  gdouble x, y;
+  gint i;
+
+  for (i = 0; i < bench_items / 4; i++)
+    {
+      random_position (rand, &x, &y);
+      text = g_strdup_printf ("Item %d", i);
+      g_ptr_array_add (items,
+		       goo_canvas_text_new (parent, text, x, y,
+					    i % 2 ? 120.0 : -1.0,
+					    GTK_ANCHOR_NORTH_WEST,
+					    "font", "Sans 12",
+					    "fill-color-rgba", random_color (rand),
+					    NULL));
+      g_free (text);
+    }
+}
+
+
+static void
+build_svgs (GooCanvasItem *parent,
+	    GRand         *rand,
+	    GPtrArray     *items)
+{
+  GooCanvasItem *item;
+  gdouble x, y;
+  gint i;
+
+  for (i = 0; i < bench_items / 8; i++)
+    {
+      random_position (rand, &x, &y);
+      item = goo_canvas_svg_new (parent, svg_handle, NULL);
+      goo_canvas_item_translate (item, x, y);
+      g_ptr_array_add (items, item);
+    }
+}
+
+
+static void
+build_group_tree (GooCanvasItem *parent,
+		  GRand         *rand,
+		  GPtrArray     *items,
+		  gint           depth)
+{
+  GooCanvasItem *group;
+  gint i;
+
+  if (depth == 0)
+    {
+      g_ptr_array_add (items,
+		       goo_canvas_rect_new (parent, 0.0, 0.0, 12.0, 12.0,
+					    "fill-color-rgba", random_color (rand),
+					    NULL));
+      return;
+    }
+
+  for (i = 0; i < 4; i++)
+    {
+      group = goo_canvas_group_new (parent, NULL);
+      goo_canvas_item_translate (group,
+				 g_rand_double_range (rand, 0.0, 64.0 * depth),
+				 g_rand_double_range (rand, 0.0, 48.0 * depth));
+      build_group_tree (group, rand, items, depth - 1);
+    }
+}
+
+
+static void
+build_groups (GooCanvasItem *parent,
+	      GRand         *rand,
+	      GPtrArray     *items)
+{
+  /* 4^5 leaves, 1365 groups above them. */
+  build_group_tree (parent, rand, items, 5);
+}
+
+
+static void
+build_table (GooCanvasItem *parent,
+	     GRand         *rand,
+	     GPtrArray     *items)
+{
+  GooCanvasItem *table, *item;
+  gchar *text;
+  gint row, column;
+
+  table = goo_canvas_table_new (parent,
+				"row-spacing", 2.0,
+				"column-spacing", 2.0,
+				NULL);
+
+  for (row = 0; row < 24; row++)
+    for (column = 0; column < 16; column++)
+      {
+	if ((row + column) % 2)
+	  {
+	    text = g_strdup_printf ("%d,%d", row, column);
+	    item = goo_canvas_text_new (table, text, 0.0, 0.0, -1.0,
+					GTK_ANCHOR_NORTH_WEST,
+					"font", "Sans 10",
+					NULL);
+	    g_free (text);
+	  }
+	else
+	  {
+	    item = goo_canvas_rect_new (table, 0.0, 0.0,
+					g_rand_double_range (rand, 10.0, 40.0),
+					g_rand_double_range (rand, 10.0, 24.0),
+					"fill-color-rgba", random_color (rand),
+					NULL);
+	  }
+
+	goo_canvas_item_set_child_properties (table, item,
+					      "row", row,
+					      "column", column,
+					      "x-fill", TRUE,
+					      NULL);
+	g_ptr_array_add (items, item);
+      }
+}
+
+
+static void
+build_all (GooCanvasItem *parent,
+	   GRand         *rand,
+	   GPtrArray     *items)
+{
+  build_rects (parent, rand, items);
+  build_paths (parent, rand, items);
+  build_texts (parent, rand, items);
+  build_svgs (parent, rand, items);
+  build_groups (parent, rand, items);
+  build_table (parent, rand, items);
+}
+
+
+typedef struct _BenchScene BenchScene;
+struct _BenchScene
+{
+  const gchar *name;
+  void (*build) (GooCanvasItem *parent,
+		 GRand         *rand,
+		 GPtrArray     *items);
+};
+
+static const BenchScene scenes[] = {
+  { "rects",  build_rects },
+  { "paths",  build_paths },
+  { "texts",  build_texts },
+  { "svgs",   build_svgs },
+  { "groups", build_groups },
+  { "table",  build_table },
+  { "all",    build_all },
+};
+
+
+typedef struct _BenchPhase BenchPhase;
+struct _BenchPhase
+{
+  const gchar *name;
+  void (*run) (GooCanvas *canvas,
+	       GPtrArray *items,
+	       GRand     *rand,
+	       gint       iteration);
+};
+
+
+static void
+run_update (GooCanvas *canvas,
+	    GPtrArray *items,
+	    GRand     *rand,
+	    gint       iteration)
+{
+  gdouble line_width = iteration % 2 ? 2.0 : 1.0;
+  guint i;
+
+  for (i = 0; i < items->len; i++)
+    g_object_set (items->pdata[i], "line-width", line_width, NULL);
+
+  goo_canvas_update (canvas);
+}
+
+
+static void
+run_paint (GooCanvas *canvas,
+	   GPtrArray *items,
+	   GRand     *rand,
+	   gint       iteration)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+					bench_width, bench_height);
+  cr = cairo_create (surface);
+  cairo_set_antialias (cr, CAIRO_ANTIALIAS_GRAY);
+
+  goo_canvas_render (canvas, cr, NULL, 1.0);
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (surface);
+}
+
+
+static void
+run_pick (GooCanvas *canvas,
+	  GPtrArray *items,
+	  GRand     *rand,
+	  gint       iteration)
+{
+  GList *found;
+  gint i;
+
+  for (i = 0; i < BENCH_N_PICKS; i++)
+    {
+      found = goo_canvas_get_items_at (canvas,
+				       g_rand_double_range (rand, 0.0, bench_width),
+				       g_rand_double_range (rand, 0.0, bench_height),
+				       TRUE);
+      g_list_free (found);
+    }
+}
+
+
+static const BenchPhase phases[] = {
+  { "update", run_update },
+  { "paint",  run_paint },
+  { "pick",   run_pick },
+};
+
+
+static void
+bench_run_scene (const BenchScene *scene)
+{
+  GtkWidget *canvas;
+  GooCanvasItem *root;
+  GPtrArray *items;
+  GRand *rand;
+  GTimer *timer;
+  gdouble elapsed, total, min;
+  guint phase;
+  gint i;
+
+  canvas = goo_canvas_new ();
+  g_object_ref_sink (canvas);
+  goo_canvas_set_bounds (GOO_CANVAS (canvas), 0, 0, bench_width, bench_height);
+  root = goo_canvas_get_root_item (GOO_CANVAS (canvas));
+
+  /* The same seed gives the same scene on every run. */
+  rand = g_rand_new_with_seed (1);
+  items = g_ptr_array_new ();
+  scene->build (root, rand, items);
+  goo_canvas_update (GOO_CANVAS (canvas));
+
+  timer = g_timer_new ();
+  for (phase = 0; phase < G_N_ELEMENTS (phases); phase++)
+    {
+      /* The first iteration fills the caches, it is not timed. */
+      phases[phase].run (GOO_CANVAS (canvas), items, rand, 0);
+
+      total = 0.0;
+      min = G_MAXDOUBLE;
+      for (i = 1; i <= bench_iterations; i++)
+	{
+	  g_timer_start (timer);
+	  phases[phase].run (GOO_CANVAS (canvas), items, rand, i);
+	  elapsed = g_timer_elapsed (timer, NULL);
+
+	  total += elapsed;
+	  min = MIN (min, elapsed);
+	}
+
+      printf ("%s\t%s\t%u\t%d\t%.1f\t%.1f\n", scene->name, phases[phase].name,
+	      items->len, bench_iterations,
+	      total * 1e6 / bench_iterations, min * 1e6);
+      fflush (stdout);
+    }
+  g_timer_destroy (timer);
+
+  g_ptr_array_free (items, TRUE);
+  g_rand_free (rand);
+  gtk_widget_destroy (canvas);
+  g_object_unref (canvas);
+}
+
+
+static void
+bench_run_convert (void)
+{
+  static const gchar *names[] = { "rgb", "rgba" };
+  GdkPixbuf *pixbuf;
+  cairo_surface_t *surface;
+  GRand *rand;
+  GTimer *timer;
+  guchar *pixels;
+  gdouble elapsed, total, min;
+  gint rowstride, has_alpha, x, y, i;
+
+  rand = g_rand_new_with_seed (1);
+  timer = g_timer_new ();
+
+  for (has_alpha = 0; has_alpha < 2; has_alpha++)
+    {
+      pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8,
+			       bench_width, bench_height);
+      pixels = gdk_pixbuf_get_pixels (pixbuf);
+      rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+      for (y = 0; y < bench_height; y++)
+	for (x = 0; x < bench_width * (has_alpha ? 4 : 3); x++)
+	  pixels[y * rowstride + x] = g_rand_int_range (rand, 0, 256);
+
+      total = 0.0;
+      min = G_MAXDOUBLE;
+      for (i = 0; i <= bench_iterations; i++)
+	{
+	  g_timer_start (timer);
+	  surface = goo_canvas_cairo_surface_from_pixbuf (pixbuf);
+	  elapsed = g_timer_elapsed (timer, NULL);
+	  cairo_surface_destroy (surface);
+
+	  /* The first iteration is not timed, as for the scenes. */
+	  if (i == 0)
+	    continue;
+
+	  total += elapsed;
+	  min = MIN (min, elapsed);
+	}
+
+      printf ("convert\t%s\t%d\t%d\t%.1f\t%.1f\n", names[has_alpha],
+	      bench_width * bench_height, bench_iterations,
+	      total * 1e6 / bench_iterations, min * 1e6);
+      fflush (stdout);
+
+      g_object_unref (pixbuf);
+    }
+
+  g_timer_destroy (timer);
+  g_rand_free (rand);
+}
+
+
+/* Sends an expose of the whole canvas, as the window system would. */
+static void
+bench_expose (GooCanvas *canvas)
+{
+  GdkEventExpose event = { 0 };
+
+  event.type = GDK_EXPOSE;
+  event.window = canvas->canvas_window;
+  event.area.width = bench_width;
+  event.area.height = bench_height;
+  event.region = gdk_region_rectangle (&event.area);
+
+  gtk_widget_send_expose (GTK_WIDGET (canvas), (GdkEvent*) &event);
+
+  gdk_region_destroy (event.region);
+}
+
+
+static gboolean
+bench_check_deferred (void)
+{
+  GtkWidget *window, *canvas;
+  GtkAllocation allocation = { 0, 0, 0, 0 };
+  GooCanvasItem *root, *group, *rect;
+  GooCanvasBounds bounds;
+  gboolean ok = TRUE;
+
+  window = gtk_window_new (GTK_WINDOW_POPUP);
+  canvas = goo_canvas_new ();
+  gtk_container_add (GTK_CONTAINER (window), canvas);
+  goo_canvas_set_bounds (GOO_CANVAS (canvas), 0, 0, bench_width, bench_height);
+
+  allocation.width = bench_width;
+  allocation.height = bench_height;
+  gtk_widget_size_allocate (canvas, &allocation);
+  gtk_widget_realize (canvas);
+
+  root = goo_canvas_get_root_item (GOO_CANVAS (canvas));
+  goo_canvas_rect_new (root, 0.0, 0.0, 10.0, 10.0, NULL);
+  group = goo_canvas_group_new (root,
+				"visibility", GOO_CANVAS_ITEM_INVISIBLE,
+				NULL);
+  rect = goo_canvas_rect_new (group, 0.0, 0.0, 10.0, 10.0, NULL);
+
+  bench_expose (GOO_CANVAS (canvas));
+
+  /* A change in the hidden group must not be updated by the next paint. */
+  g_object_set (rect, "x", 20.0, NULL);
+  bench_expose (GOO_CANVAS (canvas));
+
+  if (!goo_canvas_has_deferred_items (GOO_CANVAS (canvas))
+      || !GOO_CANVAS_ITEM_SIMPLE (rect)->need_update)
+    {
+      fprintf (stderr, "The hidden group was updated by the expose\n");
+      ok = FALSE;
+    }
+
+  /* Its bounds are right as soon as they are read. */
+  goo_canvas_item_get_bounds (rect, &bounds);
+  if (bounds.x1 > 20.0 || bounds.x2 < 30.0)
+    {
+      fprintf (stderr, "The hidden group was not updated when read\n");
+      ok = FALSE;
+    }
+
+  gtk_widget_destroy (window);
+
+  return ok;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  gboolean found = FALSE;
+  guint i;
+
+  context = g_option_context_new ("- time the canvas on recorded scenes");
+  g_option_context_set_summary (context,
+				"Needs a display, use xvfb-run without one.");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      fprintf (stderr, "%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  bench_iterations = MAX (bench_iterations, 1);
+  bench_width = MAX (bench_width, 64);
+  bench_height = MAX (bench_height, 64);
+
+  /* GTK needs a display to create the canvas widget. */
+  if (!gtk_init_check (&argc, &argv))
+    {
+      if (!bench_scene || strcmp (bench_scene, "convert"))
+	{
+	  fprintf (stderr, "Can't open a display. The canvas needs one, run"
+		   " the bench with xvfb-run, or only the convert scene"
+		   " (--scene=convert)\n");
+	  return 1;
+	}
+#if !GLIB_CHECK_VERSION (2, 35, 0)
+      g_type_init ();
+#endif
+    }
+
+#if !LIBRSVG_CHECK_VERSION (2, 36, 0)
+  rsvg_init ();
+#endif
+
+  svg_handle = rsvg_handle_new_from_data ((const guint8 *) svg_data,
+					  strlen (svg_data), NULL);
+  if (!svg_handle)
+    {
+      fprintf (stderr, "Can't load the SVG item\n");
+      return 1;
+    }
+
+  printf ("scene\tphase\titems\titerations\tmean_us\tmin_us\n");
+
+  for (i = 0; i < G_N_ELEMENTS (scenes); i++)
+    {
+      if (bench_scene && strcmp (bench_scene, scenes[i].name))
+	continue;
+
+      bench_run_scene (&scenes[i]);
+      found = TRUE;
+    }
+
+  if (!bench_scene || !strcmp (bench_scene, "convert"))
+    {
+      bench_run_convert ();
+      found = TRUE;
+    }
+
+  if (!bench_scene || !strcmp (bench_scene, "deferred"))
+    {
+      if (!bench_check_deferred ())
+	return 1;
+      found = TRUE;
+    }
+
+  g_object_unref (svg_handle);
+
+  if (!found)
+    {
+      fprintf (stderr, "Unknown scene %s\n", bench_scene);
+      return 1;
+    }
+
+  return 0;
+}
@@ -103,6 +103,7 @@
 #include "goocanvasitem.h"
 #include "goocanvasgroup.h"
 #include "goocanvasmarshal.h"
+#include "goocanvasprivate.h"
 
 
 #define GOO_CANVAS_GET_PRIVATE(canvas)  \
@@ -113,8 +114,77 @@ struct _GooCanvasPrivate {
   GooCanvasItem *static_root_item;
   GooCanvasItemModel *static_root_item_model;
   gint window_x, window_y;
+
+  /* The retained item is painted once into retained_surface, which is then
+     used instead of painting the item on each expose. The surface is
+     rendered again when the item changes or the canvas is scaled. */
+  GooCanvasItem *retained_item;
+  cairo_surface_t *retained_surface;
+  gdouble retained_device_to_pixels_x, retained_device_to_pixels_y;
+  GooCanvasBounds retained_canvas_bounds;
+
+  /* What goo_canvas_paint_child_filter() lets through. */
+  guint paint_mode : 2;
+
+  /* The threads rendering the exposed area in tiles, if render_threads is
+     set. pending_tiles counts the tiles not rendered yet. */
+  gint render_threads;
+  GThreadPool *render_pool;
+  GMutex *render_mutex;
+  GCond *render_cond;
+  gint pending_tiles;
+
+  /* The nesting level of goo_canvas_begin_batch(), the items changed in the
+     batch and the area to redraw once it ends. */
+  gint batch_depth;
+  GPtrArray *batch_items;
+  GdkRegion *batch_damage;
+
+  /* Set while the update is done to paint the canvas, the items which are
+     not painted may then defer the update of their children. deferred_items
+     are updated before anything else reads the bounds of the items. */
+  gboolean defer_updates;
+  GPtrArray *deferred_items;
+};
+
+/* A tile of the exposed area, rendered by a thread of the render pool. */
+typedef struct _GooCanvasRenderTile GooCanvasRenderTile;
+struct _GooCanvasRenderTile
+{
+  GdkRectangle area;
+  GooCanvasBounds root_item_bounds;
+  cairo_surface_t *surface;
+};
+
+/* The paint modes used when there is a retained item. */
+enum {
+  GOO_CANVAS_PAINT_ALL,
+  GOO_CANVAS_PAINT_SKIP_RETAINED,
+  GOO_CANVAS_PAINT_ONLY_RETAINED
 };
 
+/* The size of the tiles the exposed area is snapped to, when it is made of
+   too many rectangles to paint them one by one. */
+#define GOO_CANVAS_TILE_SIZE		64
+#define GOO_CANVAS_MAX_EXPOSE_RECTS	8
+
+/* We don't retain an item if its surface would be larger than this. */
+#define GOO_CANVAS_MAX_RETAINED_SIZE	4096
+
+/* The size of the tiles rendered by the render threads. */
+#define GOO_CANVAS_RENDER_TILE_SIZE	256
+#define GOO_CANVAS_MAX_RENDER_THREADS	64
+
+/* Set while the render threads paint tiles. The items that can't be painted
+   by several threads at once are then painted with paint_mutex held. */
+static gboolean paint_threads_active = FALSE;
+static GStaticRecMutex paint_mutex = G_STATIC_REC_MUTEX_INIT;
+
+/* The paint() methods that only read the items. */
+#define GOO_CANVAS_MAX_THREAD_SAFE_PAINTS 8
+static gpointer thread_safe_paints[GOO_CANVAS_MAX_THREAD_SAFE_PAINTS];
+static gint n_thread_safe_paints = 0;
+
 
 enum {
   PROP_0,
@@ -137,7 +207,8 @@ enum {
   PROP_BACKGROUND_COLOR_RGB,
   PROP_INTEGER_LAYOUT,
   PROP_CLEAR_BACKGROUND,
-  PROP_REDRAW_WHEN_SCROLLED
+  PROP_REDRAW_WHEN_SCROLLED,
+  PROP_RENDER_THREADS
 };
 
 enum {
@@ -218,6 +289,8 @@ static void     update_pointer_item        (GooCanvas        *canvas,
 static void     reconfigure_canvas	   (GooCanvas        *canvas,
 					    gboolean          redraw_if_needed);
 static void	goo_canvas_update_automatic_bounds (GooCanvas       *canvas);
+static void	goo_canvas_update_deferred_items (GooCanvas     *canvas,
+						  gboolean       update);
 
 static void     goo_canvas_convert_to_static_item_space (GooCanvas     *canvas,
 							 gdouble       *x,
@@ -424,6 +497,13 @@ goo_canvas_class_init (GooCanvasClass *klass)
 							 FALSE,
 							 G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_RENDER_THREADS,
+				   g_param_spec_int ("render-threads",
+						     _("Render Threads"),
+						     _("The number of threads rendering the exposed area in tiles, 0 to render it in the GTK thread"),
+						     0, GOO_CANVAS_MAX_RENDER_THREADS, 0,
+						     G_PARAM_READWRITE));
+
   /**
    * GooCanvas::set-scroll-adjustments
    * @canvas: the canvas.
@@ -553,6 +633,8 @@ goo_canvas_dispose (GObject *object)
   GooCanvas *canvas = (GooCanvas*) object;
   GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
 
+  goo_canvas_set_retained_item (canvas, NULL);
+
   if (canvas->model_to_item)
     {
       g_hash_table_destroy (canvas->model_to_item);
@@ -608,6 +690,17 @@ goo_canvas_dispose (GObject *object)
       canvas->vadjustment = NULL;
     }
 
+  goo_canvas_set_render_threads (canvas, 0);
+
+  /* Release the items of an unfinished batch. */
+  if (priv->batch_depth > 0)
+    {
+      priv->batch_depth = 1;
+      goo_canvas_end_batch (canvas);
+    }
+
+  goo_canvas_update_deferred_items (canvas, FALSE);
+
   G_OBJECT_CLASS (goo_canvas_parent_class)->dispose (object);
 }
 
@@ -761,6 +854,9 @@ goo_canvas_get_property    (GObject            *object,
     case PROP_REDRAW_WHEN_SCROLLED:
       g_value_set_boolean (value, canvas->redraw_when_scrolled);
       break;
+    case PROP_RENDER_THREADS:
+      g_value_set_int (value, GOO_CANVAS_GET_PRIVATE (canvas)->render_threads);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -867,6 +963,9 @@ goo_canvas_set_property    (GObject            *object,
     case PROP_REDRAW_WHEN_SCROLLED:
       canvas->redraw_when_scrolled = g_value_get_boolean (value);
       break;
+    case PROP_RENDER_THREADS:
+      goo_canvas_set_render_threads (canvas, g_value_get_int (value));
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -1543,6 +1642,8 @@ goo_canvas_unrealize (GtkWidget *widget)
 
   canvas = GOO_CANVAS (widget);
 
+  goo_canvas_invalidate_retained_item (canvas, NULL, FALSE);
+
   gdk_window_set_user_data (canvas->canvas_window, NULL);
   gdk_window_destroy (canvas->canvas_window);
   canvas->canvas_window = NULL;
@@ -1720,6 +1821,27 @@ recalculate_scales (GooCanvas *canvas)
 }
 
 
+/* Invalidates a rectangle of the canvas window, or adds it to the area to
+   redraw at the end of the current batch. */
+static void
+goo_canvas_invalidate_rect (GooCanvas    *canvas,
+			    GdkRectangle *rect)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  if (priv->batch_depth > 0)
+    {
+      if (priv->batch_damage)
+	gdk_region_union_with_rect (priv->batch_damage, rect);
+      else
+	priv->batch_damage = gdk_region_rectangle (rect);
+      return;
+    }
+
+  gdk_window_invalidate_rect (canvas->canvas_window, rect, FALSE);
+}
+
+
 static void
 request_static_redraw (GooCanvas             *canvas,
 		       const GooCanvasBounds *bounds)
@@ -1744,7 +1866,7 @@ request_static_redraw (GooCanvas             *canvas,
   rect.width = (double) bounds->x2 - priv->window_x - rect.x + 2 + 1;
   rect.height = (double) bounds->y2 - priv->window_y - rect.y + 2 + 1;
 
-  gdk_window_invalidate_rect (canvas->canvas_window, &rect, FALSE);
+  goo_canvas_invalidate_rect (canvas, &rect);
 }
 
 
@@ -2557,7 +2679,15 @@ goo_canvas_update_internal (GooCanvas *canvas,
 void
 goo_canvas_update (GooCanvas *canvas)
 {
-  cairo_t *cr = goo_canvas_create_cairo_context (canvas);
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  cairo_t *cr;
+
+  /* Unless we are about to paint, all the bounds must be right, even those
+     of the items which are not painted. */
+  if (!priv->defer_updates)
+    goo_canvas_update_deferred_items (canvas, TRUE);
+
+  cr = goo_canvas_create_cairo_context (canvas);
   goo_canvas_update_internal (canvas, cr);
   cairo_destroy (cr);
 }
@@ -2566,9 +2696,14 @@ goo_canvas_update (GooCanvas *canvas)
 static gint
 goo_canvas_idle_handler (GooCanvas *canvas)
 {
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
   GDK_THREADS_ENTER ();
 
+  /* This update is only done for the next paint. */
+  priv->defer_updates = TRUE;
   goo_canvas_update (canvas);
+  priv->defer_updates = FALSE;
 
   /* Reset idle id. Note that we do this after goo_canvas_update(), to
      make sure we don't schedule another idle handler while that is running. */
@@ -2652,7 +2787,7 @@ goo_canvas_request_redraw (GooCanvas             *canvas,
   rect.x += canvas->canvas_x_offset;
   rect.y += canvas->canvas_y_offset;
 
-  gdk_window_invalidate_rect (canvas->canvas_window, &rect, FALSE);
+  goo_canvas_invalidate_rect (canvas, &rect);
 }
 
 
@@ -2684,6 +2819,748 @@ goo_canvas_request_item_redraw (GooCanvas             *canvas,
 }
 
 
+/**
+ * goo_canvas_begin_batch:
+ * @canvas: a #GooCanvas.
+ *
+ * Starts a batch of changes to the items, which ends with
+ * goo_canvas_end_batch(). Batches can be nested.
+ *
+ * Within a batch, each item changed is only redrawn once, at the end of the
+ * batch, however many of its properties are set. All the areas to redraw are
+ * then invalidated at once. The bounds of the items are still updated when
+ * they are asked for.
+ **/
+void
+goo_canvas_begin_batch (GooCanvas *canvas)
+{
+  g_return_if_fail (GOO_IS_CANVAS (canvas));
+
+  GOO_CANVAS_GET_PRIVATE (canvas)->batch_depth++;
+}
+
+
+/**
+ * goo_canvas_end_batch:
+ * @canvas: a #GooCanvas.
+ *
+ * Ends a batch of changes started with goo_canvas_begin_batch(). When the
+ * outermost batch ends, the items changed in it are redrawn.
+ **/
+void
+goo_canvas_end_batch (GooCanvas *canvas)
+{
+  GooCanvasPrivate *priv;
+  GPtrArray *items;
+  guint i;
+
+  g_return_if_fail (GOO_IS_CANVAS (canvas));
+
+  priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  g_return_if_fail (priv->batch_depth > 0);
+
+  if (priv->batch_depth > 1)
+    {
+      priv->batch_depth--;
+      return;
+    }
+
+  /* The redraws the items request here are still added to the damage. */
+  items = priv->batch_items;
+  priv->batch_items = NULL;
+  if (items)
+    {
+      for (i = 0; i < items->len; i++)
+	{
+	  goo_canvas_item_simple_end_batch (items->pdata[i]);
+	  g_object_unref (items->pdata[i]);
+	}
+      g_ptr_array_free (items, TRUE);
+    }
+
+  priv->batch_depth = 0;
+
+  if (priv->batch_damage)
+    {
+#if GTK_CHECK_VERSION(2, 18, 0)
+      if (gtk_widget_is_drawable (GTK_WIDGET(canvas)))
+#else
+      if (GTK_WIDGET_DRAWABLE (canvas))
+#endif
+	gdk_window_invalidate_region (canvas->canvas_window,
+				      priv->batch_damage, FALSE);
+      gdk_region_destroy (priv->batch_damage);
+      priv->batch_damage = NULL;
+    }
+}
+
+
+/*
+ * goo_canvas_is_in_batch:
+ * @canvas: a #GooCanvas.
+ *
+ * Returns: %TRUE if a batch of changes has been started on @canvas.
+ */
+gboolean
+goo_canvas_is_in_batch (GooCanvas *canvas)
+{
+  return GOO_CANVAS_GET_PRIVATE (canvas)->batch_depth > 0;
+}
+
+
+/*
+ * goo_canvas_add_batch_item:
+ * @canvas: a #GooCanvas.
+ * @item: an item changed in the current batch.
+ *
+ * Keeps @item until the batch ends, goo_canvas_item_simple_end_batch() is
+ * then called on it. Each item must only be added once per batch.
+ */
+void
+goo_canvas_add_batch_item (GooCanvas           *canvas,
+			   GooCanvasItemSimple *item)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  if (!priv->batch_items)
+    priv->batch_items = g_ptr_array_new ();
+  g_ptr_array_add (priv->batch_items, g_object_ref (item));
+}
+
+
+/*
+ * goo_canvas_may_defer_update:
+ * @canvas: a #GooCanvas.
+ *
+ * Returns: %TRUE if the items which are not painted may defer the update of
+ *  their children, see goo_canvas_item_simple_defer_update(). This is only
+ *  the case while the canvas is updated to be painted, and if its bounds
+ *  don't depend on those of the items.
+ */
+gboolean
+goo_canvas_may_defer_update (GooCanvas *canvas)
+{
+  return GOO_CANVAS_GET_PRIVATE (canvas)->defer_updates
+    && !canvas->automatic_bounds;
+}
+
+
+/*
+ * goo_canvas_add_deferred_item:
+ * @canvas: a #GooCanvas.
+ * @item: an item which deferred its update.
+ *
+ * Keeps @item until something reads the bounds of the items, 
+ * goo_canvas_item_simple_end_deferred_update() is then called on it. Each
+ * item must only be added once.
+ */
+void
+goo_canvas_add_deferred_item (GooCanvas           *canvas,
+			      GooCanvasItemSimple *item)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  if (!priv->deferred_items)
+    priv->deferred_items = g_ptr_array_new ();
+  g_ptr_array_add (priv->deferred_items, g_object_ref (item));
+}
+
+
+/*
+ * goo_canvas_has_deferred_items:
+ * @canvas: a #GooCanvas.
+ *
+ * Returns: %TRUE if some items deferred their update, so the bounds of their
+ *  descendants may be out of date.
+ */
+gboolean
+goo_canvas_has_deferred_items (GooCanvas *canvas)
+{
+  return GOO_CANVAS_GET_PRIVATE (canvas)->deferred_items != NULL;
+}
+
+
+/* Releases the items which deferred their update. If update is set, the
+   updates they deferred are requested. */
+static void
+goo_canvas_update_deferred_items (GooCanvas *canvas,
+				  gboolean   update)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  GPtrArray *items = priv->deferred_items;
+  guint i;
+
+  if (!items)
+    return;
+
+  priv->deferred_items = NULL;
+  for (i = 0; i < items->len; i++)
+    {
+      goo_canvas_item_simple_end_deferred_update (items->pdata[i], update);
+      g_object_unref (items->pdata[i]);
+    }
+  g_ptr_array_free (items, TRUE);
+}
+
+
+static void
+goo_canvas_retained_item_finalized (gpointer  data,
+				    GObject  *where_the_object_was)
+{
+  GooCanvas *canvas = data;
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  priv->retained_item = NULL;
+  if (priv->retained_surface)
+    cairo_surface_destroy (priv->retained_surface);
+  priv->retained_surface = NULL;
+}
+
+
+/**
+ * goo_canvas_set_retained_item:
+ * @canvas: a #GooCanvas.
+ * @item: the item to retain, or %NULL.
+ *
+ * Sets the item to keep rendered in an offscreen surface, typically a large
+ * background image. The surface is painted instead of the item on each
+ * expose, and it is only rendered again when the item (or one of its
+ * ancestors) changes or when the canvas scale changes.
+ *
+ * The surface is only used while @item is painted below all the other items,
+ * i.e. it is the first child of each of its ancestors up to the root item.
+ * Otherwise the item is painted as usual.
+ *
+ * The canvas does not hold a reference to @item.
+ **/
+void
+goo_canvas_set_retained_item (GooCanvas     *canvas,
+			      GooCanvasItem *item)
+{
+  GooCanvasPrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS (canvas));
+  g_return_if_fail (item == NULL || GOO_IS_CANVAS_ITEM (item));
+
+  priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  if (priv->retained_item == item)
+    return;
+
+  if (priv->retained_item)
+    g_object_weak_unref ((GObject*) priv->retained_item,
+			 goo_canvas_retained_item_finalized, canvas);
+
+  goo_canvas_retained_item_finalized (canvas, NULL);
+
+  priv->retained_item = item;
+  if (item)
+    g_object_weak_ref ((GObject*) item,
+		       goo_canvas_retained_item_finalized, canvas);
+}
+
+
+static gboolean
+goo_canvas_item_is_ancestor_or_self (GooCanvasItem *ancestor,
+				     GooCanvasItem *item)
+{
+  while (item)
+    {
+      if (item == ancestor)
+	return TRUE;
+      item = goo_canvas_item_get_parent (item);
+    }
+  return FALSE;
+}
+
+
+/*
+ * goo_canvas_invalidate_retained_item:
+ * @canvas: a #GooCanvas.
+ * @item: the item which changed, or %NULL to always invalidate.
+ * @check_ancestors: if the retained surface also depends on @item when it
+ *  is an ancestor of the retained item, e.g. for a transform change but not
+ *  for a child added to a group.
+ *
+ * Drops the retained surface if @item is the retained item or one of its
+ * descendants, or one of its ancestors if @check_ancestors is %TRUE.
+ */
+void
+goo_canvas_invalidate_retained_item (GooCanvas     *canvas,
+				     GooCanvasItem *item,
+				     gboolean       check_ancestors)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  if (!priv->retained_surface)
+    return;
+
+  if (item
+      && !goo_canvas_item_is_ancestor_or_self (priv->retained_item, item)
+      && !(check_ancestors
+	   && goo_canvas_item_is_ancestor_or_self (item, priv->retained_item)))
+    return;
+
+  cairo_surface_destroy (priv->retained_surface);
+  priv->retained_surface = NULL;
+}
+
+
+/*
+ * goo_canvas_paint_child_filter:
+ * @canvas: a #GooCanvas.
+ * @child: a child item about to be painted by its group.
+ *
+ * Returns: %TRUE if @child has to be painted, according to the current
+ *  paint mode. This lets the canvas paint everything except the retained
+ *  item, or only the retained item.
+ */
+gboolean
+goo_canvas_paint_child_filter (GooCanvas     *canvas,
+			       GooCanvasItem *child)
+{
+  GooCanvasPrivate *priv;
+
+  if (!canvas)
+    return TRUE;
+
+  priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  switch (priv->paint_mode)
+    {
+    case GOO_CANVAS_PAINT_SKIP_RETAINED:
+      return child != priv->retained_item;
+    case GOO_CANVAS_PAINT_ONLY_RETAINED:
+      return goo_canvas_item_is_ancestor_or_self (child, priv->retained_item)
+	|| goo_canvas_item_is_ancestor_or_self (priv->retained_item, child);
+    default:
+      return TRUE;
+    }
+}
+
+
+/* Returns TRUE if the retained item is painted below all the other items. */
+static gboolean
+goo_canvas_retained_item_is_lowest (GooCanvas *canvas)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  GooCanvasItem *item = priv->retained_item, *parent;
+
+  if (!item || item == canvas->root_item)
+    return FALSE;
+
+  while ((parent = goo_canvas_item_get_parent (item)))
+    {
+      if (goo_canvas_item_get_child (parent, 0) != item)
+	return FALSE;
+      item = parent;
+    }
+
+  return item == canvas->root_item;
+}
+
+
+/* Returns the up to date retained surface, rendering it if needed, or NULL
+   if the retained item can't be used. */
+static cairo_surface_t*
+goo_canvas_get_retained_surface (GooCanvas *canvas,
+				 cairo_t   *cr)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  cairo_t *retained_cr;
+  gint width, height;
+
+  if (!goo_canvas_retained_item_is_lowest (canvas))
+    return NULL;
+
+  if (priv->retained_surface
+      && priv->retained_device_to_pixels_x == canvas->device_to_pixels_x
+      && priv->retained_device_to_pixels_y == canvas->device_to_pixels_y
+      && priv->retained_canvas_bounds.x1 == canvas->bounds.x1
+      && priv->retained_canvas_bounds.y1 == canvas->bounds.y1
+      && priv->retained_canvas_bounds.x2 == canvas->bounds.x2
+      && priv->retained_canvas_bounds.y2 == canvas->bounds.y2)
+    return priv->retained_surface;
+
+  goo_canvas_invalidate_retained_item (canvas, NULL, FALSE);
+
+  width = ceil ((canvas->bounds.x2 - canvas->bounds.x1)
+		* canvas->device_to_pixels_x);
+  height = ceil ((canvas->bounds.y2 - canvas->bounds.y1)
+		 * canvas->device_to_pixels_y);
+  if (width <= 0 || height <= 0
+      || width > GOO_CANVAS_MAX_RETAINED_SIZE
+      || height > GOO_CANVAS_MAX_RETAINED_SIZE)
+    return NULL;
+
+  priv->retained_surface =
+    cairo_surface_create_similar (cairo_get_target (cr),
+				  CAIRO_CONTENT_COLOR_ALPHA, width, height);
+  priv->retained_device_to_pixels_x = canvas->device_to_pixels_x;
+  priv->retained_device_to_pixels_y = canvas->device_to_pixels_y;
+  priv->retained_canvas_bounds = canvas->bounds;
+
+  /* Paint the root item, letting only the retained item and its ancestors
+     through. */
+  retained_cr = cairo_create (priv->retained_surface);
+  cairo_set_antialias (retained_cr, CAIRO_ANTIALIAS_GRAY);
+  cairo_set_line_width (retained_cr,
+			goo_canvas_get_default_line_width (canvas));
+  cairo_scale (retained_cr, canvas->device_to_pixels_x,
+	       canvas->device_to_pixels_y);
+  cairo_translate (retained_cr, -canvas->bounds.x1, -canvas->bounds.y1);
+
+  priv->paint_mode = GOO_CANVAS_PAINT_ONLY_RETAINED;
+  goo_canvas_item_paint (canvas->root_item, retained_cr, &canvas->bounds,
+			 canvas->scale);
+  priv->paint_mode = GOO_CANVAS_PAINT_ALL;
+
+  cairo_destroy (retained_cr);
+
+  return priv->retained_surface;
+}
+
+
+/* Returns the rectangles to paint for an expose event. When there are too
+   many of them, they are snapped to a grid of tiles and merged, so that we
+   walk the items a bounded number of times. The caller frees the array. */
+static GdkRectangle*
+goo_canvas_get_expose_rectangles (GdkEventExpose *event,
+				  gint           *n_rects)
+{
+  GdkRectangle *rects;
+  GdkRegion *tiles;
+  gint i;
+
+  if (!event->region)
+    {
+      *n_rects = 1;
+      return g_memdup (&event->area, sizeof (GdkRectangle));
+    }
+
+  gdk_region_get_rectangles (event->region, &rects, n_rects);
+  if (*n_rects <= GOO_CANVAS_MAX_EXPOSE_RECTS)
+    return rects;
+
+  tiles = gdk_region_new ();
+  for (i = 0; i < *n_rects; i++)
+    {
+      GdkRectangle tile;
+
+      tile.x = rects[i].x - rects[i].x % GOO_CANVAS_TILE_SIZE;
+      tile.y = rects[i].y - rects[i].y % GOO_CANVAS_TILE_SIZE;
+      tile.width = rects[i].x + rects[i].width - tile.x;
+      tile.height = rects[i].y + rects[i].height - tile.y;
+      tile.width += GOO_CANVAS_TILE_SIZE - 1;
+      tile.width -= tile.width % GOO_CANVAS_TILE_SIZE;
+      tile.height += GOO_CANVAS_TILE_SIZE - 1;
+      tile.height -= tile.height % GOO_CANVAS_TILE_SIZE;
+
+      gdk_region_union_with_rect (tiles, &tile);
+    }
+  g_free (rects);
+
+  /* Don't paint outside of what was exposed. */
+  gdk_region_intersect (tiles, event->region);
+  gdk_region_get_rectangles (tiles, &rects, n_rects);
+  gdk_region_destroy (tiles);
+
+  /* Still too fragmented, use the bounding box. */
+  if (*n_rects > GOO_CANVAS_MAX_EXPOSE_RECTS)
+    {
+      g_free (rects);
+      *n_rects = 1;
+      rects = g_memdup (&event->area, sizeof (GdkRectangle));
+    }
+
+  return rects;
+}
+
+
+/* Paints the root item in the given window area. The cairo context is set up
+   for window coordinates. */
+static void
+goo_canvas_paint_area (GooCanvas             *canvas,
+		       cairo_t               *cr,
+		       const GdkRectangle    *area,
+		       const GooCanvasBounds *root_item_bounds)
+{
+  GooCanvasBounds bounds;
+  double x1, y1, x2, y2;
+
+  bounds.x1 = ((area->x - canvas->canvas_x_offset) / canvas->device_to_pixels_x)
+    + canvas->bounds.x1;
+  bounds.y1 = ((area->y - canvas->canvas_y_offset) / canvas->device_to_pixels_y)
+    + canvas->bounds.y1;
+  bounds.x2 = (area->width / canvas->device_to_pixels_x) + bounds.x1;
+  bounds.y2 = (area->height / canvas->device_to_pixels_y) + bounds.y1;
+
+  /* Translate it to use the canvas pixel offsets (used when the canvas is
+     smaller than the window and the anchor isn't set to NORTH_WEST). */
+  cairo_translate (cr, canvas->canvas_x_offset, canvas->canvas_y_offset);
+
+  /* Scale it so we can use canvas coordinates. */
+  cairo_scale (cr, canvas->device_to_pixels_x, canvas->device_to_pixels_y);
+
+  /* Translate it so the top-left of the canvas becomes (0,0). */
+  cairo_translate (cr, -canvas->bounds.x1, -canvas->bounds.y1);
+
+  /* Clip to the canvas bounds, if necessary. We only need to clip if the
+     items in the canvas extend outside the canvas bounds and the canvas
+     bounds is less than the area being painted. */
+  if ((root_item_bounds->x1 < canvas->bounds.x1
+       && canvas->bounds.x1 > bounds.x1)
+      || (root_item_bounds->x2 > canvas->bounds.x2
+	  && canvas->bounds.x2 < bounds.x2)
+      || (root_item_bounds->y1 < canvas->bounds.y1
+	  && canvas->bounds.y1 > bounds.y1)
+      || (root_item_bounds->y2 > canvas->bounds.y2
+	  && canvas->bounds.y2 < bounds.y2))
+    {
+      /* Clip to the intersection of the canvas bounds and the expose
+	 bounds, to avoid cairo's 16-bit limits. */
+      x1 = MAX (canvas->bounds.x1, bounds.x1);
+      y1 = MAX (canvas->bounds.y1, bounds.y1);
+      x2 = MIN (canvas->bounds.x2, bounds.x2);
+      y2 = MIN (canvas->bounds.y2, bounds.y2);
+
+      cairo_new_path (cr);
+      cairo_move_to (cr, x1, y1);
+      cairo_line_to (cr, x2, y1);
+      cairo_line_to (cr, x2, y2);
+      cairo_line_to (cr, x1, y2);
+      cairo_close_path (cr);
+      cairo_clip (cr);
+    }
+
+  goo_canvas_item_paint (canvas->root_item, cr, &bounds, canvas->scale);
+}
+
+
+/*
+ * goo_canvas_register_thread_safe_paint:
+ * @paint: a paint() method of #GooCanvasItemIface, or a simple_paint() method
+ *  of #GooCanvasItemSimpleClass.
+ *
+ * Marks @paint as only reading the item and the shared caches, so that the
+ * render threads can run it at once. This is called by the class init
+ * functions, before any item is painted.
+ */
+void
+goo_canvas_register_thread_safe_paint (gpointer paint)
+{
+  g_return_if_fail (n_thread_safe_paints < GOO_CANVAS_MAX_THREAD_SAFE_PAINTS);
+
+  thread_safe_paints[n_thread_safe_paints++] = paint;
+}
+
+
+/*
+ * goo_canvas_paint_lock:
+ * @paint: the paint method about to be called.
+ *
+ * Returns: %TRUE if the paint lock was taken, since @paint is called while
+ *  the render threads paint and may not be run by several of them at once.
+ *  goo_canvas_paint_unlock() must then be called once @paint returns.
+ */
+gboolean
+goo_canvas_paint_lock (gpointer paint)
+{
+  gint i;
+
+  if (!paint_threads_active)
+    return FALSE;
+
+  for (i = 0; i < n_thread_safe_paints; i++)
+    if (thread_safe_paints[i] == paint)
+      return FALSE;
+
+  g_static_rec_mutex_lock (&paint_mutex);
+  return TRUE;
+}
+
+
+void
+goo_canvas_paint_unlock (void)
+{
+  g_static_rec_mutex_unlock (&paint_mutex);
+}
+
+
+/**
+ * goo_canvas_set_render_threads:
+ * @canvas: a #GooCanvas.
+ * @n_threads: the number of threads, or 0.
+ *
+ * Sets the number of threads rendering the exposed area. When it is more than
+ * 0, the exposed area is split in tiles which are rendered in image surfaces
+ * by these threads and then copied to the window. Items that can't be painted
+ * by several threads at once, such as text, are painted by one thread at a
+ * time.
+ *
+ * If GLib threads are not initialized, the area is rendered in the GTK
+ * thread as usual.
+ **/
+void
+goo_canvas_set_render_threads (GooCanvas *canvas,
+			       gint       n_threads)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  n_threads = CLAMP (n_threads, 0, GOO_CANVAS_MAX_RENDER_THREADS);
+  if (n_threads == priv->render_threads)
+    return;
+
+  /* The pool is created again with the new size when it is needed. */
+  if (priv->render_pool)
+    {
+      g_thread_pool_free (priv->render_pool, FALSE, TRUE);
+      priv->render_pool = NULL;
+      g_mutex_free (priv->render_mutex);
+      priv->render_mutex = NULL;
+      g_cond_free (priv->render_cond);
+      priv->render_cond = NULL;
+    }
+
+  priv->render_threads = n_threads;
+}
+
+
+static void
+goo_canvas_render_tile (gpointer data,
+			gpointer user_data)
+{
+  GooCanvasRenderTile *tile = data;
+  GooCanvas *canvas = user_data;
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  cairo_t *cr;
+
+  tile->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+					      tile->area.width,
+					      tile->area.height);
+  cr = cairo_create (tile->surface);
+
+  /* The same setup as goo_canvas_create_cairo_context(). */
+  cairo_set_antialias (cr, CAIRO_ANTIALIAS_GRAY);
+  cairo_set_line_width (cr, goo_canvas_get_default_line_width (canvas));
+
+  cairo_translate (cr, -tile->area.x, -tile->area.y);
+  goo_canvas_paint_area (canvas, cr, &tile->area, &tile->root_item_bounds);
+
+  cairo_destroy (cr);
+
+  g_mutex_lock (priv->render_mutex);
+  if (--priv->pending_tiles == 0)
+    g_cond_signal (priv->render_cond);
+  g_mutex_unlock (priv->render_mutex);
+}
+
+
+/* Renders the exposed rectangles in tiles with the render threads, and
+   copies them to the window. Returns FALSE if the rectangles must be painted
+   in this thread instead. */
+static gboolean
+goo_canvas_render_tiles (GooCanvas             *canvas,
+			 cairo_t               *cr,
+			 const GdkRectangle    *rects,
+			 gint                   n_rects,
+			 cairo_surface_t       *retained_surface,
+			 const GooCanvasBounds *root_item_bounds)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  GooCanvasRenderTile *tiles;
+  gint n_tiles = 0, i, x, y;
+
+  if (priv->render_threads <= 0 || !g_thread_supported ())
+    return FALSE;
+
+  for (i = 0; i < n_rects; i++)
+    n_tiles += ((rects[i].width + GOO_CANVAS_RENDER_TILE_SIZE - 1)
+		/ GOO_CANVAS_RENDER_TILE_SIZE)
+      * ((rects[i].height + GOO_CANVAS_RENDER_TILE_SIZE - 1)
+	 / GOO_CANVAS_RENDER_TILE_SIZE);
+
+  /* Not worth the copies. */
+  if (n_tiles < 2)
+    return FALSE;
+
+  if (!priv->render_pool)
+    {
+      priv->render_pool = g_thread_pool_new (goo_canvas_render_tile, canvas,
+					     priv->render_threads, FALSE, NULL);
+      if (!priv->render_pool)
+	return FALSE;
+      priv->render_mutex = g_mutex_new ();
+      priv->render_cond = g_cond_new ();
+    }
+
+  tiles = g_new0 (GooCanvasRenderTile, n_tiles);
+  n_tiles = 0;
+  for (i = 0; i < n_rects; i++)
+    for (y = rects[i].y; y < rects[i].y + rects[i].height;
+	 y += GOO_CANVAS_RENDER_TILE_SIZE)
+      for (x = rects[i].x; x < rects[i].x + rects[i].width;
+	   x += GOO_CANVAS_RENDER_TILE_SIZE)
+	{
+	  GooCanvasRenderTile *tile = &tiles[n_tiles++];
+
+	  tile->area.x = x;
+	  tile->area.y = y;
+	  tile->area.width = MIN (GOO_CANVAS_RENDER_TILE_SIZE,
+				  rects[i].x + rects[i].width - x);
+	  tile->area.height = MIN (GOO_CANVAS_RENDER_TILE_SIZE,
+				   rects[i].y + rects[i].height - y);
+	  tile->root_item_bounds = *root_item_bounds;
+	}
+
+  /* The item tree is only read while the tiles are rendered, this thread
+     just waits for them. */
+  if (retained_surface)
+    priv->paint_mode = GOO_CANVAS_PAINT_SKIP_RETAINED;
+  paint_threads_active = TRUE;
+
+  priv->pending_tiles = n_tiles;
+  for (i = 0; i < n_tiles; i++)
+    g_thread_pool_push (priv->render_pool, &tiles[i], NULL);
+
+  g_mutex_lock (priv->render_mutex);
+  while (priv->pending_tiles > 0)
+    g_cond_wait (priv->render_cond, priv->render_mutex);
+  g_mutex_unlock (priv->render_mutex);
+
+  paint_threads_active = FALSE;
+  priv->paint_mode = GOO_CANVAS_PAINT_ALL;
+
+  for (i = 0; i < n_tiles; i++)
+    {
+      GdkRectangle *area = &tiles[i].area;
+
+      cairo_save (cr);
+
+      cairo_rectangle (cr, area->x, area->y, area->width, area->height);
+      cairo_clip (cr);
+
+      if (retained_surface)
+	{
+	  cairo_set_source_surface (cr, retained_surface,
+				    canvas->canvas_x_offset,
+				    canvas->canvas_y_offset);
+	  cairo_paint (cr);
+	}
+
+      cairo_set_source_surface (cr, tiles[i].surface, area->x, area->y);
+      cairo_paint (cr);
+
+      cairo_restore (cr);
+
+      cairo_surface_destroy (tiles[i].surface);
+    }
+  g_free (tiles);
+
+  return TRUE;
+}
+
+
 static void
 paint_static_items (GooCanvas      *canvas,
 		    GdkEventExpose *event,
@@ -2713,9 +3590,12 @@ goo_canvas_expose_event (GtkWidget      *widget,
 			 GdkEventExpose *event)
 {
   GooCanvas *canvas = GOO_CANVAS (widget);
-  GooCanvasBounds bounds, root_item_bounds;
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  GooCanvasBounds root_item_bounds;
+  cairo_surface_t *retained_surface;
+  GdkRectangle *rects;
+  gint n_rects, i;
   cairo_t *cr;
-  double x1, y1, x2, y2;
 
   if (!canvas->root_item)
     return FALSE;
@@ -2734,59 +3614,53 @@ goo_canvas_expose_event (GtkWidget      *widget,
 
   cr = goo_canvas_create_cairo_context (canvas);
 
+  /* The items which are not painted keep their update deferred until the
+     paint is done, even if their bounds are read meanwhile. */
+  priv->defer_updates = TRUE;
+
   if (canvas->need_update)
     goo_canvas_update_internal (canvas, cr);
 
-  bounds.x1 = ((event->area.x - canvas->canvas_x_offset) / canvas->device_to_pixels_x)
-    + canvas->bounds.x1;
-  bounds.y1 = ((event->area.y - canvas->canvas_y_offset) / canvas->device_to_pixels_y)
-    + canvas->bounds.y1;
-  bounds.x2 = (event->area.width / canvas->device_to_pixels_x) + bounds.x1;
-  bounds.y2 = (event->area.height / canvas->device_to_pixels_y) + bounds.y1;
+  retained_surface = goo_canvas_get_retained_surface (canvas, cr);
 
-  /* Translate it to use the canvas pixel offsets (used when the canvas is
-     smaller than the window and the anchor isn't set to NORTH_WEST). */
-  cairo_translate (cr, canvas->canvas_x_offset, canvas->canvas_y_offset);
+  goo_canvas_item_get_bounds (canvas->root_item, &root_item_bounds);
 
-  /* Scale it so we can use canvas coordinates. */
-  cairo_scale (cr, canvas->device_to_pixels_x, canvas->device_to_pixels_y);
+  /* Paint each exposed rectangle on its own, so that small changes far from
+     each other don't make us paint everything in between. */
+  rects = goo_canvas_get_expose_rectangles (event, &n_rects);
+  if (!goo_canvas_render_tiles (canvas, cr, rects, n_rects, retained_surface,
+				&root_item_bounds))
+    {
+      for (i = 0; i < n_rects; i++)
+	{
+	  GdkRectangle *area = &rects[i];
 
-  /* Translate it so the top-left of the canvas becomes (0,0). */
-  cairo_translate (cr, -canvas->bounds.x1, -canvas->bounds.y1);
+	  cairo_save (cr);
 
-  /* Clip to the canvas bounds, if necessary. We only need to clip if the
-     items in the canvas extend outside the canvas bounds and the canvas
-     bounds is less than the area being painted. */
-  goo_canvas_item_get_bounds (canvas->root_item, &root_item_bounds);
-  if ((root_item_bounds.x1 < canvas->bounds.x1
-       && canvas->bounds.x1 > bounds.x1)
-      || (root_item_bounds.x2 > canvas->bounds.x2
-	  && canvas->bounds.x2 < bounds.x2)
-      || (root_item_bounds.y1 < canvas->bounds.y1
-	  && canvas->bounds.y1 > bounds.y1)
-      || (root_item_bounds.y2 > canvas->bounds.y2
-	  && canvas->bounds.y2 < bounds.y2))
-    {
-      /* Clip to the intersection of the canvas bounds and the expose
-	 bounds, to avoid cairo's 16-bit limits. */
-      x1 = MAX (canvas->bounds.x1, bounds.x1);
-      y1 = MAX (canvas->bounds.y1, bounds.y1);
-      x2 = MIN (canvas->bounds.x2, bounds.x2);
-      y2 = MIN (canvas->bounds.y2, bounds.y2);
+	  cairo_rectangle (cr, area->x, area->y, area->width, area->height);
+	  cairo_clip (cr);
 
-      cairo_new_path (cr);
-      cairo_move_to (cr, x1, y1);
-      cairo_line_to (cr, x2, y1);
-      cairo_line_to (cr, x2, y2);
-      cairo_line_to (cr, x1, y2);
-      cairo_close_path (cr);
-      cairo_clip (cr);
-    }
+	  if (retained_surface)
+	    {
+	      cairo_set_source_surface (cr, retained_surface,
+					canvas->canvas_x_offset,
+					canvas->canvas_y_offset);
+	      cairo_paint (cr);
+	      priv->paint_mode = GOO_CANVAS_PAINT_SKIP_RETAINED;
+	    }
 
-  goo_canvas_item_paint (canvas->root_item, cr, &bounds, canvas->scale);
+	  goo_canvas_paint_area (canvas, cr, area, &root_item_bounds);
+	  priv->paint_mode = GOO_CANVAS_PAINT_ALL;
+
+	  cairo_restore (cr);
+	}
+    }
+  g_free (rects);
 
   paint_static_items (canvas, event, cr);
 
+  priv->defer_updates = FALSE;
+
   cairo_destroy (cr);
 
   GTK_WIDGET_CLASS (goo_canvas_parent_class)->expose_event (widget, event);
@@ -217,6 +217,14 @@ GooCanvasItemModel* goo_canvas_get_static_root_item_model (GooCanvas	       *can
 void                goo_canvas_set_static_root_item_model (GooCanvas	       *canvas,
 							   GooCanvasItemModel *model);
 
+void            goo_canvas_set_retained_item       (GooCanvas		*canvas,
+						    GooCanvasItem      *item);
+void            goo_canvas_set_render_threads      (GooCanvas		*canvas,
+						    gint                n_threads);
+
+void            goo_canvas_begin_batch             (GooCanvas		*canvas);
+void            goo_canvas_end_batch               (GooCanvas		*canvas);
+
 GooCanvasItem*  goo_canvas_get_item	    (GooCanvas		*canvas,
 					     GooCanvasItemModel *model);
 GooCanvasItem*  goo_canvas_get_item_at	    (GooCanvas		*canvas,
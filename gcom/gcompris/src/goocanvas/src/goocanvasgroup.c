@@ -49,6 +49,11 @@ struct _GooCanvasGroupPrivate {
   gdouble y;
   gdouble width;
   gdouble height;
+
+  /* The device bounds of the area the children are clipped to, if any.
+     Computed in update(), only used by items. */
+  GooCanvasBounds clip_bounds;
+  gboolean has_clip_bounds;
 };
 
 #define GOO_CANVAS_GROUP_GET_PRIVATE(group)  \
@@ -76,6 +81,10 @@ static void goo_canvas_group_set_property (GObject            *object,
                                            const GValue       *value,
                                            GParamSpec         *pspec);
 static void canvas_item_interface_init    (GooCanvasItemIface *iface);
+static void goo_canvas_group_paint        (GooCanvasItem         *item,
+					   cairo_t               *cr,
+					   const GooCanvasBounds *bounds,
+					   gdouble                scale);
 
 G_DEFINE_TYPE_WITH_CODE (GooCanvasGroup, goo_canvas_group,
 			 GOO_TYPE_CANVAS_ITEM_SIMPLE,
@@ -130,6 +139,8 @@ goo_canvas_group_class_init (GooCanvasGroupClass *klass)
   gobject_class->get_property = goo_canvas_group_get_property;
   gobject_class->set_property = goo_canvas_group_set_property;
 
+  goo_canvas_register_thread_safe_paint (goo_canvas_group_paint);
+
   /* Register our accessible factory, but only if accessibility is enabled. */
   if (!ATK_IS_NO_OP_OBJECT_FACTORY (atk_registry_get_factory (atk_get_default_registry (), GTK_TYPE_WIDGET)))
     {
@@ -356,6 +367,9 @@ goo_canvas_group_add_child     (GooCanvasItem  *item,
 			     position, child_atk_obj);
     }
 
+  if (simple->canvas)
+    goo_canvas_invalidate_retained_item (simple->canvas, item, FALSE);
+
   goo_canvas_item_request_update (item);
 }
 
@@ -381,6 +395,9 @@ goo_canvas_group_move_child    (GooCanvasItem  *item,
 
   goo_canvas_util_ptr_array_move (group->items, old_position, new_position);
 
+  if (simple->canvas)
+    goo_canvas_invalidate_retained_item (simple->canvas, item, FALSE);
+
   goo_canvas_item_request_update (item);
 }
 
@@ -420,6 +437,9 @@ goo_canvas_group_remove_child  (GooCanvasItem  *item,
   goo_canvas_item_set_parent (child, NULL);
   g_object_unref (child);
 
+  if (simple->canvas)
+    goo_canvas_invalidate_retained_item (simple->canvas, item, FALSE);
+
   goo_canvas_item_request_update (item);
 }
 
@@ -581,14 +601,24 @@ goo_canvas_group_update  (GooCanvasItem   *item,
 			  GooCanvasBounds *bounds)
 {
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
+  GooCanvasItemSimpleData *simple_data = simple->simple_data;
   GooCanvasGroup *group = (GooCanvasGroup*) item;
   GooCanvasGroupPrivate *priv = goo_canvas_group_get_private (group);
-  GooCanvasBounds child_bounds;
+  GooCanvasBounds child_bounds, clip_bounds;
   gboolean initial_bounds = TRUE;
   gint i;
 
   if (entire_tree || simple->need_update)
     {
+      /* The children of a group which isn't painted are updated when it
+	 changes, or when something needs their bounds. */
+      if (simple_data->visibility <= GOO_CANVAS_ITEM_INVISIBLE
+	  && goo_canvas_item_simple_defer_update (simple))
+	{
+	  *bounds = simple->bounds;
+	  return;
+	}
+
       if (simple->need_entire_subtree_update)
 	entire_tree = TRUE;
 
@@ -606,6 +636,38 @@ goo_canvas_group_update  (GooCanvasItem   *item,
 
       cairo_translate (cr, priv->x, priv->y);
 
+      /* Find the area the children are clipped to when painted. */
+      priv->has_clip_bounds = FALSE;
+      if (simple_data->clip_path_commands)
+	{
+	  goo_canvas_create_path (simple_data->clip_path_commands, cr);
+	  cairo_fill_extents (cr, &priv->clip_bounds.x1, &priv->clip_bounds.y1,
+			      &priv->clip_bounds.x2, &priv->clip_bounds.y2);
+	  cairo_new_path (cr);
+	  goo_canvas_item_simple_user_bounds_to_device (simple, cr,
+							&priv->clip_bounds);
+	  priv->has_clip_bounds = TRUE;
+	}
+
+      if (priv->width > 0.0 && priv->height > 0.0)
+	{
+	  clip_bounds.x1 = clip_bounds.y1 = 0.0;
+	  clip_bounds.x2 = priv->width;
+	  clip_bounds.y2 = priv->height;
+	  goo_canvas_item_simple_user_bounds_to_device (simple, cr,
+							&clip_bounds);
+	  if (priv->has_clip_bounds)
+	    {
+	      priv->clip_bounds.x1 = MAX (priv->clip_bounds.x1, clip_bounds.x1);
+	      priv->clip_bounds.y1 = MAX (priv->clip_bounds.y1, clip_bounds.y1);
+	      priv->clip_bounds.x2 = MIN (priv->clip_bounds.x2, clip_bounds.x2);
+	      priv->clip_bounds.y2 = MIN (priv->clip_bounds.y2, clip_bounds.y2);
+	    }
+	  else
+	    priv->clip_bounds = clip_bounds;
+	  priv->has_clip_bounds = TRUE;
+	}
+
       for (i = 0; i < group->items->len; i++)
         {
           GooCanvasItem *child = group->items->pdata[i];
@@ -737,6 +799,7 @@ goo_canvas_group_paint (GooCanvasItem         *item,
   GooCanvasItemSimpleData *simple_data = simple->simple_data;
   GooCanvasGroup *group = (GooCanvasGroup*) item;
   GooCanvasGroupPrivate *priv = goo_canvas_group_get_private (group);
+  GooCanvasBounds clip_bounds;
   gint i;
 
   /* Skip the item if the bounds don't intersect the expose rectangle. */
@@ -750,6 +813,19 @@ goo_canvas_group_paint (GooCanvasItem         *item,
 	  && simple->canvas->scale < simple_data->visibility_threshold))
     return;
 
+  /* The children outside the clip area are skipped like those outside the
+     expose rectangle, e.g. the scrolled away part of a list. */
+  if (priv->has_clip_bounds)
+    {
+      clip_bounds.x1 = MAX (bounds->x1, priv->clip_bounds.x1);
+      clip_bounds.y1 = MAX (bounds->y1, priv->clip_bounds.y1);
+      clip_bounds.x2 = MIN (bounds->x2, priv->clip_bounds.x2);
+      clip_bounds.y2 = MIN (bounds->y2, priv->clip_bounds.y2);
+      if (clip_bounds.x1 > clip_bounds.x2 || clip_bounds.y1 > clip_bounds.y2)
+	return;
+      bounds = &clip_bounds;
+    }
+
   /* Paint all the items in the group. */
   cairo_save (cr);
   if (simple_data->transform)
@@ -774,7 +850,8 @@ goo_canvas_group_paint (GooCanvasItem         *item,
   for (i = 0; i < group->items->len; i++)
     {
       GooCanvasItem *child = group->items->pdata[i];
-      goo_canvas_item_paint (child, cr, bounds, scale);
+      if (goo_canvas_paint_child_filter (simple->canvas, child))
+	goo_canvas_item_paint (child, cr, bounds, scale);
     }
   cairo_restore (cr);
 }
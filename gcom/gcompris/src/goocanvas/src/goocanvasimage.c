@@ -372,6 +372,9 @@ goo_canvas_image_paint (GooCanvasItemSimple   *simple,
   GooCanvasImage *image = (GooCanvasImage*) simple;
   GooCanvasImageData *image_data = image->image_data;
   cairo_matrix_t matrix;
+  cairo_pattern_t *pattern;
+  cairo_surface_t *surface;
+  gboolean locked = FALSE;
 
   if (!image_data->pattern)
     return;
@@ -379,18 +382,39 @@ goo_canvas_image_paint (GooCanvasItemSimple   *simple,
   gdouble sx = image_data->width_ref / image_data->width;
   gdouble sy = image_data->height_ref / image_data->height;
 #if 1
+  /* Set the matrix on a pattern of our own, so that the render threads can
+     paint the image at once. Other patterns are shared, one at a time. */
+  if (cairo_pattern_get_surface (image_data->pattern, &surface)
+      == CAIRO_STATUS_SUCCESS)
+    {
+      pattern = cairo_pattern_create_for_surface (surface);
+      cairo_pattern_set_extend (pattern,
+				cairo_pattern_get_extend (image_data->pattern));
+      cairo_pattern_set_filter (pattern,
+				cairo_pattern_get_filter (image_data->pattern));
+    }
+  else
+    {
+      locked = goo_canvas_paint_lock (NULL);
+      pattern = cairo_pattern_reference (image_data->pattern);
+    }
+
   cairo_matrix_init_translate (&matrix,
 			       -image_data->x * sx,
 			       -image_data->y * sy);
   cairo_matrix_scale(&matrix,
 		     sx,
 		     sy);
-  cairo_pattern_set_matrix (image_data->pattern, &matrix);
+  cairo_pattern_set_matrix (pattern, &matrix);
   goo_canvas_style_set_fill_options (simple->simple_data->style, cr);
-  cairo_set_source (cr, image_data->pattern);
+  cairo_set_source (cr, pattern);
   cairo_rectangle (cr, image_data->x, image_data->y,
 		   image_data->width, image_data->height);
   cairo_fill (cr);
+
+  cairo_pattern_destroy (pattern);
+  if (locked)
+    goo_canvas_paint_unlock ();
 #else
   /* Using cairo_paint() used to be much slower than cairo_fill(), though
      they seem similar now. I'm not sure if it matters which we use. */
@@ -454,6 +478,8 @@ goo_canvas_image_class_init (GooCanvasImageClass *klass)
   simple_class->simple_paint       = goo_canvas_image_paint;
   simple_class->simple_is_item_at  = goo_canvas_image_is_item_at;
 
+  goo_canvas_register_thread_safe_paint (goo_canvas_image_paint);
+
   goo_canvas_image_install_common_properties (gobject_class);
 }
 
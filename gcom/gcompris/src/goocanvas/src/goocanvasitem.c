@@ -1713,8 +1713,12 @@ goo_canvas_item_paint (GooCanvasItem         *item,
 		       gdouble                scale)
 {
   GooCanvasItemIface *iface = GOO_CANVAS_ITEM_GET_IFACE (item);
+  gboolean locked;
 
+  locked = goo_canvas_paint_lock (iface->paint);
   iface->paint (item, cr, bounds, scale);
+  if (locked)
+    goo_canvas_paint_unlock ();
 }
 
 
@@ -85,6 +85,57 @@ enum {
 
 static gboolean accessibility_enabled = FALSE;
 
+extern guint _goo_canvas_style_get_serial (GooCanvasStyle *style);
+
+
+/* The paths built by create_path() are kept in user space, along with the
+   linear part of the matrix they were built with, since cairo picks the
+   number of segments of arcs from it. Updating and painting use different
+   matrices, so a couple of them are kept. */
+#define GOO_CANVAS_N_CACHED_PATHS 2
+
+typedef struct _GooCanvasCachedPath GooCanvasCachedPath;
+struct _GooCanvasCachedPath
+{
+  gdouble xx, yx, xy, yy;
+  cairo_path_t *path;
+};
+
+typedef struct _GooCanvasPathCache GooCanvasPathCache;
+struct _GooCanvasPathCache
+{
+  GooCanvasCachedPath paths[GOO_CANVAS_N_CACHED_PATHS];
+  gint next;
+};
+
+/* Held while a cache is used, since the render threads may paint the same
+   item at once. */
+static GStaticMutex path_cache_mutex = G_STATIC_MUTEX_INIT;
+
+typedef struct _GooCanvasItemSimplePrivate GooCanvasItemSimplePrivate;
+struct _GooCanvasItemSimplePrivate
+{
+  GooCanvasPathCache path;
+  GooCanvasPathCache clip_path;
+
+  /* The user space bounds of the path, for the style serial and the default
+     line width they were computed with. */
+  GooCanvasBounds user_bounds;
+  guint user_bounds_style_serial;
+  gdouble user_bounds_line_width;
+  gboolean user_bounds_valid;
+
+  /* Set while the item is kept by the current batch of its canvas, and if
+     it has to be redrawn when the batch ends. */
+  guint in_batch : 1;
+  guint batch_redraw : 1;
+
+  /* Set if the update of the children was deferred, and while the item is
+     kept by its canvas for that. */
+  guint update_deferred : 1;
+  guint in_deferred_items : 1;
+};
+
 static void canvas_item_interface_init          (GooCanvasItemIface   *iface);
 static void goo_canvas_item_simple_dispose      (GObject              *object);
 static void goo_canvas_item_simple_finalize     (GObject              *object);
@@ -96,6 +147,7 @@ static void goo_canvas_item_simple_set_property (GObject              *object,
 						 guint                 prop_id,
 						 const GValue         *value,
 						 GParamSpec           *pspec);
+static void goo_canvas_item_simple_request_deferred_update (GooCanvasItemSimple *item);
 
 static void     goo_canvas_item_simple_default_create_path (GooCanvasItemSimple   *simple,
 							    cairo_t               *cr);
@@ -104,6 +156,10 @@ static void     goo_canvas_item_simple_default_update      (GooCanvasItemSimple
 static void     goo_canvas_item_simple_default_paint       (GooCanvasItemSimple   *simple,
 							    cairo_t               *cr,
 							    const GooCanvasBounds *bounds);
+static void     goo_canvas_item_simple_paint               (GooCanvasItem         *item,
+							    cairo_t               *cr,
+							    const GooCanvasBounds *bounds,
+							    gdouble                scale);
 static gboolean goo_canvas_item_simple_default_is_item_at  (GooCanvasItemSimple   *simple,
 							    double                 x,
 							    double                 y,
@@ -351,6 +407,9 @@ goo_canvas_item_simple_class_init (GooCanvasItemSimpleClass *klass)
   klass->simple_update      = goo_canvas_item_simple_default_update;
   klass->simple_paint       = goo_canvas_item_simple_default_paint;
   klass->simple_is_item_at  = goo_canvas_item_simple_default_is_item_at;
+
+  goo_canvas_register_thread_safe_paint (goo_canvas_item_simple_paint);
+  goo_canvas_register_thread_safe_paint (goo_canvas_item_simple_default_paint);
 }
 
 
@@ -366,6 +425,105 @@ goo_canvas_item_simple_init (GooCanvasItemSimple *item)
   item->simple_data->clip_fill_rule = CAIRO_FILL_RULE_WINDING;
   item->need_update = TRUE;
   item->need_entire_subtree_update = TRUE;
+  item->priv = g_slice_new0 (GooCanvasItemSimplePrivate);
+}
+
+
+static void
+goo_canvas_path_cache_clear (GooCanvasPathCache *cache)
+{
+  gint i;
+
+  for (i = 0; i < GOO_CANVAS_N_CACHED_PATHS; i++)
+    {
+      if (cache->paths[i].path)
+	{
+	  cairo_path_destroy (cache->paths[i].path);
+	  cache->paths[i].path = NULL;
+	}
+    }
+}
+
+
+/* Sets the current path from the cache, building and caching it with
+   create_path() or the clip path commands if needed. */
+static void
+goo_canvas_path_cache_append (GooCanvasPathCache  *cache,
+			      GooCanvasItemSimple *simple,
+			      gboolean             clip_path,
+			      cairo_t             *cr)
+{
+  GooCanvasItemSimpleClass *class = GOO_CANVAS_ITEM_SIMPLE_GET_CLASS (simple);
+  GooCanvasCachedPath *cached;
+  cairo_matrix_t matrix;
+  cairo_path_t *path;
+  gint i;
+
+  cairo_get_matrix (cr, &matrix);
+
+  g_static_mutex_lock (&path_cache_mutex);
+
+  for (i = 0; i < GOO_CANVAS_N_CACHED_PATHS; i++)
+    {
+      cached = &cache->paths[i];
+      if (cached->path && cached->xx == matrix.xx && cached->yx == matrix.yx
+	  && cached->xy == matrix.xy && cached->yy == matrix.yy)
+	{
+	  cairo_new_path (cr);
+	  cairo_append_path (cr, cached->path);
+	  g_static_mutex_unlock (&path_cache_mutex);
+	  return;
+	}
+    }
+
+  if (clip_path)
+    goo_canvas_create_path (simple->simple_data->clip_path_commands, cr);
+  else
+    class->simple_create_path (simple, cr);
+
+  path = cairo_copy_path (cr);
+  if (path->status != CAIRO_STATUS_SUCCESS)
+    {
+      cairo_path_destroy (path);
+      g_static_mutex_unlock (&path_cache_mutex);
+      return;
+    }
+
+  cached = &cache->paths[cache->next];
+  cache->next = (cache->next + 1) % GOO_CANVAS_N_CACHED_PATHS;
+
+  if (cached->path)
+    cairo_path_destroy (cached->path);
+  cached->path = path;
+  cached->xx = matrix.xx;
+  cached->yx = matrix.yx;
+  cached->xy = matrix.xy;
+  cached->yy = matrix.yy;
+
+  g_static_mutex_unlock (&path_cache_mutex);
+}
+
+
+/* Drops the cached paths and bounds, when the geometry of the item may have
+   changed. */
+static void
+goo_canvas_item_simple_clear_cache (GooCanvasItemSimple *simple)
+{
+  GooCanvasItemSimplePrivate *priv = simple->priv;
+
+  goo_canvas_path_cache_clear (&priv->path);
+  goo_canvas_path_cache_clear (&priv->clip_path);
+  priv->user_bounds_valid = FALSE;
+}
+
+
+/* Sets the item's clip path as the current path. */
+static void
+goo_canvas_item_simple_create_clip_path (GooCanvasItemSimple *simple,
+					 cairo_t             *cr)
+{
+  goo_canvas_path_cache_append (&((GooCanvasItemSimplePrivate*) simple->priv)->clip_path,
+				simple, TRUE, cr);
 }
 
 
@@ -419,6 +577,7 @@ goo_canvas_item_simple_dispose (GObject *object)
 
   goo_canvas_item_simple_reset_model (simple);
   goo_canvas_item_simple_free_data (simple->simple_data);
+  goo_canvas_item_simple_clear_cache (simple);
 
   G_OBJECT_CLASS (goo_canvas_item_simple_parent_class)->dispose (object);
 }
@@ -432,6 +591,10 @@ goo_canvas_item_simple_finalize (GObject *object)
   g_slice_free (GooCanvasItemSimpleData, simple->simple_data);
   simple->simple_data = NULL;
 
+  goo_canvas_item_simple_clear_cache (simple);
+  g_slice_free (GooCanvasItemSimplePrivate, simple->priv);
+  simple->priv = NULL;
+
   G_OBJECT_CLASS (goo_canvas_item_simple_parent_class)->finalize (object);
 }
 
@@ -855,9 +1018,36 @@ goo_canvas_item_simple_changed    (GooCanvasItemSimple *item,
 {
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
   GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  GooCanvasItemSimplePrivate *priv = item->priv;
+
+  /* The children may be shown now, so they are updated. */
+  if (priv->update_deferred)
+    goo_canvas_item_simple_request_deferred_update (item);
+
+  if (item->canvas && goo_canvas_is_in_batch (item->canvas))
+    {
+      /* The redraw and the retained surface wait for the end of the batch.
+	 The update is still requested, so the bounds can be read before. */
+      if (!priv->in_batch)
+	{
+	  priv->in_batch = TRUE;
+	  goo_canvas_add_batch_item (item->canvas, item);
+	}
+
+      if (!recompute_bounds)
+	{
+	  priv->batch_redraw = TRUE;
+	  return;
+	}
+    }
+  else if (item->canvas)
+    goo_canvas_invalidate_retained_item (item->canvas, (GooCanvasItem*) item,
+					 TRUE);
 
   if (recompute_bounds)
     {
+      goo_canvas_item_simple_clear_cache (item);
+
       item->need_entire_subtree_update = TRUE;
       if (!item->need_update)
 	{
@@ -876,6 +1066,106 @@ goo_canvas_item_simple_changed    (GooCanvasItemSimple *item,
 }
 
 
+/*
+ * goo_canvas_item_simple_end_batch:
+ * @item: a #GooCanvasItemSimple changed in a batch.
+ *
+ * Does what goo_canvas_item_simple_changed() left for the end of the batch.
+ */
+void
+goo_canvas_item_simple_end_batch (GooCanvasItemSimple *item)
+{
+  GooCanvasItemSimplePrivate *priv = item->priv;
+  gboolean redraw = priv->batch_redraw;
+
+  priv->in_batch = FALSE;
+  priv->batch_redraw = FALSE;
+
+  if (!item->canvas)
+    return;
+
+  goo_canvas_invalidate_retained_item (item->canvas, (GooCanvasItem*) item,
+				       TRUE);
+
+  /* The update redraws the item anyway. */
+  if (redraw && !item->need_update)
+    goo_canvas_request_item_redraw (item->canvas, &item->bounds,
+				    item->simple_data->is_static);
+}
+
+
+/*
+ * goo_canvas_item_simple_defer_update:
+ * @item: a #GooCanvasItemSimple which is not painted.
+ *
+ * Used by containers which are not painted, instead of updating their
+ * children. The update of the whole subtree then waits until the item changes
+ * or something else than painting needs the bounds of the items.
+ *
+ * Returns: %TRUE if the update was deferred, the container keeps its bounds.
+ */
+gboolean
+goo_canvas_item_simple_defer_update (GooCanvasItemSimple *item)
+{
+  GooCanvasItemSimplePrivate *priv = item->priv;
+
+  if (!item->canvas || !goo_canvas_may_defer_update (item->canvas))
+    return FALSE;
+
+  priv->update_deferred = TRUE;
+  if (!priv->in_deferred_items)
+    {
+      priv->in_deferred_items = TRUE;
+      goo_canvas_add_deferred_item (item->canvas, item);
+    }
+
+  item->need_update = FALSE;
+  item->need_entire_subtree_update = TRUE;
+
+  return TRUE;
+}
+
+
+/* Requests the update deferred by goo_canvas_item_simple_defer_update(). */
+static void
+goo_canvas_item_simple_request_deferred_update (GooCanvasItemSimple *item)
+{
+  GooCanvasItemSimplePrivate *priv = item->priv;
+
+  priv->update_deferred = FALSE;
+
+  /* need_entire_subtree_update is still set. */
+  if (!item->need_update)
+    goo_canvas_item_request_update ((GooCanvasItem*) item);
+}
+
+
+/*
+ * goo_canvas_item_simple_end_deferred_update:
+ * @item: a #GooCanvasItemSimple kept by its canvas.
+ * @update: if the update deferred by the item should be requested.
+ *
+ * Called by the canvas when it releases an item added with
+ * goo_canvas_add_deferred_item().
+ */
+void
+goo_canvas_item_simple_end_deferred_update (GooCanvasItemSimple *item,
+					    gboolean             update)
+{
+  GooCanvasItemSimplePrivate *priv = item->priv;
+
+  priv->in_deferred_items = FALSE;
+
+  if (priv->update_deferred)
+    {
+      if (update)
+	goo_canvas_item_simple_request_deferred_update (item);
+      else
+	priv->update_deferred = FALSE;
+    }
+}
+
+
 static gboolean
 goo_canvas_item_simple_get_transform (GooCanvasItem       *item,
 				      cairo_matrix_t      *matrix)
@@ -949,13 +1239,38 @@ goo_canvas_item_simple_set_style (GooCanvasItem  *item,
 }
 
 
+/* Returns TRUE if the item or one of its ancestors deferred its update, so
+   the bounds of the item may be out of date. */
+static gboolean
+goo_canvas_item_simple_is_deferred (GooCanvasItemSimple *simple)
+{
+  GooCanvasItem *item = (GooCanvasItem*) simple;
+  GooCanvasItemSimplePrivate *priv;
+
+  if (!simple->canvas || !goo_canvas_has_deferred_items (simple->canvas))
+    return FALSE;
+
+  for (; item; item = goo_canvas_item_get_parent (item))
+    {
+      if (!GOO_IS_CANVAS_ITEM_SIMPLE (item))
+	continue;
+
+      priv = ((GooCanvasItemSimple*) item)->priv;
+      if (priv->update_deferred)
+	return TRUE;
+    }
+
+  return FALSE;
+}
+
+
 static void
 goo_canvas_item_simple_get_bounds  (GooCanvasItem   *item,
 				    GooCanvasBounds *bounds)
 {
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
 
-  if (simple->need_update)
+  if (simple->need_update || goo_canvas_item_simple_is_deferred (simple))
     goo_canvas_item_ensure_updated (item);
     
   *bounds = simple->bounds;
@@ -1013,7 +1328,7 @@ goo_canvas_item_simple_get_items_at (GooCanvasItem  *item,
   /* If the item has a clip path, check if the point is inside it. */
   if (simple_data->clip_path_commands)
     {
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
+      goo_canvas_item_simple_create_clip_path (simple, cr);
       cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
       if (!cairo_in_fill (cr, user_x, user_y))
 	{
@@ -1041,8 +1356,6 @@ goo_canvas_item_simple_default_is_item_at (GooCanvasItemSimple *simple,
 					   cairo_t             *cr,
 					   gboolean             is_pointer_event)
 {
-  GooCanvasItemSimpleClass *class = GOO_CANVAS_ITEM_SIMPLE_GET_CLASS (simple);
-
   GooCanvasItemSimpleData *simple_data = simple->simple_data;
   GooCanvasPointerEvents pointer_events = GOO_CANVAS_EVENTS_ALL;
 
@@ -1050,7 +1363,7 @@ goo_canvas_item_simple_default_is_item_at (GooCanvasItemSimple *simple,
     pointer_events = simple_data->pointer_events;
 
   /* Use the virtual method subclasses define to create the path. */
-  class->simple_create_path (simple, cr);
+  goo_canvas_item_simple_create_path (simple, cr);
 
   if (goo_canvas_item_simple_check_in_path (simple, x, y, cr, pointer_events))
     return TRUE;
@@ -1158,7 +1471,7 @@ goo_canvas_item_simple_update_internal  (GooCanvasItemSimple *simple,
   if (simple_data->clip_path_commands)
     {
       cairo_identity_matrix (cr);
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
+      goo_canvas_item_simple_create_clip_path (simple, cr);
       cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
       cairo_fill_extents (cr, &tmp_bounds.x1, &tmp_bounds.y1,
 			  &tmp_bounds.x2, &tmp_bounds.y2);
@@ -1181,13 +1494,32 @@ static void
 goo_canvas_item_simple_default_update (GooCanvasItemSimple   *simple,
 				       cairo_t               *cr)
 {
-  GooCanvasItemSimpleClass *class = GOO_CANVAS_ITEM_SIMPLE_GET_CLASS (simple);
+  GooCanvasItemSimplePrivate *priv = simple->priv;
+  guint style_serial;
+  gdouble line_width;
 
   /* Use the identity matrix to get the bounds completely in user space. */
   cairo_identity_matrix (cr);
 
-  class->simple_create_path (simple, cr);
+  /* The bounds only change with the path, the style and the default line
+     width, which is set in the cairo context. */
+  style_serial = _goo_canvas_style_get_serial (simple->simple_data->style);
+  line_width = cairo_get_line_width (cr);
+  if (priv->user_bounds_valid
+      && priv->user_bounds_style_serial == style_serial
+      && priv->user_bounds_line_width == line_width)
+    {
+      simple->bounds = priv->user_bounds;
+      return;
+    }
+
+  goo_canvas_item_simple_create_path (simple, cr);
   goo_canvas_item_simple_get_path_bounds (simple, cr, &simple->bounds);
+
+  priv->user_bounds = simple->bounds;
+  priv->user_bounds_style_serial = style_serial;
+  priv->user_bounds_line_width = line_width;
+  priv->user_bounds_valid = TRUE;
 }
 
 
@@ -1343,6 +1675,7 @@ goo_canvas_item_simple_paint (GooCanvasItem         *item,
   GooCanvasItemSimpleClass *class = GOO_CANVAS_ITEM_SIMPLE_GET_CLASS (item);
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
   GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  gboolean locked;
 
   /* Skip the item if the bounds don't intersect the expose rectangle. */
   if (simple->bounds.x1 > bounds->x2 || simple->bounds.x2 < bounds->x1
@@ -1362,12 +1695,15 @@ goo_canvas_item_simple_paint (GooCanvasItem         *item,
   /* Clip with the item's clip path, if it is set. */
   if (simple_data->clip_path_commands)
     {
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
+      goo_canvas_item_simple_create_clip_path (simple, cr);
       cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
       cairo_clip (cr);
     }
 
+  locked = goo_canvas_paint_lock (class->simple_paint);
   class->simple_paint (simple, cr, bounds);
+  if (locked)
+    goo_canvas_paint_unlock ();
 
   cairo_restore (cr);
 }
@@ -1378,9 +1714,7 @@ goo_canvas_item_simple_default_paint (GooCanvasItemSimple   *simple,
 				      cairo_t               *cr,
 				      const GooCanvasBounds *bounds)
 {
-  GooCanvasItemSimpleClass *class = GOO_CANVAS_ITEM_SIMPLE_GET_CLASS (simple);
-
-  class->simple_create_path (simple, cr);
+  goo_canvas_item_simple_create_path (simple, cr);
   goo_canvas_item_simple_paint_path (simple, cr);
 }
 
@@ -1479,6 +1813,8 @@ goo_canvas_item_simple_set_model (GooCanvasItemSimple  *item,
   item->model = g_object_ref (model);
   item->simple_data = &item->model->simple_data;
 
+  goo_canvas_item_simple_clear_cache (item);
+
   if (accessibility_enabled)
     goo_canvas_item_simple_setup_accessibility (item);
 
@@ -1546,6 +1882,26 @@ canvas_item_interface_init (GooCanvasItemIface *iface)
 }
 
 
+/**
+ * goo_canvas_item_simple_create_path:
+ * @item: a #GooCanvasItemSimple.
+ * @cr: a cairo context.
+ * 
+ * This function is intended to be used by subclasses of #GooCanvasItemSimple.
+ *
+ * It sets the item's path as the current path. The path is built with the
+ * create_path() method and cached until goo_canvas_item_simple_changed() is
+ * called with @recompute_bounds set.
+ **/
+void
+goo_canvas_item_simple_create_path (GooCanvasItemSimple *item,
+				    cairo_t             *cr)
+{
+  goo_canvas_path_cache_append (&((GooCanvasItemSimplePrivate*) item->priv)->path,
+				item, FALSE, cr);
+}
+
+
 /**
  * goo_canvas_item_simple_paint_path:
  * @item: a #GooCanvasItemSimple.
@@ -106,7 +106,7 @@ struct _GooCanvasItemSimple
   guint need_entire_subtree_update      : 1;
 
   /* <private> */
-  /* We might use this in future for things like a cache. */
+  /* The cached paths and bounds. */
   gpointer priv;
 };
 
@@ -172,6 +172,8 @@ void     goo_canvas_item_simple_user_bounds_to_device	(GooCanvasItemSimple	*item
 void     goo_canvas_item_simple_user_bounds_to_parent	(GooCanvasItemSimple	*item,
 							 cairo_t		*cr,
 							 GooCanvasBounds	*bounds);
+void     goo_canvas_item_simple_create_path		(GooCanvasItemSimple	*item,
+							 cairo_t		*cr);
 gboolean goo_canvas_item_simple_check_in_path		(GooCanvasItemSimple	*item,
 							 gdouble		 x,
 							 gdouble		 y,
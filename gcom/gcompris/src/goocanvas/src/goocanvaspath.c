@@ -545,7 +545,7 @@ goo_canvas_path_is_item_at (GooCanvasItemSimple *simple,
   if (is_pointer_event)
     pointer_events = simple_data->pointer_events;
 
-  goo_canvas_path_create_path (simple, cr);
+  goo_canvas_item_simple_create_path (simple, cr);
   if (goo_canvas_item_simple_check_in_path (simple, x, y, cr, pointer_events))
     return TRUE;
 
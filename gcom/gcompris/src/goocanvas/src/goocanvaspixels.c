@@ -0,0 +1,308 @@
+/*
+ * GooCanvas. Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvaspixels.c - converts pixbuf rows to cairo image surface rows.
+ *
+ * GdkPixbuf rows are R, G, B[, A] bytes, with non premultiplied alpha. Cairo
+ * wants native endian 32 bit pixels, with premultiplied alpha for
+ * CAIRO_FORMAT_ARGB32. The premultiplication is
+ *
+ *   t = c * a;  c' = ((t >> 8) + t) >> 8
+ *
+ * and all the versions below give exactly the same pixels.
+ *
+ * The SSE2 and AVX2 versions are picked at run time on x86, when the compiler
+ * supports the target attribute, otherwise SSE2 is used if it is enabled at
+ * build time. The NEON version is used if it is enabled at build time.
+ */
+#include <config.h>
+#include <gtk/gtk.h>
+#include "goocanvas.h"
+#include "goocanvasprivate.h"
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#if (defined (__i386__) || defined (__x86_64__)) && defined (__GNUC__) \
+  && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define GOO_CANVAS_PIXELS_X86_DISPATCH 1
+#define GOO_CANVAS_PIXELS_SSE2 1
+#define GOO_CANVAS_PIXELS_AVX2 1
+#define GOO_CANVAS_TARGET(isa) __attribute__ ((target (isa)))
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#define GOO_CANVAS_PIXELS_SSE2 1
+#define GOO_CANVAS_TARGET(isa)
+#include <emmintrin.h>
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+#define GOO_CANVAS_PIXELS_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+typedef void (*GooCanvasPixelsFunc) (guint32      *dest,
+				     const guchar *src,
+				     gint          n_pixels);
+
+
+static void
+premultiply_rgba_c (guint32      *dest,
+		    const guchar *src,
+		    gint          n_pixels)
+{
+  const guchar *end = src + 4 * n_pixels;
+  guint t1, t2, t3;
+
+#define MULT(d,c,a,t) G_STMT_START { t = c * a; d = ((t >> 8) + t) >> 8; } G_STMT_END
+
+  while (src < end)
+    {
+      guint r, g, b;
+
+      MULT (r, src[0], src[3], t1);
+      MULT (g, src[1], src[3], t2);
+      MULT (b, src[2], src[3], t3);
+      *dest++ = ((guint32) src[3] << 24) | (r << 16) | (g << 8) | b;
+      src += 4;
+    }
+
+#undef MULT
+}
+
+
+static void
+convert_rgb_c (guint32      *dest,
+	       const guchar *src,
+	       gint          n_pixels)
+{
+  const guchar *end = src + 3 * n_pixels;
+
+  /* The alpha byte is ignored by CAIRO_FORMAT_RGB24. */
+  while (src < end)
+    {
+      *dest++ = 0xff000000 | (src[0] << 16) | (src[1] << 8) | src[2];
+      src += 3;
+    }
+}
+
+
+#ifdef GOO_CANVAS_PIXELS_SSE2
+/* Premultiplies 2 pixels, unpacked to 16 bits per channel, and swaps R and
+   B. The alpha channel is kept as is. */
+GOO_CANVAS_TARGET ("sse2") static inline __m128i
+premultiply_2_sse2 (__m128i pixels,
+		    __m128i alpha_mask)
+{
+  __m128i alpha, t;
+
+  pixels = _mm_shufflelo_epi16 (pixels, _MM_SHUFFLE (3, 0, 1, 2));
+  pixels = _mm_shufflehi_epi16 (pixels, _MM_SHUFFLE (3, 0, 1, 2));
+  alpha = _mm_shufflelo_epi16 (pixels, _MM_SHUFFLE (3, 3, 3, 3));
+  alpha = _mm_shufflehi_epi16 (alpha, _MM_SHUFFLE (3, 3, 3, 3));
+
+  /* t fits in 16 bits: 255 * 255 + 254 < 65536. */
+  t = _mm_mullo_epi16 (pixels, alpha);
+  t = _mm_srli_epi16 (_mm_add_epi16 (t, _mm_srli_epi16 (t, 8)), 8);
+
+  return _mm_or_si128 (_mm_andnot_si128 (alpha_mask, t),
+		       _mm_and_si128 (alpha_mask, pixels));
+}
+
+
+GOO_CANVAS_TARGET ("sse2") static void
+premultiply_rgba_sse2 (guint32      *dest,
+		       const guchar *src,
+		       gint          n_pixels)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i alpha_mask = _mm_set_epi16 (-1, 0, 0, 0, -1, 0, 0, 0);
+  gint i;
+
+  for (i = 0; i + 4 <= n_pixels; i += 4)
+    {
+      __m128i pixels = _mm_loadu_si128 ((const __m128i*) (src + 4 * i));
+      __m128i lo = premultiply_2_sse2 (_mm_unpacklo_epi8 (pixels, zero),
+				       alpha_mask);
+      __m128i hi = premultiply_2_sse2 (_mm_unpackhi_epi8 (pixels, zero),
+				       alpha_mask);
+
+      _mm_storeu_si128 ((__m128i*) (dest + i), _mm_packus_epi16 (lo, hi));
+    }
+
+  premultiply_rgba_c (dest + i, src + 4 * i, n_pixels - i);
+}
+#endif /* GOO_CANVAS_PIXELS_SSE2 */
+
+
+#ifdef GOO_CANVAS_PIXELS_AVX2
+/* The same as premultiply_2_sse2(), on 4 pixels. The AVX2 instructions work
+   on each 128 bit half, as SSE2 does. */
+GOO_CANVAS_TARGET ("avx2") static inline __m256i
+premultiply_4_avx2 (__m256i pixels,
+		    __m256i alpha_mask)
+{
+  __m256i alpha, t;
+
+  pixels = _mm256_shufflelo_epi16 (pixels, _MM_SHUFFLE (3, 0, 1, 2));
+  pixels = _mm256_shufflehi_epi16 (pixels, _MM_SHUFFLE (3, 0, 1, 2));
+  alpha = _mm256_shufflelo_epi16 (pixels, _MM_SHUFFLE (3, 3, 3, 3));
+  alpha = _mm256_shufflehi_epi16 (alpha, _MM_SHUFFLE (3, 3, 3, 3));
+
+  t = _mm256_mullo_epi16 (pixels, alpha);
+  t = _mm256_srli_epi16 (_mm256_add_epi16 (t, _mm256_srli_epi16 (t, 8)), 8);
+
+  return _mm256_blendv_epi8 (t, pixels, alpha_mask);
+}
+
+
+GOO_CANVAS_TARGET ("avx2") static void
+premultiply_rgba_avx2 (guint32      *dest,
+		       const guchar *src,
+		       gint          n_pixels)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i alpha_mask = _mm256_set_epi16 (-1, 0, 0, 0, -1, 0, 0, 0,
+					       -1, 0, 0, 0, -1, 0, 0, 0);
+  gint i;
+
+  for (i = 0; i + 8 <= n_pixels; i += 8)
+    {
+      __m256i pixels = _mm256_loadu_si256 ((const __m256i*) (src + 4 * i));
+      __m256i lo = premultiply_4_avx2 (_mm256_unpacklo_epi8 (pixels, zero),
+				       alpha_mask);
+      __m256i hi = premultiply_4_avx2 (_mm256_unpackhi_epi8 (pixels, zero),
+				       alpha_mask);
+
+      _mm256_storeu_si256 ((__m256i*) (dest + i),
+			   _mm256_packus_epi16 (lo, hi));
+    }
+
+  premultiply_rgba_c (dest + i, src + 4 * i, n_pixels - i);
+}
+#endif /* GOO_CANVAS_PIXELS_AVX2 */
+
+
+#ifdef GOO_CANVAS_PIXELS_NEON
+static void
+premultiply_rgba_neon (guint32      *dest,
+		       const guchar *src,
+		       gint          n_pixels)
+{
+  gint i;
+
+  for (i = 0; i + 8 <= n_pixels; i += 8)
+    {
+      uint8x8x4_t rgba = vld4_u8 (src + 4 * i);
+      uint8x8x4_t bgra;
+      uint16x8_t t;
+
+#define MULT(d,c) G_STMT_START {					\
+	t = vmull_u8 (c, rgba.val[3]);					\
+	d = vshrn_n_u16 (vaddq_u16 (t, vshrq_n_u16 (t, 8)), 8);	\
+      } G_STMT_END
+
+      MULT (bgra.val[0], rgba.val[2]);
+      MULT (bgra.val[1], rgba.val[1]);
+      MULT (bgra.val[2], rgba.val[0]);
+      bgra.val[3] = rgba.val[3];
+
+#undef MULT
+
+      vst4_u8 ((guchar*) (dest + i), bgra);
+    }
+
+  premultiply_rgba_c (dest + i, src + 4 * i, n_pixels - i);
+}
+
+
+static void
+convert_rgb_neon (guint32      *dest,
+		  const guchar *src,
+		  gint          n_pixels)
+{
+  gint i;
+
+  for (i = 0; i + 8 <= n_pixels; i += 8)
+    {
+      uint8x8x3_t rgb = vld3_u8 (src + 3 * i);
+      uint8x8x4_t bgra;
+
+      bgra.val[0] = rgb.val[2];
+      bgra.val[1] = rgb.val[1];
+      bgra.val[2] = rgb.val[0];
+      bgra.val[3] = vdup_n_u8 (0xff);
+      vst4_u8 ((guchar*) (dest + i), bgra);
+    }
+
+  convert_rgb_c (dest + i, src + 3 * i, n_pixels - i);
+}
+#endif /* GOO_CANVAS_PIXELS_NEON */
+
+
+static GooCanvasPixelsFunc premultiply_rgba_func = NULL;
+static GooCanvasPixelsFunc convert_rgb_func = NULL;
+
+static void
+goo_canvas_pixels_init (void)
+{
+  GooCanvasPixelsFunc premultiply_rgba = premultiply_rgba_c;
+  GooCanvasPixelsFunc convert_rgb = convert_rgb_c;
+
+  /* Set GOO_CANVAS_NO_SIMD to compare with the plain C versions. */
+  if (!g_getenv ("GOO_CANVAS_NO_SIMD"))
+    {
+#if defined (GOO_CANVAS_PIXELS_X86_DISPATCH)
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx2"))
+	premultiply_rgba = premultiply_rgba_avx2;
+      else if (__builtin_cpu_supports ("sse2"))
+	premultiply_rgba = premultiply_rgba_sse2;
+#elif defined (GOO_CANVAS_PIXELS_SSE2)
+      premultiply_rgba = premultiply_rgba_sse2;
+#elif defined (GOO_CANVAS_PIXELS_NEON)
+      premultiply_rgba = premultiply_rgba_neon;
+      convert_rgb = convert_rgb_neon;
+#endif
+    }
+
+  convert_rgb_func = convert_rgb;
+  premultiply_rgba_func = premultiply_rgba;
+}
+
+
+/*
+ * goo_canvas_pixels_from_rgba:
+ * @dest: the pixels of a CAIRO_FORMAT_ARGB32 surface.
+ * @src: the pixels of a GdkPixbuf with an alpha channel.
+ * @n_pixels: the number of pixels to convert.
+ *
+ * Converts a row of pixels, premultiplying them by their alpha.
+ */
+void
+goo_canvas_pixels_from_rgba (guint32      *dest,
+			     const guchar *src,
+			     gint          n_pixels)
+{
+  if (!premultiply_rgba_func)
+    goo_canvas_pixels_init ();
+
+  premultiply_rgba_func (dest, src, n_pixels);
+}
+
+
+/*
+ * goo_canvas_pixels_from_rgb:
+ * @dest: the pixels of a CAIRO_FORMAT_RGB24 surface.
+ * @src: the pixels of a GdkPixbuf without an alpha channel.
+ * @n_pixels: the number of pixels to convert.
+ *
+ * Converts a row of pixels.
+ */
+void
+goo_canvas_pixels_from_rgb (guint32      *dest,
+			    const guchar *src,
+			    gint          n_pixels)
+{
+  if (!premultiply_rgba_func)
+    goo_canvas_pixels_init ();
+
+  convert_rgb_func (dest, src, n_pixels);
+}
@@ -32,6 +32,7 @@
 #include <string.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
+#include "goocanvasprivate.h"
 #include "goocanvaspolyline.h"
 #include "goocanvas.h"
 
@@ -250,6 +251,8 @@ static void
 goo_canvas_polyline_get_extent (GooCanvasPolylineData *polyline_data,
                                 GooCanvasBounds *bounds)
 {
+  const gdouble *coords = polyline_data->coords;
+  gdouble min[2], max[2];
   guint i;
 
   if (polyline_data->num_points == 0)
@@ -258,17 +261,58 @@ goo_canvas_polyline_get_extent (GooCanvasPolylineData *polyline_data,
     }
   else
     {
-      bounds->x1 = bounds->x2 = polyline_data->coords[0];
-      bounds->y1 = bounds->y2 = polyline_data->coords[1];
+      /* The x and y minimums and maximums are kept side by side, like the
+	 coordinates, so the compiler can update both at once with packed
+	 min/max instructions. */
+      min[0] = max[0] = coords[0];
+      min[1] = max[1] = coords[1];
 
-      for (i = 1; i < polyline_data->num_points; i++)
+      for (i = 2; i < polyline_data->num_points * 2; i += 2)
         {
-	  bounds->x1 = MIN (bounds->x1, polyline_data->coords[2 * i]);
-	  bounds->y1 = MIN (bounds->y1, polyline_data->coords[2 * i + 1]);
-	  bounds->x2 = MAX (bounds->x2, polyline_data->coords[2 * i]);
-	  bounds->y2 = MAX (bounds->y2, polyline_data->coords[2 * i + 1]);
+	  min[0] = coords[i] < min[0] ? coords[i] : min[0];
+	  min[1] = coords[i + 1] < min[1] ? coords[i + 1] : min[1];
+	  max[0] = coords[i] > max[0] ? coords[i] : max[0];
+	  max[1] = coords[i + 1] > max[1] ? coords[i + 1] : max[1];
         }
+
+      bounds->x1 = min[0];
+      bounds->y1 = min[1];
+      bounds->x2 = max[0];
+      bounds->y2 = max[1];
+    }
+}
+
+
+/* Copies the coordinates of num_points points, reusing the array when the
+   number of points doesn't change. */
+static void
+goo_canvas_polyline_set_coords_internal (GObject               *object,
+					 GooCanvasPolylineData *polyline_data,
+					 const gdouble         *coords,
+					 gint                   num_points)
+{
+  if (!coords)
+    num_points = 0;
+
+  if (polyline_data->coords && polyline_data->num_points != num_points)
+    {
+      g_slice_free1 (polyline_data->num_points * 2 * sizeof (double), polyline_data->coords);
+      polyline_data->coords = NULL;
+    }
+
+  if (num_points > 0)
+    {
+      if (!polyline_data->coords)
+	polyline_data->coords = g_slice_alloc (num_points * 2 * sizeof (double));
+      memcpy (polyline_data->coords, coords, num_points * 2 * sizeof (double));
     }
+  polyline_data->num_points = num_points;
+
+  polyline_data->reconfigure_arrows = TRUE;
+  g_object_notify (object, "x");
+  g_object_notify (object, "y");
+  g_object_notify (object, "width");
+  g_object_notify (object, "height");
 }
 
 
@@ -514,29 +558,9 @@ goo_canvas_polyline_set_common_property (GObject              *object,
     {
     case PROP_POINTS:
       points = g_value_get_boxed (value);
-
-      if (polyline_data->coords)
-	{
-	  g_slice_free1 (polyline_data->num_points * 2 * sizeof (double), polyline_data->coords);
-	  polyline_data->coords = NULL;
-	}
-
-      if (!points)
-	{
-	  polyline_data->num_points = 0;
-	}
-      else
-	{
-	  polyline_data->num_points = points->num_points;
-	  polyline_data->coords = g_slice_alloc (polyline_data->num_points * 2 * sizeof (double));
-	  memcpy (polyline_data->coords, points->coords,
-		  polyline_data->num_points * 2 * sizeof (double));
-	}
-      polyline_data->reconfigure_arrows = TRUE;
-      g_object_notify (object, "x");
-      g_object_notify (object, "y");
-      g_object_notify (object, "width");
-      g_object_notify (object, "height");
+      goo_canvas_polyline_set_coords_internal (object, polyline_data,
+					       points ? points->coords : NULL,
+					       points ? points->num_points : 0);
       break;
     case PROP_CLOSE_PATH:
       polyline_data->close_path = g_value_get_boolean (value);
@@ -794,6 +818,41 @@ goo_canvas_polyline_new_line          (GooCanvasItem *parent,
 }
 
 
+/**
+ * goo_canvas_polyline_set_coords:
+ * @polyline: a #GooCanvasPolyline.
+ * @coords: the pairs of coordinates of the points, or %NULL.
+ * @num_points: the number of points.
+ * 
+ * Sets all the points of the polyline at once, from an array of coordinates.
+ * This is like setting the "points" property, without creating a
+ * #GooCanvasPoints struct, and the polyline keeps its array of coordinates
+ * if the number of points doesn't change.
+ **/
+void
+goo_canvas_polyline_set_coords (GooCanvasPolyline *polyline,
+				const gdouble     *coords,
+				gint               num_points)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) polyline;
+
+  g_return_if_fail (GOO_IS_CANVAS_POLYLINE (polyline));
+  g_return_if_fail (num_points >= 0);
+
+  if (simple->model)
+    {
+      g_warning ("Can't set property of a canvas item with a model - set the model property instead");
+      return;
+    }
+
+  goo_canvas_polyline_set_coords_internal ((GObject*) polyline,
+					   polyline->polyline_data,
+					   coords, num_points);
+  g_object_notify ((GObject*) polyline, "points");
+  goo_canvas_item_simple_changed (simple, TRUE);
+}
+
+
 static void
 goo_canvas_polyline_create_path (GooCanvasPolyline *polyline,
 				 cairo_t           *cr)
@@ -1096,6 +1155,8 @@ goo_canvas_polyline_class_init (GooCanvasPolylineClass *klass)
   simple_class->simple_paint         = goo_canvas_polyline_paint;
   simple_class->simple_is_item_at    = goo_canvas_polyline_is_item_at;
 
+  goo_canvas_register_thread_safe_paint (goo_canvas_polyline_paint);
+
   goo_canvas_polyline_install_common_properties (gobject_class);
 }
 
@@ -1304,6 +1365,31 @@ goo_canvas_polyline_model_new_line (GooCanvasItemModel *parent,
 }
 
 
+/**
+ * goo_canvas_polyline_model_set_coords:
+ * @pmodel: a #GooCanvasPolylineModel.
+ * @coords: the pairs of coordinates of the points, or %NULL.
+ * @num_points: the number of points.
+ * 
+ * Sets all the points of the polyline model at once, from an array of
+ * coordinates. See goo_canvas_polyline_set_coords().
+ **/
+void
+goo_canvas_polyline_model_set_coords (GooCanvasPolylineModel *pmodel,
+				      const gdouble          *coords,
+				      gint                    num_points)
+{
+  g_return_if_fail (GOO_IS_CANVAS_POLYLINE_MODEL (pmodel));
+  g_return_if_fail (num_points >= 0);
+
+  goo_canvas_polyline_set_coords_internal ((GObject*) pmodel,
+					   &pmodel->polyline_data,
+					   coords, num_points);
+  g_object_notify ((GObject*) pmodel, "points");
+  g_signal_emit_by_name (pmodel, "changed", TRUE);
+}
+
+
 static void
 goo_canvas_polyline_model_finalize (GObject *object)
 {
@@ -118,6 +118,10 @@ GooCanvasItem*      goo_canvas_polyline_new_line       (GooCanvasItem      *pare
 							gdouble             y2,
 							...);
 
+void                goo_canvas_polyline_set_coords     (GooCanvasPolyline  *polyline,
+							const gdouble      *coords,
+							gint                num_points);
+
 
 
 #define GOO_TYPE_CANVAS_POLYLINE_MODEL            (goo_canvas_polyline_model_get_type ())
@@ -171,6 +175,10 @@ GooCanvasItemModel* goo_canvas_polyline_model_new_line (GooCanvasItemModel *pare
 							gdouble             y2,
 							...);
 
+void                goo_canvas_polyline_model_set_coords (GooCanvasPolylineModel *pmodel,
+							  const gdouble          *coords,
+							  gint                    num_points);
+
 G_END_DECLS
 
 #endif /* __GOO_CANVAS_POLYLINE_H__ */
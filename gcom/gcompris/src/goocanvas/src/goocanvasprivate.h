@@ -9,6 +9,8 @@
 
 #include <gtk/gtk.h>
 #include "goocanvasstyle.h"
+#include "goocanvasitem.h"
+#include "goocanvasitemsimple.h"
 
 G_BEGIN_DECLS
 
@@ -31,6 +33,13 @@ gint goo_canvas_util_ptr_array_find_index (GPtrArray *ptr_array,
 cairo_pattern_t* goo_canvas_cairo_pattern_from_pixbuf (GdkPixbuf *pixbuf);
 cairo_surface_t* goo_canvas_cairo_surface_from_pixbuf (GdkPixbuf *pixbuf);
 
+void goo_canvas_pixels_from_rgba (guint32      *dest,
+				  const guchar *src,
+				  gint          n_pixels);
+void goo_canvas_pixels_from_rgb  (guint32      *dest,
+				  const guchar *src,
+				  gint          n_pixels);
+
 guint goo_canvas_convert_colors_to_rgba (double red,
 					 double green,
 					 double blue,
@@ -54,6 +63,31 @@ gboolean goo_canvas_boolean_handled_accumulator (GSignalInvocationHint *ihint,
 						 gpointer               dummy);
 
 
+void     goo_canvas_invalidate_retained_item (GooCanvas     *canvas,
+					      GooCanvasItem *item,
+					      gboolean       check_ancestors);
+
+gboolean goo_canvas_paint_child_filter       (GooCanvas     *canvas,
+					      GooCanvasItem *child);
+
+void     goo_canvas_register_thread_safe_paint (gpointer paint);
+gboolean goo_canvas_paint_lock                 (gpointer paint);
+void     goo_canvas_paint_unlock               (void);
+
+gboolean goo_canvas_is_in_batch                (GooCanvas           *canvas);
+void     goo_canvas_add_batch_item             (GooCanvas           *canvas,
+						GooCanvasItemSimple *item);
+void     goo_canvas_item_simple_end_batch      (GooCanvasItemSimple *item);
+
+gboolean goo_canvas_may_defer_update           (GooCanvas           *canvas);
+void     goo_canvas_add_deferred_item          (GooCanvas           *canvas,
+						GooCanvasItemSimple *item);
+gboolean goo_canvas_has_deferred_items         (GooCanvas           *canvas);
+gboolean goo_canvas_item_simple_defer_update   (GooCanvasItemSimple *item);
+void     goo_canvas_item_simple_end_deferred_update (GooCanvasItemSimple *item,
+						     gboolean             update);
+
+
 G_END_DECLS
 
 #endif /* __GOO_CANVAS_PRIVATE_H__ */
@@ -22,6 +22,7 @@
  * standard style properties to the given cairo_t.
  */
 #include <config.h>
+#include <string.h>
 #include <gtk/gtk.h>
 #include "goocanvasstyle.h"
 #include "goocanvasutils.h"
@@ -115,6 +116,49 @@ GQuark goo_canvas_style_hint_metrics_id;
 static void goo_canvas_style_dispose  (GObject *object);
 static void goo_canvas_style_finalize (GObject *object);
 
+
+/* The standard properties, as resolved through a style and its ancestors. */
+enum {
+  FLAT_STROKE_PATTERN,
+  FLAT_FILL_PATTERN,
+  FLAT_FILL_RULE,
+  FLAT_OPERATOR,
+  FLAT_ANTIALIAS,
+  FLAT_LINE_WIDTH,
+  FLAT_LINE_CAP,
+  FLAT_LINE_JOIN,
+  FLAT_LINE_JOIN_MITER_LIMIT,
+  FLAT_LINE_DASH,
+  FLAT_FONT_DESC,
+  FLAT_HINT_METRICS,
+
+  FLAT_N_PROPERTIES
+};
+
+typedef struct _GooCanvasStyleFlat GooCanvasStyleFlat;
+struct _GooCanvasStyleFlat
+{
+  /* The style generation it was last checked at. */
+  guint generation;
+
+  /* What it was computed from, the style stamp and the parent snapshot. */
+  guint stamp;
+  GooCanvasStyle *parent;
+  guint parent_serial;
+
+  /* Unique for each computation, so children notice a new snapshot. */
+  guint serial;
+
+  /* The values point into the properties of the style or of an ancestor.
+     They stay valid until one of them changes, which bumps the stamps. */
+  GValue *values[FLAT_N_PROPERTIES];
+};
+
+/* Bumped whenever any style changes. While it is unchanged the snapshots
+   are used without checking the ancestors. */
+static guint style_generation = 1;
+static guint flat_serial = 0;
+
 G_DEFINE_TYPE (GooCanvasStyle, goo_canvas_style, G_TYPE_OBJECT)
 
 
@@ -147,6 +191,117 @@ _goo_canvas_style_init (void)
 }
 
 
+static gint
+goo_canvas_style_flat_index (GQuark property_id)
+{
+  if (property_id == goo_canvas_style_stroke_pattern_id)
+    return FLAT_STROKE_PATTERN;
+  if (property_id == goo_canvas_style_fill_pattern_id)
+    return FLAT_FILL_PATTERN;
+  if (property_id == goo_canvas_style_fill_rule_id)
+    return FLAT_FILL_RULE;
+  if (property_id == goo_canvas_style_operator_id)
+    return FLAT_OPERATOR;
+  if (property_id == goo_canvas_style_antialias_id)
+    return FLAT_ANTIALIAS;
+  if (property_id == goo_canvas_style_line_width_id)
+    return FLAT_LINE_WIDTH;
+  if (property_id == goo_canvas_style_line_cap_id)
+    return FLAT_LINE_CAP;
+  if (property_id == goo_canvas_style_line_join_id)
+    return FLAT_LINE_JOIN;
+  if (property_id == goo_canvas_style_line_join_miter_limit_id)
+    return FLAT_LINE_JOIN_MITER_LIMIT;
+  if (property_id == goo_canvas_style_line_dash_id)
+    return FLAT_LINE_DASH;
+  if (property_id == goo_canvas_style_font_desc_id)
+    return FLAT_FONT_DESC;
+  if (property_id == goo_canvas_style_hint_metrics_id)
+    return FLAT_HINT_METRICS;
+  return -1;
+}
+
+
+/* Marks the style as changed, its snapshot and the ones of its descendants
+   are recomputed the next time they are used. */
+static void
+goo_canvas_style_changed (GooCanvasStyle *style)
+{
+  style->stamp++;
+  style_generation++;
+}
+
+
+static GooCanvasStyleFlat*
+goo_canvas_style_flatten_internal (GooCanvasStyle *style)
+{
+  GooCanvasStyleFlat *flat = style->flat, *parent_flat = NULL;
+  GooCanvasStyleProperty *property;
+  gint i, index;
+
+  if (!flat)
+    {
+      flat = style->flat = g_slice_new0 (GooCanvasStyleFlat);
+    }
+  else if (flat->generation == style_generation)
+    {
+      return flat;
+    }
+
+  if (style->parent)
+    parent_flat = goo_canvas_style_flatten_internal (style->parent);
+
+  if (flat->serial == 0
+      || flat->stamp != style->stamp
+      || flat->parent != style->parent
+      || (parent_flat && flat->parent_serial != parent_flat->serial))
+    {
+      if (parent_flat)
+	memcpy (flat->values, parent_flat->values, sizeof (flat->values));
+      else
+	memset (flat->values, 0, sizeof (flat->values));
+
+      /* The style's own settings override the ones of its ancestors. */
+      for (i = 0; i < style->properties->len; i++)
+	{
+	  property = &g_array_index (style->properties, GooCanvasStyleProperty,
+				     i);
+	  index = goo_canvas_style_flat_index (property->id);
+	  if (index >= 0)
+	    flat->values[index] = &property->value;
+	}
+
+      flat->stamp = style->stamp;
+      flat->parent = style->parent;
+      flat->parent_serial = parent_flat ? parent_flat->serial : 0;
+      flat->serial = ++flat_serial;
+    }
+
+  flat->generation = style_generation;
+
+  return flat;
+}
+
+
+/* Returns the standard properties of the style resolved through its
+   ancestors. The snapshot is only recomputed when the style or one of its
+   ancestors has changed since it was computed. The render threads of the
+   canvas may paint items with the same styles at once, so this is done with
+   a lock held. Once computed, a snapshot is not changed while they paint. */
+static GooCanvasStyleFlat*
+goo_canvas_style_flatten (GooCanvasStyle *style)
+{
+  static GStaticMutex mutex = G_STATIC_MUTEX_INIT;
+  GooCanvasStyleFlat *flat;
+
+  g_static_mutex_lock (&mutex);
+  flat = goo_canvas_style_flatten_internal (style);
+  g_static_mutex_unlock (&mutex);
+
+  return flat;
+}
+
+
 static void
 goo_canvas_style_class_init (GooCanvasStyleClass *klass)
 {
@@ -166,6 +321,16 @@ goo_canvas_style_init (GooCanvasStyle *style)
 }
 
 
+/* Returns a number that changes whenever the standard properties of the style,
+   as resolved through its ancestors, may have changed. It is 0 for a NULL
+   style. */
+guint
+_goo_canvas_style_get_serial (GooCanvasStyle *style)
+{
+  return style ? goo_canvas_style_flatten (style)->serial : 0;
+}
+
+
 /**
  * goo_canvas_style_new:
  * 
@@ -201,6 +366,8 @@ goo_canvas_style_dispose (GObject *object)
     }
   g_array_set_size (style->properties, 0);
 
+  goo_canvas_style_changed (style);
+
   G_OBJECT_CLASS (goo_canvas_style_parent_class)->dispose (object);
 }
 
@@ -212,6 +379,9 @@ goo_canvas_style_finalize (GObject *object)
 
   g_array_free (style->properties, TRUE);
 
+  if (style->flat)
+    g_slice_free (GooCanvasStyleFlat, style->flat);
+
   G_OBJECT_CLASS (goo_canvas_style_parent_class)->finalize (object);
 }
 
@@ -280,6 +450,8 @@ goo_canvas_style_set_parent         (GooCanvasStyle *style,
 
   if (style->parent)
     g_object_ref (style->parent);
+
+  goo_canvas_style_changed (style);
 }
 
 
@@ -291,7 +463,8 @@ goo_canvas_style_set_parent         (GooCanvasStyle *style,
  * Gets the value of a property.
  *
  * This searches though all the #GooCanvasStyle's own list of property settings
- * and also all ancestor #GooCanvasStyle objects.
+ * and also all ancestor #GooCanvasStyle objects. The standard properties are
+ * looked up in a snapshot that is only recomputed when a style changes.
  *
  * Note that it returns a pointer to the internal #GValue setting, which should
  * not be changed.
@@ -303,10 +476,16 @@ goo_canvas_style_get_property       (GooCanvasStyle *style,
 				     GQuark          property_id)
 {
   GooCanvasStyleProperty *property;
-  gint i;
+  gint i, index;
 
-  /* Step up the hierarchy of styles until we find the property. Note that
-     if style is passed in as NULL we simply return NULL. */
+  if (!style)
+    return NULL;
+
+  index = goo_canvas_style_flat_index (property_id);
+  if (index >= 0)
+    return goo_canvas_style_flatten (style)->values[index];
+
+  /* Step up the hierarchy of styles until we find the property. */
   while (style)
     {
       for (i = 0; i < style->properties->len; i++)
@@ -361,6 +540,7 @@ goo_canvas_style_set_property	    (GooCanvasStyle *style,
 	      g_array_remove_index_fast (style->properties, i);
 	    }
 
+	  goo_canvas_style_changed (style);
 	  return;
 	}
     }
@@ -372,6 +552,9 @@ goo_canvas_style_set_property	    (GooCanvasStyle *style,
       g_value_init (&new_property.value, G_VALUE_TYPE (value));
       g_value_copy (value, &new_property.value);
       g_array_append_val (style->properties, new_property);
+
+      /* The array may have moved, so the snapshots must be recomputed. */
+      goo_canvas_style_changed (style);
     }
 }
 
@@ -390,86 +573,56 @@ gboolean
 goo_canvas_style_set_stroke_options (GooCanvasStyle *style,
 				     cairo_t        *cr)
 {
-  GooCanvasStyleProperty *property;
-  gboolean operator_set = FALSE, antialias_set = FALSE;
-  gboolean stroke_pattern_set = FALSE, line_width_set = FALSE;
-  gboolean line_cap_set = FALSE, line_join_set = FALSE;
-  gboolean miter_limit_set = FALSE, line_dash_set = FALSE;
-  gboolean source_set = FALSE, need_stroke = TRUE;
-  gint i;
+  GooCanvasStyleFlat *flat;
+  GValue **values, *value;
+  gboolean need_stroke = TRUE;
 
   if (!style)
     return TRUE;
 
-  /* Step up the hierarchy of styles looking for the properties. */
-  while (style)
-    {
-      for (i = 0; i < style->properties->len; i++)
-	{
-	  property = &g_array_index (style->properties, GooCanvasStyleProperty,
-				     i);
+  flat = goo_canvas_style_flatten (style);
+  values = flat->values;
 
-	  if (property->id == goo_canvas_style_operator_id && !operator_set)
-	    {
-	      cairo_set_operator (cr, property->value.data[0].v_long);
-	      operator_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_antialias_id && !antialias_set)
-	    {
-	      cairo_set_antialias (cr, property->value.data[0].v_long);
-	      antialias_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_stroke_pattern_id && !stroke_pattern_set)
-	    {
-	      if (property->value.data[0].v_pointer)
-		{
-		  cairo_set_source (cr, property->value.data[0].v_pointer);
-		  source_set = TRUE;
-		}
-	      else
-		{
-		  /* If the stroke pattern has been explicitly set to NULL,
-		     then we don't need to do the stroke. */
-		  need_stroke = FALSE;
-		}
-	      stroke_pattern_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_line_width_id && !line_width_set)
-	    {
-	      cairo_set_line_width (cr, property->value.data[0].v_double);
-	      line_width_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_line_cap_id && !line_cap_set)
-	    {
-	      cairo_set_line_cap (cr, property->value.data[0].v_long);
-	      line_cap_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_line_join_id && !line_join_set)
-	    {
-	      cairo_set_line_join (cr, property->value.data[0].v_long);
-	      line_join_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_line_join_miter_limit_id && !miter_limit_set)
-	    {
-	      cairo_set_miter_limit (cr, property->value.data[0].v_double);
-	      miter_limit_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_line_dash_id && !line_dash_set)
-	    {
-	      GooCanvasLineDash *dash = property->value.data[0].v_pointer;
-	      cairo_set_dash (cr, dash->dashes, dash->num_dashes,
-			      dash->dash_offset);
-	      line_dash_set = TRUE;
-	    }
-	}
+  if ((value = values[FLAT_OPERATOR]))
+    cairo_set_operator (cr, value->data[0].v_long);
 
-      style = style->parent;
+  if ((value = values[FLAT_ANTIALIAS]))
+    cairo_set_antialias (cr, value->data[0].v_long);
+
+  if ((value = values[FLAT_LINE_WIDTH]))
+    cairo_set_line_width (cr, value->data[0].v_double);
+
+  if ((value = values[FLAT_LINE_CAP]))
+    cairo_set_line_cap (cr, value->data[0].v_long);
+
+  if ((value = values[FLAT_LINE_JOIN]))
+    cairo_set_line_join (cr, value->data[0].v_long);
+
+  if ((value = values[FLAT_LINE_JOIN_MITER_LIMIT]))
+    cairo_set_miter_limit (cr, value->data[0].v_double);
+
+  if ((value = values[FLAT_LINE_DASH]))
+    {
+      GooCanvasLineDash *dash = value->data[0].v_pointer;
+      cairo_set_dash (cr, dash->dashes, dash->num_dashes, dash->dash_offset);
     }
 
-  /* If a stroke pattern hasn't been set in the style we reset the source to
-     black, just in case a fill pattern was used for the item. */
-  if (!source_set)
-    cairo_set_source_rgb (cr, 0, 0, 0);
+  value = values[FLAT_STROKE_PATTERN];
+  if (value && value->data[0].v_pointer)
+    {
+      cairo_set_source (cr, value->data[0].v_pointer);
+    }
+  else
+    {
+      /* If the stroke pattern has been explicitly set to NULL, then we don't
+	 need to do the stroke. */
+      if (value)
+	need_stroke = FALSE;
+
+      /* If a stroke pattern hasn't been set in the style we reset the source
+	 to black, just in case a fill pattern was used for the item. */
+      cairo_set_source_rgb (cr, 0, 0, 0);
+    }
 
   return need_stroke;
 }
@@ -489,51 +642,30 @@ gboolean
 goo_canvas_style_set_fill_options   (GooCanvasStyle *style,
 				     cairo_t        *cr)
 {
-  GooCanvasStyleProperty *property;
-  gboolean operator_set = FALSE, antialias_set = FALSE;
-  gboolean fill_rule_set = FALSE, fill_pattern_set = FALSE;
-  gboolean need_fill = FALSE;
-  gint i;
+  GooCanvasStyleFlat *flat;
+  GValue **values, *value;
 
   if (!style)
     return FALSE;
 
-  /* Step up the hierarchy of styles looking for the properties. */
-  while (style)
-    {
-      for (i = 0; i < style->properties->len; i++)
-	{
-	  property = &g_array_index (style->properties, GooCanvasStyleProperty,
-				     i);
+  flat = goo_canvas_style_flatten (style);
+  values = flat->values;
 
-	  if (property->id == goo_canvas_style_operator_id && !operator_set)
-	    {
-	      cairo_set_operator (cr, property->value.data[0].v_long);
-	      operator_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_antialias_id && !antialias_set)
-	    {
-	      cairo_set_antialias (cr, property->value.data[0].v_long);
-	      antialias_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_fill_rule_id && !fill_rule_set)
-	    {
-	      cairo_set_fill_rule (cr, property->value.data[0].v_long);
-	      fill_rule_set = TRUE;
-	    }
-	  else if (property->id == goo_canvas_style_fill_pattern_id && !fill_pattern_set)
-	    {
-	      if (property->value.data[0].v_pointer)
-		{
-		  cairo_set_source (cr, property->value.data[0].v_pointer);
-		  need_fill = TRUE;
-		}
-	      fill_pattern_set = TRUE;
-	    }
-	}
+  if ((value = values[FLAT_OPERATOR]))
+    cairo_set_operator (cr, value->data[0].v_long);
 
-      style = style->parent;
+  if ((value = values[FLAT_ANTIALIAS]))
+    cairo_set_antialias (cr, value->data[0].v_long);
+
+  if ((value = values[FLAT_FILL_RULE]))
+    cairo_set_fill_rule (cr, value->data[0].v_long);
+
+  value = values[FLAT_FILL_PATTERN];
+  if (value && value->data[0].v_pointer)
+    {
+      cairo_set_source (cr, value->data[0].v_pointer);
+      return TRUE;
     }
 
-  return need_fill;
+  return FALSE;
 }
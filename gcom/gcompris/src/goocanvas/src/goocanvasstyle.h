@@ -69,6 +69,15 @@ struct _GooCanvasStyle
   /* <public> */
   GooCanvasStyle *parent;
   GArray *properties;
+
+  /* <private> */
+
+  /* Bumped whenever the properties or the parent change. */
+  guint stamp;
+
+  /* The standard properties resolved through the ancestors, see
+     goo_canvas_style_flatten(). */
+  gpointer flat;
 };
 
 struct _GooCanvasStyleClass
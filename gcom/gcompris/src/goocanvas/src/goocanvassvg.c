@@ -4,9 +4,65 @@
  *
  * goocanvassvg.c - a simple svg item.
  */
+#include <math.h>
 #include "goocanvas.h"
 #include "goocanvassvg.h"
 
+/* When the canvas is zoomed in, the items are rasterized again at 2, 4 or 8
+   times their size, in the background. These levels are shared by the items
+   showing the same id of the same handle. Until the level wanted is ready,
+   the closest one is painted, or else the one rendered at the normal size. */
+#define GOO_CANVAS_SVG_N_LEVELS		4
+
+/* The levels larger than this are not rendered. */
+#define GOO_CANVAS_SVG_MAX_LEVEL_SIZE	4096
+
+typedef struct _GooCanvasSvgLevels GooCanvasSvgLevels;
+struct _GooCanvasSvgLevels
+{
+  gint ref_count;
+  gchar *key;
+  RsvgHandle *svg_handle;
+  gchar *id;
+
+  /* The area of the id in the SVG. */
+  gdouble x, y, width, height;
+
+  /* The level n is rendered at 2^n times the normal size. The level 0 is
+     the item's own pattern. */
+  cairo_surface_t *surfaces[GOO_CANVAS_SVG_N_LEVELS];
+  guint pending;
+
+  /* The items to redraw when a level is ready. */
+  GSList *items;
+};
+
+typedef struct _GooCanvasSvgJob GooCanvasSvgJob;
+struct _GooCanvasSvgJob
+{
+  GooCanvasSvgLevels *levels;
+  gint level;
+  cairo_surface_t *surface;
+};
+
+typedef struct _GooCanvasSvgPrivate GooCanvasSvgPrivate;
+struct _GooCanvasSvgPrivate {
+  GooCanvasSvgLevels *levels;
+};
+
+#define GOO_CANVAS_SVG_GET_PRIVATE(svg)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((svg), GOO_TYPE_CANVAS_SVG, GooCanvasSvgPrivate))
+
+/* The levels by handle and id. */
+static GHashTable *svg_levels = NULL;
+
+/* The levels are rendered one at a time, by this thread. */
+static GThreadPool *svg_render_pool = NULL;
+
+/* Held while a handle is rendered or measured, the handles are shared.
+   The other users of the handles take it with goo_canvas_svg_lock(). */
+static GStaticMutex svg_render_mutex = G_STATIC_MUTEX_INIT;
+
 enum {
   PROP_0,
 
@@ -87,10 +143,213 @@ _autocrop(cairo_surface_t *src_surface,
   return dst_surface;
 }
 
+static void
+goo_canvas_svg_levels_unref (GooCanvasSvgLevels *levels)
+{
+  gint i;
+
+  if (--levels->ref_count > 0)
+    return;
+
+  g_hash_table_remove (svg_levels, levels->key);
+
+  for (i = 0; i < GOO_CANVAS_SVG_N_LEVELS; i++)
+    if (levels->surfaces[i])
+      cairo_surface_destroy (levels->surfaces[i]);
+
+  g_object_unref (levels->svg_handle);
+  g_free (levels->id);
+  g_free (levels->key);
+  g_free (levels);
+}
+
+
+/* Returns the levels of the id of svg_handle, with a new reference. */
+static GooCanvasSvgLevels*
+goo_canvas_svg_levels_get (RsvgHandle        *svg_handle,
+			   const gchar       *id,
+			   RsvgPositionData  *position_data,
+			   RsvgDimensionData *dimension_data)
+{
+  GooCanvasSvgLevels *levels;
+  gchar *key;
+
+  if (dimension_data->width <= 0 || dimension_data->height <= 0)
+    return NULL;
+
+  if (!svg_levels)
+    svg_levels = g_hash_table_new (g_str_hash, g_str_equal);
+
+  key = g_strdup_printf ("%p %s", svg_handle, id ? id : "");
+  levels = g_hash_table_lookup (svg_levels, key);
+  if (levels)
+    {
+      g_free (key);
+      levels->ref_count++;
+      return levels;
+    }
+
+  levels = g_new0 (GooCanvasSvgLevels, 1);
+  levels->ref_count = 1;
+  levels->key = key;
+  levels->svg_handle = g_object_ref (svg_handle);
+  levels->id = g_strdup (id);
+  levels->x = position_data->x;
+  levels->y = position_data->y;
+  levels->width = dimension_data->width;
+  levels->height = dimension_data->height;
+  g_hash_table_insert (svg_levels, levels->key, levels);
+
+  return levels;
+}
+
+
+/* Takes the reference to levels. */
+static void
+goo_canvas_svg_set_levels (GooCanvasSvg       *canvas_svg,
+			   GooCanvasSvgLevels *levels)
+{
+  GooCanvasSvgPrivate *priv = GOO_CANVAS_SVG_GET_PRIVATE (canvas_svg);
+
+  if (priv->levels)
+    {
+      priv->levels->items = g_slist_remove (priv->levels->items, canvas_svg);
+      goo_canvas_svg_levels_unref (priv->levels);
+    }
+
+  priv->levels = levels;
+  if (levels)
+    levels->items = g_slist_prepend (levels->items, canvas_svg);
+}
+
+
+/* Called in the main thread once a level is rendered. */
+static gboolean
+goo_canvas_svg_level_ready (gpointer data)
+{
+  GooCanvasSvgJob *job = data;
+  GooCanvasSvgLevels *levels = job->levels;
+  GSList *l;
+
+  levels->pending &= ~(1 << job->level);
+  levels->surfaces[job->level] = job->surface;
+
+  for (l = levels->items; l; l = l->next)
+    goo_canvas_item_simple_changed (l->data, FALSE);
+
+  goo_canvas_svg_levels_unref (levels);
+  g_free (job);
+
+  return FALSE;
+}
+
+
+static void
+goo_canvas_svg_render_level (gpointer data,
+			     gpointer user_data)
+{
+  GooCanvasSvgJob *job = data;
+  GooCanvasSvgLevels *levels = job->levels;
+  gdouble scale = 1 << job->level;
+  cairo_t *cr;
+
+  job->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+					     ceil (levels->width * scale),
+					     ceil (levels->height * scale));
+  cr = cairo_create (job->surface);
+  cairo_scale (cr, scale, scale);
+  cairo_translate (cr, -levels->x, -levels->y);
+
+  g_static_mutex_lock (&svg_render_mutex);
+  rsvg_handle_render_cairo_sub (levels->svg_handle, cr, levels->id);
+  g_static_mutex_unlock (&svg_render_mutex);
+
+  cairo_destroy (cr);
+
+  g_idle_add (goo_canvas_svg_level_ready, job);
+}
+
+
+/* Returns the level closest to the one wanted, and starts rendering the one
+   wanted if it is not there yet. Returns NULL if only the item's own pattern
+   can be painted. */
+static cairo_surface_t*
+goo_canvas_svg_levels_lookup (GooCanvasSvgLevels *levels,
+			      gint                wanted,
+			      gint               *level)
+{
+  GooCanvasSvgJob *job;
+  gint i;
+
+  while (wanted > 0
+	 && (levels->width * (1 << wanted) > GOO_CANVAS_SVG_MAX_LEVEL_SIZE
+	     || levels->height * (1 << wanted) > GOO_CANVAS_SVG_MAX_LEVEL_SIZE))
+    wanted--;
+
+  if (wanted == 0)
+    return NULL;
+
+  if (!levels->surfaces[wanted] && !(levels->pending & (1 << wanted)))
+    {
+      if (!svg_render_pool)
+	{
+	  if (!g_thread_supported ()) g_thread_init (NULL);
+	  svg_render_pool = g_thread_pool_new (goo_canvas_svg_render_level,
+					       NULL, 1, FALSE, NULL);
+	}
+
+      if (svg_render_pool)
+	{
+	  job = g_new0 (GooCanvasSvgJob, 1);
+	  job->levels = levels;
+	  job->level = wanted;
+	  levels->ref_count++;
+	  levels->pending |= 1 << wanted;
+	  g_thread_pool_push (svg_render_pool, job, NULL);
+	}
+    }
+
+  for (i = wanted; i < GOO_CANVAS_SVG_N_LEVELS; i++)
+    if (levels->surfaces[i])
+      {
+	*level = i;
+	return levels->surfaces[i];
+      }
+
+  for (i = wanted - 1; i > 0; i--)
+    if (levels->surfaces[i])
+      {
+	*level = i;
+	return levels->surfaces[i];
+      }
+
+  return NULL;
+}
+
+
+/* Returns the level to paint at the scale of cr. */
+static gint
+goo_canvas_svg_get_level (cairo_t *cr)
+{
+  gdouble x1 = 1.0, y1 = 0.0, x2 = 0.0, y2 = 1.0, scale;
+  gint level = 0;
+
+  cairo_user_to_device_distance (cr, &x1, &y1);
+  cairo_user_to_device_distance (cr, &x2, &y2);
+  scale = MAX (sqrt (x1 * x1 + y1 * y1), sqrt (x2 * x2 + y2 * y2));
+
+  while (level + 1 < GOO_CANVAS_SVG_N_LEVELS && (1 << level) < scale - 0.01)
+    level++;
+
+  return level;
+}
+
+
 static void _init_surface(GooCanvasSvg *canvas_svg,
 			  RsvgHandle *svg_handle, double zoom)
 {
   g_assert(svg_handle);
+  g_static_mutex_lock (&svg_render_mutex);
   RsvgDimensionData dimension_data_max;
   rsvg_handle_get_dimensions (svg_handle, &dimension_data_max);
 
@@ -144,6 +403,13 @@ static void _init_surface(GooCanvasSvg *canvas_svg,
     canvas_svg->pattern = cairo_pattern_create_for_surface (cst);
 
   cairo_surface_destroy(cst);
+  g_static_mutex_unlock (&svg_render_mutex);
+
+  goo_canvas_svg_set_levels (canvas_svg,
+			     goo_canvas_svg_levels_get (svg_handle,
+							canvas_svg->id,
+							&position_data,
+							&dimension_data));
 }
 
 /* The standard object initialization function. */
@@ -198,6 +464,33 @@ goo_canvas_svg_new (GooCanvasItem      *parent,
 }
 
 
+/**
+ * goo_canvas_svg_lock:
+ *
+ * Takes the lock held while the handles of the svg items are used in the
+ * background. librsvg handles are not thread safe, so it must be held
+ * around any call on a handle given to goo_canvas_svg_new(), such as
+ * rsvg_handle_get_dimensions(), while that handle is shown on a canvas.
+ **/
+void
+goo_canvas_svg_lock (void)
+{
+  g_static_mutex_lock (&svg_render_mutex);
+}
+
+
+/**
+ * goo_canvas_svg_unlock:
+ *
+ * Releases the lock taken by goo_canvas_svg_lock().
+ **/
+void
+goo_canvas_svg_unlock (void)
+{
+  g_static_mutex_unlock (&svg_render_mutex);
+}
+
+
 /* The update method. This is called when the canvas is initially shown and
    also whenever the object is updated and needs to change its size and/or
    shape. It should calculate its new bounds in its own coordinate space,
@@ -224,8 +517,28 @@ goo_canvas_svg_paint (GooCanvasItemSimple   *simple,
 		     const GooCanvasBounds *bounds)
 {
   GooCanvasSvg *canvas_svg = (GooCanvasSvg*) simple;
+  GooCanvasSvgPrivate *priv = GOO_CANVAS_SVG_GET_PRIVATE (canvas_svg);
+  cairo_surface_t *surface = NULL;
+  gint level;
+
+  if (priv->levels)
+    surface = goo_canvas_svg_levels_lookup (priv->levels,
+					    goo_canvas_svg_get_level (cr),
+					    &level);
 
-  if(canvas_svg->pattern)
+  if (surface)
+    {
+      gdouble scale = 1 << level;
+
+      /* The levels are cropped to the id, as the autocrop pattern is. */
+      cairo_save (cr);
+      cairo_translate (cr, canvas_svg->x1, canvas_svg->y1);
+      cairo_scale (cr, 1.0 / scale, 1.0 / scale);
+      cairo_set_source_surface (cr, surface, 0.0, 0.0);
+      cairo_paint (cr);
+      cairo_restore (cr);
+    }
+  else if(canvas_svg->pattern)
     {
       cairo_set_source (cr, canvas_svg->pattern);
       cairo_paint (cr);
@@ -254,6 +567,8 @@ goo_canvas_svg_finalize (GObject *object)
     g_object_unref (canvas_svg->svg_handle);
   canvas_svg->svg_handle = NULL;
 
+  goo_canvas_svg_set_levels (canvas_svg, NULL);
+
   G_OBJECT_CLASS (goo_canvas_svg_parent_class)->finalize (object);
 }
 
@@ -344,6 +659,8 @@ goo_canvas_svg_class_init (GooCanvasSvgClass *klass)
   GObjectClass *gobject_class = (GObjectClass*) klass;
   GooCanvasItemSimpleClass *simple_class = (GooCanvasItemSimpleClass*) klass;
 
+  g_type_class_add_private (gobject_class, sizeof (GooCanvasSvgPrivate));
+
   gobject_class->set_property = goo_canvas_svg_set_property;
 
   gobject_class->finalize            = goo_canvas_svg_finalize;
@@ -54,6 +54,9 @@ GooCanvasItem*      goo_canvas_svg_new       (GooCanvasItem      *parent,
 					      RsvgHandle         *svg_handle,
 					      ...);
 
+void                goo_canvas_svg_lock      (void);
+void                goo_canvas_svg_unlock    (void);
+
 
 G_END_DECLS
 
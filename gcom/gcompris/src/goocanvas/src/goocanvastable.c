@@ -147,6 +147,17 @@ struct _GooCanvasTableChildLayoutData
   gdouble requested_position[2];
   gdouble requested_size[2];
   gdouble start_pad[2], end_pad[2];
+
+  /* The width the requested height was last calculated for, or -1. */
+  gdouble height_width;
+
+  /* The last area and offsets the child was allocated. */
+  GooCanvasBounds allocated_area;
+  gdouble x_offset, y_offset;
+
+  /* Set if the child was measured in this layout, so it has to be
+     allocated again. */
+  guint measured : 1;
 };
 
 /* Convenience macros to set/unset/check bit-flags. */
@@ -159,8 +170,11 @@ struct _GooCanvasTableChildLayoutData
 #define GOO_CANVAS_TABLE_IS_GRID_LINE_VISIBLE(dim, x, y) \
   ((dim)[(x)].grid_line_visibility[(y)/32] & (1 << ((y) % 32)))
 
-/* The children array is only kept around while doing the layout.
-   It gets freed in goo_canvas_table_allocate_area(). */
+/* The children array is kept between the layouts done by
+   goo_canvas_table_update(). When the table itself has not changed since the
+   last one, the layout is incremental: only the children which changed are
+   measured again, and only the children which changed or moved are
+   allocated again. */
 struct _GooCanvasTableLayoutData
 {
   GooCanvasTableDimensionLayoutData *dldata[2];
@@ -196,6 +210,18 @@ struct _GooCanvasTableLayoutData
      It is initialized to -1 in goo_canvas_table_init_layout_data() and
      checked/set in goo_canvas_table_update_requested_heights(). */
   gdouble last_width;
+
+  /* The number of children in the children array. */
+  guint n_children;
+
+  /* Set if the children array holds the last layout done by
+     goo_canvas_table_update(), for the given table and cairo matrix. */
+  gboolean children_valid;
+  GooCanvasTable *layout_table;
+  cairo_matrix_t layout_matrix;
+
+  /* Set during an incremental layout. */
+  gboolean incremental;
 };
 
 static GooCanvasItemIface *goo_canvas_table_parent_iface;
@@ -431,6 +457,10 @@ goo_canvas_table_init_data (GooCanvasTableData *table_data)
   table_data->layout_data->y = 0.0;
 
   table_data->layout_data->children = NULL;
+  table_data->layout_data->n_children = 0;
+  table_data->layout_data->children_valid = FALSE;
+  table_data->layout_data->layout_table = NULL;
+  table_data->layout_data->incremental = FALSE;
   for (d = 0; d < 2; d++)
     {
       table_data->layout_data->dldata[d] = NULL;
@@ -836,6 +866,9 @@ goo_canvas_table_add_child     (GooCanvasItem  *item,
   if (!simple->model)
     goo_canvas_table_add_child_internal (table->table_data, position);
 
+  /* The children laid out last are not at the same positions any more. */
+  table->table_data->layout_data->children_valid = FALSE;
+
   /* Let the parent GooCanvasGroup code do the rest. */
   goo_canvas_table_parent_iface->add_child (item, child, position);
 }
@@ -891,6 +924,9 @@ goo_canvas_table_move_child    (GooCanvasItem  *item,
     goo_canvas_table_move_child_internal (table->table_data, old_position,
 					  new_position);
 
+  /* The children laid out last are not at the same positions any more. */
+  table->table_data->layout_data->children_valid = FALSE;
+
   /* Let the parent GooCanvasGroup code do the rest. */
   goo_canvas_table_parent_iface->move_child (item, old_position, new_position);
 }
@@ -909,6 +945,9 @@ goo_canvas_table_remove_child  (GooCanvasItem  *item,
   if (!simple->model)
     g_array_remove_index (table->table_data->children, child_num);
 
+  /* The children laid out last are not at the same positions any more. */
+  table->table_data->layout_data->children_valid = FALSE;
+
   /* Let the parent GooCanvasGroup code do the rest. */
   goo_canvas_table_parent_iface->remove_child (item, child_num);
 }
@@ -1186,8 +1225,14 @@ goo_canvas_table_init_layout_data (GooCanvasTable *table)
   GooCanvasTableDimensionLayoutData *dldata;
   gint d, i;
 
-  layout_data->children = g_new (GooCanvasTableChildLayoutData,
-				 table_data->children->len);
+  /* An incremental layout reuses the requests of the children. */
+  if (!layout_data->incremental)
+    {
+      layout_data->children = g_renew (GooCanvasTableChildLayoutData,
+				       layout_data->children,
+				       table_data->children->len);
+      layout_data->n_children = table_data->children->len;
+    }
   layout_data->last_width = -1;
 
   /* If we are not yet added to a canvas, integer layout is irrelevant anyway.
@@ -1247,6 +1292,45 @@ goo_canvas_table_init_layout_data (GooCanvasTable *table)
 }
 
 
+/* Returns TRUE if the child may request another area than in the last
+   layout. Only simple items tell if they have changed. */
+static gboolean
+goo_canvas_table_child_changed (GooCanvasItem *child_item)
+{
+  return !GOO_IS_CANVAS_ITEM_SIMPLE (child_item)
+    || ((GooCanvasItemSimple*) child_item)->need_update;
+}
+
+
+/* Sets the expand, shrink & empty flags in the
+   GooCanvasTableDimensionLayoutData for the row/column, if the item only
+   spans 1 row/column. */
+static void
+goo_canvas_table_set_child_flags (GooCanvasTableLayoutData *layout_data,
+				  GooCanvasTableChild      *child)
+{
+  GooCanvasTableDimensionLayoutData *dldata;
+  gint d, start;
+  guint8 flags;
+
+  for (d = 0; d < 2; d++)
+    {
+      dldata = layout_data->dldata[d];
+      start = child->start[d];
+      flags = child->flags[d];
+
+      if (child->size[d] == 1)
+	{
+	  if (flags & GOO_CANVAS_TABLE_CHILD_EXPAND)
+	    dldata[start].expand = TRUE;
+	  if (!(flags & GOO_CANVAS_TABLE_CHILD_SHRINK))
+	    dldata[start].shrink = FALSE;
+	  dldata[start].empty = FALSE;
+	}
+    }
+}
+
+
 /* This gets the requested size of all child items, and sets the expand,
    shrink and empty flags for each row and column.
    It should only be called once in the entire size_request/allocate procedure
@@ -1273,6 +1357,21 @@ goo_canvas_table_size_request_init (GooCanvasTable *table,
       child = &g_array_index (table_data->children, GooCanvasTableChild, i);
       child_item = group->items->pdata[i];
 
+      /* Keep the last request of the children which haven't changed. */
+      if (layout_data->incremental
+	  && !goo_canvas_table_child_changed (child_item))
+	{
+	  layout_data->children[i].measured = FALSE;
+	  if (layout_data->children[i].requested_size[HORZ] < 0.0)
+	    continue;
+
+	  goo_canvas_table_set_child_flags (layout_data, child);
+	  continue;
+	}
+
+      layout_data->children[i].measured = TRUE;
+      layout_data->children[i].height_width = -1.0;
+
       /* Children will return FALSE if they don't need space allocated. */
       allocate = goo_canvas_item_get_requested_area (child_item, cr, &bounds);
 
@@ -1306,24 +1405,7 @@ goo_canvas_table_size_request_init (GooCanvasTable *table,
 	  layout_data->children[i].end_pad[VERT] = floor (layout_data->children[i].end_pad[VERT] + 0.5);
 	}
 
-      /* Set the expand, shrink & empty flags in the
-	 GooCanvasTableDimensionLayoutData for the row/column, if the item
-	 only spans 1 row/column. */
-      for (d = 0; d < 2; d++)
-	{
-	  dldata = layout_data->dldata[d];
-	  start = child->start[d];
-	  flags = child->flags[d];
-
-	  if (child->size[d] == 1)
-	    {
-	      if (flags & GOO_CANVAS_TABLE_CHILD_EXPAND)
-		dldata[start].expand = TRUE;
-	      if (!(flags & GOO_CANVAS_TABLE_CHILD_SHRINK))
-		dldata[start].shrink = FALSE;
-	      dldata[start].empty = FALSE;
-	    }
-	}
+      goo_canvas_table_set_child_flags (layout_data, child);
     }
 
   /* Now handle children that span more than one row or column. */
@@ -1769,7 +1851,7 @@ goo_canvas_table_size_allocate_pass3 (GooCanvasTable *table,
   GooCanvasTableChild *child;
   GooCanvasItem *child_item;
   GooCanvasTableChildLayoutData *child_data;
-  GooCanvasBounds requested_area, allocated_area;
+  GooCanvasBounds requested_area, allocated_area, bounds;
   GtkTextDirection direction = GTK_TEXT_DIR_NONE;
   gint start_column, end_column, start_row, end_row, i;
   gdouble x, y, max_width, max_height, width, height;
@@ -1848,9 +1930,40 @@ goo_canvas_table_size_allocate_pass3 (GooCanvasTable *table,
       x_offset += table_x_offset;
       y_offset += table_y_offset;
 
+      if (!child_data->measured)
+	{
+	  /* A child which hasn't changed keeps its bounds if it hasn't moved
+	     either. */
+	  if (allocated_area.x1 == child_data->allocated_area.x1
+	      && allocated_area.y1 == child_data->allocated_area.y1
+	      && allocated_area.x2 == child_data->allocated_area.x2
+	      && allocated_area.y2 == child_data->allocated_area.y2
+	      && x_offset == child_data->x_offset
+	      && y_offset == child_data->y_offset)
+	    {
+	      cairo_translate (cr, -child->position[HORZ],
+			       -child->position[VERT]);
+	      continue;
+	    }
+
+	  /* Otherwise its bounds are where it was allocated, so it is
+	     measured again. This is only done in an incremental layout, where
+	     the context is the one the children were measured with. */
+	  cairo_translate (cr, -child->position[HORZ], -child->position[VERT]);
+	  goo_canvas_item_get_requested_area (child_item, cr, &bounds);
+	  if (child_data->height_width >= 0.0)
+	    goo_canvas_item_get_requested_height (child_item, cr,
+						  child_data->height_width);
+	  cairo_translate (cr, child->position[HORZ], child->position[VERT]);
+	}
+
       goo_canvas_item_allocate_area (child_item, cr, &requested_area,
 				     &allocated_area, x_offset, y_offset);
 
+      child_data->allocated_area = allocated_area;
+      child_data->x_offset = x_offset;
+      child_data->y_offset = y_offset;
+
       cairo_translate (cr, -child->position[HORZ], -child->position[VERT]);
     }
 }
@@ -1869,6 +1982,7 @@ goo_canvas_table_update_requested_heights (GooCanvasItem       *item,
   GooCanvasTableChild *child;
   GooCanvasItem *child_item;
   GooCanvasTableChildLayoutData *child_data;
+  GooCanvasBounds bounds;
   gint start_column, end_column, i, row, end;
   gdouble x, max_width, width, requested_width, requested_height, height = 0.0;
 
@@ -1906,10 +2020,25 @@ goo_canvas_table_update_requested_heights (GooCanvasItem       *item,
       if (!(child->flags[HORZ] & GOO_CANVAS_TABLE_CHILD_FILL))
 	width = MIN (max_width, requested_width);
 
+      /* The height of a child which hasn't changed only depends on its
+	 width. */
+      if (!child_data->measured)
+	{
+	  if (child_data->height_width == width)
+	    continue;
+
+	  /* Its bounds were allocated, so it is measured again first. */
+	  goo_canvas_item_get_requested_area (child_item, cr, &bounds);
+	}
+
       requested_height = goo_canvas_item_get_requested_height (child_item, cr,
 							       width);
       if (requested_height >= 0.0)
 	child_data->requested_size[VERT] = requested_height;
+
+      /* This may have changed the bounds of the child. */
+      child_data->height_width = width;
+      child_data->measured = TRUE;
     }
 
   /* Now recalculate the requested heights of each row. */
@@ -1946,8 +2075,15 @@ goo_canvas_table_get_requested_area (GooCanvasItem        *item,
   gdouble width = 0.0, height = 0.0;
   gint row, column, end;
 
-  /* Request a redraw of the existing bounds */
-  goo_canvas_request_item_redraw (simple->canvas, &simple->bounds, simple_data->is_static);
+  /* A table laid out by its parent is laid out from scratch. In an
+     incremental layout goo_canvas_table_update() redraws what is needed. */
+  if (!layout_data->incremental)
+    {
+      layout_data->children_valid = FALSE;
+
+      /* Request a redraw of the existing bounds */
+      goo_canvas_request_item_redraw (simple->canvas, &simple->bounds, simple_data->is_static);
+    }
 
   /* We reset the bounds to 0, just in case we are hidden or aren't allocated
      any area. */
@@ -2168,14 +2304,13 @@ goo_canvas_table_allocate_area (GooCanvasItem         *item,
 
   goo_canvas_table_size_allocate_pass3 (table, cr, x_offset, y_offset);
 
-  /* We free the children array but keep the dimension layout data, since
-     we may need that for clipping children. */
-  g_free (layout_data->children);
-  layout_data->children = NULL;
+  /* We keep the children array, for the next incremental layout, and the
+     dimension layout data, since we may need that for clipping children. */
 
   cairo_restore (cr);
 
-  goo_canvas_request_item_redraw (simple->canvas, &simple->bounds, simple_data->is_static);
+  if (!layout_data->incremental)
+    goo_canvas_request_item_redraw (simple->canvas, &simple->bounds, simple_data->is_static);
 }
 
 
@@ -2186,21 +2321,91 @@ goo_canvas_table_update  (GooCanvasItem   *item,
 			  GooCanvasBounds *bounds)
 {
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
-  GooCanvasBounds tmp_bounds;
+  GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  GooCanvasTable *table = (GooCanvasTable*) item;
+  GooCanvasTableData *table_data = table->table_data;
+  GooCanvasTableLayoutData *layout_data = table_data->layout_data;
+  GooCanvasBounds tmp_bounds, old_bounds;
+  gdouble *old_edges = NULL;
+  cairo_matrix_t matrix;
+  gint n_edges = 0, d, i, j;
+  gboolean allocated;
 
   if (entire_tree || simple->need_update)
     {
+      cairo_get_matrix (cr, &matrix);
+
+      /* If only some children changed, the others keep their layout. */
+      layout_data->incremental = !entire_tree
+	&& !simple->need_entire_subtree_update
+	&& layout_data->children_valid
+	&& layout_data->layout_table == table
+	&& layout_data->n_children == table_data->children->len
+	&& !memcmp (&layout_data->layout_matrix, &matrix, sizeof (matrix));
+
       simple->need_update = FALSE;
       simple->need_entire_subtree_update = FALSE;
 
       goo_canvas_item_simple_check_style (simple);
 
+      /* Remember the rows and columns, to redraw the table only if they
+	 move. */
+      if (layout_data->incremental)
+	{
+	  old_bounds = simple->bounds;
+	  n_edges = (table_data->dimensions[HORZ].size
+		     + table_data->dimensions[VERT].size) * 2;
+	  old_edges = g_new (gdouble, n_edges);
+	  for (d = 0, j = 0; d < 2; d++)
+	    for (i = 0; i < table_data->dimensions[d].size; i++)
+	      {
+		old_edges[j++] = layout_data->dldata[d][i].start;
+		old_edges[j++] = layout_data->dldata[d][i].end;
+	      }
+	}
+
       /* We just allocate exactly what is requested. */
-      if (goo_canvas_table_get_requested_area (item, cr, &tmp_bounds))
+      allocated = goo_canvas_table_get_requested_area (item, cr, &tmp_bounds);
+      if (allocated)
 	{
 	  goo_canvas_table_allocate_area (item, cr, &tmp_bounds, &tmp_bounds,
 					  0, 0);
 	}
+
+      if (old_edges)
+	{
+	  gboolean moved = FALSE;
+
+	  for (d = 0, j = 0; d < 2; d++)
+	    for (i = 0; i < table_data->dimensions[d].size; i++)
+	      {
+		if (old_edges[j] != layout_data->dldata[d][i].start
+		    || old_edges[j + 1] != layout_data->dldata[d][i].end)
+		  moved = TRUE;
+		j += 2;
+	      }
+
+	  if (moved || !allocated
+	      || old_bounds.x1 != simple->bounds.x1
+	      || old_bounds.y1 != simple->bounds.y1
+	      || old_bounds.x2 != simple->bounds.x2
+	      || old_bounds.y2 != simple->bounds.y2)
+	    {
+	      goo_canvas_request_item_redraw (simple->canvas, &old_bounds,
+					      simple_data->is_static);
+	      goo_canvas_request_item_redraw (simple->canvas, &simple->bounds,
+					      simple_data->is_static);
+	    }
+
+	  g_free (old_edges);
+	}
+
+      /* The children keep this layout until something else lays them
+	 out. */
+      layout_data->children_valid = allocated;
+      layout_data->layout_table = table;
+      layout_data->layout_matrix = matrix;
+      layout_data->incremental = FALSE;
     }
 
   *bounds = simple->bounds;
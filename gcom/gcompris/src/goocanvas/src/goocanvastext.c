@@ -29,6 +29,7 @@
  * g_object_get() and g_object_set().
  */
 #include <config.h>
+#include <string.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
 #include "goocanvastext.h"
@@ -37,8 +38,22 @@
 typedef struct _GooCanvasTextPrivate GooCanvasTextPrivate;
 struct _GooCanvasTextPrivate {
   gdouble height;
+
+  /* The cached layout, only used by items (never by models). It is shared
+     with the other items displaying the same text with the same settings.
+     layout_key describes the layout settings, layout_dirty is set when the
+     item is updated, to check the key again before using the layout. */
+  PangoLayout *layout;
+  gchar *layout_key;
+  gdouble layout_width;
+  gboolean layout_dirty;
 };
 
+/* The shared layouts, keyed by their settings. The table does not hold a
+   reference, layouts remove themselves from it when they are finalized. */
+static GHashTable *shared_layouts = NULL;
+static GQuark layout_key_quark = 0;
+
 #define GOO_CANVAS_TEXT_GET_PRIVATE(text) \
    (G_TYPE_INSTANCE_GET_PRIVATE ((text), GOO_TYPE_CANVAS_TEXT, GooCanvasTextPrivate))
 #define GOO_CANVAS_TEXT_MODEL_GET_PRIVATE(text) \
@@ -60,13 +75,13 @@ enum {
 };
 
 static PangoLayout*
-goo_canvas_text_create_layout (GooCanvasItemSimpleData *simple_data,
-			       GooCanvasTextData       *text_data,
+goo_canvas_text_create_layout (GooCanvasText           *text,
 			       gdouble                  layout_width,
 			       cairo_t                 *cr,
 			       GooCanvasBounds         *bounds,
 			       gdouble	               *origin_x_return,
 			       gdouble	               *origin_y_return);
+static void goo_canvas_text_free_layout (GooCanvasText *text);
 
 static void goo_canvas_text_finalize     (GObject            *object);
 static void canvas_item_interface_init   (GooCanvasItemIface *iface);
@@ -185,6 +200,7 @@ goo_canvas_text_init (GooCanvasText *text)
   text->layout_width = -1.0;
 
   priv->height = -1.0;
+  priv->layout_dirty = TRUE;
 }
 
 
@@ -275,6 +291,8 @@ goo_canvas_text_finalize (GObject *object)
     }
   text->text_data = NULL;
 
+  goo_canvas_text_free_layout (text);
+
   G_OBJECT_CLASS (goo_canvas_text_parent_class)->finalize (object);
 }
 
@@ -423,23 +441,60 @@ goo_canvas_text_set_property (GObject              *object,
 }
 
 
+/* Builds the string describing all the settings the layout depends on. */
+static gchar*
+goo_canvas_text_layout_key (GooCanvasItemSimpleData *simple_data,
+			    GooCanvasTextData       *text_data,
+			    gdouble                  layout_width)
+{
+  GooCanvasStyle *style = simple_data->style;
+  GValue *svalue;
+  gchar *font = NULL, *key;
+  cairo_hint_metrics_t hint_metrics = CAIRO_HINT_METRICS_OFF;
+
+  svalue = goo_canvas_style_get_property (style,
+					  goo_canvas_style_font_desc_id);
+  if (svalue && svalue->data[0].v_pointer)
+    font = pango_font_description_to_string (svalue->data[0].v_pointer);
+
+  svalue = goo_canvas_style_get_property (style,
+					  goo_canvas_style_hint_metrics_id);
+  if (svalue)
+    hint_metrics = svalue->data[0].v_long;
+
+  key = g_strdup_printf ("%i %i %i %i %i %g %s\n%s",
+			 text_data->use_markup, text_data->alignment,
+			 text_data->ellipsize, text_data->wrap, hint_metrics,
+			 layout_width > 0 ? layout_width : -1.0,
+			 font ? font : "",
+			 text_data->text ? text_data->text : "");
+  g_free (font);
+
+  return key;
+}
+
+
+static void
+goo_canvas_text_shared_layout_removed (gpointer data)
+{
+  gchar *key = data;
+
+  g_hash_table_remove (shared_layouts, key);
+  g_free (key);
+}
+
+
 static PangoLayout*
-goo_canvas_text_create_layout (GooCanvasItemSimpleData *simple_data,
-			       GooCanvasTextData       *text_data,
-			       gdouble                  layout_width,
-			       cairo_t                 *cr,
-			       GooCanvasBounds         *bounds,
-			       gdouble	               *origin_x_return,
-			       gdouble	               *origin_y_return)
+goo_canvas_text_new_layout (GooCanvasItemSimpleData *simple_data,
+			    GooCanvasTextData       *text_data,
+			    gdouble                  layout_width,
+			    cairo_t                 *cr)
 {
   GooCanvasStyle *style = simple_data->style;
   GValue *svalue;
   PangoLayout *layout;
   PangoContext *context;
-  PangoRectangle ink_rect, logical_rect;
-  double logical_width, logical_height, align_width, origin_x, origin_y;
   gchar *string;
-  double x1_extension, x2_extension, y1_extension, y2_extension;
   cairo_font_options_t *font_options;
   cairo_hint_metrics_t hint_metrics = CAIRO_HINT_METRICS_OFF;
 
@@ -478,6 +533,110 @@ goo_canvas_text_create_layout (GooCanvasItemSimpleData *simple_data,
 
   pango_layout_set_wrap (layout, text_data->wrap);
 
+  return layout;
+}
+
+
+static void
+goo_canvas_text_free_layout (GooCanvasText *text)
+{
+  GooCanvasTextPrivate *priv = GOO_CANVAS_TEXT_GET_PRIVATE (text);
+
+  if (priv->layout)
+    g_object_unref (priv->layout);
+  priv->layout = NULL;
+  g_free (priv->layout_key);
+  priv->layout_key = NULL;
+  priv->layout_dirty = TRUE;
+}
+
+
+/* Returns the item's layout for the given width, reusing the cached one if
+   its settings haven't changed, or one shared with another item. The layout
+   is updated to the transformation and font options of the given cairo
+   context, which only invalidates it if they differ from the last use. */
+static PangoLayout*
+goo_canvas_text_get_layout (GooCanvasText *text,
+			    gdouble        layout_width,
+			    cairo_t       *cr)
+{
+  GooCanvasItemSimpleData *simple_data = text->parent.simple_data;
+  GooCanvasTextPrivate *priv = GOO_CANVAS_TEXT_GET_PRIVATE (text);
+  PangoLayout *layout;
+  gchar *key;
+
+  if (priv->layout && !priv->layout_dirty
+      && priv->layout_width == layout_width)
+    {
+      pango_cairo_update_layout (cr, priv->layout);
+      return priv->layout;
+    }
+
+  key = goo_canvas_text_layout_key (simple_data, text->text_data,
+				    layout_width);
+
+  if (priv->layout && !strcmp (key, priv->layout_key))
+    {
+      g_free (key);
+      priv->layout_width = layout_width;
+      priv->layout_dirty = FALSE;
+      pango_cairo_update_layout (cr, priv->layout);
+      return priv->layout;
+    }
+
+  goo_canvas_text_free_layout (text);
+
+  if (!shared_layouts)
+    {
+      shared_layouts = g_hash_table_new (g_str_hash, g_str_equal);
+      layout_key_quark = g_quark_from_static_string ("goo-canvas-text-layout-key");
+    }
+
+  layout = g_hash_table_lookup (shared_layouts, key);
+  if (layout)
+    {
+      g_object_ref (layout);
+      pango_cairo_update_layout (cr, layout);
+    }
+  else
+    {
+      gchar *shared_key = g_strdup (key);
+
+      layout = goo_canvas_text_new_layout (simple_data, text->text_data,
+					   layout_width, cr);
+      g_hash_table_insert (shared_layouts, shared_key, layout);
+      g_object_set_qdata_full ((GObject*) layout, layout_key_quark,
+			       shared_key,
+			       goo_canvas_text_shared_layout_removed);
+    }
+
+  priv->layout = layout;
+  priv->layout_key = key;
+  priv->layout_width = layout_width;
+  priv->layout_dirty = FALSE;
+
+  return layout;
+}
+
+
+/* Returns a new reference to the item's layout, and computes its bounds
+   and origin if requested. */
+static PangoLayout*
+goo_canvas_text_create_layout (GooCanvasText           *text,
+			       gdouble                  layout_width,
+			       cairo_t                 *cr,
+			       GooCanvasBounds         *bounds,
+			       gdouble	               *origin_x_return,
+			       gdouble	               *origin_y_return)
+{
+  GooCanvasTextData *text_data = text->text_data;
+  PangoLayout *layout;
+  PangoRectangle ink_rect, logical_rect;
+  double logical_width, logical_height, align_width, origin_x, origin_y;
+  double x1_extension, x2_extension, y1_extension, y2_extension;
+
+  layout = g_object_ref (goo_canvas_text_get_layout (text, layout_width, cr));
+
   if (bounds)
     {
       /* Get size of the text, so we can position it according to anchor. */
@@ -601,8 +760,11 @@ goo_canvas_text_update  (GooCanvasItemSimple *simple,
      layout container and settings. */
   text->layout_width = text->text_data->width;
 
+  /* Something changed, check the cached layout settings again. */
+  GOO_CANVAS_TEXT_GET_PRIVATE (text)->layout_dirty = TRUE;
+
   /* Compute the new bounds. */
-  layout = goo_canvas_text_create_layout (simple->simple_data, text->text_data,
+  layout = goo_canvas_text_create_layout (text,
 					  text->layout_width, cr,
 					  &simple->bounds, NULL, NULL);
   g_object_unref (layout);
@@ -660,7 +822,7 @@ goo_canvas_text_is_item_at (GooCanvasItemSimple *simple,
   if (priv->height > 0.0 && y > priv->height)
     return FALSE;
 
-  layout = goo_canvas_text_create_layout (simple_data, text->text_data,
+  layout = goo_canvas_text_create_layout (text,
 					  text->layout_width, cr, &bounds,
 					  &origin_x, &origin_y);
 
@@ -724,7 +886,7 @@ goo_canvas_text_paint (GooCanvasItemSimple   *simple,
   goo_canvas_style_set_fill_options (simple->simple_data->style, cr);
 
   cairo_new_path (cr);
-  layout = goo_canvas_text_create_layout (simple->simple_data, text->text_data,
+  layout = goo_canvas_text_create_layout (text,
 					  text->layout_width, cr,
 					  &layout_bounds,
 					  &origin_x, &origin_y);
@@ -776,7 +938,7 @@ goo_canvas_text_get_requested_height (GooCanvasItem	*item,
   if (priv->height < 0.0)
     {
      /* Create layout with given width. */
-      layout = goo_canvas_text_create_layout (simple_data, text->text_data,
+      layout = goo_canvas_text_create_layout (text,
 					      text->layout_width, cr,
 					      &simple->bounds, NULL, NULL);
       g_object_unref (layout);
@@ -828,7 +990,7 @@ goo_canvas_text_get_natural_extents (GooCanvasText  *text,
     goo_canvas_item_ensure_updated (item);
 
   cr = goo_canvas_create_cairo_context (simple->canvas);
-  layout = goo_canvas_text_create_layout (simple->simple_data, text->text_data,
+  layout = goo_canvas_text_create_layout (text,
 					  text->text_data->width, cr, NULL,
 					  NULL, NULL);
   pango_layout_get_extents (layout, ink_rect, logical_rect);
@@ -849,6 +1011,8 @@ goo_canvas_text_set_model    (GooCanvasItem      *item,
   if (!simple->model)
     g_slice_free (GooCanvasTextData, text->text_data);
 
+  goo_canvas_text_free_layout (text);
+
   /* Now use the new model's text_data instead. */
   text->text_data = &tmodel->text_data;
 
@@ -14,6 +14,7 @@
  */
 #include <config.h>
 #include <math.h>
+#include <string.h>
 #include <gtk/gtk.h>
 #include "goocanvas.h"
 
@@ -119,55 +120,11 @@ goo_canvas_cairo_surface_from_pixbuf (GdkPixbuf *pixbuf)
 
   for (j = height; j; j--)
     {
-      guchar *p = gdk_pixels;
-      guchar *q = cairo_pixels;
-
       if (n_channels == 3)
-	{
-	  guchar *end = p + 3 * width;
-	  
-	  while (p < end)
-	    {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-	      q[0] = p[2];
-	      q[1] = p[1];
-	      q[2] = p[0];
-#else	  
-	      q[1] = p[0];
-	      q[2] = p[1];
-	      q[3] = p[2];
-#endif
-	      p += 3;
-	      q += 4;
-	    }
-	}
+	goo_canvas_pixels_from_rgb ((guint32*) cairo_pixels, gdk_pixels, width);
       else
-	{
-	  guchar *end = p + 4 * width;
-	  guint t1,t2,t3;
-	    
-#define MULT(d,c,a,t) G_STMT_START { t = c * a; d = ((t >> 8) + t) >> 8; } G_STMT_END
-
-	  while (p < end)
-	    {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-	      MULT(q[0], p[2], p[3], t1);
-	      MULT(q[1], p[1], p[3], t2);
-	      MULT(q[2], p[0], p[3], t3);
-	      q[3] = p[3];
-#else	  
-	      q[0] = p[3];
-	      MULT(q[1], p[0], p[3], t1);
-	      MULT(q[2], p[1], p[3], t2);
-	      MULT(q[3], p[2], p[3], t3);
-#endif
-	      
-	      p += 4;
-	      q += 4;
-	    }
-	  
-#undef MULT
-	}
+	goo_canvas_pixels_from_rgba ((guint32*) cairo_pixels, gdk_pixels,
+				     width);
 
       gdk_pixels += gdk_rowstride;
       cairo_pixels += 4 * width;
@@ -551,18 +508,8 @@ parse_flag (gchar    **pos,
 }
 
 
-/**
- * goo_canvas_parse_path_data:
- * @path_data: the sequence of path commands, specified as a string using the
- *  same syntax as in the <ulink url="http://www.w3.org/Graphics/SVG/">Scalable
- *  Vector Graphics (SVG)</ulink> path element.
- * 
- * Parses the given SVG path specification string.
- * 
- * Returns: a #GArray of #GooCanvasPathCommand elements.
- **/
-GArray*
-goo_canvas_parse_path_data (const gchar       *path_data)
+static GArray*
+goo_canvas_parse_path_data_internal (const gchar *path_data)
 {
   GArray *commands;
   GooCanvasPathCommand cmd;
@@ -720,6 +667,62 @@ goo_canvas_parse_path_data (const gchar       *path_data)
 }
 
 
+/* The parsed paths, keyed by their path data. Boards set the same path data
+   again and again, so each one is only parsed once. The cache is emptied when
+   it is full, and long paths, which are seldom set twice, are not kept. */
+#define GOO_CANVAS_MAX_PARSED_PATHS		256
+#define GOO_CANVAS_MAX_PARSED_PATH_LENGTH	4096
+
+static GHashTable *parsed_paths = NULL;
+
+static void
+goo_canvas_free_parsed_path (gpointer data)
+{
+  g_array_free (data, TRUE);
+}
+
+
+/**
+ * goo_canvas_parse_path_data:
+ * @path_data: the sequence of path commands, specified as a string using the
+ *  same syntax as in the <ulink url="http://www.w3.org/Graphics/SVG/">Scalable
+ *  Vector Graphics (SVG)</ulink> path element.
+ * 
+ * Parses the given SVG path specification string.
+ * 
+ * Returns: a #GArray of #GooCanvasPathCommand elements.
+ **/
+GArray*
+goo_canvas_parse_path_data (const gchar       *path_data)
+{
+  GArray *parsed, *commands;
+
+  if (!path_data || strlen (path_data) > GOO_CANVAS_MAX_PARSED_PATH_LENGTH)
+    return goo_canvas_parse_path_data_internal (path_data);
+
+  if (!parsed_paths)
+    parsed_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					  goo_canvas_free_parsed_path);
+
+  parsed = g_hash_table_lookup (parsed_paths, path_data);
+  if (!parsed)
+    {
+      if (g_hash_table_size (parsed_paths) >= GOO_CANVAS_MAX_PARSED_PATHS)
+	g_hash_table_remove_all (parsed_paths);
+
+      parsed = goo_canvas_parse_path_data_internal (path_data);
+      g_hash_table_insert (parsed_paths, g_strdup (path_data), parsed);
+    }
+
+  /* The items change their commands in place, so each gets its own copy. */
+  commands = g_array_sized_new (0, 0, sizeof (GooCanvasPathCommand),
+				parsed->len);
+  g_array_append_vals (commands, parsed->data, parsed->len);
+
+  return commands;
+}
+
+
 static void
 do_curve_to (GooCanvasPathCommand *cmd,
 	     cairo_t              *cr,
@@ -22,6 +22,7 @@ import gcompris
 import gcompris.utils
 import gcompris.skin
 import gcompris.bonus
+import gcompris.lightsoff
 import goocanvas
 
 from gcompris import gcompris_gettext as _
@@ -376,8 +377,21 @@ class Gcompris_lightsoff:
        [0,0,0,1,1],
        [0,1,1,1,0],
        [0,0,1,0,0]],
+      # Then random grids of growing size, (size, number of presses)
+      (6, 8),
+      (6, 12),
+      (7, 12),
+      (7, 16),
+      (8, 16),
+      (8, 20),
       ]
 
+    # The grid of the current level
+    self.level_data = None
+
+    # The solver of each grid size
+    self.solvers = {}
+
 
   def start(self):
     self.gcomprisBoard.level=1
@@ -465,7 +479,7 @@ class Gcompris_lightsoff:
     gcompris.bar_location(gcompris.BOARD_WIDTH/2 - 90, -1, 0.6)
     gcompris.bar_set_level(self.gcomprisBoard)
 
-    self.display_game()
+    self.start_level()
 
   def end(self):
     self.backroot.remove()
@@ -496,14 +510,14 @@ class Gcompris_lightsoff:
     if(self.gamewon == True and pause == False):
       self.gamewon = False
       if(self.increment_level()):
-        self.display_game()
+        self.start_level()
 
 
 
   def set_level(self, level):
     self.gcomprisBoard.level = level
     gcompris.bar_set_level(self.gcomprisBoard)
-    self.display_game()
+    self.start_level()
 
 
   # Code that increments the sublevel and level
@@ -523,10 +537,26 @@ class Gcompris_lightsoff:
 
     return 1
 
+  def get_solver(self, size):
+    if not self.solvers.has_key(size):
+      self.solvers[size] = gcompris.lightsoff.Solver(size, size)
+    return self.solvers[size]
+
+  # Set the grid of the current level, the random ones are generated
+  def start_level(self):
+    data = self.data[self.gcomprisBoard.level - 1]
+    if isinstance(data, tuple):
+      (size, presses) = data
+      data = self.get_solver(size).generate(presses)
+    self.level_data = data
+
+    self.display_game()
+
   def create_empty_list(self):
+    size = len(self.level_data)
     items = []
-    for x in range(5):
-      items.append(range(5))
+    for x in range(size):
+      items.append(range(size))
     for y in range(len(items)):
       for x in range(len(items[0])):
         items[y][x] = 0
@@ -563,9 +593,15 @@ class Gcompris_lightsoff:
       iheight = svghandle.props.height
 
       gap = 10
-      x_start = (gcompris.BOARD_WIDTH - len(self.items) * (iwidth + gap) ) / 2
-      y_start = (gcompris.BOARD_HEIGHT - len(self.items[0]) \
-                   * (iheight + gap) ) / 2 - 40
+
+      # Grids larger than 5 are zoomed out to take the same room
+      zoom = min(1.0, 5.0 / len(self.items))
+      self.rootitem.scale(zoom, zoom)
+
+      x_start = (gcompris.BOARD_WIDTH - len(self.items) * (iwidth + gap) * zoom) \
+          / 2 / zoom
+      y_start = ((gcompris.BOARD_HEIGHT - len(self.items[0]) \
+                    * (iheight + gap) * zoom) / 2 - 40) / zoom
 
       goocanvas.Rect(
         parent = self.rootitem,
@@ -580,7 +616,7 @@ class Gcompris_lightsoff:
         line_width = 2
         )
 
-      data = self.data[self.gcomprisBoard.level - 1]
+      data = self.level_data
       for y in range(len(self.items)):
         for x in range(len(self.items[0])):
           item = goocanvas.Rect(
@@ -674,57 +710,6 @@ class Gcompris_lightsoff:
       self.gamewon = True
       gcompris.bonus.display(gcompris.bonus.WIN, gcompris.bonus.FLOWER)
 
-  def solution_switch(self, items, clicks, y, x):
-    items[y][x] = not items[y][x]
-    clicks[y][x] = not clicks[y][x]
-    if y >= 1:
-      items[y-1][x] = not items[y-1][x]
-    if y <= 3:
-      items[y+1][x] = not items[y+1][x]
-    if x >= 1:
-      items[y][x-1] = not items[y][x-1]
-    if x <= 3:
-      items[y][x+1] = not items[y][x+1]
-
-
-  def chase_light(self, items, clicks):
-    for y in range(1, len(items)):
-      for x in range(len(items[0])):
-        if items[y-1][x]:
-          self.solution_switch(items, clicks, y, x)
-
-  def is_solution_pattern(self, s, a, b, c, d, e):
-    if s[4][0] == a and \
-          s[4][1] == b and \
-          s[4][2] == c and \
-          s[4][3] == d and \
-          s[4][4] == e:
-      return True
-    return False
-
-
-  # Return False if the is no solution
-  def solution_wrap(self, solution, clicks):
-    if self.is_solution_pattern(solution, 1, 0, 0 , 0, 1):
-      self.solution_switch(solution, clicks, 0, 0)
-      self.solution_switch(solution, clicks, 0, 1)
-    elif self.is_solution_pattern(solution, 0, 1, 0, 1, 0):
-      self.solution_switch(solution, clicks, 0, 0)
-      self.solution_switch(solution, clicks, 0, 3)
-    elif self.is_solution_pattern(solution, 1, 1, 1, 0, 0):
-      self.solution_switch(solution, clicks, 0, 1)
-    elif self.is_solution_pattern(solution, 0, 0, 1, 1 , 1):
-      self.solution_switch(solution, clicks, 0, 3)
-    elif self.is_solution_pattern(solution, 1, 0, 1, 1, 0):
-      self.solution_switch(solution, clicks, 0, 4)
-    elif self.is_solution_pattern(solution, 0, 1, 1, 0, 1):
-      self.solution_switch(solution, clicks, 0, 0)
-    elif self.is_solution_pattern(solution, 1, 1, 0, 1, 1):
-      self.solution_switch(solution, clicks, 0, 2)
-    else:
-      return False
-    return True
-
   def items2list(self, items):
     list = []
     for y in range(len(items[0])):
@@ -737,13 +722,6 @@ class Gcompris_lightsoff:
       list.append(line)
     return list
 
-  # We check only the last line
-  def solution_found(self, solution):
-    for x in range(len(solution[0])):
-      if solution[4][x]:
-        return False
-    return True
-
   def solution_length(self, clicks):
     click = 0
     for y in range(0, len(clicks)):
@@ -752,75 +730,14 @@ class Gcompris_lightsoff:
           click += 1
     return click
 
-  def solve_one(self, solution, clicks):
-    found = False
-    for index in range(0, 5):
-
-      self.chase_light( solution, clicks )
-
-      if self.solution_found(solution):
-        found = True
-        break
-
-      if not self.solution_wrap(solution, clicks):
-        break
-
-    if found:
-      return clicks
-    else:
-      return None
-
-  # Solving algorithm is the one described here:
-  # http://www.haar.clara.co.uk/Lights/solving.html To begin, you turn
-  # out all the lights on the top row, by pressing the buttons on the
-  # second row that are directly underneath any lit buttons on the top
-  # row. The top row will then have all it's lights off.  Repeat this
-  # step for the second, third and fourth row. (i.e. chase the lights
-  # all the way down to the bottom row). This may have solved the
-  # puzzle already ( click here for an example of this ), but is more
-  # likely that there will now be some lights left on in the bottom
-  # row. If so, there are only 7 posible configurations. Depending on
-  # which configuration you are left with, you need to press some
-  # buttons in the top row. You can determine which buttons you need
-  # to press from the following table.
-  # Light on bottom row     Press on this on top row
-  # 10001                   11000
-  # 01010                   10010
-  # 11100                   01000
-  # 00111                   00010
-  # 10110                   00001
-  # 01101                   10000
-  # 11011                   00100
-
+  # The shortest solution is found by the lightsoff solver, with a
+  # gaussian elimination over GF(2) of the lights left on the bottom
+  # row when chasing the lights down from the top row.
   def solve_it(self):
-    clicks = None
-
-    # Our solving algorithm does not find the shortest solution. We
-    # don't really care but we'd like to keep the proposed solution
-    # stable (not propose a complete new solution when one light
-    # changes).  To achieve this (closely), we test here all the
-    # combination of the first line, trying to find the shortest
-    # solution.
-    for x in range(64):
-      solution = self.items2list(self.items)
-      clicks2 = self.create_empty_list()
-      if x & 1:
-        self.solution_switch(solution, clicks2, 0, 0)
-      if x & 2:
-        self.solution_switch(solution, clicks2, 0, 1)
-      if x & 4:
-        self.solution_switch(solution, clicks2, 0, 2)
-      if x & 8:
-        self.solution_switch(solution, clicks2, 0, 3)
-      if x & 16:
-        self.solution_switch(solution, clicks2, 0, 4)
-
-      clicks2 = self.solve_one(solution, clicks2)
-      if clicks == None and clicks2:
-        clicks = clicks2
-      elif clicks2 and \
-            self.solution_length(clicks2) < self.solution_length(clicks):
-        clicks = clicks2
+    lights = self.items2list(self.items)
+    clicks = self.get_solver(len(lights)).solve(lights)
+    if clicks == None:
+      clicks = self.create_empty_list()
 
     if self.hints_mode:
       self.show_hints(clicks)
@@ -838,7 +755,8 @@ class Gcompris_lightsoff:
 
 
   def update_background(self, clicks):
-    length = self.solution_length(clicks)
+    # Larger grids need more clicks, they do not fit the sky
+    length = min(self.solution_length(clicks), 18)
     c = int(length * 0xFF / 18.0)
     color = 0X33 << 24 | 0x11 << 16 | c << 8 | 0xFFL
     self.background.set_properties(fill_color_rgba = color)
@@ -770,7 +770,9 @@ static void money_next_level()
       svg_handle =							\
 	gc_rsvg_load(imageList[g_random_int_range(0, number_of_images - 1)]);
 
+      goo_canvas_svg_lock();
       rsvg_handle_get_dimensions(svg_handle, &dimension);
+      goo_canvas_svg_unlock();
 
       item = goo_canvas_svg_new ( boardRootItem,
 				  svg_handle,
@@ -285,7 +285,9 @@ money_widget_add (MoneyWidget *moneyWidget, MoneyEuroType value)
 
   svg_handle = gc_rsvg_load(euroList[value].image);
 
+  goo_canvas_svg_lock();
   rsvg_handle_get_dimensions(svg_handle, &dimension);
+  goo_canvas_svg_unlock();
 
   xratio =  block_width  / (dimension.width + BORDER_GAP);
   yratio =  block_height / (dimension.height + BORDER_GAP);
@@ -305,7 +305,9 @@ static void paratrooper_next_level()
 
   /* Setup and Display the plane */
   svg_handle = gc_rsvg_load("paratrooper/tuxplane.svgz");
+  goo_canvas_svg_lock ();
   rsvg_handle_get_dimensions (svg_handle, &rsvg_dimension);
+  goo_canvas_svg_unlock ();
 
   planeroot = \
     goo_canvas_group_new (boardRootItem,
@@ -351,7 +353,9 @@ static void paratrooper_next_level()
 
   /* Display the target */
   svg_handle = gc_rsvg_load("paratrooper/fishingboat.svgz");
+  goo_canvas_svg_lock ();
   rsvg_handle_get_dimensions (svg_handle, &rsvg_dimension);
+  goo_canvas_svg_unlock ();
   boat_x = (BOARDWIDTH - rsvg_dimension.width) / 2;
   boat_y = BOARDHEIGHT - 100;
   boat_landarea_y = boat_y + 20;
@@ -508,7 +512,9 @@ paratrooper_create_cloud(GooCanvasItem *parent)
   RsvgDimensionData rsvg_dimension;
 
   svg_handle = gc_rsvg_load("paratrooper/cloud.svgz");
+  goo_canvas_svg_lock ();
   rsvg_handle_get_dimensions (svg_handle, &rsvg_dimension);
+  goo_canvas_svg_unlock ();
 
   if(windspeed>0)
     {
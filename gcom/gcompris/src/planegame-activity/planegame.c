@@ -454,7 +454,9 @@ static GooCanvasItem *planegame_create_item(GooCanvasItem *parent)
 		     "cloud_number", GINT_TO_POINTER (i));
 
   svg_handle = gc_rsvg_load("planegame/cloud.svgz");
+  goo_canvas_svg_lock();
   rsvg_handle_get_dimensions(svg_handle, &dimension);
+  goo_canvas_svg_unlock();
 
   y = (g_random_int()%(BOARDHEIGHT - 40 -
 		       (guint)(dimension.height * imageZoom)));
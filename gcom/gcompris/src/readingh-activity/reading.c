@@ -195,7 +195,9 @@ static void start_board (GcomprisBoard *agcomprisBoard)
       gcomprisBoard->maxlevel = 9;
       gc_bar_set(GC_BAR_CONFIG|GC_BAR_LEVEL);
       gc_bar_location(BOARDWIDTH-240, -1, 0.7);
-      PangoFontDescription *font_medium = pango_font_description_from_string(gc_skin_font_board_medium);
+      PangoFontDescription *font_medium =
+	gc_skin_get_font_desc_quark(g_quark_from_static_string("gcompris/board/medium"),
+				    FONT_BOARD_MEDIUM);
       font_size = PANGO_PIXELS(pango_font_description_get_size (font_medium));
       interline = (int) (1.5*font_size);
 
@@ -204,7 +206,6 @@ static void start_board (GcomprisBoard *agcomprisBoard)
       PangoFontMetrics* pango_metrics =  pango_context_get_metrics (pango_context,
 								    font_medium,
 								    pango_language_from_string   (gc_locale_get()));
-      pango_font_description_free(font_medium);
 
       int ascent = PANGO_PIXELS(pango_font_metrics_get_ascent (pango_metrics));
       int descent = PANGO_PIXELS(pango_font_metrics_get_descent (pango_metrics));
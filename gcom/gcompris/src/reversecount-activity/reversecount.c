@@ -454,7 +454,9 @@ static GooCanvasItem *reversecount_create_item(GooCanvasItem *parent)
   // Ice blocks
   svg_handle = gc_rsvg_load("reversecount/iceblock.svgz");
   RsvgDimensionData rsvg_dimension;
+  goo_canvas_svg_lock ();
   rsvg_handle_get_dimensions (svg_handle, &rsvg_dimension);
+  goo_canvas_svg_unlock ();
 
   xratio = block_width / rsvg_dimension.width;
   yratio =  block_height / rsvg_dimension.height;
@@ -493,7 +495,9 @@ static GooCanvasItem *reversecount_create_item(GooCanvasItem *parent)
   //----------------------------------------
   // Create the dice area
   svg_handle = gc_rsvg_load("reversecount/dice_area.svgz");
+  goo_canvas_svg_lock ();
   rsvg_handle_get_dimensions (svg_handle, &rsvg_dimension);
+  goo_canvas_svg_unlock ();
 
   dice_area_x = BOARDWIDTH - block_width - rsvg_dimension.width - 20;
 
@@ -506,7 +510,9 @@ static GooCanvasItem *reversecount_create_item(GooCanvasItem *parent)
   //----------------------------------------
   // Create the dices
   svg_handle = gc_rsvg_load("reversecount/dice1.svgz");
+  goo_canvas_svg_lock ();
   rsvg_handle_get_dimensions (svg_handle, &rsvg_dimension);
+  goo_canvas_svg_unlock ();
   guint dice_width = 78;
 
   for(d=0; d<number_of_dices; d++)
@@ -553,7 +559,9 @@ static GooCanvasItem *reversecount_create_item(GooCanvasItem *parent)
   tuxItem = goo_canvas_svg_new (tuxRootItem, svg_handle, NULL);
 
   RsvgDimensionData dimension;
+  goo_canvas_svg_lock();
   rsvg_handle_get_dimensions(svg_handle, &dimension);
+  goo_canvas_svg_unlock();
 
   /* Calc the tux best ratio to display it */
   xratio =  block_width  / (dimension.width + TUX_TO_BORDER_GAP);
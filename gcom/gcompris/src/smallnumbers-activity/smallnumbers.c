@@ -432,7 +432,9 @@ static void smallnumbers_create_item(GooCanvasItem *parent)
     RsvgDimensionData rsvg_dimension;
     str1 = g_strdup_printf("smallnumbers/dice%c.svgz", numbers[i]);
     svg_handle = gc_rsvg_load(str1);
+    goo_canvas_svg_lock ();
     rsvg_handle_get_dimensions (svg_handle, &rsvg_dimension);
+    goo_canvas_svg_unlock ();
 
     g_free(str1);
 
@@ -974,6 +974,9 @@ static gboolean update_timeout() {
   if(board_paused)
     return TRUE;
 
+  /* The gauges set below are redrawn once */
+  goo_canvas_begin_batch(gcomprisBoard->canvas);
+
   /* air in ballasts */
   if (ballast_av_purge_open) {
     ballast_av_air -= UPDATE_DELAY/1000.0 *500.0; // 500 liters go out per second
@@ -1035,6 +1038,8 @@ static gboolean update_timeout() {
   if (regleur_dirty)
     setRegleur(regleur);
 
+  goo_canvas_end_batch(gcomprisBoard->canvas);
+
   return TRUE;
 }
 /* =====================================================================
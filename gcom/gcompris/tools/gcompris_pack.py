@@ -0,0 +1,157 @@
+#!/usr/bin/python
+#
+# Copyright (C) 2008 Bruno Coudoin
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, see <http://www.gnu.org/licenses/>.
+#
+#######################################################################
+#
+# Pack the boards data in a single archive, read by src/gcompris/gc_pack.c
+#
+# Usage: gcompris_pack.py <boards dir> [<archive>]
+#
+# The archive defaults to <boards dir>.pack, next to the boards dir, where
+# GCompris looks for it. The files left in the boards dir still override
+# the ones of the archive.
+#
+#######################################################################
+
+import os
+import struct
+import sys
+
+MAGIC = b"GCPK"
+VERSION = 1
+
+FLAG_LZ4 = 1
+
+# The text files are worth compressing, the images and sounds are not
+COMPRESSED = ('.svg', '.svgz', '.xml', '.txt', '.py', '.desktop')
+
+HEADER = struct.Struct("<4sIII")
+ENTRY = struct.Struct("<IIQQQ")
+
+MIN_MATCH = 4
+# The format wants the last literals to cover these bytes
+LAST_LITERALS = 5
+MF_LIMIT = 12
+
+def _length(out, length):
+  while length >= 255:
+    out.append(255)
+    length -= 255
+  out.append(length)
+
+def _sequence(out, literals, match_length, offset):
+  token_lit = min(len(literals), 15)
+  if match_length is None:
+    token_match = 0
+  else:
+    token_match = min(match_length - MIN_MATCH, 15)
+  out.append((token_lit << 4) | token_match)
+  if token_lit == 15:
+    _length(out, len(literals) - 15)
+  out.extend(literals)
+  if match_length is not None:
+    out.extend(struct.pack("<H", offset))
+    if token_match == 15:
+      _length(out, match_length - MIN_MATCH - 15)
+
+def lz4_compress(data):
+  """ Compress data in a LZ4 block, a greedy match finder is enough here """
+  data = bytearray(data)
+  out = bytearray()
+  table = {}
+  anchor = 0
+  i = 0
+  limit = len(data) - MF_LIMIT
+  while i < limit:
+    key = bytes(data[i:i + MIN_MATCH])
+    candidate = table.get(key)
+    table[key] = i
+    if candidate is None or i - candidate > 0xffff:
+      i += 1
+      continue
+    length = MIN_MATCH
+    end = len(data) - LAST_LITERALS
+    while i + length < end and data[candidate + length] == data[i + length]:
+      length += 1
+    _sequence(out, data[anchor:i], length, i - candidate)
+    i += length
+    anchor = i
+  _sequence(out, data[anchor:], None, 0)
+  return bytes(out)
+
+def collect(boards_dir):
+  files = []
+  for dirpath, dirnames, filenames in os.walk(boards_dir):
+    dirnames.sort()
+    for filename in filenames:
+      path = os.path.join(dirpath, filename)
+      name = os.path.relpath(path, boards_dir).replace(os.sep, '/')
+      files.append((name, path))
+  # gc_pack.c looks the names up with a binary search on strcmp()
+  files.sort(key=lambda f: f[0].encode('utf-8'))
+  return files
+
+def pack(boards_dir, archive):
+  files = collect(boards_dir)
+
+  names = bytearray()
+  name_offsets = []
+  for name, path in files:
+    name_offsets.append(len(names))
+    names.extend(name.encode('utf-8') + b"\0")
+
+  offset = HEADER.size + ENTRY.size * len(files) + len(names)
+  entries = []
+  contents = []
+  for (name, path), name_offset in zip(files, name_offsets):
+    f = open(path, 'rb')
+    data = f.read()
+    f.close()
+    flags = 0
+    stored = data
+    if name.endswith(COMPRESSED) and data:
+      compressed = lz4_compress(data)
+      if len(compressed) < len(data):
+        flags = FLAG_LZ4
+        stored = compressed
+    entries.append(ENTRY.pack(name_offset, flags, offset, len(data), len(stored)))
+    contents.append(stored)
+    offset += len(stored)
+
+  out = open(archive, 'wb')
+  out.write(HEADER.pack(MAGIC, VERSION, len(files), len(names)))
+  for entry in entries:
+    out.write(entry)
+  out.write(bytes(names))
+  for stored in contents:
+    out.write(stored)
+  out.close()
+
+  print("%s: %d files, %d bytes" % (archive, len(files), offset))
+
+if __name__ == '__main__':
+  if len(sys.argv) not in (2, 3):
+    sys.stderr.write("Usage: %s <boards dir> [<archive>]\n" % sys.argv[0])
+    sys.exit(1)
+
+  boards_dir = sys.argv[1].rstrip('/')
+  if len(sys.argv) == 3:
+    archive = sys.argv[2]
+  else:
+    archive = boards_dir + ".pack"
+
+  pack(boards_dir, archive)